@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Loss distribution and coverage of the empirical models over an area,
+ * for each model and environment, without a raster of the losses.
+ *
+ * Random locations are evaluated until the coverage of every model is
+ * known within the precision, and its 90% loss within the quantile
+ * precision; --precision=0 --quantilePrecision=0 evaluates the whole grid.
+ *
+ *   ./waf --run 'area-loss-statistics-report --radius=5000 --precision=0.005'
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include "ns3/area-loss-statistics.h"
+
+using namespace ns3;
+using namespace std;
+
+NS_LOG_COMPONENT_DEFINE ("AreaLossStatisticsReport");
+
+int main (int argc, char *argv[])
+{
+  double radius = 5000.0;
+  double frequency = 900e6;
+  double txHeight = 35.0;
+  double rxHeight = 1.5;
+  double txPower = 43.0;
+  double sensitivity = -95.0;
+  double precision = 0.005;
+  double quantilePrecision = 0.0;
+  double spacing = 25.0;
+  uint32_t threads = 0;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("radius", "Half side of the square area around the site [m]", radius);
+  cmd.AddValue ("frequency", "Carrier frequency [Hz]", frequency);
+  cmd.AddValue ("txHeight", "Antenna height of the site [m]", txHeight);
+  cmd.AddValue ("txPower", "Transmission power of the site [dBm]", txPower);
+  cmd.AddValue ("sensitivity", "Received power of a covered location [dBm]", sensitivity);
+  cmd.AddValue ("precision", "Half width of the coverage intervals to stop at, 0 for the whole grid", precision);
+  cmd.AddValue ("quantilePrecision", "Half width of the 90% loss intervals to stop at, 0 not to stop on them [dB]",
+                quantilePrecision);
+  cmd.AddValue ("spacing", "Grid spacing without a precision [m]", spacing);
+  cmd.AddValue ("threads", "Number of threads, 0 for one per core", threads);
+  cmd.Parse (argc, argv);
+
+  vector<Ptr<EmpiricalPropagationLossModel> > models;
+  vector<string> names;
+
+  const ECC33PropagationLossModel::Environment ecc33Environments[2] = {
+    ECC33PropagationLossModel::Suburban, ECC33PropagationLossModel::Urban
+  };
+  const char *ecc33Names[2] = { "ECC-33 suburban", "ECC-33 urban" };
+  for (uint32_t e = 0; e < 2; e++)
+    {
+      Ptr<ECC33PropagationLossModel> ecc33 = CreateObject<ECC33PropagationLossModel> ();
+      ecc33->SetFrequency (frequency);
+      ecc33->SetTxAntennaHeight (txHeight);
+      ecc33->SetRxAntennaHeight (rxHeight);
+      ecc33->SetEnvironment (ecc33Environments[e]);
+      models.push_back (ecc33);
+      names.push_back (ecc33Names[e]);
+    }
+
+  const EricssonPropagationLossModel::Environment ericssonEnvironments[3] = {
+    EricssonPropagationLossModel::Rural, EricssonPropagationLossModel::Suburban, EricssonPropagationLossModel::Urban
+  };
+  const char *ericssonNames[3] = { "Ericsson rural", "Ericsson suburban", "Ericsson urban" };
+  for (uint32_t e = 0; e < 3; e++)
+    {
+      Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+      ericsson->SetFrequency (frequency);
+      ericsson->SetTxAntennaHeight (txHeight);
+      ericsson->SetRxAntennaHeight (rxHeight);
+      ericsson->SetEnvironment (ericssonEnvironments[e]);
+      models.push_back (ericsson);
+      names.push_back (ericssonNames[e]);
+    }
+
+  const SUIPropagationLossModel::Terrain suiTerrains[3] = {
+    SUIPropagationLossModel::A, SUIPropagationLossModel::B, SUIPropagationLossModel::C
+  };
+  const char *suiNames[3] = { "SUI A", "SUI B", "SUI C" };
+  for (uint32_t e = 0; e < 3; e++)
+    {
+      Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+      sui->SetLambda (3e8 / frequency);
+      sui->SetBSAntennaHeight (txHeight);
+      sui->SetSSAntennaHeight (rxHeight);
+      sui->SetTerrain (suiTerrains[e]);
+      models.push_back (sui);
+      names.push_back (suiNames[e]);
+    }
+
+  Ptr<AreaLossStatistics> statistics = CreateObject<AreaLossStatistics> ();
+  bool stopEarly = precision > 0 || quantilePrecision > 0;
+  if (stopEarly)
+    {
+      statistics->SetAttribute ("Sampling", EnumValue (AreaLossStatistics::Random));
+      statistics->SetAttribute ("Precision", DoubleValue (precision));
+      statistics->SetAttribute ("QuantilePrecision", DoubleValue (quantilePrecision));
+      statistics->SetAttribute ("PrecisionQuantile", DoubleValue (0.9));
+    }
+  else
+    {
+      statistics->SetAttribute ("GridSpacing", DoubleValue (spacing));
+    }
+  statistics->SetAttribute ("TxPowerDbm", DoubleValue (txPower));
+  statistics->SetAttribute ("SensitivityDbm", DoubleValue (sensitivity));
+  statistics->SetAttribute ("ReceiverHeight", DoubleValue (rxHeight));
+  statistics->SetAttribute ("Threads", UintegerValue (threads));
+  statistics->SetSite (Vector (0.0, 0.0, txHeight));
+  statistics->SetArea (-radius, -radius, radius, radius);
+  for (uint32_t k = 0; k < models.size (); k++)
+    {
+      statistics->AddModel (models[k]);
+    }
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now ();
+  statistics->Run ();
+  double seconds = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+  printf ("%llu locations in %.3f s%s\n", static_cast<unsigned long long> (statistics->GetNSamples ()), seconds,
+          stopEarly ? (statistics->HasConverged () ? ", precision reached" : ", precision not reached") : "");
+  printf ("%-18s %24s %24s %24s\n", "model", "coverage [%]", "median loss [dB]", "90% loss [dB]");
+  for (uint32_t k = 0; k < models.size (); k++)
+    {
+      double coverageLow;
+      double coverageHigh;
+      double medianLow;
+      double medianHigh;
+      double tailLow;
+      double tailHigh;
+      statistics->GetCoverageBounds (k, coverageLow, coverageHigh);
+      statistics->GetQuantileBounds (k, 0.5, medianLow, medianHigh);
+      statistics->GetQuantileBounds (k, 0.9, tailLow, tailHigh);
+      printf ("%-18s %6.2f [%6.2f, %6.2f]  %6.1f [%6.1f, %6.1f]  %6.1f [%6.1f, %6.1f]\n", names[k].c_str (),
+              100 * statistics->GetCoverage (k), 100 * coverageLow, 100 * coverageHigh,
+              statistics->GetQuantile (k, 0.5), medianLow, medianHigh,
+              statistics->GetQuantile (k, 0.9), tailLow, tailHigh);
+    }
+  statistics->Dispose ();
+  return 0;
+}
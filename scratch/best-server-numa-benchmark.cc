@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Scaling of the best server reduction over the NUMA nodes.
+ *
+ * The same map is reduced with three configurations:
+ *   - one node: the CPUs of the first node, pinned, one partition
+ *   - unpartitioned: every CPU, unpinned, one partition
+ *   - every node: every CPU, pinned, one partition per node
+ * On a dual-socket server, the first and last lines give the 1 vs 2
+ * socket scaling, and the middle one the cost of ignoring the topology.
+ *
+ *   ./waf --run 'best-server-numa-benchmark --locations=4000000 --sites=64'
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/best-server-reduction.h"
+#include "ns3/numa-topology.h"
+
+using namespace ns3;
+using namespace std;
+
+NS_LOG_COMPONENT_DEFINE ("BestServerNumaBenchmark");
+
+/// One line of the benchmark
+struct BenchmarkConfig
+{
+  const char *name; //!< name of the line
+  uint32_t threads; //!< Threads attribute
+  uint32_t numaNodes; //!< NumaNodes attribute
+  bool pin; //!< PinThreads attribute
+};
+
+int main (int argc, char *argv[])
+{
+  uint32_t nLocations = 4000000;
+  uint32_t nSites = 64;
+  uint32_t repeat = 3;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("locations", "Number of locations of the map", nLocations);
+  cmd.AddValue ("sites", "Number of sites", nSites);
+  cmd.AddValue ("repeat", "Number of runs per configuration, the fastest is kept", repeat);
+  cmd.Parse (argc, argv);
+
+  const NumaTopology &topology = NumaTopology::GetSystem ();
+  uint32_t allCpus = 0;
+  for (uint32_t node = 0; node < topology.GetNNodes (); ++node)
+    {
+      cout << "Node " << node << ": " << topology.GetCpus (node).size () << " CPUs" << endl;
+      allCpus += topology.GetCpus (node).size ();
+    }
+
+  // a square grid of 25 m cells, with the sites on a regular lattice over it
+  uint32_t side = 1;
+  while (static_cast<uint64_t> (side) * side < nLocations)
+    {
+      side++;
+    }
+  vector<double> x (nLocations);
+  vector<double> y (nLocations);
+  vector<double> z (nLocations, 1.5);
+  for (uint32_t i = 0; i < nLocations; ++i)
+    {
+      x[i] = 25.0 * (i % side);
+      y[i] = 25.0 * (i / side);
+    }
+  Ptr<EricssonPropagationLossModel> model = CreateObject<EricssonPropagationLossModel> ();
+  model->SetFrequency (900e6);
+  model->SetTxAntennaHeight (35.0);
+  model->SetEnvironment (EricssonPropagationLossModel::Suburban);
+  uint32_t sitesPerSide = 1;
+  while (sitesPerSide * sitesPerSide < nSites)
+    {
+      sitesPerSide++;
+    }
+  double spacing = 25.0 * side / sitesPerSide;
+
+  const BenchmarkConfig configs[3] = {
+    { "one node", static_cast<uint32_t> (topology.GetCpus (0).size ()), 1, true },
+    { "unpartitioned", allCpus, 1, false },
+    { "every node", allCpus, 0, true }
+  };
+  double first = 0;
+  for (uint32_t c = 0; c < 3; ++c)
+    {
+      Ptr<BestServerReduction> reduction = CreateObject<BestServerReduction> ();
+      reduction->SetAttribute ("Threads", UintegerValue (configs[c].threads));
+      reduction->SetAttribute ("NumaNodes", UintegerValue (configs[c].numaNodes));
+      reduction->SetAttribute ("PinThreads", BooleanValue (configs[c].pin));
+      for (uint32_t s = 0; s < nSites; ++s)
+        {
+          Vector position (spacing * (s % sitesPerSide + 0.5), spacing * (s / sitesPerSide + 0.5), 35.0);
+          reduction->AddSite (position, 43.0, model);
+        }
+      // after the attributes, so that the locations land on their partition
+      reduction->SetLocations (x.data (), y.data (), z.data (), nLocations);
+
+      double best = 0;
+      for (uint32_t r = 0; r < repeat; ++r)
+        {
+          chrono::steady_clock::time_point start = chrono::steady_clock::now ();
+          reduction->Run ();
+          double seconds = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+          best = (r == 0 || seconds < best) ? seconds : best;
+        }
+      if (c == 0)
+        {
+          first = best;
+        }
+      printf ("%-14s %4u threads %8.3f s %10.1f Mlinks/s  x%.2f\n", configs[c].name, configs[c].threads, best,
+              static_cast<double> (nLocations) * nSites / best / 1e6, first / best);
+      reduction->Dispose ();
+    }
+  return 0;
+}
@@ -41,16 +41,16 @@
 #include "ns3/ecc33-propagation-loss-model.h"
 #include "ns3/ericsson-propagation-loss-model.h"
 #include "ns3/sui-propagation-loss-model.h"
+#include "ns3/perf-counter-scope.h"
+#include "ns3/site-height-optimizer.h"
+#include "ns3/adaptive-path-sampler.h"
+#include "empirical-propagation-loss-paths.h"
 
 using namespace ns3;
 using namespace std;
 
 NS_LOG_COMPONENT_DEFINE ("EmpiricalPropagationLossComparison");
 
-double urban[20][2] = { {80, 0}, {100, 0}, {150, 0}, {200, 0}, {250, 0}, {300, 0}, {350, 0}, {400, 0}, {450, 0}, {500, 0}, {550, 0}, {600, 0}, {650, 0}, {700, 0}, {750, 0}, {790, 0}, {790, 50}, {790, 100}, {790, 150}, {790, 150} };
-double suburban[20][2] = { {56.57, 56.57}, {100, 100}, {125, 125}, {150, 150}, {150, 200}, {150, 250}, {150, 300}, {200, 300}, {250, 300},  {300, 300}, {300, 350}, {300, 400}, {350, 400}, {400, 400}, {400, 450},  {400, 500}, {400, 550}, {400, 600}, {400, 650}, {400, 700} };
-double rural[20][2] = { {0, 80}, {0, 125}, {50, 125}, {60, 150}, {70, 200}, {100, 230}, {150, 250}, {200, 300}, {225, 315}, {250, 330}, {275, 335}, {300, 340}, {350, 370}, {400, 380}, {450, 390}, {500, 400}, {550, 400}, {600, 400}, {650, 400}, {700, 400} };
-
 void
 AdvancePosition (Ptr<Node> tx, Ptr<Node> rx, vector<Ptr<PropagationLossModel>>  models, int idx, double path[20][2], vector<Gnuplot2dDataset> output)
 {
@@ -75,34 +75,81 @@ int main (int argc, char *argv[])
   double frequency = 900e6; 
   string env = "urban";
   double path[20][2]; 
+  bool perf = false;
+  bool optimizeHeight = false;
+  double sensitivity = -70.0;
+  bool adaptive = false;
+  double tolerance = 0.5;
 
   CommandLine cmd (__FILE__);
   cmd.AddValue ("environment", "Environment type", env);
+  cmd.AddValue ("perf", "Report the hardware performance counters of the empirical models", perf);
+  cmd.AddValue ("optimizeHeight", "Replace the AP height with the lowest one covering the most of the path (Ericsson model)", optimizeHeight);
+  cmd.AddValue ("sensitivity", "Received power of a covered path point for optimizeHeight [dBm]", sensitivity);
+  cmd.AddValue ("adaptive", "Sample the whole path where the losses change by more than tolerance, instead of at the waypoints", adaptive);
+  cmd.AddValue ("tolerance", "Largest loss change between two adaptive samples [dB]", tolerance);
   cmd.Parse (argc, argv);
+  PerfCounters::Enable (perf);
 
   if(env == "urban"){
-    ap1_z = 33.0;
+    ap1_z = urbanBsHeight;
     for(int i=0; i < 20; i++){
       path[i][0] = urban[i][0];
       path[i][1] = urban[i][1];
     }
   } else if (env == "suburban") {
-    ap1_z = 35.0;
+    ap1_z = suburbanBsHeight;
     for(int i=0; i < 20; i++){
       path[i][0] = suburban[i][0];
       path[i][1] = suburban[i][1];
     }
   } else if (env == "rural") {
-    ap1_z = 42.0;
+    ap1_z = ruralBsHeight;
     for(int i=0; i < 20; i++){
       path[i][0] = rural[i][0];
       path[i][1] = rural[i][1];
     }
   } else {
-    cout << "Invaid environment type. Please enter 'urban', 'suburban', or 'rural.'" << endl;
+    cout << "Invalid environment type. Please enter 'urban', 'suburban', or 'rural.'" << endl;
     return 1;
   }
 
+  if (optimizeHeight)
+    {
+      Ptr<EricssonPropagationLossModel> model = CreateObject<EricssonPropagationLossModel> ();
+      model->SetFrequency (frequency);
+      model->SetRxAntennaHeight (sta1_z);
+      if (env == "urban")
+        {
+          model->SetEnvironment (EricssonPropagationLossModel::Urban);
+        }
+      else if (env == "suburban")
+        {
+          model->SetEnvironment (EricssonPropagationLossModel::Suburban);
+        }
+      else
+        {
+          model->SetEnvironment (EricssonPropagationLossModel::Rural);
+        }
+      double x[20];
+      double y[20];
+      for (int i = 0; i < 20; i++)
+        {
+          x[i] = path[i][0];
+          y[i] = path[i][1];
+        }
+      Ptr<SiteHeightOptimizer> optimizer = CreateObject<SiteHeightOptimizer> ();
+      optimizer->SetAttribute ("TxPowerDbm", DoubleValue (47.0));
+      optimizer->SetAttribute ("SensitivityDbm", DoubleValue (sensitivity));
+      optimizer->SetAttribute ("ReceiverHeight", DoubleValue (sta1_z));
+      optimizer->SetModel (model);
+      optimizer->AddCandidateSite (0.0, 0.0);
+      optimizer->SetTargetArea (x, y, 20);
+      optimizer->Run ();
+      ap1_z = optimizer->GetBestHeight ();
+      cout << "AP height " << ap1_z << " m covers " << 100 * optimizer->GetBestCoverage () << "% of the path" << endl;
+    }
+
   double simuTime = 20;
 
   // Define the APs
@@ -210,10 +257,42 @@ int main (int argc, char *argv[])
   }
 
 
-  Simulator::Schedule (Seconds (0.5 + 1), &AdvancePosition, wifiApNodes.Get (0), wifiStaNodes.Get (0), models, 0, path, output);
+  if (adaptive)
+    {
+      Ptr<AdaptivePathSampler> sampler = CreateObject<AdaptivePathSampler> ();
+      sampler->SetAttribute ("Tolerance", DoubleValue (tolerance));
+      sampler->SetTransmitter (Vector (0.0, 0.0, ap1_z));
+      for (uint16_t i = 0; i < models.size (); i++)
+        {
+          sampler->AddModel (models.at (i));
+        }
+      vector<Vector> waypoints;
+      waypoints.push_back (Vector (80.0, 0.0, sta1_z));
+      double length = 0;
+      for (int i = 0; i < 20; i++)
+        {
+          waypoints.push_back (Vector (path[i][0], path[i][1], sta1_z));
+          length += CalculateDistance (waypoints[i], waypoints[i + 1]);
+        }
+      sampler->Sample (waypoints);
+      for (uint32_t j = 0; j < sampler->GetNSamples (); j++)
+        {
+          for (uint16_t i = 0; i < models.size (); i++)
+            {
+              output.at (i).Add (sampler->GetDistance (j), sampler->GetLoss (i, j));
+            }
+        }
+      cout << sampler->GetNSamples () << " samples over " << length << " m of path ("
+           << static_cast<uint32_t> (length) + 1 << " at 1 m spacing)" << endl;
+      sampler->Dispose ();
+    }
+  else
+    {
+      Simulator::Schedule (Seconds (0.5 + 1), &AdvancePosition, wifiApNodes.Get (0), wifiStaNodes.Get (0), models, 0, path, output);
 
-  Simulator::Stop (Seconds (simuTime));
-  Simulator::Run ();
+      Simulator::Stop (Seconds (simuTime));
+      Simulator::Run ();
+    }
 
   std::ofstream outfile ("propagation-loss-" + env + ".plt");
   Gnuplot gnuplot = Gnuplot ("propagation-loss-" + env + ".png");
@@ -238,5 +317,10 @@ int main (int argc, char *argv[])
 
   Simulator::Destroy ();
 
+  if (perf)
+    {
+      PerfCounters::Print (cout);
+    }
+
   return 0;
 }
@@ -0,0 +1,44 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * The paths of the mobile station in the urban, suburban and rural
+ * environments, and the BS height of each environment, shared by
+ * empirical-propagation-loss-comparison and empirical-propagation-loss-sweep.
+ */
+
+#ifndef EMPIRICAL_PROPAGATION_LOSS_PATHS_H
+#define EMPIRICAL_PROPAGATION_LOSS_PATHS_H
+
+/// Number of waypoints of each path
+const int nPathPoints = 20;
+
+/// Waypoints (x, y) of the urban path [m]
+const double urban[nPathPoints][2] = { {80, 0}, {100, 0}, {150, 0}, {200, 0}, {250, 0}, {300, 0}, {350, 0}, {400, 0}, {450, 0}, {500, 0}, {550, 0}, {600, 0}, {650, 0}, {700, 0}, {750, 0}, {790, 0}, {790, 50}, {790, 100}, {790, 150}, {790, 150} };
+/// Waypoints (x, y) of the suburban path [m]
+const double suburban[nPathPoints][2] = { {56.57, 56.57}, {100, 100}, {125, 125}, {150, 150}, {150, 200}, {150, 250}, {150, 300}, {200, 300}, {250, 300},  {300, 300}, {300, 350}, {300, 400}, {350, 400}, {400, 400}, {400, 450},  {400, 500}, {400, 550}, {400, 600}, {400, 650}, {400, 700} };
+/// Waypoints (x, y) of the rural path [m]
+const double rural[nPathPoints][2] = { {0, 80}, {0, 125}, {50, 125}, {60, 150}, {70, 200}, {100, 230}, {150, 250}, {200, 300}, {225, 315}, {250, 330}, {275, 335}, {300, 340}, {350, 370}, {400, 380}, {450, 390}, {500, 400}, {550, 400}, {600, 400}, {650, 400}, {700, 400} };
+
+/// BS height of the urban path [m]
+const double urbanBsHeight = 33.0;
+/// BS height of the suburban path [m]
+const double suburbanBsHeight = 35.0;
+/// BS height of the rural path [m]
+const double ruralBsHeight = 42.0;
+
+#endif /* EMPIRICAL_PROPAGATION_LOSS_PATHS_H */
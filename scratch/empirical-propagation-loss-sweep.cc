@@ -0,0 +1,417 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Sharded sweep of the empirical models over a grid of BS heights,
+ * distances and frequencies.
+ *
+ * The Simulator is a process-wide singleton, so instead of threads the
+ * sweep forks one worker process per shard. Each job (environment, model,
+ * frequency, BS height) is a row of the result region, a shm_open/mmap
+ * segment created before the fork: worker w evaluates the jobs w, w + N,
+ * w + 2N... and writes their losses in place, then the parent reads the
+ * rows it inherited through the same mapping once every worker has exited.
+ *
+ * Each list option takes values and first:last:step ranges, separated by
+ * commas. Without --distances, the mobile station follows the path of
+ * each environment of empirical-propagation-loss-comparison; without
+ * --bsHeights, the BS is at the height of that path.
+ *
+ *   ./waf --run 'empirical-propagation-loss-sweep --workers=8 --frequencies=700e6,900e6,1.8e9
+ *                --bsHeights=30:60:5 --distances=100:5000:10'
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include "empirical-propagation-loss-paths.h"
+
+using namespace ns3;
+using namespace std;
+
+NS_LOG_COMPONENT_DEFINE ("EmpiricalPropagationLossSweep");
+
+const char *environments[3] = { "urban", "suburban", "rural" };
+const char *modelNames[3] = { "Ericsson", "SUI", "ECC-33" };
+const double pathBsHeights[3] = { urbanBsHeight, suburbanBsHeight, ruralBsHeight };
+const uint32_t cacheLine = 64;
+
+/// One (environment, model, frequency, BS height) combination of the sweep
+struct SweepJob
+{
+  uint32_t environment; //!< index in environments
+  uint32_t model; //!< index in modelNames
+  double frequency; //!< frequency [Hz]
+  double bsHeight; //!< BS antenna height [m]
+};
+
+/// The positions (x, y) of the mobile station, the BS being at the origin
+struct SweepPoints
+{
+  vector<double> x; //!< x coordinates [m]
+  vector<double> y; //!< y coordinates [m]
+};
+
+/**
+ * The rows of the shared result region. Each row starts on its own cache
+ * line with its done flag, followed by the distances and the losses of
+ * its points, and is padded up to the next cache line, so that two workers
+ * never write to the same line.
+ */
+class SweepRegion
+{
+public:
+  /**
+   * \param nPoints the largest number of points of a job
+   */
+  SweepRegion (uint32_t nPoints)
+    : m_base (0),
+      m_nPoints (nPoints)
+  {
+    m_stride = (cacheLine + 2 * nPoints * sizeof (double) + cacheLine - 1) / cacheLine * cacheLine;
+  }
+  /**
+   * \param nRows the number of rows
+   * \returns the size of the region [bytes]
+   */
+  size_t GetSize (size_t nRows) const
+  {
+    return nRows * m_stride;
+  }
+  /**
+   * \param base the start of the mapping, page aligned
+   */
+  void SetBase (void *base)
+  {
+    m_base = static_cast<char *> (base);
+  }
+  /**
+   * \param row the index of a job
+   * \returns the flag set by the worker once the row is written
+   */
+  uint32_t * GetDone (uint32_t row) const
+  {
+    return reinterpret_cast<uint32_t *> (m_base + row * m_stride);
+  }
+  /**
+   * \param row the index of a job
+   * \returns the 3D BS-SS distances of the row [m]
+   */
+  double * GetDistance (uint32_t row) const
+  {
+    return reinterpret_cast<double *> (m_base + row * m_stride + cacheLine);
+  }
+  /**
+   * \param row the index of a job
+   * \returns the losses of the row [dB]
+   */
+  double * GetLoss (uint32_t row) const
+  {
+    return GetDistance (row) + m_nPoints;
+  }
+
+private:
+  char *m_base; //!< start of the mapping
+  uint32_t m_nPoints; //!< largest number of points of a job
+  size_t m_stride; //!< bytes between two rows, a multiple of the cache line
+};
+
+/**
+ * \param list values and first:last:step ranges, separated by commas
+ * \param values the values of the list, in order
+ * \returns whether the list is valid
+ */
+bool
+ParseValues (const string &list, vector<double> &values)
+{
+  istringstream iss (list);
+  string token;
+  while (getline (iss, token, ','))
+    {
+      double first;
+      double last;
+      double step;
+      char colon1;
+      char colon2;
+      istringstream range (token);
+      if (range >> first >> colon1 >> last >> colon2 >> step && colon1 == ':' && colon2 == ':')
+        {
+          if (!(step > 0) || !(last >= first))
+            {
+              return false;
+            }
+          // the last value is included when it falls on the step
+          uint32_t n = static_cast<uint32_t> ((last - first) / step + 1e-9) + 1;
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              values.push_back (first + i * step);
+            }
+        }
+      else
+        {
+          char *end;
+          double value = strtod (token.c_str (), &end);
+          if (end == token.c_str () || *end != '\0')
+            {
+              return false;
+            }
+          values.push_back (value);
+        }
+    }
+  return !values.empty ();
+}
+
+Ptr<PropagationLossModel>
+CreateModel (const SweepJob &job, double ssHeight)
+{
+  double hb = job.bsHeight;
+  if (job.model == 0)
+    {
+      Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+      ericsson->SetFrequency (job.frequency);
+      ericsson->SetTxAntennaHeight (hb);
+      ericsson->SetRxAntennaHeight (ssHeight);
+      const EricssonPropagationLossModel::Environment env[3] = {
+        EricssonPropagationLossModel::Urban, EricssonPropagationLossModel::Suburban, EricssonPropagationLossModel::Rural
+      };
+      ericsson->SetEnvironment (env[job.environment]);
+      return ericsson;
+    }
+  if (job.model == 1)
+    {
+      Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+      sui->SetLambda (3e8 / job.frequency);
+      sui->SetBSAntennaHeight (hb);
+      sui->SetSSAntennaHeight (ssHeight);
+      const SUIPropagationLossModel::Terrain terrain[3] = {
+        SUIPropagationLossModel::A, SUIPropagationLossModel::B, SUIPropagationLossModel::C
+      };
+      sui->SetTerrain (terrain[job.environment]);
+      return sui;
+    }
+  Ptr<ECC33PropagationLossModel> ecc33 = CreateObject<ECC33PropagationLossModel> ();
+  ecc33->SetFrequency (job.frequency);
+  ecc33->SetTxAntennaHeight (hb);
+  ecc33->SetRxAntennaHeight (ssHeight);
+  ecc33->SetEnvironment (job.environment == 0 ? ECC33PropagationLossModel::Urban : ECC33PropagationLossModel::Suburban);
+  return ecc33;
+}
+
+void
+RunShard (const vector<SweepJob> &jobs, const SweepPoints *points, double ssHeight,
+          const SweepRegion &region, uint32_t worker, uint32_t nWorkers)
+{
+  Ptr<MobilityModel> bs = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> ss = CreateObject<ConstantPositionMobilityModel> ();
+  for (uint32_t i = worker; i < jobs.size (); i += nWorkers)
+    {
+      const SweepPoints &path = points[jobs[i].environment];
+      Ptr<PropagationLossModel> model = CreateModel (jobs[i], ssHeight);
+      double *distance = region.GetDistance (i);
+      double *loss = region.GetLoss (i);
+      bs->SetPosition (Vector (0.0, 0.0, jobs[i].bsHeight));
+      for (uint32_t j = 0; j < path.x.size (); ++j)
+        {
+          ss->SetPosition (Vector (path.x[j], path.y[j], ssHeight));
+          distance[j] = bs->GetDistanceFrom (ss);
+          loss[j] = 47 - model->CalcRxPower (47, bs, ss);
+        }
+      *region.GetDone (i) = 1;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nWorkers = sysconf (_SC_NPROCESSORS_ONLN);
+  string frequencies = "700e6,900e6,1.8e9,2.1e9,2.6e9,3.5e9";
+  string bsHeights = "";
+  string distances = "";
+  double ssHeight = 1.0;
+  string filename = "propagation-loss-sweep.csv";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("workers", "Number of worker processes", nWorkers);
+  cmd.AddValue ("frequencies", "Carrier frequencies [Hz]", frequencies);
+  cmd.AddValue ("bsHeights", "BS antenna heights, empty for the height of each path [m]", bsHeights);
+  cmd.AddValue ("distances", "Horizontal BS-SS distances, empty for the path of each environment [m]", distances);
+  cmd.AddValue ("ssHeight", "SS antenna height [m]", ssHeight);
+  cmd.AddValue ("output", "Output CSV file", filename);
+  cmd.Parse (argc, argv);
+
+  vector<double> frequencyValues;
+  if (!ParseValues (frequencies, frequencyValues))
+    {
+      cout << "Invalid frequencies '" << frequencies << "'" << endl;
+      return 1;
+    }
+  vector<double> heightValues;
+  if (!bsHeights.empty () && !ParseValues (bsHeights, heightValues))
+    {
+      cout << "Invalid BS heights '" << bsHeights << "'" << endl;
+      return 1;
+    }
+  vector<double> distanceValues;
+  if (!distances.empty () && !ParseValues (distances, distanceValues))
+    {
+      cout << "Invalid distances '" << distances << "'" << endl;
+      return 1;
+    }
+
+  // the points of each environment: the distances along the x axis, or its path
+  SweepPoints points[3];
+  const double (*paths[3])[2] = { urban, suburban, rural };
+  for (uint32_t env = 0; env < 3; env++)
+    {
+      if (distanceValues.empty ())
+        {
+          for (int j = 0; j < nPathPoints; ++j)
+            {
+              points[env].x.push_back (paths[env][j][0]);
+              points[env].y.push_back (paths[env][j][1]);
+            }
+        }
+      else
+        {
+          points[env].x = distanceValues;
+          points[env].y.assign (distanceValues.size (), 0.0);
+        }
+    }
+
+  vector<SweepJob> jobs;
+  for (uint32_t f = 0; f < frequencyValues.size (); f++)
+    {
+      if (!(frequencyValues[f] > 0))
+        {
+          cout << "Invalid frequency " << frequencyValues[f] << endl;
+          return 1;
+        }
+      for (uint32_t env = 0; env < 3; env++)
+        {
+          vector<double> hb = heightValues.empty () ? vector<double> (1, pathBsHeights[env]) : heightValues;
+          for (uint32_t h = 0; h < hb.size (); h++)
+            {
+              // no rural variant of ECC-33
+              for (uint32_t model = 0; model < (env == 2 ? 2u : 3u); model++)
+                {
+                  SweepJob job = { env, model, frequencyValues[f], hb[h] };
+                  jobs.push_back (job);
+                }
+            }
+        }
+    }
+  if (nWorkers == 0 || jobs.empty ())
+    {
+      cout << "Nothing to do" << endl;
+      return 1;
+    }
+  if (nWorkers > jobs.size ())
+    {
+      nWorkers = jobs.size ();
+    }
+
+  // The segment is unlinked right away: the mapping survives in the parent
+  // and is inherited by the workers, and nothing is left in /dev/shm if a
+  // process crashes.
+  ostringstream shmName;
+  shmName << "/ns3-loss-sweep-" << getpid ();
+  // every environment has as many points
+  SweepRegion rows (points[0].x.size ());
+  size_t regionSize = rows.GetSize (jobs.size ());
+  int fd = shm_open (shmName.str ().c_str (), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0)
+    {
+      NS_FATAL_ERROR ("Can't create shared memory segment " << shmName.str ());
+    }
+  shm_unlink (shmName.str ().c_str ());
+  if (ftruncate (fd, regionSize) != 0)
+    {
+      close (fd);
+      NS_FATAL_ERROR ("Can't size shared memory segment to " << regionSize << " bytes");
+    }
+  void *region = mmap (0, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close (fd);
+  if (region == MAP_FAILED)
+    {
+      NS_FATAL_ERROR ("Can't map shared memory segment");
+    }
+  rows.SetBase (region);
+
+  vector<pid_t> workers;
+  for (uint32_t w = 0; w < nWorkers; w++)
+    {
+      pid_t pid = fork ();
+      if (pid < 0)
+        {
+          NS_FATAL_ERROR ("fork failed after " << w << " workers");
+        }
+      if (pid == 0)
+        {
+          RunShard (jobs, points, ssHeight, rows, w, nWorkers);
+          // skip the static destructors and stdio buffers of the parent
+          _exit (0);
+        }
+      workers.push_back (pid);
+    }
+
+  bool failed = false;
+  for (uint32_t w = 0; w < workers.size (); w++)
+    {
+      int status;
+      if (waitpid (workers[w], &status, 0) < 0 || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        {
+          cout << "Worker " << w << " failed" << endl;
+          failed = true;
+        }
+    }
+
+  std::ofstream outfile (filename.c_str ());
+  outfile << "environment,model,frequency,bsHeight,distance,loss\n";
+  for (uint32_t i = 0; i < jobs.size (); i++)
+    {
+      if (!*rows.GetDone (i))
+        {
+          failed = true;
+          continue;
+        }
+      const double *distance = rows.GetDistance (i);
+      const double *loss = rows.GetLoss (i);
+      for (uint32_t j = 0; j < points[jobs[i].environment].x.size (); ++j)
+        {
+          outfile << environments[jobs[i].environment] << "," << modelNames[jobs[i].model] << ","
+                  << jobs[i].frequency << "," << jobs[i].bsHeight << "," << distance[j] << "," << loss[j] << "\n";
+        }
+    }
+  munmap (region, regionSize);
+
+  cout << jobs.size () << " jobs on " << nWorkers << " workers written to " << filename << endl;
+  return failed ? 1 : 0;
+}
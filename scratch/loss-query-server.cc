@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Local loss query daemon: serves the losses of the ECC-33 (model 0),
+ * Ericsson (model 1) and SUI (model 2) models in one environment over a
+ * Unix domain socket, until SIGINT or SIGTERM. See LossQueryServer for
+ * the frames.
+ *
+ *   ./waf --run 'loss-query-server --socket=/tmp/loss.sock --environment=suburban --window=2'
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/string.h"
+#include <iostream>
+#include <string>
+#include <csignal>
+
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include "ns3/loss-query-server.h"
+
+using namespace ns3;
+using namespace std;
+
+NS_LOG_COMPONENT_DEFINE ("LossQueryServerExample");
+
+static LossQueryServer *g_server = 0;
+
+void
+HandleSignal (int signal)
+{
+  if (g_server != 0)
+    {
+      g_server->Stop ();
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  string socketPath = "/tmp/ns3-loss-query.sock";
+  string env = "urban";
+  uint32_t window = 0;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("socket", "Path of the listening socket", socketPath);
+  cmd.AddValue ("environment", "Environment type", env);
+  cmd.AddValue ("window", "Maximum wait for more requests before a batch [ms]", window);
+  cmd.Parse (argc, argv);
+
+  uint32_t environment;
+  if (env == "urban")
+    {
+      environment = 0;
+    }
+  else if (env == "suburban")
+    {
+      environment = 1;
+    }
+  else if (env == "rural")
+    {
+      environment = 2;
+    }
+  else
+    {
+      cout << "Invalid environment type. Please enter 'urban', 'suburban', or 'rural.'" << endl;
+      return 1;
+    }
+
+  Ptr<ECC33PropagationLossModel> ecc33 = CreateObject<ECC33PropagationLossModel> ();
+  ecc33->SetEnvironment (environment == 0 ? ECC33PropagationLossModel::Urban : ECC33PropagationLossModel::Suburban);
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  const EricssonPropagationLossModel::Environment ericssonEnv[3] = {
+    EricssonPropagationLossModel::Urban, EricssonPropagationLossModel::Suburban, EricssonPropagationLossModel::Rural
+  };
+  ericsson->SetEnvironment (ericssonEnv[environment]);
+  Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+  const SUIPropagationLossModel::Terrain terrain[3] = {
+    SUIPropagationLossModel::A, SUIPropagationLossModel::B, SUIPropagationLossModel::C
+  };
+  sui->SetTerrain (terrain[environment]);
+
+  Ptr<LossQueryServer> server = CreateObject<LossQueryServer> ();
+  server->SetAttribute ("SocketPath", StringValue (socketPath));
+  server->SetAttribute ("BatchWindow", TimeValue (MilliSeconds (window)));
+  server->AddModel (ecc33);
+  server->AddModel (ericsson);
+  server->AddModel (sui);
+  server->Start ();
+
+  g_server = PeekPointer (server);
+  signal (SIGINT, HandleSignal);
+  signal (SIGTERM, HandleSignal);
+  cout << "Serving ECC-33 (0), Ericsson (1) and SUI (2) " << env << " losses on " << socketPath << endl;
+  server->Run ();
+  g_server = 0;
+
+  cout << server->GetNBatches () << " batches" << endl;
+  server->Dispose ();
+  return 0;
+}
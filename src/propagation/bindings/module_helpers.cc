@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+ * Batch methods of the empirical models for Python, registered by
+ * modulegen_customizations.py. The arrays are taken through the buffer
+ * protocol without a copy, and the losses are written into an array of
+ * the caller, with the GIL released:
+ *
+ *   distance = numpy.linspace (100.0, 5000.0, 1000000)
+ *   loss = numpy.empty_like (distance)
+ *   model.GetLossBatch (distance, loss)
+ */
+
+#include "ns3module.h"
+#include "ns3/empirical-propagation-loss-model.h"
+#include "ns3/clutter-raster.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/// Number of position links converted to distances at a time
+const uint32_t POSITION_CHUNK = 4096;
+
+/**
+ * Move the current Python error to return_exception, so that pybindgen
+ * can try the other overloads of the method
+ * \param return_exception the error of this overload
+ * \returns NULL
+ */
+PyObject *
+Fail (PyObject **return_exception)
+{
+  PyObject *type;
+  PyObject *traceback;
+  PyErr_Fetch (&type, return_exception, &traceback);
+  Py_XDECREF (type);
+  Py_XDECREF (traceback);
+  return NULL;
+}
+
+/**
+ * \brief A C-contiguous buffer of a NumPy array, or of any other buffer
+ * exporter, released with the object
+ */
+class Buffer
+{
+public:
+  Buffer ()
+    : m_valid (false)
+  {
+  }
+  ~Buffer ()
+  {
+    if (m_valid)
+      {
+        PyBuffer_Release (&m_view);
+      }
+  }
+
+  /**
+   * \param object the exporter
+   * \param format the struct format of the items, 'd' or 'B'
+   * \param writable whether the buffer is written
+   * \param name the name of the argument, for the errors
+   * \returns false, with a Python error set, if object doesn't export a
+   *          suitable buffer
+   */
+  bool Get (PyObject *object, char format, bool writable, const char *name)
+  {
+    int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+    if (PyObject_GetBuffer (object, &m_view, flags) != 0)
+      {
+        return false;
+      }
+    m_valid = true;
+    // native byte order, implicit or explicit
+    const uint16_t one = 1;
+    const char native = *reinterpret_cast<const char *> (&one) == 1 ? '<' : '>';
+    const char *f = m_view.format == NULL ? "B" : m_view.format;
+    if (*f == '@' || *f == '=' || *f == native)
+      {
+        ++f;
+      }
+    Py_ssize_t size = format == 'd' ? sizeof (double) : sizeof (uint8_t);
+    if (f[0] != format || f[1] != 0 || m_view.itemsize != size)
+      {
+        PyErr_Format (PyExc_TypeError, "%s must be a contiguous %s array", name,
+                      format == 'd' ? "float64" : "uint8");
+        return false;
+      }
+    return true;
+  }
+  /**
+   * \returns the number of items
+   */
+  Py_ssize_t GetCount (void) const
+  {
+    return m_view.len / m_view.itemsize;
+  }
+  /**
+   * \returns the items
+   */
+  void * GetData (void) const
+  {
+    return m_view.buf;
+  }
+
+private:
+  Py_buffer m_view; //!< the exported buffer
+  bool m_valid; //!< whether m_view must be released
+};
+
+/**
+ * \param n a number of links
+ * \returns false, with a Python error set, if the batch methods can't
+ *          take n links
+ */
+bool
+CheckCount (Py_ssize_t n)
+{
+  if (n > static_cast<Py_ssize_t> (UINT32_MAX))
+    {
+      PyErr_SetString (PyExc_ValueError, "too many links for one batch");
+      return false;
+    }
+  return true;
+}
+
+} // anonymous namespace
+
+/**
+ * EmpiricalPropagationLossModel.GetLossBatch (distance, loss, clutter=None)
+ *
+ * \param distance float64 array of link distances [m]
+ * \param loss float64 array of the same size, filled with the losses
+ * \param clutter optional uint8 array of the same size, the
+ *        ns3::ClutterRaster::ClutterClass of each receiver
+ */
+PyObject *
+_wrap_EmpiricalPropagationLossModel_GetLossBatch (PyNs3EmpiricalPropagationLossModel *self,
+                                                  PyObject *args, PyObject *kwargs,
+                                                  PyObject **return_exception)
+{
+  PyObject *distanceObject;
+  PyObject *lossObject;
+  PyObject *clutterObject = NULL;
+  const char *keywords[] = { "distance", "loss", "clutter", NULL };
+  if (!PyArg_ParseTupleAndKeywords (args, kwargs, "OO|O", const_cast<char **> (keywords),
+                                    &distanceObject, &lossObject, &clutterObject))
+    {
+      return Fail (return_exception);
+    }
+
+  Buffer distance;
+  Buffer loss;
+  Buffer clutter;
+  if (!distance.Get (distanceObject, 'd', false, "distance")
+      || !loss.Get (lossObject, 'd', true, "loss"))
+    {
+      return Fail (return_exception);
+    }
+  bool mixed = clutterObject != NULL && clutterObject != Py_None;
+  if (mixed && !clutter.Get (clutterObject, 'B', false, "clutter"))
+    {
+      return Fail (return_exception);
+    }
+  Py_ssize_t n = distance.GetCount ();
+  if (loss.GetCount () != n || (mixed && clutter.GetCount () != n))
+    {
+      PyErr_SetString (PyExc_ValueError, "the arrays must have the same size");
+      return Fail (return_exception);
+    }
+  if (!CheckCount (n))
+    {
+      return Fail (return_exception);
+    }
+
+  const ns3::EmpiricalPropagationLossModel *model = self->obj;
+  const double *d = static_cast<const double *> (distance.GetData ());
+  const uint8_t *c = static_cast<const uint8_t *> (clutter.GetData ());
+  double *l = static_cast<double *> (loss.GetData ());
+  Py_BEGIN_ALLOW_THREADS
+  if (mixed)
+    {
+      model->GetLossBatch (d, c, l, n);
+    }
+  else
+    {
+      model->GetLossBatch (d, l, n);
+    }
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
+
+/**
+ * EmpiricalPropagationLossModel.GetLossBatchPositions (tx, rx, loss)
+ *
+ * Models with a clutter raster use the class at each Rx position.
+ *
+ * \param tx float64 array of Tx positions [m], (x, y, z) per link, or a
+ *        single (x, y, z) shared by all the links
+ * \param rx float64 array of Rx positions [m], (x, y, z) per link
+ * \param loss float64 array with one item per link, filled with the
+ *        losses
+ */
+PyObject *
+_wrap_EmpiricalPropagationLossModel_GetLossBatchPositions (PyNs3EmpiricalPropagationLossModel *self,
+                                                           PyObject *args, PyObject *kwargs,
+                                                           PyObject **return_exception)
+{
+  PyObject *txObject;
+  PyObject *rxObject;
+  PyObject *lossObject;
+  const char *keywords[] = { "tx", "rx", "loss", NULL };
+  if (!PyArg_ParseTupleAndKeywords (args, kwargs, "OOO", const_cast<char **> (keywords),
+                                    &txObject, &rxObject, &lossObject))
+    {
+      return Fail (return_exception);
+    }
+
+  Buffer tx;
+  Buffer rx;
+  Buffer loss;
+  if (!tx.Get (txObject, 'd', false, "tx")
+      || !rx.Get (rxObject, 'd', false, "rx")
+      || !loss.Get (lossObject, 'd', true, "loss"))
+    {
+      return Fail (return_exception);
+    }
+  Py_ssize_t n = loss.GetCount ();
+  if (rx.GetCount () != 3 * n || (tx.GetCount () != 3 * n && tx.GetCount () != 3))
+    {
+      PyErr_SetString (PyExc_ValueError, "rx must hold 3 coordinates per loss, and tx 3 or as many as rx");
+      return Fail (return_exception);
+    }
+  if (!CheckCount (n))
+    {
+      return Fail (return_exception);
+    }
+
+  const ns3::EmpiricalPropagationLossModel *model = self->obj;
+  // the reference count of Ptr isn't atomic: take the raster with the GIL
+  const ns3::ClutterRaster *raster = ns3::PeekPointer (model->GetClutterRaster ());
+  const double *t = static_cast<const double *> (tx.GetData ());
+  const double *r = static_cast<const double *> (rx.GetData ());
+  double *l = static_cast<double *> (loss.GetData ());
+  size_t txStride = tx.GetCount () == 3 ? 0 : 3;
+  uint32_t chunk = std::min<Py_ssize_t> (n, POSITION_CHUNK);
+  std::vector<double> distance (chunk);
+  std::vector<uint8_t> clutter (raster == NULL ? 0 : chunk);
+
+  Py_BEGIN_ALLOW_THREADS
+  for (Py_ssize_t begin = 0; begin < n; begin += chunk)
+    {
+      uint32_t m = std::min<Py_ssize_t> (n - begin, chunk);
+      for (uint32_t i = 0; i < m; ++i)
+        {
+          const double *a = t + (begin + i) * txStride;
+          const double *b = r + (begin + i) * 3;
+          double dx = b[0] - a[0];
+          double dy = b[1] - a[1];
+          double dz = b[2] - a[2];
+          distance[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+          if (raster != NULL)
+            {
+              clutter[i] = raster->GetClass (ns3::Vector (b[0], b[1], b[2]));
+            }
+        }
+      if (raster != NULL)
+        {
+          model->GetLossBatch (distance.data (), clutter.data (), l + begin, m);
+        }
+      else
+        {
+          model->GetLossBatch (distance.data (), l + begin, m);
+        }
+    }
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
@@ -0,0 +1,21 @@
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+
+# Batch methods of the empirical models that take NumPy arrays through the
+# buffer protocol, implemented in module_helpers.cc.
+
+WRAPPERS = [
+    ('GetLossBatch', '_wrap_EmpiricalPropagationLossModel_GetLossBatch'),
+    ('GetLossBatchPositions', '_wrap_EmpiricalPropagationLossModel_GetLossBatchPositions'),
+    ]
+
+def post_register_types(root_module):
+    for method, wrapper in WRAPPERS:
+        root_module.after_forward_declarations.writeln(
+            'PyObject * %s (PyNs3EmpiricalPropagationLossModel *self, PyObject *args, '
+            'PyObject *kwargs, PyObject **return_exception);' % wrapper)
+
+def post_register_methods(root_module):
+    model = root_module['ns3::EmpiricalPropagationLossModel']
+    for method, wrapper in WRAPPERS:
+        model.add_custom_method_wrapper(method, wrapper,
+                                        flags=['METH_VARARGS', 'METH_KEYWORDS'])
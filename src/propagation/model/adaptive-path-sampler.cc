@@ -0,0 +1,218 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/constant-position-mobility-model.h"
+#include <cmath>
+#include "adaptive-path-sampler.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AdaptivePathSampler");
+
+NS_OBJECT_ENSURE_REGISTERED (AdaptivePathSampler);
+
+TypeId
+AdaptivePathSampler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AdaptivePathSampler")
+    .SetParent<Object> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<AdaptivePathSampler> ()
+    .AddAttribute ("Tolerance",
+                   "The largest loss change of any model between two samples (default is 0.5 dB).",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&AdaptivePathSampler::m_tolerance),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MinSpacing",
+                   "The length below which a segment is not split any more, "
+                   "e.g. at a discontinuity of a model (default is 0.5 m).",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&AdaptivePathSampler::m_minSpacing),
+                   MakeDoubleChecker<double> (0.0));
+  return tid;
+}
+
+AdaptivePathSampler::AdaptivePathSampler ()
+  : m_transmitter (CreateObject<ConstantPositionMobilityModel> ()),
+    m_receiver (CreateObject<ConstantPositionMobilityModel> ())
+{
+}
+
+AdaptivePathSampler::~AdaptivePathSampler ()
+{
+}
+
+void
+AdaptivePathSampler::DoDispose (void)
+{
+  m_models.clear ();
+  m_transmitter = 0;
+  m_receiver = 0;
+  Object::DoDispose ();
+}
+
+void
+AdaptivePathSampler::SetTransmitter (const Vector &position)
+{
+  NS_LOG_FUNCTION (this << position);
+  m_transmitter->SetPosition (position);
+}
+
+uint32_t
+AdaptivePathSampler::AddModel (Ptr<PropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  NS_ABORT_MSG_IF (model == 0, "No model");
+  m_models.push_back (model);
+  m_positions.clear ();
+  m_losses.clear ();
+  return m_models.size () - 1;
+}
+
+uint32_t
+AdaptivePathSampler::GetNModels (void) const
+{
+  return m_models.size ();
+}
+
+void
+AdaptivePathSampler::Evaluate (const Vector &position, std::vector<double> &loss)
+{
+  m_receiver->SetPosition (position);
+  loss.resize (m_models.size ());
+  for (uint32_t k = 0; k < m_models.size (); ++k)
+    {
+      loss[k] = 0 - m_models[k]->CalcRxPower (0, m_transmitter, m_receiver);
+    }
+}
+
+void
+AdaptivePathSampler::Append (const Vector &position, const std::vector<double> &loss)
+{
+  m_positions.push_back (position);
+  m_losses.insert (m_losses.end (), loss.begin (), loss.end ());
+}
+
+void
+AdaptivePathSampler::Refine (const Vector &a, const std::vector<double> &lossA,
+                             const Vector &b, const std::vector<double> &lossB)
+{
+  if (CalculateDistance (a, b) <= m_minSpacing)
+    {
+      return;
+    }
+  double change = 0;
+  for (uint32_t k = 0; k < m_models.size (); ++k)
+    {
+      change = std::max (change, std::fabs (lossB[k] - lossA[k]));
+    }
+  if (!(change > m_tolerance))
+    {
+      return;
+    }
+  Vector middle ((a.x + b.x) / 2, (a.y + b.y) / 2, (a.z + b.z) / 2);
+  std::vector<double> lossMiddle;
+  Evaluate (middle, lossMiddle);
+  Refine (a, lossA, middle, lossMiddle);
+  Append (middle, lossMiddle);
+  Refine (middle, lossMiddle, b, lossB);
+}
+
+void
+AdaptivePathSampler::SampleLeg (const Vector &a, const std::vector<double> &lossA,
+                                const Vector &b, const std::vector<double> &lossB)
+{
+  // the closest point to the transmitter: the distance decreases before it
+  // and increases after it, so the midpoint test holds on each side
+  Vector transmitter = m_transmitter->GetPosition ();
+  Vector ab (b.x - a.x, b.y - a.y, b.z - a.z);
+  double length2 = ab.x * ab.x + ab.y * ab.y + ab.z * ab.z;
+  double t = 0;
+  if (length2 > 0)
+    {
+      t = ((transmitter.x - a.x) * ab.x + (transmitter.y - a.y) * ab.y + (transmitter.z - a.z) * ab.z) / length2;
+    }
+  Vector foot (a.x + t * ab.x, a.y + t * ab.y, a.z + t * ab.z);
+  if (!(t > 0 && t < 1) || CalculateDistance (a, foot) <= m_minSpacing || CalculateDistance (foot, b) <= m_minSpacing)
+    {
+      Refine (a, lossA, b, lossB);
+      return;
+    }
+  std::vector<double> lossFoot;
+  Evaluate (foot, lossFoot);
+  Refine (a, lossA, foot, lossFoot);
+  Append (foot, lossFoot);
+  Refine (foot, lossFoot, b, lossB);
+}
+
+void
+AdaptivePathSampler::Sample (const std::vector<Vector> &waypoints)
+{
+  NS_LOG_FUNCTION (this << waypoints.size ());
+  NS_ABORT_MSG_IF (m_models.empty (), "No model");
+  m_positions.clear ();
+  m_losses.clear ();
+  if (waypoints.empty ())
+    {
+      return;
+    }
+  std::vector<double> lossA;
+  std::vector<double> lossB;
+  Evaluate (waypoints[0], lossA);
+  Append (waypoints[0], lossA);
+  for (uint32_t w = 1; w < waypoints.size (); ++w)
+    {
+      Evaluate (waypoints[w], lossB);
+      SampleLeg (waypoints[w - 1], lossA, waypoints[w], lossB);
+      Append (waypoints[w], lossB);
+      lossA.swap (lossB);
+    }
+  NS_LOG_LOGIC (m_positions.size () << " samples for " << waypoints.size () << " waypoints");
+}
+
+uint32_t
+AdaptivePathSampler::GetNSamples (void) const
+{
+  return m_positions.size ();
+}
+
+Vector
+AdaptivePathSampler::GetPosition (uint32_t i) const
+{
+  NS_ASSERT (i < m_positions.size ());
+  return m_positions[i];
+}
+
+double
+AdaptivePathSampler::GetDistance (uint32_t i) const
+{
+  NS_ASSERT (i < m_positions.size ());
+  return CalculateDistance (m_transmitter->GetPosition (), m_positions[i]);
+}
+
+double
+AdaptivePathSampler::GetLoss (uint32_t model, uint32_t i) const
+{
+  NS_ASSERT (model < m_models.size () && i < m_positions.size ());
+  return m_losses[static_cast<size_t> (i) * m_models.size () + model];
+}
+
+}
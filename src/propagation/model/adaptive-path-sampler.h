@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef ADAPTIVE_PATH_SAMPLER_H
+#define ADAPTIVE_PATH_SAMPLER_H
+
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/vector.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/mobility-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Sample the losses of several models along a path, densely only
+ * where they change quickly
+ *
+ * The path is a polyline of waypoints, and every waypoint is a sample.
+ * A leg passing the transmitter is first split at the point closest to
+ * it, the foot of the perpendicular from the transmitter, which is also
+ * a sample: the distance, and hence the loss, is then monotone on each
+ * piece. Each segment between two samples is split at its middle as long as
+ * the loss of any model changes by more than Tolerance between its two
+ * ends, and it is longer than MinSpacing. All the models are evaluated
+ * at every sample, so they share the samples and can be plotted
+ * together.
+ *
+ * Between two consecutive samples, the losses of the models then differ
+ * by at most Tolerance, so along any stretch where a loss is monotone
+ * (e.g. a path moving away from the transmitter) the straight line
+ * between the samples is within Tolerance of the model. Near the
+ * transmitter, where log10 of the distance is steep, the samples are
+ * dense; far from it, a few samples cover kilometers.
+ */
+class AdaptivePathSampler : public Object
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  AdaptivePathSampler ();
+  virtual ~AdaptivePathSampler ();
+
+  /**
+   * \param position the position of the transmitter
+   */
+  void SetTransmitter (const Vector &position);
+  /**
+   * \param model a model to evaluate along the path
+   * \returns the index of the model
+   */
+  uint32_t AddModel (Ptr<PropagationLossModel> model);
+  /**
+   * \returns the number of models
+   */
+  uint32_t GetNModels (void) const;
+
+  /**
+   * Sample a path, discarding the previous samples
+   * \param waypoints the positions of the receiver along the path
+   */
+  void Sample (const std::vector<Vector> &waypoints);
+
+  /**
+   * \returns the number of samples
+   */
+  uint32_t GetNSamples (void) const;
+  /**
+   * \param i the index of a sample
+   * \returns the position of the receiver
+   */
+  Vector GetPosition (uint32_t i) const;
+  /**
+   * \param i the index of a sample
+   * \returns the distance from the transmitter to the receiver [m]
+   */
+  double GetDistance (uint32_t i) const;
+  /**
+   * \param model the index of a model
+   * \param i the index of a sample
+   * \returns the loss of the model (positive, in dB)
+   */
+  double GetLoss (uint32_t model, uint32_t i) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  AdaptivePathSampler (const AdaptivePathSampler &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  AdaptivePathSampler & operator = (const AdaptivePathSampler &);
+
+  /**
+   * Evaluate every model at a receiver position
+   * \param position the receiver position
+   * \param loss the losses of the models (positive, in dB)
+   */
+  void Evaluate (const Vector &position, std::vector<double> &loss);
+  /**
+   * Add a sample
+   * \param position the receiver position
+   * \param loss the losses of the models
+   */
+  void Append (const Vector &position, const std::vector<double> &loss);
+  /**
+   * Add the samples strictly between two waypoints
+   * \param a the first waypoint
+   * \param lossA the losses at a
+   * \param b the second waypoint
+   * \param lossB the losses at b
+   */
+  void SampleLeg (const Vector &a, const std::vector<double> &lossA,
+                  const Vector &b, const std::vector<double> &lossB);
+  /**
+   * Add the samples strictly between the ends of a segment
+   * \param a the first end
+   * \param lossA the losses at a
+   * \param b the second end
+   * \param lossB the losses at b
+   */
+  void Refine (const Vector &a, const std::vector<double> &lossA,
+               const Vector &b, const std::vector<double> &lossB);
+
+  double m_tolerance; //!< largest loss change between two samples [dB]
+  double m_minSpacing; //!< length below which a segment is not split [m]
+
+  std::vector<Ptr<PropagationLossModel> > m_models; //!< the models
+  Ptr<MobilityModel> m_transmitter; //!< position of the transmitter
+  Ptr<MobilityModel> m_receiver; //!< position of the receiver, moved along the path
+  std::vector<Vector> m_positions; //!< positions of the samples
+  std::vector<double> m_losses; //!< losses, sample-major: m_losses[i * models + model]
+};
+
+}
+
+#endif /* ADAPTIVE_PATH_SAMPLER_H */
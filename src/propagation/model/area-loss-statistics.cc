@@ -0,0 +1,616 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "clutter-raster.h"
+#include "area-loss-statistics.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AreaLossStatistics");
+
+NS_OBJECT_ENSURE_REGISTERED (AreaLossStatistics);
+
+namespace {
+
+/**
+ * \param state the state of the generator, advanced
+ * \returns the next 64 random bits (SplitMix64)
+ */
+inline uint64_t
+NextRandom (uint64_t &state)
+{
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * \param state the state of the generator, advanced
+ * \returns a uniform random number in [0, 1)
+ */
+inline double
+NextUniform (uint64_t &state)
+{
+  return (NextRandom (state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * \param confidence the level of a two-sided interval, in (0, 1)
+ * \returns the standard normal quantile of (1 + confidence) / 2
+ */
+double
+GetNormalQuantile (double confidence)
+{
+  double target = (1 + confidence) / 2;
+  double lo = 0;
+  double hi = 40;
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      double mid = (lo + hi) / 2;
+      if (0.5 * std::erfc (-mid / std::sqrt (2.0)) < target)
+        {
+          lo = mid;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+  return (lo + hi) / 2;
+}
+
+} // anonymous namespace
+
+LossHistogram::LossHistogram (double min, double max, double binWidth)
+  : m_min (min),
+    m_binWidth (binWidth),
+    m_count (0)
+{
+  NS_ABORT_MSG_IF (!(binWidth > 0) || !(max > min), "Empty histogram range");
+  m_nBins = static_cast<uint32_t> (std::ceil ((max - min) / binWidth - 1e-9));
+  m_counts.assign (m_nBins + 2, 0);
+}
+
+void
+LossHistogram::Add (double loss)
+{
+  uint32_t bin = 0;
+  if (loss >= m_min)
+    {
+      double position = (loss - m_min) / m_binWidth;
+      bin = position < m_nBins ? static_cast<uint32_t> (position) + 1 : m_nBins + 1;
+    }
+  m_counts[bin]++;
+  m_count++;
+}
+
+void
+LossHistogram::Add (const double *loss, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Add (loss[i]);
+    }
+}
+
+void
+LossHistogram::Merge (const LossHistogram &other)
+{
+  NS_ABORT_MSG_IF (other.m_min != m_min || other.m_binWidth != m_binWidth || other.m_nBins != m_nBins,
+                   "Histograms with different bins");
+  for (uint32_t b = 0; b < m_counts.size (); ++b)
+    {
+      m_counts[b] += other.m_counts[b];
+    }
+  m_count += other.m_count;
+}
+
+void
+LossHistogram::Clear (void)
+{
+  std::fill (m_counts.begin (), m_counts.end (), 0);
+  m_count = 0;
+}
+
+uint64_t
+LossHistogram::GetCount (void) const
+{
+  return m_count;
+}
+
+double
+LossHistogram::GetCdf (double loss) const
+{
+  // the underflow is at min and the overflow at max
+  if (m_count == 0 || loss < m_min)
+    {
+      return 0;
+    }
+  double position = (loss - m_min) / m_binWidth;
+  if (position >= m_nBins)
+    {
+      return 1;
+    }
+  uint32_t last = static_cast<uint32_t> (position);
+  double below = m_counts[0];
+  for (uint32_t b = 0; b < last; ++b)
+    {
+      below += m_counts[b + 1];
+    }
+  below += m_counts[last + 1] * (position - last);
+  return below / m_count;
+}
+
+double
+LossHistogram::GetQuantile (double p) const
+{
+  NS_ASSERT (m_count > 0 && p >= 0 && p <= 1);
+  double target = p * m_count;
+  double below = m_counts[0];
+  if (target <= below)
+    {
+      return m_min;
+    }
+  for (uint32_t b = 0; b < m_nBins; ++b)
+    {
+      double count = m_counts[b + 1];
+      if (below + count >= target)
+        {
+          return m_min + (b + (target - below) / count) * m_binWidth;
+        }
+      below += count;
+    }
+  return m_min + m_nBins * m_binWidth;
+}
+
+TypeId
+AreaLossStatistics::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AreaLossStatistics")
+    .SetParent<Object> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<AreaLossStatistics> ()
+    .AddAttribute ("Sampling",
+                   "The locations of the area: the centers of a grid, or uniform random locations (default is Grid).",
+                   EnumValue (AreaLossStatistics::Grid),
+                   MakeEnumAccessor (&AreaLossStatistics::m_sampling),
+                   MakeEnumChecker (AreaLossStatistics::Grid, "Grid",
+                                    AreaLossStatistics::Random, "Random"))
+    .AddAttribute ("GridSpacing",
+                   "The spacing of the Grid locations (default is 25 m).",
+                   DoubleValue (25.0),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_gridSpacing),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MaxSamples",
+                   "The largest number of Random locations (default is 10000000).",
+                   UintegerValue (10000000),
+                   MakeUintegerAccessor (&AreaLossStatistics::m_maxSamples),
+                   MakeUintegerChecker<uint64_t> (1))
+    .AddAttribute ("Precision",
+                   "The half width of the confidence interval of the coverage at which a Random run stops, "
+                   "0 not to stop on the coverage (default is 0.005).",
+                   DoubleValue (0.005),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_precision),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("QuantilePrecision",
+                   "The half width of the confidence interval of PrecisionQuantile at which a Random run stops, "
+                   "0 not to stop on the quantile (default is 0 dB).",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_quantilePrecision),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("PrecisionQuantile",
+                   "The quantile of the losses QuantilePrecision applies to (default is 0.5).",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_precisionQuantile),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("Confidence",
+                   "The level of the confidence intervals, also when a Random run stops on a precision "
+                   "(default is 0.95).",
+                   DoubleValue (0.95),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_confidence),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("CheckInterval",
+                   "The number of tiles between two checks of the precision (default is 16).",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&AreaLossStatistics::m_checkInterval),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Seed",
+                   "The seed of the Random locations (default is 1).",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&AreaLossStatistics::m_seed),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MinLoss",
+                   "The lower edge of the histograms (default is 0 dB).",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_minLoss),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxLoss",
+                   "The upper edge of the histograms (default is 250 dB).",
+                   DoubleValue (250.0),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_maxLoss),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("BinWidth",
+                   "The width of the bins of the histograms (default is 0.1 dB).",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_binWidth),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TxPowerDbm",
+                   "The transmission power of the site (default is 43 dBm).",
+                   DoubleValue (43.0),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_txPowerDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SensitivityDbm",
+                   "The received power a location needs to be covered (default is -95 dBm).",
+                   DoubleValue (-95.0),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_sensitivityDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("ReceiverHeight",
+                   "The height of the receivers, for the link distances (default is 1.5 m).",
+                   DoubleValue (1.5),
+                   MakeDoubleAccessor (&AreaLossStatistics::m_receiverHeight),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("TileSize",
+                   "The number of locations evaluated together (default is 4096).",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&AreaLossStatistics::m_tileSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Threads",
+                   "The number of threads, 0 for one per core (default is 0).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&AreaLossStatistics::m_threads),
+                   MakeUintegerChecker<uint32_t> ());
+  return tid;
+}
+
+AreaLossStatistics::AreaLossStatistics ()
+  : m_site (0.0, 0.0, 0.0),
+    m_xMin (0),
+    m_yMin (0),
+    m_xMax (0),
+    m_yMax (0),
+    m_nx (0),
+    m_nLocations (0),
+    m_nSamples (0),
+    m_converged (false),
+    m_z (0)
+{
+}
+
+AreaLossStatistics::~AreaLossStatistics ()
+{
+}
+
+void
+AreaLossStatistics::DoDispose (void)
+{
+  m_models.clear ();
+  m_peekModels.clear ();
+  m_peekRasters.clear ();
+  Object::DoDispose ();
+}
+
+void
+AreaLossStatistics::SetSite (const Vector &position)
+{
+  NS_LOG_FUNCTION (this << position);
+  m_site = position;
+}
+
+uint32_t
+AreaLossStatistics::AddModel (Ptr<EmpiricalPropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  NS_ABORT_MSG_IF (model == 0, "No model");
+  m_models.push_back (model);
+  m_histograms.clear ();
+  m_covered.clear ();
+  return m_models.size () - 1;
+}
+
+uint32_t
+AreaLossStatistics::GetNModels (void) const
+{
+  return m_models.size ();
+}
+
+void
+AreaLossStatistics::SetArea (double xMin, double yMin, double xMax, double yMax)
+{
+  NS_LOG_FUNCTION (this << xMin << yMin << xMax << yMax);
+  m_xMin = xMin;
+  m_yMin = yMin;
+  m_xMax = xMax;
+  m_yMax = yMax;
+}
+
+uint32_t
+AreaLossStatistics::GetTileLocations (uint64_t tile, double *x, double *y) const
+{
+  uint64_t begin = tile * m_tileSize;
+  uint32_t n = static_cast<uint32_t> (std::min<uint64_t> (m_tileSize, m_nLocations - begin));
+  if (m_sampling == Grid)
+    {
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          uint64_t cell = begin + i;
+          x[i] = m_xMin + (cell % m_nx + 0.5) * m_gridSpacing;
+          y[i] = m_yMin + (cell / m_nx + 0.5) * m_gridSpacing;
+        }
+    }
+  else
+    {
+      // one stream per tile, whichever thread evaluates it
+      uint64_t state = (static_cast<uint64_t> (m_seed) << 40) ^ tile;
+      double width = m_xMax - m_xMin;
+      double height = m_yMax - m_yMin;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          x[i] = m_xMin + NextUniform (state) * width;
+          y[i] = m_yMin + NextUniform (state) * height;
+        }
+    }
+  return n;
+}
+
+void
+AreaLossStatistics::Worker (std::atomic<uint64_t> *nextTile, uint64_t endTile,
+                            std::vector<LossHistogram> *histograms, uint64_t *covered) const
+{
+  std::vector<double> x (m_tileSize);
+  std::vector<double> y (m_tileSize);
+  std::vector<double> distance (m_tileSize);
+  std::vector<double> loss (m_tileSize);
+  std::vector<uint8_t> clutter (m_tileSize);
+  double threshold = m_sensitivityDbm - m_txPowerDbm;
+  double dz = m_site.z - m_receiverHeight;
+  while (true)
+    {
+      uint64_t tile = nextTile->fetch_add (1);
+      if (tile >= endTile)
+        {
+          return;
+        }
+      uint32_t n = GetTileLocations (tile, x.data (), y.data ());
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          double dx = x[i] - m_site.x;
+          double dy = y[i] - m_site.y;
+          distance[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+        }
+      const ClutterRaster *classified = 0;
+      for (uint32_t k = 0; k < m_peekModels.size (); ++k)
+        {
+          const ClutterRaster *raster = m_peekRasters[k];
+          if (raster == 0)
+            {
+              m_peekModels[k]->GetLossBatch (distance.data (), loss.data (), n);
+            }
+          else
+            {
+              // the models of several environments usually share a raster
+              if (raster != classified)
+                {
+                  raster->GetClasses (x.data (), y.data (), clutter.data (), n);
+                  classified = raster;
+                }
+              m_peekModels[k]->GetLossBatch (distance.data (), clutter.data (), loss.data (), n);
+            }
+          uint64_t count = 0;
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              count += loss[i] >= threshold;
+              loss[i] = -loss[i];
+            }
+          covered[k] += count;
+          (*histograms)[k].Add (loss.data (), n);
+        }
+    }
+}
+
+void
+AreaLossStatistics::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_models.empty (), "No model");
+  NS_ABORT_MSG_IF (!(m_xMax > m_xMin) || !(m_yMax > m_yMin), "Empty area");
+  NS_ABORT_MSG_IF (!(m_confidence > 0) || !(m_confidence < 1), "Confidence must be in (0, 1)");
+  if (m_sampling == Grid)
+    {
+      NS_ABORT_MSG_IF (!(m_gridSpacing > 0), "No grid spacing");
+      m_nx = std::max (1u, static_cast<uint32_t> ((m_xMax - m_xMin) / m_gridSpacing));
+      uint32_t ny = std::max (1u, static_cast<uint32_t> ((m_yMax - m_yMin) / m_gridSpacing));
+      m_nLocations = static_cast<uint64_t> (m_nx) * ny;
+    }
+  else
+    {
+      m_nLocations = m_maxSamples;
+    }
+
+  // the workers only use raw pointers: the reference counts are not atomic
+  m_peekModels.clear ();
+  m_peekRasters.clear ();
+  for (uint32_t k = 0; k < m_models.size (); ++k)
+    {
+      m_peekModels.push_back (PeekPointer (m_models[k]));
+      m_peekRasters.push_back (PeekPointer (m_models[k]->GetClutterRaster ()));
+    }
+
+  uint32_t nModels = m_models.size ();
+  LossHistogram empty (m_minLoss, m_maxLoss, m_binWidth);
+  m_histograms.assign (nModels, empty);
+  m_covered.assign (nModels, 0);
+  m_nSamples = 0;
+  m_converged = false;
+
+  uint64_t tiles = (m_nLocations + m_tileSize - 1) / m_tileSize;
+  bool stopEarly = m_sampling == Random && (m_precision > 0 || m_quantilePrecision > 0);
+  uint64_t roundTiles = stopEarly ? m_checkInterval : tiles;
+  if (stopEarly)
+    {
+      // union bound over the planned checks: the interval at the round
+      // the run stops at keeps the Confidence level
+      uint64_t checks = (tiles + roundTiles - 1) / roundTiles;
+      m_z = GetNormalQuantile (1 - (1 - m_confidence) / checks);
+    }
+  else
+    {
+      m_z = GetNormalQuantile (m_confidence);
+    }
+  uint32_t threads = m_threads > 0 ? m_threads : std::max (1u, std::thread::hardware_concurrency ());
+  threads = static_cast<uint32_t> (std::min<uint64_t> (threads, roundTiles));
+  // one set of histograms per worker, merged after each round
+  std::vector<std::vector<LossHistogram> > histograms (threads, m_histograms);
+  std::vector<std::vector<uint64_t> > covered (threads, std::vector<uint64_t> (nModels, 0));
+
+  for (uint64_t begin = 0; begin < tiles; begin += roundTiles)
+    {
+      uint64_t end = std::min (begin + roundTiles, tiles);
+      std::atomic<uint64_t> nextTile (begin);
+      uint32_t roundThreads = static_cast<uint32_t> (std::min<uint64_t> (threads, end - begin));
+      if (roundThreads <= 1)
+        {
+          Worker (&nextTile, end, &histograms[0], covered[0].data ());
+        }
+      else
+        {
+          std::vector<std::thread> workers;
+          for (uint32_t t = 0; t < roundThreads; ++t)
+            {
+              workers.push_back (std::thread (&AreaLossStatistics::Worker, this, &nextTile, end,
+                                              &histograms[t], covered[t].data ()));
+            }
+          for (uint32_t t = 0; t < roundThreads; ++t)
+            {
+              workers[t].join ();
+            }
+        }
+      for (uint32_t t = 0; t < roundThreads; ++t)
+        {
+          for (uint32_t k = 0; k < nModels; ++k)
+            {
+              m_histograms[k].Merge (histograms[t][k]);
+              histograms[t][k].Clear ();
+              m_covered[k] += covered[t][k];
+              covered[t][k] = 0;
+            }
+        }
+      m_nSamples = std::min (end * m_tileSize, m_nLocations);
+
+      if (stopEarly)
+        {
+          bool reached = true;
+          for (uint32_t k = 0; k < nModels && reached; ++k)
+            {
+              reached = (m_precision == 0 || GetCoverageHalfWidth (k) <= m_precision)
+                && (m_quantilePrecision == 0 || GetQuantileHalfWidth (k) <= m_quantilePrecision);
+            }
+          if (reached)
+            {
+              m_converged = true;
+              break;
+            }
+        }
+    }
+  NS_LOG_LOGIC (m_nSamples << " of " << m_nLocations << " locations, converged " << m_converged);
+}
+
+uint64_t
+AreaLossStatistics::GetNSamples (void) const
+{
+  return m_nSamples;
+}
+
+bool
+AreaLossStatistics::HasConverged (void) const
+{
+  return m_converged;
+}
+
+const LossHistogram &
+AreaLossStatistics::GetHistogram (uint32_t model) const
+{
+  NS_ASSERT (model < m_histograms.size ());
+  return m_histograms[model];
+}
+
+double
+AreaLossStatistics::GetCoverage (uint32_t model) const
+{
+  NS_ASSERT (model < m_covered.size () && m_nSamples > 0);
+  return static_cast<double> (m_covered[model]) / m_nSamples;
+}
+
+double
+AreaLossStatistics::GetCoverageHalfWidth (uint32_t model) const
+{
+  double low;
+  double high;
+  GetCoverageBounds (model, low, high);
+  return (high - low) / 2;
+}
+
+double
+AreaLossStatistics::GetQuantileHalfWidth (uint32_t model) const
+{
+  double low;
+  double high;
+  GetQuantileBounds (model, m_precisionQuantile, low, high);
+  return (high - low) / 2;
+}
+
+void
+AreaLossStatistics::GetCoverageBounds (uint32_t model, double &low, double &high) const
+{
+  // Wilson score interval
+  double p = GetCoverage (model);
+  double n = static_cast<double> (m_nSamples);
+  double z2 = m_z * m_z;
+  double denominator = 1 + z2 / n;
+  double center = (p + z2 / (2 * n)) / denominator;
+  double half = m_z * std::sqrt (p * (1 - p) / n + z2 / (4 * n * n)) / denominator;
+  // the interval contains p, also after the rounding at p = 0 or 1
+  low = std::max (0.0, std::min (p, center - half));
+  high = std::min (1.0, std::max (p, center + half));
+}
+
+double
+AreaLossStatistics::GetQuantile (uint32_t model, double p) const
+{
+  return GetHistogram (model).GetQuantile (p);
+}
+
+void
+AreaLossStatistics::GetQuantileBounds (uint32_t model, double p, double &low, double &high) const
+{
+  // the rank of the quantile p among n samples is binomial (n, p)
+  const LossHistogram &histogram = GetHistogram (model);
+  double spread = m_z * std::sqrt (p * (1 - p) / histogram.GetCount ());
+  low = histogram.GetQuantile (std::max (0.0, p - spread));
+  high = histogram.GetQuantile (std::min (1.0, p + spread));
+}
+
+}
@@ -0,0 +1,303 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef AREA_LOSS_STATISTICS_H
+#define AREA_LOSS_STATISTICS_H
+
+#include <atomic>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/vector.h"
+#include "ns3/empirical-propagation-loss-model.h"
+
+namespace ns3 {
+
+class ClutterRaster;
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Fixed-width histogram of losses
+ *
+ * The bins span [min, max); a loss below min or from max on is counted
+ * in an underflow or overflow bin. Histograms with the same bins are
+ * merged by adding their counts, so the histograms of several threads
+ * sum to the histogram of all their losses, in any order.
+ */
+class LossHistogram
+{
+public:
+  /**
+   * \param min the lower edge of the first bin [dB]
+   * \param max the upper edge of the last bin [dB]
+   * \param binWidth the width of a bin [dB]
+   */
+  LossHistogram (double min, double max, double binWidth);
+
+  /**
+   * \param loss a loss [dB]
+   */
+  void Add (double loss);
+  /**
+   * \param loss the losses [dB]
+   * \param n the number of losses
+   */
+  void Add (const double *loss, uint32_t n);
+  /**
+   * \param other a histogram with the same bins
+   */
+  void Merge (const LossHistogram &other);
+  /**
+   * Reset the counts
+   */
+  void Clear (void);
+
+  /**
+   * \returns the number of losses
+   */
+  uint64_t GetCount (void) const;
+  /**
+   * \param loss a loss [dB]
+   * \returns the fraction of the losses at most loss, interpolated
+   *          within its bin
+   */
+  double GetCdf (double loss) const;
+  /**
+   * \param p a fraction in [0, 1]
+   * \returns the loss below which the fraction p of the losses lie,
+   *          interpolated within its bin [dB]
+   */
+  double GetQuantile (double p) const;
+
+private:
+  double m_min; //!< lower edge of the first bin [dB]
+  double m_binWidth; //!< width of a bin [dB]
+  uint32_t m_nBins; //!< number of bins between min and max
+  std::vector<uint64_t> m_counts; //!< underflow, the bins, then overflow
+  uint64_t m_count; //!< sum of the counts
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Distribution of the losses of empirical models over an area,
+ * without a raster
+ *
+ * The area is a rectangle around a site. Its locations are either the
+ * centers of a grid (Grid), or uniform random locations (Random). The
+ * locations are generated and evaluated a tile at a time, and each
+ * worker thread adds the losses of its tiles to its own histograms, one
+ * per model; the histograms of the threads are then merged. No array
+ * of the size of the area is allocated.
+ *
+ * For each model, the results are the histogram of the losses, the
+ * fraction of the locations whose received power reaches the
+ * sensitivity (counted exactly, not from the histogram), and
+ * confidence bounds of both. The bounds of the coverage are Wilson
+ * score intervals; those of a quantile come from the ranks of the
+ * binomial order statistics. They treat the locations as independent
+ * samples of the area, which the Random locations are.
+ *
+ * With Random locations and a positive Precision or QuantilePrecision,
+ * the tiles run in rounds of CheckInterval tiles, and the run stops
+ * after the first round where the confidence interval of the coverage
+ * of every model is at most Precision wide on each side, and that of
+ * its PrecisionQuantile at most QuantilePrecision, or after MaxSamples
+ * locations. Stopping on intervals checked after every round would
+ * make them too narrow, so such a run splits the error level
+ * 1 - Confidence evenly over the rounds it plans up to MaxSamples (a
+ * union bound): every interval, of the checks and of the results, is
+ * then at least at the Confidence level at whichever round the run
+ * stops, at the price of wider intervals, hence more locations, than
+ * a run of a fixed size. The locations of a tile only depend on Seed
+ * and its index, and the rounds are fixed, so the results do not
+ * depend on the number of threads.
+ */
+class AreaLossStatistics : public Object
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  AreaLossStatistics ();
+  virtual ~AreaLossStatistics ();
+
+  /**
+   * The locations of the area
+   */
+  enum Sampling
+  {
+    Grid,  //!< centers of the cells of a grid of GridSpacing
+    Random //!< uniform random locations
+  };
+
+  /**
+   * \param position the position of the site, for the link distances;
+   *        the models keep their own antenna heights
+   */
+  void SetSite (const Vector &position);
+  /**
+   * \param model a model of the site, e.g. one per environment
+   * \returns the index of the model
+   */
+  uint32_t AddModel (Ptr<EmpiricalPropagationLossModel> model);
+  /**
+   * \returns the number of models
+   */
+  uint32_t GetNModels (void) const;
+  /**
+   * \param xMin the lowest x coordinate of the area [m]
+   * \param yMin the lowest y coordinate of the area [m]
+   * \param xMax the highest x coordinate of the area [m]
+   * \param yMax the highest y coordinate of the area [m]
+   */
+  void SetArea (double xMin, double yMin, double xMax, double yMax);
+
+  /**
+   * Evaluate every model over the area
+   */
+  void Run (void);
+
+  /**
+   * \returns the number of locations evaluated by the last run
+   */
+  uint64_t GetNSamples (void) const;
+  /**
+   * \returns whether the last run stopped on Precision
+   */
+  bool HasConverged (void) const;
+  /**
+   * \param model the index of a model
+   * \returns the histogram of the losses of the model (positive, in dB)
+   */
+  const LossHistogram & GetHistogram (uint32_t model) const;
+  /**
+   * \param model the index of a model
+   * \returns the fraction of the locations the model covers
+   */
+  double GetCoverage (uint32_t model) const;
+  /**
+   * \param model the index of a model
+   * \param low the lower confidence bound of the coverage
+   * \param high the upper confidence bound of the coverage
+   */
+  void GetCoverageBounds (uint32_t model, double &low, double &high) const;
+  /**
+   * \param model the index of a model
+   * \param p a fraction in [0, 1]
+   * \returns the quantile p of the losses of the model [dB]
+   */
+  double GetQuantile (uint32_t model, double p) const;
+  /**
+   * \param model the index of a model
+   * \param p a fraction in [0, 1]
+   * \param low the lower confidence bound of the quantile [dB]
+   * \param high the upper confidence bound of the quantile [dB]
+   */
+  void GetQuantileBounds (uint32_t model, double p, double &low, double &high) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  AreaLossStatistics (const AreaLossStatistics &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  AreaLossStatistics & operator = (const AreaLossStatistics &);
+
+  /**
+   * Take tiles until the end of the round
+   * \param nextTile the index of the next tile to take
+   * \param endTile the index of the first tile after the round
+   * \param histograms the histograms of this worker, one per model
+   * \param covered the covered locations of this worker, per model
+   */
+  void Worker (std::atomic<uint64_t> *nextTile, uint64_t endTile,
+               std::vector<LossHistogram> *histograms, uint64_t *covered) const;
+  /**
+   * Generate the locations of a tile
+   * \param tile the index of the tile
+   * \param x the x coordinates [m]
+   * \param y the y coordinates [m]
+   * \returns the number of locations of the tile
+   */
+  uint32_t GetTileLocations (uint64_t tile, double *x, double *y) const;
+  /**
+   * \param model the index of a model
+   * \returns the half width of the confidence interval of the coverage
+   *          of the model
+   */
+  double GetCoverageHalfWidth (uint32_t model) const;
+  /**
+   * \param model the index of a model
+   * \returns the half width of the confidence interval of the
+   *          PrecisionQuantile of the model [dB]
+   */
+  double GetQuantileHalfWidth (uint32_t model) const;
+
+  Sampling m_sampling; //!< locations of the area
+  double m_gridSpacing; //!< spacing of the Grid locations [m]
+  uint64_t m_maxSamples; //!< largest number of Random locations
+  double m_precision; //!< half width of the coverage intervals to stop at
+  double m_quantilePrecision; //!< half width of the quantile intervals to stop at [dB]
+  double m_precisionQuantile; //!< quantile whose interval QuantilePrecision applies to
+  double m_confidence; //!< level of the confidence intervals
+  uint32_t m_checkInterval; //!< number of tiles between two checks of the precision
+  uint32_t m_seed; //!< seed of the Random locations
+  double m_minLoss; //!< lower edge of the histograms [dB]
+  double m_maxLoss; //!< upper edge of the histograms [dB]
+  double m_binWidth; //!< width of the bins of the histograms [dB]
+  double m_txPowerDbm; //!< transmission power [dBm]
+  double m_sensitivityDbm; //!< received power of a covered location [dBm]
+  double m_receiverHeight; //!< height of the receivers [m]
+  uint32_t m_tileSize; //!< number of locations per tile
+  uint32_t m_threads; //!< number of threads, 0 for one per core
+
+  Vector m_site; //!< position of the site
+  double m_xMin; //!< lowest x coordinate of the area [m]
+  double m_yMin; //!< lowest y coordinate of the area [m]
+  double m_xMax; //!< highest x coordinate of the area [m]
+  double m_yMax; //!< highest y coordinate of the area [m]
+  std::vector<Ptr<EmpiricalPropagationLossModel> > m_models; //!< the models
+  std::vector<const EmpiricalPropagationLossModel *> m_peekModels; //!< m_models for the workers, set by Run
+  std::vector<const ClutterRaster *> m_peekRasters; //!< clutter rasters of the models for the workers, set by Run
+  uint32_t m_nx; //!< number of Grid columns, set by Run
+  uint64_t m_nLocations; //!< number of locations to evaluate, set by Run
+
+  std::vector<LossHistogram> m_histograms; //!< histogram of each model
+  std::vector<uint64_t> m_covered; //!< covered locations of each model
+  uint64_t m_nSamples; //!< locations evaluated by the last run
+  bool m_converged; //!< whether the last run stopped on Precision
+  double m_z; //!< standard normal quantile of the intervals, set by Run
+};
+
+}
+
+#endif /* AREA_LOSS_STATISTICS_H */
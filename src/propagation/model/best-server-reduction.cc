@@ -0,0 +1,376 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include "clutter-raster.h"
+#include "best-server-reduction.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BestServerReduction");
+
+NS_OBJECT_ENSURE_REGISTERED (BestServerReduction);
+
+const uint32_t BestServerReduction::NO_SITE;
+
+TypeId
+BestServerReduction::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BestServerReduction")
+    .SetParent<Object> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<BestServerReduction> ()
+    .AddAttribute ("TopK",
+                   "The number of strongest servers kept per location (default is 3).",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&BestServerReduction::m_topK),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("TileSize",
+                   "The number of locations reduced together (default is 4096).",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&BestServerReduction::m_tileSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Threads",
+                   "The number of threads, 0 for one per core (default is 0).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&BestServerReduction::m_threads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("NumaNodes",
+                   "The number of partitions of the locations, each on its own NUMA node, "
+                   "0 for every node of the machine (default is 1).",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&BestServerReduction::m_numaNodes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PinThreads",
+                   "Whether to pin each thread to a CPU of the NUMA node of its partition (default is false).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&BestServerReduction::m_pinThreads),
+                   MakeBooleanChecker ())
+    .AddAttribute ("NoisePowerDbm",
+                   "The noise power at the receivers (default is -100 dBm).",
+                   DoubleValue (-100.0),
+                   MakeDoubleAccessor (&BestServerReduction::m_noisePowerDbm),
+                   MakeDoubleChecker<double> ());
+  return tid;
+}
+
+BestServerReduction::BestServerReduction ()
+  : m_nLocations (0),
+    m_sourceX (0),
+    m_sourceY (0),
+    m_sourceZ (0)
+{
+}
+
+BestServerReduction::~BestServerReduction ()
+{
+}
+
+void
+BestServerReduction::DoDispose (void)
+{
+  m_sites.clear ();
+  Object::DoDispose ();
+}
+
+uint32_t
+BestServerReduction::AddSite (const Vector &position, double txPowerDbm, Ptr<EmpiricalPropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << position << txPowerDbm << model);
+  NS_ABORT_MSG_IF (model == 0, "No model for the site");
+  Site site;
+  site.x = position.x;
+  site.y = position.y;
+  site.z = position.z;
+  site.txPowerDbm = txPowerDbm;
+  site.model = model;
+  site.raster = 0;
+  m_sites.push_back (site);
+  return m_sites.size () - 1;
+}
+
+uint32_t
+BestServerReduction::GetNSites (void) const
+{
+  return m_sites.size ();
+}
+
+void
+BestServerReduction::SetLocations (const double *x, const double *y, const double *z, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_nLocations = n;
+  m_x.Allocate (n * sizeof (double));
+  m_y.Allocate (n * sizeof (double));
+  m_z.Allocate (n * sizeof (double));
+  m_server.Free ();
+  m_rsrp.Free ();
+  m_sinr.Free ();
+  // the threads of each partition copy its locations to their node
+  m_sourceX = x;
+  m_sourceY = y;
+  m_sourceZ = z;
+  RunWorkers (false);
+  m_sourceX = 0;
+  m_sourceY = 0;
+  m_sourceZ = 0;
+}
+
+uint32_t
+BestServerReduction::GetNLocations (void) const
+{
+  return m_nLocations;
+}
+
+void
+BestServerReduction::ReduceTile (uint32_t begin, uint32_t n, double *distance, double *rsrp,
+                                 uint8_t *clutter, double *total)
+{
+  // rank r of location begin + i is at [r * stride + i]
+  size_t stride = m_nLocations;
+  double *topRsrp = m_rsrp.Get<double> () + begin;
+  uint32_t *topServer = m_server.Get<uint32_t> () + begin;
+  double *sinr = m_sinr.Get<double> () + begin;
+  const double *x = m_x.Get<double> () + begin;
+  const double *y = m_y.Get<double> () + begin;
+  const double *z = m_z.Get<double> () + begin;
+  for (uint32_t rank = 0; rank < m_topK; ++rank)
+    {
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          topRsrp[rank * stride + i] = -std::numeric_limits<double>::infinity ();
+          topServer[rank * stride + i] = NO_SITE;
+        }
+    }
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      sinr[i] = -std::numeric_limits<double>::infinity ();
+      total[i] = 0;
+    }
+
+  for (uint32_t s = 0; s < m_sites.size (); ++s)
+    {
+      const Site &site = m_sites[s];
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          double dx = x[i] - site.x;
+          double dy = y[i] - site.y;
+          double dz = z[i] - site.z;
+          distance[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+        }
+      if (site.raster == 0)
+        {
+          site.model->GetLossBatch (distance, rsrp, n);
+        }
+      else
+        {
+          site.raster->GetClasses (x, y, clutter, n);
+          site.model->GetLossBatch (distance, clutter, rsrp, n);
+        }
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          rsrp[i] += site.txPowerDbm;
+          total[i] += std::pow (10.0, rsrp[i] / 10);
+        }
+
+      // insert into the running top-K, kept sorted by decreasing RSRP
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          uint32_t rank = m_topK;
+          while (rank > 0 && rsrp[i] > topRsrp[(rank - 1) * stride + i])
+            {
+              if (rank < m_topK)
+                {
+                  topRsrp[rank * stride + i] = topRsrp[(rank - 1) * stride + i];
+                  topServer[rank * stride + i] = topServer[(rank - 1) * stride + i];
+                }
+              rank--;
+            }
+          if (rank < m_topK)
+            {
+              topRsrp[rank * stride + i] = rsrp[i];
+              topServer[rank * stride + i] = s;
+            }
+        }
+    }
+
+  double noise = std::pow (10.0, m_noisePowerDbm / 10);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      if (topServer[i] == NO_SITE)
+        {
+          continue;
+        }
+      double signal = std::pow (10.0, topRsrp[i] / 10);
+      double interference = std::max (total[i] - signal, 0.0);
+      sinr[i] = topRsrp[i] - 10 * std::log10 (interference + noise);
+    }
+}
+
+uint32_t
+BestServerReduction::MakePartitions (void)
+{
+  const NumaTopology &topology = NumaTopology::GetSystem ();
+  uint32_t tiles = (m_nLocations + static_cast<uint64_t> (m_tileSize) - 1) / m_tileSize;
+  uint32_t threads = m_threads > 0 ? m_threads : std::max (1u, std::thread::hardware_concurrency ());
+  threads = std::max (1u, std::min (threads, tiles));
+  uint32_t nodes = m_numaNodes > 0 ? m_numaNodes : topology.GetNNodes ();
+  nodes = std::min (nodes, threads);
+
+  // the tiles follow the threads, so that every thread gets as many
+  m_partitions.clear ();
+  uint32_t firstThread = 0;
+  for (uint32_t p = 0; p < nodes; ++p)
+    {
+      Partition partition;
+      partition.node = p % topology.GetNNodes ();
+      partition.threads = threads / nodes + (p < threads % nodes);
+      partition.firstTile = static_cast<uint64_t> (tiles) * firstThread / threads;
+      firstThread += partition.threads;
+      partition.endTile = static_cast<uint64_t> (tiles) * firstThread / threads;
+      m_partitions.push_back (partition);
+    }
+  return threads;
+}
+
+void
+BestServerReduction::Worker (const Partition *partition, uint32_t rank, bool pin,
+                             std::atomic<uint32_t> *nextTile, bool reduce)
+{
+  if (pin)
+    {
+      const std::vector<uint32_t> &cpus = NumaTopology::GetSystem ().GetCpus (partition->node);
+      if (!NumaTopology::PinCurrentThread (cpus[rank % cpus.size ()]))
+        {
+          NS_LOG_WARN ("Can't pin a thread to CPU " << cpus[rank % cpus.size ()]);
+        }
+    }
+  std::vector<double> distance;
+  std::vector<double> rsrp;
+  std::vector<uint8_t> clutter;
+  std::vector<double> total;
+  if (reduce)
+    {
+      distance.resize (m_tileSize);
+      rsrp.resize (m_tileSize);
+      clutter.resize (m_tileSize);
+      total.resize (m_tileSize);
+    }
+  while (true)
+    {
+      uint32_t tile = partition->firstTile + nextTile->fetch_add (1);
+      if (tile >= partition->endTile)
+        {
+          return;
+        }
+      uint64_t begin = static_cast<uint64_t> (tile) * m_tileSize;
+      uint32_t n = std::min<uint64_t> (m_tileSize, m_nLocations - begin);
+      if (reduce)
+        {
+          ReduceTile (begin, n, distance.data (), rsrp.data (), clutter.data (), total.data ());
+        }
+      else
+        {
+          std::copy (m_sourceX + begin, m_sourceX + begin + n, m_x.Get<double> () + begin);
+          std::copy (m_sourceY + begin, m_sourceY + begin + n, m_y.Get<double> () + begin);
+          std::copy (m_sourceZ + begin, m_sourceZ + begin + n, m_z.Get<double> () + begin);
+        }
+    }
+}
+
+void
+BestServerReduction::RunWorkers (bool reduce)
+{
+  if (m_nLocations == 0)
+    {
+      return;
+    }
+  uint32_t threads = MakePartitions ();
+  std::vector<std::atomic<uint32_t> > nextTile (m_partitions.size ());
+  for (uint32_t p = 0; p < m_partitions.size (); ++p)
+    {
+      nextTile[p] = 0;
+    }
+  if (threads <= 1)
+    {
+      // the calling thread is never pinned
+      Worker (&m_partitions[0], 0, false, &nextTile[0], reduce);
+      return;
+    }
+  std::vector<std::thread> workers;
+  for (uint32_t p = 0; p < m_partitions.size (); ++p)
+    {
+      for (uint32_t t = 0; t < m_partitions[p].threads; ++t)
+        {
+          workers.push_back (std::thread (&BestServerReduction::Worker, this, &m_partitions[p], t,
+                                          m_pinThreads, &nextTile[p], reduce));
+        }
+    }
+  for (uint32_t t = 0; t < workers.size (); ++t)
+    {
+      workers[t].join ();
+    }
+}
+
+void
+BestServerReduction::Run (void)
+{
+  NS_LOG_FUNCTION (this << m_sites.size () << m_nLocations);
+
+  // the results are initialized by the threads of their partition
+  m_server.Allocate (static_cast<size_t> (m_topK) * m_nLocations * sizeof (uint32_t));
+  m_rsrp.Allocate (static_cast<size_t> (m_topK) * m_nLocations * sizeof (double));
+  m_sinr.Allocate (static_cast<size_t> (m_nLocations) * sizeof (double));
+  // the workers only use raw pointers: the reference counts are not atomic
+  for (uint32_t s = 0; s < m_sites.size (); ++s)
+    {
+      m_sites[s].raster = PeekPointer (m_sites[s].model->GetClutterRaster ());
+    }
+  RunWorkers (true);
+}
+
+const uint32_t *
+BestServerReduction::GetServer (uint32_t rank) const
+{
+  NS_ASSERT (rank < m_topK && m_server.GetSize () > 0);
+  return m_server.Get<uint32_t> () + static_cast<size_t> (rank) * m_nLocations;
+}
+
+const double *
+BestServerReduction::GetRsrp (uint32_t rank) const
+{
+  NS_ASSERT (rank < m_topK && m_rsrp.GetSize () > 0);
+  return m_rsrp.Get<double> () + static_cast<size_t> (rank) * m_nLocations;
+}
+
+const double *
+BestServerReduction::GetSinr (void) const
+{
+  NS_ASSERT (m_sinr.GetSize () > 0);
+  return m_sinr.Get<double> ();
+}
+
+}
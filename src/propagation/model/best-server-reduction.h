@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef BEST_SERVER_REDUCTION_H
+#define BEST_SERVER_REDUCTION_H
+
+#include <atomic>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/vector.h"
+#include "ns3/empirical-propagation-loss-model.h"
+#include "ns3/numa-topology.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Best server, RSRP and SINR of every location of a coverage map
+ *
+ * The locations are split into tiles of TileSize locations, and Threads
+ * threads take the tiles in turn. For each tile, the sites are streamed
+ * one after the other: the distances from the site to the tile are
+ * computed, the model of the site evaluates them with its batch path,
+ * and the received powers are folded into a running top-K of the
+ * servers and a running sum of the total received power of each
+ * location. No location x site table is ever stored, so the memory is
+ * proportional to the number of locations (times TopK).
+ *
+ * The SINR is the power of the best server over the power of every
+ * other site plus NoisePowerDbm, i.e., all the sites share the channel
+ * and are fully loaded.
+ *
+ * The results are kept as separate arrays over the locations: the
+ * server and received power of each rank, and the SINR.
+ *
+ * On a NUMA machine, NumaNodes splits the tiles into contiguous
+ * partitions, one per node, each computed by the threads of its node
+ * (pinned to its CPUs with PinThreads). The locations and the results
+ * are never written by the main thread: the threads of each partition
+ * copy its locations in SetLocations and initialize its results in Run,
+ * so the first-touch policy of the kernel places every page on the node
+ * that reads and writes it. NumaNodes, Threads and TileSize are thus
+ * best set before SetLocations.
+ */
+class BestServerReduction : public Object
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  BestServerReduction ();
+  virtual ~BestServerReduction ();
+
+  /// Server of the ranks a location hears fewer than TopK sites for
+  static const uint32_t NO_SITE = 0xffffffff;
+
+  /**
+   * Add a base station
+   *
+   * The antenna heights and frequency are those of the model, and the
+   * position only sets the distances. Several sites can share a model.
+   *
+   * \param position the antenna position
+   * \param txPowerDbm the transmission power [dBm]
+   * \param model the empirical model of the site
+   * \returns the index of the site
+   */
+  uint32_t AddSite (const Vector &position, double txPowerDbm, Ptr<EmpiricalPropagationLossModel> model);
+  /**
+   * \returns the number of sites
+   */
+  uint32_t GetNSites (void) const;
+  /**
+   * Set the receiver locations, discarding the results of the previous
+   * locations
+   * \param x the x coordinates [m]
+   * \param y the y coordinates [m]
+   * \param z the z coordinates [m]
+   * \param n the number of locations
+   */
+  void SetLocations (const double *x, const double *y, const double *z, uint32_t n);
+  /**
+   * \returns the number of locations
+   */
+  uint32_t GetNLocations (void) const;
+
+  /**
+   * Reduce all the sites over all the locations
+   */
+  void Run (void);
+
+  /**
+   * \param rank the rank, 0 for the best server, less than TopK
+   * \returns the server of that rank at each location, or NO_SITE
+   */
+  const uint32_t * GetServer (uint32_t rank) const;
+  /**
+   * \param rank the rank, 0 for the best server, less than TopK
+   * \returns the RSRP of the server of that rank at each location [dBm],
+   *          or -inf
+   */
+  const double * GetRsrp (uint32_t rank) const;
+  /**
+   * \returns the SINR of the best server at each location [dB]
+   */
+  const double * GetSinr (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  BestServerReduction (const BestServerReduction &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  BestServerReduction & operator = (const BestServerReduction &);
+
+  /**
+   * A base station
+   */
+  struct Site
+  {
+    double x; //!< x coordinate [m]
+    double y; //!< y coordinate [m]
+    double z; //!< z coordinate [m]
+    double txPowerDbm; //!< transmission power [dBm]
+    Ptr<EmpiricalPropagationLossModel> model; //!< empirical model
+    const ClutterRaster *raster; //!< clutter raster of the model, set by Run
+  };
+
+  /**
+   * A contiguous range of tiles and the threads that compute it
+   */
+  struct Partition
+  {
+    uint32_t node; //!< index of the NUMA node in NumaTopology::GetSystem
+    uint32_t firstTile; //!< first tile
+    uint32_t endTile; //!< tile after the last one
+    uint32_t threads; //!< number of threads
+  };
+
+  /**
+   * Split the tiles of the current locations into m_partitions
+   * \returns the total number of threads
+   */
+  uint32_t MakePartitions (void);
+  /**
+   * Run Worker on every partition
+   * \param reduce false to copy the locations from m_sourceX, m_sourceY
+   *        and m_sourceZ, true to reduce the sites
+   */
+  void RunWorkers (bool reduce);
+  /**
+   * Take the tiles of a partition until there are none left
+   * \param partition the partition
+   * \param rank the index of the thread in the partition
+   * \param pin whether to pin the thread to a CPU of the partition node
+   * \param nextTile the index of the next tile to take
+   * \param reduce false to copy the locations, true to reduce the sites
+   */
+  void Worker (const Partition *partition, uint32_t rank, bool pin,
+               std::atomic<uint32_t> *nextTile, bool reduce);
+  /**
+   * Reduce all the sites over a tile
+   * \param begin the first location of the tile
+   * \param n the number of locations of the tile
+   * \param distance scratch space of n distances
+   * \param rsrp scratch space of n received powers
+   * \param clutter scratch space of n clutter classes
+   * \param total scratch space of n total received powers
+   */
+  void ReduceTile (uint32_t begin, uint32_t n, double *distance, double *rsrp,
+                   uint8_t *clutter, double *total);
+
+  uint32_t m_topK; //!< number of servers kept per location
+  uint32_t m_tileSize; //!< number of locations per tile
+  uint32_t m_threads; //!< number of threads, 0 for one per core
+  uint32_t m_numaNodes; //!< number of partitions, 0 for one per NUMA node
+  bool m_pinThreads; //!< whether to pin the threads to the CPUs of their node
+  double m_noisePowerDbm; //!< noise power [dBm]
+
+  std::vector<Site> m_sites; //!< base stations
+  std::vector<Partition> m_partitions; //!< partitions of the tiles, set by MakePartitions
+  uint32_t m_nLocations; //!< number of locations
+  const double *m_sourceX; //!< x coordinates passed to SetLocations, while copying them
+  const double *m_sourceY; //!< y coordinates passed to SetLocations, while copying them
+  const double *m_sourceZ; //!< z coordinates passed to SetLocations, while copying them
+  FirstTouchBuffer m_x; //!< x coordinates of the locations [m]
+  FirstTouchBuffer m_y; //!< y coordinates of the locations [m]
+  FirstTouchBuffer m_z; //!< z coordinates of the locations [m]
+  FirstTouchBuffer m_server; //!< servers, rank-major: server[rank * locations + i]
+  FirstTouchBuffer m_rsrp; //!< RSRP of the servers [dBm], rank-major
+  FirstTouchBuffer m_sinr; //!< SINR of the best servers [dB]
+};
+
+}
+
+#endif /* BEST_SERVER_REDUCTION_H */
@@ -0,0 +1,242 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "clutter-raster.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ClutterRaster");
+
+NS_OBJECT_ENSURE_REGISTERED (ClutterRaster);
+
+const char ClutterRaster::CLUTTER_RASTER_MAGIC[8] = { 'N', 'S', '3', 'C', 'L', 'U', 'T', '\0' };
+const uint32_t ClutterRaster::CLUTTER_RASTER_VERSION;
+const uint32_t ClutterRaster::NUM_CLASSES;
+
+/// Cells of an unmapped raster, never read through an in-raster index
+static const uint8_t g_noCells[1] = { 0 };
+
+TypeId
+ClutterRaster::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClutterRaster")
+    .SetParent<Object> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<ClutterRaster> ()
+    .AddAttribute ("Filename",
+                   "The clutter raster file to map.",
+                   StringValue (""),
+                   MakeStringAccessor (&ClutterRaster::SetFilename,
+                                       &ClutterRaster::GetFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("DefaultClass",
+                   "The clutter class outside the raster (default is urban).",
+                   EnumValue (Urban),
+                   MakeEnumAccessor (&ClutterRaster::m_defaultClass),
+                   MakeEnumChecker (Urban, "Urban", Suburban, "Suburban", Rural, "Rural"));
+  return tid;
+}
+
+ClutterRaster::ClutterRaster ()
+  : m_map (0),
+    m_mapSize (0),
+    m_header (0),
+    m_cells (g_noCells),
+    m_originX (0),
+    m_originY (0),
+    m_inverseCellSize (0),
+    m_width (0),
+    m_height (0)
+{
+}
+
+ClutterRaster::~ClutterRaster ()
+{
+  Close ();
+}
+
+void
+ClutterRaster::DoDispose (void)
+{
+  Close ();
+  Object::DoDispose ();
+}
+
+void
+ClutterRaster::Write (std::string filename, double originX, double originY, double cellSize,
+                      uint32_t width, uint32_t height, const uint8_t *classes)
+{
+  NS_LOG_FUNCTION (filename << originX << originY << cellSize << width << height);
+  NS_ABORT_MSG_IF (!(cellSize > 0), "Invalid clutter cell size " << cellSize);
+
+  ClutterRasterHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, CLUTTER_RASTER_MAGIC, sizeof (header.magic));
+  header.version = CLUTTER_RASTER_VERSION;
+  header.headerSize = sizeof (ClutterRasterHeader);
+  header.originX = originX;
+  header.originY = originY;
+  header.cellSize = cellSize;
+  header.width = width;
+  header.height = height;
+
+  std::ofstream os (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os.is_open ())
+    {
+      NS_FATAL_ERROR ("Can't open clutter raster file " << filename);
+    }
+  os.write (reinterpret_cast<const char *> (&header), sizeof (header));
+  os.write (reinterpret_cast<const char *> (classes), static_cast<uint64_t> (width) * height);
+  if (!os.good ())
+    {
+      NS_FATAL_ERROR ("Error while writing clutter raster file " << filename);
+    }
+}
+
+void
+ClutterRaster::SetFilename (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  m_filename = filename;
+  if (filename.empty ())
+    {
+      return;
+    }
+
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_FATAL_ERROR ("Can't open clutter raster file " << filename);
+    }
+  struct stat st;
+  if (fstat (fd, &st) != 0 || static_cast<uint64_t> (st.st_size) < sizeof (ClutterRasterHeader))
+    {
+      close (fd);
+      NS_FATAL_ERROR ("Clutter raster file " << filename << " is truncated");
+    }
+  m_mapSize = st.st_size;
+  m_map = mmap (0, m_mapSize, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (m_map == MAP_FAILED)
+    {
+      m_map = 0;
+      NS_FATAL_ERROR ("Can't map clutter raster file " << filename);
+    }
+
+  m_header = static_cast<const ClutterRasterHeader *> (m_map);
+  if (std::memcmp (m_header->magic, CLUTTER_RASTER_MAGIC, sizeof (m_header->magic)) != 0)
+    {
+      NS_FATAL_ERROR (filename << " is not a clutter raster file");
+    }
+  if (m_header->version != CLUTTER_RASTER_VERSION || m_header->headerSize != sizeof (ClutterRasterHeader))
+    {
+      NS_FATAL_ERROR ("Clutter raster file " << filename << " has version " << m_header->version
+                      << ", expected " << CLUTTER_RASTER_VERSION);
+    }
+  if (m_mapSize != sizeof (ClutterRasterHeader) + static_cast<uint64_t> (m_header->width) * m_header->height
+      || !(m_header->cellSize > 0))
+    {
+      NS_FATAL_ERROR ("Clutter raster file " << filename << " has an inconsistent size");
+    }
+
+  // an empty raster has no cell past the header: every lookup reads the
+  // dummy cell and falls outside
+  if (m_header->width > 0 && m_header->height > 0)
+    {
+      m_cells = reinterpret_cast<const uint8_t *> (m_header + 1);
+    }
+  m_originX = m_header->originX;
+  m_originY = m_header->originY;
+  m_inverseCellSize = 1.0 / m_header->cellSize;
+  m_width = m_header->width;
+  m_height = m_header->height;
+
+  NS_LOG_DEBUG ("mapped " << m_width << "x" << m_height << " clutter cells of " << m_header->cellSize
+                          << " m at " << m_originX << "," << m_originY);
+}
+
+std::string
+ClutterRaster::GetFilename (void) const
+{
+  return m_filename;
+}
+
+void
+ClutterRaster::Close (void)
+{
+  if (m_map != 0)
+    {
+      munmap (m_map, m_mapSize);
+    }
+  m_map = 0;
+  m_mapSize = 0;
+  m_header = 0;
+  m_cells = g_noCells;
+  m_width = 0;
+  m_height = 0;
+}
+
+const ClutterRasterHeader &
+ClutterRaster::GetHeader (void) const
+{
+  NS_ASSERT (m_header != 0);
+  return *m_header;
+}
+
+uint8_t
+ClutterRaster::Lookup (double x, double y) const
+{
+  double fx = (x - m_originX) * m_inverseCellSize;
+  double fy = (y - m_originY) * m_inverseCellSize;
+  // NaN fails every comparison, so it is outside as well
+  bool inside = (fx >= 0) & (fx < m_width) & (fy >= 0) & (fy < m_height);
+  // clamped so that the index is valid even when the result is discarded
+  uint64_t ix = static_cast<uint64_t> (std::min<double> (m_width - 1, std::max (0.0, fx)));
+  uint64_t iy = static_cast<uint64_t> (std::min<double> (m_height - 1, std::max (0.0, fy)));
+  uint8_t c = m_cells[(iy * m_width + ix) & -static_cast<uint64_t> (inside)];
+  return (inside & (c < NUM_CLASSES)) ? c : static_cast<uint8_t> (m_defaultClass);
+}
+
+ClutterRaster::ClutterClass
+ClutterRaster::GetClass (const Vector &position) const
+{
+  return static_cast<ClutterClass> (Lookup (position.x, position.y));
+}
+
+void
+ClutterRaster::GetClasses (const double *x, const double *y, uint8_t *classes, uint32_t n) const
+{
+  NS_LOG_FUNCTION (this << n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      classes[i] = Lookup (x[i], y[i]);
+    }
+}
+
+}
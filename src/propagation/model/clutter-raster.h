@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef CLUTTER_RASTER_H
+#define CLUTTER_RASTER_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/object.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Fixed-size header at the start of a clutter raster file
+ *
+ * A clutter raster file is laid out as
+ *   - this header
+ *   - width * height uint8_t clutter classes, row-major, row 0 at originY
+ *
+ * Cell (i, j) covers [originX + i * cellSize, originX + (i + 1) * cellSize)
+ * x [originY + j * cellSize, originY + (j + 1) * cellSize). All fields are
+ * stored in host byte order.
+ */
+struct ClutterRasterHeader
+{
+  char magic[8];            //!< CLUTTER_RASTER_MAGIC
+  uint32_t version;         //!< CLUTTER_RASTER_VERSION
+  uint32_t headerSize;      //!< sizeof (ClutterRasterHeader) of the writer
+  double originX;           //!< x of the lower left corner [m]
+  double originY;           //!< y of the lower left corner [m]
+  double cellSize;          //!< side of a square cell [m]
+  uint32_t width;           //!< number of columns (along x)
+  uint32_t height;          //!< number of rows (along y)
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Read-only, memory-mapped map from (x, y) to a clutter class
+ *
+ * Lets a single empirical model instance pick its environment or terrain
+ * per receiver location, see the ClutterRaster attribute of
+ * EmpiricalPropagationLossModel. Positions outside the raster, and cells
+ * holding an unknown class, get the DefaultClass.
+ */
+class ClutterRaster : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  ClutterRaster ();
+  virtual ~ClutterRaster ();
+
+  /**
+   * The clutter classes
+   */
+  enum ClutterClass
+  {
+    Urban, Suburban, Rural
+  };
+  /// Number of clutter classes
+  static const uint32_t NUM_CLASSES = 3;
+
+  /// Magic at the start of every clutter raster file
+  static const char CLUTTER_RASTER_MAGIC[8];
+  /// Current version of the file format
+  static const uint32_t CLUTTER_RASTER_VERSION = 1;
+
+  /**
+   * Write a clutter raster file
+   *
+   * \param filename the file to create
+   * \param originX x of the lower left corner [m]
+   * \param originY y of the lower left corner [m]
+   * \param cellSize side of a cell [m]
+   * \param width number of columns
+   * \param height number of rows
+   * \param classes the width * height ClutterClass values, row-major
+   */
+  static void Write (std::string filename, double originX, double originY, double cellSize,
+                     uint32_t width, uint32_t height, const uint8_t *classes);
+
+  /**
+   * Map a clutter raster file, aborting on a malformed or incompatible
+   * file; an empty name unmaps the current file
+   * \param filename the file to map
+   */
+  void SetFilename (std::string filename);
+  /**
+   * Get the name of the mapped file
+   * \returns the file name
+   */
+  std::string GetFilename (void) const;
+  /**
+   * Get the header of the mapped file
+   * \returns the header
+   */
+  const ClutterRasterHeader & GetHeader (void) const;
+
+  /**
+   * \param position a position; z is ignored
+   * \returns the clutter class at the position
+   */
+  ClutterClass GetClass (const Vector &position) const;
+  /**
+   * Get the clutter classes of a batch of positions
+   * \param x the x coordinates [m]
+   * \param y the y coordinates [m]
+   * \param classes the ClutterClass values
+   * \param n the number of positions
+   */
+  void GetClasses (const double *x, const double *y, uint8_t *classes, uint32_t n) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  ClutterRaster (const ClutterRaster &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  ClutterRaster & operator = (const ClutterRaster &);
+
+  /**
+   * Unmap the file, if any
+   */
+  void Close (void);
+  /**
+   * \param x x coordinate [m]
+   * \param y y coordinate [m]
+   * \returns the clutter class at (x, y)
+   */
+  uint8_t Lookup (double x, double y) const;
+
+  std::string m_filename; //!< name of the mapped file
+  ClutterClass m_defaultClass; //!< class outside the raster
+  void *m_map; //!< start of the mapping
+  uint64_t m_mapSize; //!< size of the mapping [bytes]
+  const ClutterRasterHeader *m_header; //!< header, inside the mapping
+  const uint8_t *m_cells; //!< classes, inside the mapping
+  // copies of the header fields, kept out of the mapping for the lookups
+  double m_originX; //!< x of the lower left corner [m]
+  double m_originY; //!< y of the lower left corner [m]
+  double m_inverseCellSize; //!< 1 / cell size [1/m]
+  uint32_t m_width; //!< number of columns
+  uint32_t m_height; //!< number of rows
+};
+
+}
+
+#endif /* CLUTTER_RASTER_H */
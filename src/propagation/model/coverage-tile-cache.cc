@@ -0,0 +1,322 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include <cmath>
+#include <cstring>
+#include "clutter-raster.h"
+#include "coverage-tile-cache.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CoverageTileCache");
+
+NS_OBJECT_ENSURE_REGISTERED (CoverageTileCache);
+
+TypeId
+CoverageTileCache::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CoverageTileCache")
+    .SetParent<Object> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<CoverageTileCache> ()
+    .AddAttribute ("BaseCellSize",
+                   "The side of a cell at the finest level (default is 10 m).",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&CoverageTileCache::m_baseCellSize),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TileSize",
+                   "The number of cells per tile side (default is 256).",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&CoverageTileCache::m_tileSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Levels",
+                   "The number of zoom levels; each level doubles the cell size (default is 8).",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&CoverageTileCache::m_levels),
+                   MakeUintegerChecker<uint32_t> (1, 32))
+    .AddAttribute ("MaxBytes",
+                   "The memory budget of the cached tiles (default is 64 MiB).",
+                   UintegerValue (64 << 20),
+                   MakeUintegerAccessor (&CoverageTileCache::m_maxBytes),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("ReceiverHeight",
+                   "The height of the receivers, for the link distances (default is 1.5 m).",
+                   DoubleValue (1.5),
+                   MakeDoubleAccessor (&CoverageTileCache::m_receiverHeight),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Encoding",
+                   "The storage format of the cached losses (default is Double).",
+                   EnumValue (LossQuantization::Double),
+                   MakeEnumAccessor (&CoverageTileCache::m_encoding),
+                   MakeEnumChecker (LossQuantization::Double, "Double",
+                                    LossQuantization::Uint16, "Uint16",
+                                    LossQuantization::Uint8, "Uint8"));
+  return tid;
+}
+
+CoverageTileCache::CoverageTileCache ()
+  : m_signatureValid (false),
+    m_bytes (0)
+{
+  ResetStatistics ();
+}
+
+CoverageTileCache::~CoverageTileCache ()
+{
+}
+
+void
+CoverageTileCache::DoDispose (void)
+{
+  Clear ();
+  m_model = 0;
+  Object::DoDispose ();
+}
+
+void
+CoverageTileCache::SetSite (const Vector &position, Ptr<EmpiricalPropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << position << model);
+  m_position = position;
+  m_model = model;
+}
+
+double
+CoverageTileCache::GetCellSize (uint32_t level) const
+{
+  return std::ldexp (m_baseCellSize, level);
+}
+
+void
+CoverageTileCache::Validate (void)
+{
+  NS_ABORT_MSG_IF (m_model == 0, "No site");
+  Signature signature;
+  signature.coefficients = m_model->GetCoefficients ();
+  signature.raster = PeekPointer (m_model->GetClutterRaster ());
+  signature.validityPolicy = m_model->GetValidityPolicy ();
+  signature.minDistance = m_model->GetMinDistance ();
+  signature.mathBackend = m_model->GetMathBackend ();
+  signature.position = m_position;
+  signature.receiverHeight = m_receiverHeight;
+  signature.tileSize = m_tileSize;
+  signature.baseCellSize = m_baseCellSize;
+  signature.encoding = m_encoding;
+  if (m_signatureValid && signature == m_signature)
+    {
+      return;
+    }
+  if (!m_tiles.empty ())
+    {
+      NS_LOG_LOGIC ("Site or model changed, dropping " << m_tiles.size () << " tiles");
+      m_statistics.invalidations++;
+      Clear ();
+    }
+  m_signature = signature;
+  m_signatureValid = true;
+}
+
+void
+CoverageTileCache::ComputeTile (const TileKey &key, double *loss) const
+{
+  NS_LOG_FUNCTION (this << key.level << key.column << key.row);
+  uint32_t n = m_tileSize * m_tileSize;
+  double cellSize = GetCellSize (key.level);
+  std::vector<double> x (n);
+  std::vector<double> y (n);
+  std::vector<double> distance (n);
+  for (uint32_t j = 0; j < m_tileSize; ++j)
+    {
+      double cy = (key.row * static_cast<double> (m_tileSize) + j + 0.5) * cellSize;
+      for (uint32_t i = 0; i < m_tileSize; ++i)
+        {
+          double cx = (key.column * static_cast<double> (m_tileSize) + i + 0.5) * cellSize;
+          uint32_t k = j * m_tileSize + i;
+          x[k] = cx;
+          y[k] = cy;
+          double dx = cx - m_position.x;
+          double dy = cy - m_position.y;
+          double dz = m_receiverHeight - m_position.z;
+          distance[k] = std::sqrt (dx * dx + dy * dy + dz * dz);
+        }
+    }
+
+  Ptr<ClutterRaster> raster = m_model->GetClutterRaster ();
+  if (raster == 0)
+    {
+      m_model->GetLossBatch (distance.data (), loss, n);
+      return;
+    }
+  std::vector<uint8_t> clutter (n);
+  raster->GetClasses (x.data (), y.data (), clutter.data (), n);
+  m_model->GetLossBatch (distance.data (), clutter.data (), loss, n);
+}
+
+const CoverageTileCache::Tile &
+CoverageTileCache::GetTile (const TileKey &key)
+{
+  std::map<TileKey, Tile>::iterator it = m_tiles.find (key);
+  if (it != m_tiles.end ())
+    {
+      m_statistics.hits++;
+      m_lru.splice (m_lru.begin (), m_lru, it->second.lru);
+      return it->second;
+    }
+
+  m_statistics.misses++;
+  Tile &tile = m_tiles[key];
+  uint32_t n = m_tileSize * m_tileSize;
+  tile.data.resize (static_cast<size_t> (n) * LossQuantization::GetValueSize (m_encoding));
+  tile.scale.offset = 0;
+  tile.scale.step = 1;
+  if (m_encoding == LossQuantization::Double)
+    {
+      ComputeTile (key, reinterpret_cast<double *> (tile.data.data ()));
+    }
+  else
+    {
+      std::vector<double> loss (n);
+      ComputeTile (key, loss.data ());
+      double min;
+      double max;
+      LossQuantization::GetRange (loss.data (), n, min, max);
+      tile.scale = LossQuantization::MakeScale (m_encoding, min, max);
+      LossQuantization::Encode (m_encoding, loss.data (), tile.data.data (), n, tile.scale);
+    }
+  m_lru.push_front (key);
+  tile.lru = m_lru.begin ();
+  m_bytes += tile.data.size ();
+  Evict ();
+  return tile;
+}
+
+void
+CoverageTileCache::Evict (void)
+{
+  while (m_bytes > m_maxBytes && m_lru.size () > 1)
+    {
+      std::map<TileKey, Tile>::iterator it = m_tiles.find (m_lru.back ());
+      NS_ASSERT (it != m_tiles.end ());
+      m_bytes -= it->second.data.size ();
+      m_tiles.erase (it);
+      m_lru.pop_back ();
+      m_statistics.evictions++;
+    }
+}
+
+CoverageTileCache::Region
+CoverageTileCache::GetRegion (double xMin, double yMin, double xMax, double yMax, uint32_t level)
+{
+  NS_LOG_FUNCTION (this << xMin << yMin << xMax << yMax << level);
+  NS_ABORT_MSG_IF (level >= m_levels, "Level " << level << " is not below " << m_levels);
+  NS_ABORT_MSG_IF (xMax < xMin || yMax < yMin, "Empty viewport");
+  Validate ();
+
+  double cellSize = GetCellSize (level);
+  int64_t firstColumn = static_cast<int64_t> (std::floor (xMin / cellSize));
+  int64_t firstRow = static_cast<int64_t> (std::floor (yMin / cellSize));
+  int64_t lastColumn = std::max (firstColumn, static_cast<int64_t> (std::ceil (xMax / cellSize)) - 1);
+  int64_t lastRow = std::max (firstRow, static_cast<int64_t> (std::ceil (yMax / cellSize)) - 1);
+
+  Region region;
+  region.originX = firstColumn * cellSize;
+  region.originY = firstRow * cellSize;
+  region.cellSize = cellSize;
+  region.width = lastColumn - firstColumn + 1;
+  region.height = lastRow - firstRow + 1;
+  region.loss.resize (static_cast<size_t> (region.width) * region.height);
+
+  int64_t tileSize = m_tileSize;
+  // floor division, the cells can be on either side of the origin
+  int64_t firstTileRow = firstRow >= 0 ? firstRow / tileSize : -((-firstRow + tileSize - 1) / tileSize);
+  int64_t firstTileColumn = firstColumn >= 0 ? firstColumn / tileSize : -((-firstColumn + tileSize - 1) / tileSize);
+  for (int64_t tileRow = firstTileRow; tileRow * tileSize <= lastRow; ++tileRow)
+    {
+      for (int64_t tileColumn = firstTileColumn; tileColumn * tileSize <= lastColumn; ++tileColumn)
+        {
+          TileKey key;
+          key.level = level;
+          key.column = tileColumn;
+          key.row = tileRow;
+          const Tile &tile = GetTile (key);
+          // copy the part of the tile inside the region
+          int64_t rowBegin = std::max (firstRow, tileRow * tileSize);
+          int64_t rowEnd = std::min (lastRow + 1, (tileRow + 1) * tileSize);
+          int64_t columnBegin = std::max (firstColumn, tileColumn * tileSize);
+          int64_t columnEnd = std::min (lastColumn + 1, (tileColumn + 1) * tileSize);
+          uint32_t valueSize = LossQuantization::GetValueSize (m_encoding);
+          for (int64_t row = rowBegin; row < rowEnd; ++row)
+            {
+              const char *source = tile.data.data () + ((row - tileRow * tileSize) * tileSize
+                                                         + (columnBegin - tileColumn * tileSize)) * valueSize;
+              double *destination = region.loss.data () + (row - firstRow) * region.width + (columnBegin - firstColumn);
+              LossQuantization::Decode (m_encoding, source, destination, columnEnd - columnBegin, tile.scale);
+            }
+        }
+    }
+  return region;
+}
+
+void
+CoverageTileCache::Prefetch (double xMin, double yMin, double xMax, double yMax, uint32_t level)
+{
+  NS_LOG_FUNCTION (this << xMin << yMin << xMax << yMax << level);
+  for (uint32_t l = m_levels; l-- > level; )
+    {
+      GetRegion (xMin, yMin, xMax, yMax, l);
+    }
+}
+
+CoverageTileCache::Statistics
+CoverageTileCache::GetStatistics (void) const
+{
+  return m_statistics;
+}
+
+void
+CoverageTileCache::ResetStatistics (void)
+{
+  std::memset (&m_statistics, 0, sizeof (m_statistics));
+}
+
+uint32_t
+CoverageTileCache::GetNTiles (void) const
+{
+  return m_tiles.size ();
+}
+
+uint64_t
+CoverageTileCache::GetBytes (void) const
+{
+  return m_bytes;
+}
+
+void
+CoverageTileCache::Clear (void)
+{
+  m_tiles.clear ();
+  m_lru.clear ();
+  m_bytes = 0;
+}
+
+}
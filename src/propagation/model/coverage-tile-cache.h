@@ -0,0 +1,273 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef COVERAGE_TILE_CACHE_H
+#define COVERAGE_TILE_CACHE_H
+
+#include <list>
+#include <map>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/vector.h"
+#include "ns3/empirical-propagation-loss-model.h"
+#include "ns3/loss-quantization.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Lazily computed, multi-resolution tiles of the coverage of a site
+ *
+ * The plane is divided into square cells of BaseCellSize * 2^level
+ * meters at each zoom level (level 0 is the finest), and the cells into
+ * tiles of TileSize x TileSize cells, aligned on the origin. A tile holds
+ * the loss from the site to the center of each of its cells, at
+ * ReceiverHeight, and is computed with the batch path of the model the
+ * first time it is requested.
+ *
+ * The tiles are kept in a least recently used list, and the least
+ * recently used ones are dropped when their total size exceeds MaxBytes.
+ * The coefficients of the model (which follow its frequency, antenna
+ * heights and environment), its clutter raster and the site position are
+ * checked at every request: when any of them changed, all the tiles are
+ * dropped.
+ *
+ * With the Uint16 or Uint8 Encoding, each tile stores fixed-point codes
+ * with a scale spanning its own losses (see LossQuantization), so that
+ * MaxBytes holds four or eight times as many tiles. The losses of a
+ * region are then within half a step of those of the model.
+ */
+class CoverageTileCache : public Object
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  CoverageTileCache ();
+  virtual ~CoverageTileCache ();
+
+  /**
+   * Losses of the cells of a region at one level, row-major from the
+   * lower left cell: loss[row * width + column]. The losses have the
+   * sign convention of EmpiricalPropagationLossModel::GetLoss.
+   */
+  struct Region
+  {
+    double originX; //!< x of the lower left corner [m]
+    double originY; //!< y of the lower left corner [m]
+    double cellSize; //!< side of a cell [m]
+    uint32_t width; //!< number of columns
+    uint32_t height; //!< number of rows
+    std::vector<double> loss; //!< width * height losses (in dBm)
+  };
+
+  /**
+   * Cache statistics since the last ResetStatistics
+   */
+  struct Statistics
+  {
+    uint64_t hits; //!< tile requests served from the cache
+    uint64_t misses; //!< tiles computed
+    uint64_t evictions; //!< tiles dropped to respect MaxBytes
+    uint64_t invalidations; //!< model changes that dropped all the tiles
+  };
+
+  /**
+   * \param position the antenna position of the site
+   * \param model the empirical model of the site
+   */
+  void SetSite (const Vector &position, Ptr<EmpiricalPropagationLossModel> model);
+
+  /**
+   * Get the losses of the cells covering a viewport
+   * \param xMin left of the viewport [m]
+   * \param yMin bottom of the viewport [m]
+   * \param xMax right of the viewport [m]
+   * \param yMax top of the viewport [m]
+   * \param level the zoom level, less than Levels
+   * \returns the cells
+   */
+  Region GetRegion (double xMin, double yMin, double xMax, double yMax, uint32_t level);
+  /**
+   * Compute the missing tiles of a viewport at every level from the
+   * coarsest down to level, so that a coarse map is available before the
+   * fine one
+   * \param xMin left of the viewport [m]
+   * \param yMin bottom of the viewport [m]
+   * \param xMax right of the viewport [m]
+   * \param yMax top of the viewport [m]
+   * \param level the finest zoom level, less than Levels
+   */
+  void Prefetch (double xMin, double yMin, double xMax, double yMax, uint32_t level);
+
+  /**
+   * \returns the cache statistics
+   */
+  Statistics GetStatistics (void) const;
+  /**
+   * Reset the cache statistics
+   */
+  void ResetStatistics (void);
+  /**
+   * \returns the number of cached tiles
+   */
+  uint32_t GetNTiles (void) const;
+  /**
+   * \returns the size of the cached tiles [bytes]
+   */
+  uint64_t GetBytes (void) const;
+  /**
+   * Drop all the tiles
+   */
+  void Clear (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  CoverageTileCache (const CoverageTileCache &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  CoverageTileCache & operator = (const CoverageTileCache &);
+
+  /**
+   * Tile coordinates
+   */
+  struct TileKey
+  {
+    uint32_t level; //!< zoom level
+    int64_t column; //!< tile column
+    int64_t row; //!< tile row
+
+    /**
+     * \param o another key
+     * \returns true if this key sorts before o
+     */
+    bool operator < (const TileKey &o) const
+    {
+      if (level != o.level)
+        {
+          return level < o.level;
+        }
+      if (row != o.row)
+        {
+          return row < o.row;
+        }
+      return column < o.column;
+    }
+  };
+
+  /**
+   * A cached tile
+   */
+  struct Tile
+  {
+    std::vector<char> data; //!< TileSize x TileSize losses, row-major, stored with m_encoding
+    LossQuantization::Scale scale; //!< scale of the codes
+    std::list<TileKey>::iterator lru; //!< position in m_lru
+  };
+
+  /**
+   * Drop all the tiles if the model or the site changed since they were
+   * computed
+   */
+  void Validate (void);
+  /**
+   * \param key the tile
+   * \returns the tile, computed if missing
+   */
+  const Tile & GetTile (const TileKey &key);
+  /**
+   * \param key the tile
+   * \param loss the TileSize x TileSize losses
+   */
+  void ComputeTile (const TileKey &key, double *loss) const;
+  /**
+   * Drop the least recently used tiles, except the most recent one, until
+   * the cached tiles fit in MaxBytes
+   */
+  void Evict (void);
+  /**
+   * \param level the zoom level
+   * \returns the side of a cell at that level [m]
+   */
+  double GetCellSize (uint32_t level) const;
+
+  double m_baseCellSize; //!< side of a cell at level 0 [m]
+  uint32_t m_tileSize; //!< cells per tile side
+  uint32_t m_levels; //!< number of zoom levels
+  uint64_t m_maxBytes; //!< budget of the cached tiles [bytes]
+  double m_receiverHeight; //!< height of the receivers [m]
+  LossQuantization::Encoding m_encoding; //!< storage format of the tiles
+
+  Vector m_position; //!< antenna position of the site
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< empirical model of the site
+
+  /// What the cached tiles depend on
+  struct Signature
+  {
+    EmpiricalPropagationLossModel::Coefficients coefficients; //!< coefficients of the model
+    const ClutterRaster *raster; //!< clutter raster of the model
+    EmpiricalPropagationLossModel::ValidityPolicy validityPolicy; //!< validity policy of the model
+    double minDistance; //!< distance floor of the model [m]
+    EmpiricalMath::Backend mathBackend; //!< implementation of the logarithms of the model
+    Vector position; //!< antenna position of the site
+    double receiverHeight; //!< height of the receivers [m]
+    uint32_t tileSize; //!< cells per tile side
+    double baseCellSize; //!< side of a cell at level 0 [m]
+    LossQuantization::Encoding encoding; //!< storage format of the tiles
+
+    /**
+     * \param o another signature
+     * \returns true if the tiles of o are valid for this signature
+     */
+    bool operator == (const Signature &o) const
+    {
+      return coefficients.c0 == o.coefficients.c0 && coefficients.c1 == o.coefficients.c1
+             && coefficients.c2 == o.coefficients.c2 && raster == o.raster
+             && validityPolicy == o.validityPolicy && minDistance == o.minDistance && mathBackend == o.mathBackend
+             && position.x == o.position.x && position.y == o.position.y && position.z == o.position.z
+             && receiverHeight == o.receiverHeight && tileSize == o.tileSize && baseCellSize == o.baseCellSize
+             && encoding == o.encoding;
+    }
+  };
+  Signature m_signature; //!< signature of the cached tiles
+  bool m_signatureValid; //!< whether m_signature is set
+
+  std::map<TileKey, Tile> m_tiles; //!< cached tiles
+  std::list<TileKey> m_lru; //!< cached tiles, most recently used first
+  uint64_t m_bytes; //!< size of the cached tiles [bytes]
+  Statistics m_statistics; //!< cache statistics
+};
+
+}
+
+#endif /* COVERAGE_TILE_CACHE_H */
@@ -42,6 +42,7 @@
 #include "ns3/double.h"
 #include "ns3/enum.h"
 #include "ns3/pointer.h"
+#include "ns3/perf-counter-scope.h"
 #include <cmath>
 #include "ecc33-propagation-loss-model.h"
 
@@ -55,7 +56,7 @@ TypeId
 ECC33PropagationLossModel::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::ECC33PropagationLossModel")
-    .SetParent<PropagationLossModel> ()
+    .SetParent<EmpiricalPropagationLossModel> ()
     .SetGroupName ("Propagation")
     .AddConstructor<ECC33PropagationLossModel> ()
     .AddAttribute ("Frequency",
@@ -136,26 +137,51 @@ ECC33PropagationLossModel::GetEnvironment (void) const
 double
 ECC33PropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
 {
-  double distance = (a->GetDistanceFrom (b)) / 1e3; //distance in km
-  double frequency = m_frequency / 1e9;             //frequency in GHz
+  Parameters p = GuardParameters (GetReceiverParameters (b), 1);
+  PerfCounterScope scope ("scalar", this, p.environment, 1);
+  double distance = GuardDistance (a->GetDistanceFrom (b));
+  double loss = EmpiricalKernels::Ecc33Loss (p, distance, GetMathBackend ());
 
-  double A_fs = 92.4 + 20*log10(distance) + 20*log10(frequency);
-  double A_bm = 20.41 + 9.83*std::log10(distance) + 7.89*log10(frequency) + 9.56*pow( log10(frequency), 2);
-  double G_b = log10(m_TxAntennaHeight/200)*(13.958 + 5.8*pow(log10(distance), 2));
-  double G_r = 0.0;
-  if (m_environment == Urban){
-    G_r = 0.759*m_RxAntennaHeight - 1.862;
-  } else {
-    G_r = (42.57 + 13.7*log10(frequency))*(log10(m_RxAntennaHeight) - 0.585);
-  }
+  NS_LOG_DEBUG ("dist =" << distance << ", freq = " << p.frequency << ", Tx antenna height = " << p.txAntennaHeight << ", Rx antenna height = " << p.rxAntennaHeight << ", Path Loss = " << -loss);
 
-  double loss_in_db = A_fs + A_bm - G_b - G_r;
+  return loss;
+}
 
-  NS_LOG_DEBUG ("dist =" << distance << ", freq = " << frequency << ", Tx antenna height = " << m_TxAntennaHeight << ", Rx antenna height = " << m_RxAntennaHeight << ", Path Loss = " << loss_in_db << ", G_r = " << G_r << ", G_b = " << G_b << ", A_fs = " << A_fs << ", A_bm = " << A_bm);
+ECC33PropagationLossModel::Parameters
+ECC33PropagationLossModel::DoGetParameters (void) const
+{
+  Parameters p;
+  p.frequency = m_frequency;
+  p.lambda = 300000000 / m_frequency;
+  p.txAntennaHeight = m_TxAntennaHeight;
+  p.rxAntennaHeight = m_RxAntennaHeight;
+  p.environment = m_environment;
+  return p;
+}
 
+ECC33PropagationLossModel::ValidityRange
+ECC33PropagationLossModel::DoGetValidityRange (void) const
+{
+  return EmpiricalKernels::Ecc33ValidityRange ();
+}
 
+ECC33PropagationLossModel::Coefficients
+ECC33PropagationLossModel::DoGetCoefficients (const Parameters &parameters) const
+{
+  return EmpiricalKernels::Ecc33Coefficients (parameters);
+}
 
-  return (0 - loss_in_db);
+ECC33PropagationLossModel::CoefficientDerivatives
+ECC33PropagationLossModel::DoGetCoefficientDerivatives (const Parameters &parameters) const
+{
+  return EmpiricalKernels::Ecc33CoefficientDerivatives (parameters);
+}
+
+int32_t
+ECC33PropagationLossModel::DoGetClutterEnvironment (ClutterRaster::ClutterClass clutter) const
+{
+  // no rural variant: open areas use the suburban gain
+  return clutter == ClutterRaster::Urban ? Urban : Suburban;
 }
 
 double
@@ -20,11 +20,11 @@
 #define ECC33_PROPAGATION_LOSS_MODEL_H
 
 #include "ns3/nstime.h"
-#include "ns3/propagation-loss-model.h"
+#include "ns3/empirical-propagation-loss-model.h"
 
 namespace ns3 {
 
-class ECC33PropagationLossModel : public PropagationLossModel
+class ECC33PropagationLossModel : public EmpiricalPropagationLossModel
 {
 
 public:
@@ -36,7 +36,8 @@ public:
   ECC33PropagationLossModel ();
   enum Environment
   {
-    Suburban, Urban
+    Suburban = EmpiricalKernels::ECC33_SUBURBAN,
+    Urban = EmpiricalKernels::ECC33_URBAN
   };
 
   /**
@@ -105,6 +106,11 @@ private:
 
   virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual Parameters DoGetParameters (void) const;
+  virtual ValidityRange DoGetValidityRange (void) const;
+  virtual Coefficients DoGetCoefficients (const Parameters &parameters) const;
+  virtual int32_t DoGetClutterEnvironment (ClutterRaster::ClutterClass clutter) const;
+  virtual CoefficientDerivatives DoGetCoefficientDerivatives (const Parameters &parameters) const;
 
   double m_frequency; //!< frequency [Hz]
   double m_TxAntennaHeight; //!< Tx Antenna Height [m]
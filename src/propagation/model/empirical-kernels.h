@@ -0,0 +1,626 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef EMPIRICAL_KERNELS_H
+#define EMPIRICAL_KERNELS_H
+
+#include <stdint.h>
+#include <cmath>
+#include "empirical-math.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief The formulas of the ECC-33, Ericsson and SUI models, without
+ * the ns-3 object system
+ *
+ * This header only depends on the standard library and on
+ * empirical-math.h, so offline tools can include it without linking
+ * against ns-3. The ns-3 models (ECC33PropagationLossModel,
+ * EricssonPropagationLossModel, SUIPropagationLossModel, see
+ * EmpiricalPropagationLossModel) are adapters that read their attributes
+ * into a Parameters and call these functions.
+ *
+ * Per configuration, a model reduces to Coefficients of a polynomial in
+ * log10 of the distance (the *Coefficients functions); the LossBatch
+ * kernels then evaluate links with one log10 each. The *Loss functions
+ * evaluate the published formulas of one link directly, as the scalar
+ * path of the models does.
+ *
+ * The losses have the sign convention of the models: they are added to
+ * the Tx power to get the Rx power.
+ */
+namespace EmpiricalKernels {
+
+/**
+ * \brief Loss as a polynomial in log10 of the distance [m]
+ */
+struct Coefficients
+{
+  double c0; //!< constant term [dB]
+  double c1; //!< log10 (d) term [dB]
+  double c2; //!< log10 (d)^2 term [dB]
+};
+
+/**
+ * \brief The link-independent inputs of a model
+ */
+struct Parameters
+{
+  double frequency; //!< frequency [Hz]
+  double lambda; //!< wavelength [m]
+  double txAntennaHeight; //!< Tx (BS) antenna height [m]
+  double rxAntennaHeight; //!< Rx (SS) antenna height [m]
+  int32_t environment; //!< environment or terrain enum value of the model
+};
+
+/**
+ * \brief The inputs a model was designed for
+ */
+struct ValidityRange
+{
+  double minDistance; //!< minimum distance [m]
+  double maxDistance; //!< maximum distance [m]
+  double minFrequency; //!< minimum frequency [Hz]
+  double maxFrequency; //!< maximum frequency [Hz]
+  double minTxAntennaHeight; //!< minimum Tx (BS) antenna height [m]
+  double maxTxAntennaHeight; //!< maximum Tx (BS) antenna height [m]
+  double minRxAntennaHeight; //!< minimum Rx (SS) antenna height [m]
+  double maxRxAntennaHeight; //!< maximum Rx (SS) antenna height [m]
+};
+
+/**
+ * \brief Partial derivatives of the Coefficients of a configuration
+ */
+struct CoefficientDerivatives
+{
+  Coefficients txAntennaHeight; //!< with respect to the Tx (BS) antenna height [dB/m]
+  Coefficients frequency; //!< with respect to the frequency [dB/Hz]
+};
+
+/// Environments of ECC-33, as ECC33PropagationLossModel::Environment
+enum Ecc33Environment
+{
+  ECC33_SUBURBAN = 0,
+  ECC33_URBAN = 1
+};
+
+/// Environments of Ericsson, as EricssonPropagationLossModel::Environment
+enum EricssonEnvironment
+{
+  ERICSSON_RURAL = 0,
+  ERICSSON_SUBURBAN = 1,
+  ERICSSON_URBAN = 2
+};
+
+/// Terrains of SUI, as SUIPropagationLossModel::Terrain
+enum SuiTerrain
+{
+  SUI_A = 0,
+  SUI_B = 1,
+  SUI_C = 2
+};
+
+/**
+ * \param a a value
+ * \param b another value
+ * \returns the smaller one, or a if either is NaN, as std::min
+ */
+constexpr double
+Min (double a, double b)
+{
+  return (b < a) ? b : a;
+}
+
+/**
+ * \param a a value
+ * \param b another value
+ * \returns the larger one, or a if either is NaN, as std::max
+ */
+constexpr double
+Max (double a, double b)
+{
+  return (a < b) ? b : a;
+}
+
+/**
+ * \param value a value
+ * \param min the lower bound
+ * \param max the upper bound
+ * \returns 1 if the value is outside [min, max] or NaN, 0 otherwise
+ */
+constexpr uint64_t
+IsOutOfRange (double value, double min, double max)
+{
+  // bitwise or: no branch, and NaN fails both comparisons
+  return static_cast<uint64_t> (!(value >= min) | !(value <= max));
+}
+
+/**
+ * \param value a value
+ * \param min the lower bound
+ * \param max the upper bound
+ * \returns the value clamped into [min, max]; NaN is mapped to min
+ */
+constexpr double
+ClampToRange (double value, double min, double max)
+{
+  // Max (min, NaN) is min; both compile to minsd/maxsd
+  return Min (max, Max (min, value));
+}
+
+/**
+ * \param c the coefficients
+ * \param logDistance log10 of the distance [m]
+ * \returns the loss
+ */
+constexpr double
+Evaluate (const Coefficients &c, double logDistance)
+{
+  return 0 - (c.c0 + logDistance * (c.c1 + c.c2 * logDistance));
+}
+
+/**
+ * \param c the coefficients at a reference frequency
+ * \param c0 the constant term at another frequency
+ * \returns the coefficients at the other frequency; only c0 depends on
+ *          the frequency
+ */
+constexpr Coefficients
+WithConstantTerm (const Coefficients &c, double c0)
+{
+  return Coefficients { c0, c.c1, c.c2 };
+}
+
+/**
+ * \returns the validity range of ECC-33
+ */
+constexpr ValidityRange
+Ecc33ValidityRange (void)
+{
+  // ECC Report 33: 0.5-3 GHz, 1-10 km, BS 30-200 m, mobile 1-10 m
+  return ValidityRange { 1e3, 10e3, 0.5e9, 3e9, 30.0, 200.0, 1.0, 10.0 };
+}
+
+/**
+ * \returns the validity range of Ericsson
+ */
+constexpr ValidityRange
+EricssonValidityRange (void)
+{
+  // Hata ranges, with the frequency extended to 2 GHz
+  return ValidityRange { 1e3, 20e3, 150e6, 2e9, 30.0, 200.0, 1.0, 10.0 };
+}
+
+/**
+ * \returns the validity range of SUI
+ */
+constexpr ValidityRange
+SuiValidityRange (void)
+{
+  // Erceg et al.: d >= d0 = 100 m up to 8 km, 1.9-11 GHz (with Xf),
+  // BS 10-80 m, SS 2-10 m
+  return ValidityRange { 100.0, 8e3, 1.9e9, 11e9, 10.0, 80.0, 2.0, 10.0 };
+}
+
+/**
+ * Clamp the parameters into a validity range
+ * \param parameters the parameters
+ * \param range the validity range
+ * \returns the clamped parameters; lambda follows the frequency
+ */
+inline Parameters
+ClampParameters (Parameters parameters, const ValidityRange &range)
+{
+  double frequency = ClampToRange (parameters.frequency, range.minFrequency, range.maxFrequency);
+  parameters.lambda *= parameters.frequency / frequency;
+  parameters.frequency = frequency;
+  parameters.txAntennaHeight = ClampToRange (parameters.txAntennaHeight, range.minTxAntennaHeight, range.maxTxAntennaHeight);
+  parameters.rxAntennaHeight = ClampToRange (parameters.rxAntennaHeight, range.minRxAntennaHeight, range.maxRxAntennaHeight);
+  return parameters;
+}
+
+/**
+ * \param p the parameters; the environment is an Ecc33Environment
+ * \returns the coefficients of ECC-33
+ */
+inline Coefficients
+Ecc33Coefficients (const Parameters &p)
+{
+  double frequency = p.frequency / 1e9;    //frequency in GHz
+  double lf = std::log10 (frequency);
+  double g_b = std::log10 (p.txAntennaHeight/200);
+  double G_r = 0.0;
+  if (p.environment == ECC33_URBAN){
+    G_r = 0.759*p.rxAntennaHeight - 1.862;
+  } else {
+    G_r = (42.57 + 13.7*lf)*(std::log10 (p.rxAntennaHeight) - 0.585);
+  }
+
+  // polynomial in log10 of the distance in km
+  double k0 = 92.4 + 20*lf + 20.41 + 7.89*lf + 9.56*lf*lf - 13.958*g_b - G_r;
+  double k1 = 20 + 9.83;
+  double k2 = -5.8*g_b;
+
+  // log10(d[km]) = log10(d[m]) - 3
+  return Coefficients { k0 - 3*k1 + 9*k2, k1 - 6*k2, k2 };
+}
+
+/**
+ * \param p the parameters; the environment is an EricssonEnvironment
+ * \returns the coefficients of Ericsson
+ */
+inline Coefficients
+EricssonCoefficients (const Parameters &p)
+{
+  double frequency = p.frequency / 1e6;   //frequency in MHz
+
+  double g_f = 44.49*std::log10 (frequency) - 4.78*std::pow (std::log10 (frequency), 2);
+  double a0 = 36.2;
+  double a1 = 30.2;
+  double a2 = 12;
+  double a3 = 0.1;
+  if (p.environment == ERICSSON_SUBURBAN){
+    a0 = 43.2;
+    a1 = 68.93;
+  } else if (p.environment == ERICSSON_RURAL){
+    a0 = 45.95;
+    a1 = 100.6;
+  }
+
+  // polynomial in log10 of the distance in km
+  double k0 = a0 + a2*std::log (p.rxAntennaHeight) - 3.2*std::pow (std::log10 (11.75*p.rxAntennaHeight), 2) + g_f;
+  double k1 = a1 + a3*std::log10 (p.txAntennaHeight);
+
+  // log10(d[km]) = log10(d[m]) - 3
+  return Coefficients { k0 - 3*k1, k1, 0.0 };
+}
+
+/**
+ * \param p the parameters; the environment is a SuiTerrain
+ * \param shadowing the shadowing margin [dB]
+ * \returns the coefficients of SUI
+ */
+inline Coefficients
+SuiCoefficients (const Parameters &p, double shadowing)
+{
+  double frequency_MHz = p.frequency * 1e-6;
+
+  double d0 = 100.0;
+
+  double Xf = 6.0 * std::log10 (frequency_MHz / 2000.0);
+  double Xh = -10.8 * std::log10 (p.rxAntennaHeight / 2000.0);
+  double modparam_a = 4.6, modparam_b = 0.0075, modparam_c = 12.6;
+  if (p.environment == SUI_B) {
+    modparam_a = 4.0;
+    modparam_b = 0.0065;
+    modparam_c = 17.1;
+  } else if (p.environment == SUI_C) {
+    modparam_a = 3.6;
+    modparam_b = 0.005;
+    modparam_c = 20.0;
+    Xh = -20.0 * std::log10 (p.rxAntennaHeight / 20000.0);
+  }
+
+  double param_A = 20 * std::log10 (4 * M_PI * d0 / p.lambda);
+
+  double gamma = modparam_a - modparam_b * p.txAntennaHeight + (modparam_c / p.txAntennaHeight);
+
+  return Coefficients { param_A - 10 * gamma * std::log10 (d0) + Xf + Xh + shadowing, 10 * gamma, 0.0 };
+}
+
+/// ln (10), to differentiate the base 10 logarithms
+const double LN10 = 2.30258509299404568;
+
+/**
+ * \param p the parameters; the environment is an Ecc33Environment
+ * \returns the derivatives of Ecc33Coefficients
+ */
+inline CoefficientDerivatives
+Ecc33CoefficientDerivatives (const Parameters &p)
+{
+  double lf = std::log10 (p.frequency / 1e9);
+  // d/df of log10 (f), d/dhb of log10 (hb / 200)
+  double dlf = 1 / (p.frequency * LN10);
+  double dgb = 1 / (p.txAntennaHeight * LN10);
+  double dGr = 0.0;
+  if (p.environment != ECC33_URBAN)
+    {
+      dGr = 13.7 * (std::log10 (p.rxAntennaHeight) - 0.585) * dlf;
+    }
+  double dk2 = -5.8 * dgb;
+
+  CoefficientDerivatives d;
+  d.txAntennaHeight = Coefficients { -13.958 * dgb + 9 * dk2, -6 * dk2, dk2 };
+  d.frequency = Coefficients { (20 + 7.89 + 2 * 9.56 * lf) * dlf - dGr, 0.0, 0.0 };
+  return d;
+}
+
+/**
+ * \param p the parameters; the environment is an EricssonEnvironment
+ * \returns the derivatives of EricssonCoefficients
+ */
+inline CoefficientDerivatives
+EricssonCoefficientDerivatives (const Parameters &p)
+{
+  double lf = std::log10 (p.frequency / 1e6);
+  double dlf = 1 / (p.frequency * LN10);
+  // a3 = 0.1 in every environment
+  double dk1 = 0.1 / (p.txAntennaHeight * LN10);
+
+  CoefficientDerivatives d;
+  d.txAntennaHeight = Coefficients { -3 * dk1, dk1, 0.0 };
+  d.frequency = Coefficients { (44.49 - 2 * 4.78 * lf) * dlf, 0.0, 0.0 };
+  return d;
+}
+
+/**
+ * The wavelength is taken to follow the frequency, as with
+ * SUIPropagationLossModel::SetLambda (frequency, speed)
+ * \param p the parameters; the environment is a SuiTerrain
+ * \returns the derivatives of SuiCoefficients
+ */
+inline CoefficientDerivatives
+SuiCoefficientDerivatives (const Parameters &p)
+{
+  double modparam_b = 0.0075, modparam_c = 12.6;
+  if (p.environment == SUI_B) {
+    modparam_b = 0.0065;
+    modparam_c = 17.1;
+  } else if (p.environment == SUI_C) {
+    modparam_b = 0.005;
+    modparam_c = 20.0;
+  }
+  double dgamma = -modparam_b - modparam_c / (p.txAntennaHeight * p.txAntennaHeight);
+
+  CoefficientDerivatives d;
+  // c0 has -10 * gamma * log10 (d0), with d0 = 100 m
+  d.txAntennaHeight = Coefficients { -20 * dgamma, 10 * dgamma, 0.0 };
+  // 20 log10 (4 pi d0 / lambda) and Xf = 6 log10 (f / 2 GHz)
+  d.frequency = Coefficients { 26 / (p.frequency * LN10), 0.0, 0.0 };
+  return d;
+}
+
+/**
+ * The published ECC-33 formula for one link
+ * \param p the parameters; the environment is an Ecc33Environment
+ * \param distance the link distance [m]
+ * \param backend the implementation of the logarithms
+ * \returns the loss
+ */
+inline double
+Ecc33Loss (const Parameters &p, double distance, EmpiricalMath::Backend backend)
+{
+  distance /= 1e3;                     //distance in km
+  double frequency = p.frequency / 1e9; //frequency in GHz
+
+  double A_fs = 92.4 + 20*EmpiricalMath::Log10 (backend, distance) + 20*EmpiricalMath::Log10 (backend, frequency);
+  double A_bm = 20.41 + 9.83*EmpiricalMath::Log10 (backend, distance) + 7.89*EmpiricalMath::Log10 (backend, frequency)
+    + 9.56*std::pow (EmpiricalMath::Log10 (backend, frequency), 2);
+  double G_b = EmpiricalMath::Log10 (backend, p.txAntennaHeight/200)*(13.958 + 5.8*std::pow (EmpiricalMath::Log10 (backend, distance), 2));
+  double G_r = 0.0;
+  if (p.environment == ECC33_URBAN){
+    G_r = 0.759*p.rxAntennaHeight - 1.862;
+  } else {
+    G_r = (42.57 + 13.7*EmpiricalMath::Log10 (backend, frequency))*(EmpiricalMath::Log10 (backend, p.rxAntennaHeight) - 0.585);
+  }
+
+  return 0 - (A_fs + A_bm - G_b - G_r);
+}
+
+/**
+ * The published Ericsson formula for one link
+ * \param p the parameters; the environment is an EricssonEnvironment
+ * \param distance the link distance [m]
+ * \param backend the implementation of the logarithms
+ * \returns the loss
+ */
+inline double
+EricssonLoss (const Parameters &p, double distance, EmpiricalMath::Backend backend)
+{
+  distance /= 1e3;                     //distance in km
+  double frequency = p.frequency / 1e6; //frequency in MHz
+
+  double g_f = 44.49*EmpiricalMath::Log10 (backend, frequency) - 4.78*std::pow (EmpiricalMath::Log10 (backend, frequency), 2);
+  double a0 = 36.2;
+  double a1 = 30.2;
+  double a2 = 12;
+  double a3 = 0.1;
+  if (p.environment == ERICSSON_SUBURBAN){
+    a0 = 43.2;
+    a1 = 68.93;
+  } else if (p.environment == ERICSSON_RURAL){
+    a0 = 45.95;
+    a1 = 100.6;
+  }
+
+  return 0 - (a0 + a1*EmpiricalMath::Log10 (backend, distance) + a2*EmpiricalMath::Log (backend, p.rxAntennaHeight)
+              + a3*EmpiricalMath::Log10 (backend, p.txAntennaHeight)*EmpiricalMath::Log10 (backend, distance)
+              - 3.2*std::pow (EmpiricalMath::Log10 (backend, 11.75*p.rxAntennaHeight), 2) + g_f);
+}
+
+/**
+ * The published SUI formula for one link
+ * \param p the parameters; the environment is a SuiTerrain
+ * \param shadowing the shadowing margin [dB]
+ * \param distance the link distance [m]
+ * \param backend the implementation of the logarithms
+ * \returns the loss
+ */
+inline double
+SuiLoss (const Parameters &p, double shadowing, double distance, EmpiricalMath::Backend backend)
+{
+  double frequency_MHz = p.frequency * 1e-6;
+
+  double d0 = 100.0;
+
+  double Xf = 6.0 * EmpiricalMath::Log10 (backend, frequency_MHz / 2000.0);
+  double Xh = -10.8 * EmpiricalMath::Log10 (backend, p.rxAntennaHeight / 2000.0);
+  double modparam_a = 4.6, modparam_b = 0.0075, modparam_c = 12.6;
+  if (p.environment == SUI_B) {
+    modparam_a = 4.0;
+    modparam_b = 0.0065;
+    modparam_c = 17.1;
+  } else if (p.environment == SUI_C) {
+    modparam_a = 3.6;
+    modparam_b = 0.005;
+    modparam_c = 20.0;
+    Xh = -20.0 * EmpiricalMath::Log10 (backend, p.rxAntennaHeight / 20000.0);
+  }
+
+  double param_A = 20 * EmpiricalMath::Log10 (backend, 4 * M_PI * d0 / p.lambda);
+
+  double gamma = modparam_a - modparam_b * p.txAntennaHeight + (modparam_c / p.txAntennaHeight);
+
+  return 0 - (param_A + 10 * gamma * EmpiricalMath::Log10 (backend, distance / d0) + Xf + Xh + shadowing);
+}
+
+/**
+ * Clamp the distances into [lower, upper] and take their log10
+ * \param distance the link distances [m]
+ * \param logDistance the logarithms; may be distance
+ * \param n the number of links
+ * \param range the validity range, for the count
+ * \param lower the distance floor [m]
+ * \param upper the distance ceiling [m]
+ * \param backend the implementation of the logarithms
+ * \returns the number of distances outside the validity range
+ */
+inline uint64_t
+LogDistances (const double *distance, double *logDistance, uint32_t n,
+              const ValidityRange &range, double lower, double upper,
+              EmpiricalMath::Backend backend)
+{
+  // two branch-free passes, the logarithms in place
+  uint64_t outOfRange = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      outOfRange += IsOutOfRange (distance[i], range.minDistance, range.maxDistance);
+      logDistance[i] = ClampToRange (distance[i], lower, upper);
+    }
+  EmpiricalMath::Log10 (backend, logDistance, logDistance, n);
+  return outOfRange;
+}
+
+/**
+ * Evaluate the losses of a batch of links with one configuration
+ * \param c the coefficients
+ * \param distance the link distances [m]
+ * \param loss the losses
+ * \param n the number of links
+ * \param range the validity range, for the count
+ * \param lower the distance floor [m]
+ * \param upper the distance ceiling [m]
+ * \param backend the implementation of the logarithms
+ * \returns the number of distances outside the validity range
+ */
+inline uint64_t
+LossBatch (const Coefficients &c, const double *distance, double *loss, uint32_t n,
+           const ValidityRange &range, double lower, double upper,
+           EmpiricalMath::Backend backend)
+{
+  uint64_t outOfRange = LogDistances (distance, loss, n, range, lower, upper, backend);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      loss[i] = Evaluate (c, loss[i]);
+    }
+  return outOfRange;
+}
+
+/**
+ * Evaluate the losses of a batch of links, each with one of several
+ * configurations
+ * \param table the coefficients of each configuration
+ * \param nTable the number of configurations
+ * \param index the configuration of each link; the indices past the
+ *        table use its last row
+ * \param distance the link distances [m]
+ * \param loss the losses
+ * \param n the number of links
+ * \param range the validity range, for the count
+ * \param lower the distance floor [m]
+ * \param upper the distance ceiling [m]
+ * \param backend the implementation of the logarithms
+ * \returns the number of distances outside the validity range
+ */
+inline uint64_t
+LossBatch (const Coefficients *table, uint32_t nTable, const uint8_t *index,
+           const double *distance, double *loss, uint32_t n,
+           const ValidityRange &range, double lower, double upper,
+           EmpiricalMath::Backend backend)
+{
+  uint64_t outOfRange = LogDistances (distance, loss, n, range, lower, upper, backend);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t k = index[i];
+      loss[i] = Evaluate (table[k < nTable ? k : nTable - 1], loss[i]);
+    }
+  return outOfRange;
+}
+
+/**
+ * Evaluate the losses of a batch of links with one configuration, and
+ * their partial derivatives
+ *
+ * The derivative with respect to the distance is zero where the distance
+ * is clamped to [lower, upper].
+ *
+ * \param c the coefficients
+ * \param dc the derivatives of the coefficients
+ * \param distance the link distances [m]
+ * \param loss the losses
+ * \param dDistance the derivatives with respect to the distance [dB/m]
+ * \param dTxAntennaHeight the derivatives with respect to the Tx
+ *        antenna height [dB/m]
+ * \param dFrequency the derivatives with respect to the frequency [dB/Hz]
+ * \param n the number of links
+ * \param range the validity range, for the count
+ * \param lower the distance floor [m]
+ * \param upper the distance ceiling [m]
+ * \param backend the implementation of the logarithms
+ * \returns the number of distances outside the validity range
+ */
+inline uint64_t
+LossGradientBatch (const Coefficients &c, const CoefficientDerivatives &dc,
+                   const double *distance, double *loss, double *dDistance,
+                   double *dTxAntennaHeight, double *dFrequency, uint32_t n,
+                   const ValidityRange &range, double lower, double upper,
+                   EmpiricalMath::Backend backend)
+{
+  uint64_t outOfRange = LogDistances (distance, loss, n, range, lower, upper, backend);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      double l = loss[i];
+      double d = ClampToRange (distance[i], lower, upper);
+      double inside = !IsOutOfRange (distance[i], lower, upper);
+      loss[i] = Evaluate (c, l);
+      dDistance[i] = inside * -(c.c1 + 2 * c.c2 * l) / (d * LN10);
+      // the losses are the opposite of the polynomials
+      dTxAntennaHeight[i] = Evaluate (dc.txAntennaHeight, l);
+      dFrequency[i] = Evaluate (dc.frequency, l);
+    }
+  return outOfRange;
+}
+
+} // namespace EmpiricalKernels
+
+} // namespace ns3
+
+#endif /* EMPIRICAL_KERNELS_H */
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef EMPIRICAL_MATH_H
+#define EMPIRICAL_MATH_H
+
+#include <stdint.h>
+#include <cmath>
+#include <cstring>
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Logarithms of the empirical propagation loss models
+ *
+ * Besides the libm functions, two approximations of log10 are provided:
+ * the argument is split into its binary exponent and a mantissa in
+ * [sqrt(1/2), sqrt(2)) with integer operations on its bits, and log10 of
+ * the mantissa is a minimax polynomial in (mantissa - 1). There is no
+ * branch and no division, so the array forms vectorize.
+ *
+ * The maximum absolute errors on log10 are 4.5e-6 (Accurate, degree 5)
+ * and 2.6e-4 (Fast, degree 3). The steepest term of the ECC-33, Ericsson
+ * and SUI formulas is about 100 dB per decade, and ECC-33, the model with
+ * the most logarithms, adds up to about 200 dB per decade over all of
+ * them, which bounds the loss errors to 0.001 dB and 0.05 dB: within the
+ * 0.01 dB and 0.1 dB the two levels are named after.
+ *
+ * The approximations expect positive, normal arguments; the distances
+ * are floored at the MinDistance of the models before reaching them.
+ */
+namespace EmpiricalMath {
+
+/**
+ * The available implementations
+ */
+enum Backend
+{
+  Exact,     //!< libm
+  Accurate,  //!< loss error below 0.01 dB
+  Fast       //!< loss error below 0.1 dB
+};
+
+/**
+ * Split a positive, normal number into its binary exponent and a
+ * mantissa in [sqrt(1/2), sqrt(2))
+ * \param x the number
+ * \param u the mantissa minus 1
+ * \returns the binary exponent
+ */
+inline double
+Split (double x, double &u)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &x, sizeof (bits));
+  const uint64_t mantissaMask = 0x000fffffffffffffULL;
+  // mantissa bits of sqrt(2): above them, the mantissa is halved
+  const uint64_t sqrt2Mantissa = 0x0006a09e667f3bcdULL;
+  uint64_t mantissa = bits & mantissaMask;
+  uint64_t above = mantissa > sqrt2Mantissa;
+  int64_t exponent = static_cast<int64_t> ((bits >> 52) & 0x7ff) - 1023 + static_cast<int64_t> (above);
+  uint64_t scaled = mantissa | ((1023 - above) << 52);
+  double m;
+  std::memcpy (&m, &scaled, sizeof (m));
+  u = m - 1.0;
+  return static_cast<double> (exponent);
+}
+
+/**
+ * \param x a positive, normal number
+ * \returns log10 (x), with an absolute error below 4.5e-6
+ */
+inline double
+Log10Accurate (double x)
+{
+  double u;
+  double e = Split (x, u);
+  double p = 0.07605809953103557;
+  p = p * u - 0.1187784612765251;
+  p = p * u + 0.14650704162283457;
+  p = p * u - 0.21681442226069608;
+  p = p * u + 0.43425925494106654;
+  return e * 0.30102999566398120 + p * u;
+}
+
+/**
+ * \param x a positive, normal number
+ * \returns log10 (x), with an absolute error below 2.6e-4
+ */
+inline double
+Log10Fast (double x)
+{
+  double u;
+  double e = Split (x, u);
+  double p = 0.13397909811149766;
+  p = p * u - 0.22699975960604982;
+  p = p * u + 0.43503401945529735;
+  return e * 0.30102999566398120 + p * u;
+}
+
+/**
+ * \param backend the implementation
+ * \param x a positive number
+ * \returns log10 (x)
+ */
+inline double
+Log10 (Backend backend, double x)
+{
+  switch (backend)
+    {
+    case Accurate:
+      return Log10Accurate (x);
+    case Fast:
+      return Log10Fast (x);
+    default:
+      return std::log10 (x);
+    }
+}
+
+/**
+ * \param backend the implementation
+ * \param x a positive number
+ * \returns the natural logarithm of x
+ */
+inline double
+Log (Backend backend, double x)
+{
+  return backend == Exact ? std::log (x) : Log10 (backend, x) * 2.30258509299404568;
+}
+
+/**
+ * Compute log10 over an array; the backend is dispatched once, so the
+ * loops are free of branches
+ * \param backend the implementation
+ * \param x the positive numbers
+ * \param y the logarithms; may be x
+ * \param n the number of elements
+ */
+inline void
+Log10 (Backend backend, const double *x, double *y, uint32_t n)
+{
+  switch (backend)
+    {
+    case Accurate:
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          y[i] = Log10Accurate (x[i]);
+        }
+      break;
+    case Fast:
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          y[i] = Log10Fast (x[i]);
+        }
+      break;
+    default:
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          y[i] = std::log10 (x[i]);
+        }
+      break;
+    }
+}
+
+} // namespace EmpiricalMath
+
+} // namespace ns3
+
+#endif /* EMPIRICAL_MATH_H */
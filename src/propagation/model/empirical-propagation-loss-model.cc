@@ -0,0 +1,462 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/mobility-model.h"
+#include "ns3/perf-counter-scope.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include "empirical-propagation-loss-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EmpiricalPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (EmpiricalPropagationLossModel);
+
+using EmpiricalKernels::IsOutOfRange;
+using EmpiricalKernels::ClampToRange;
+
+namespace {
+
+/**
+ * \returns the evaluation counter of the calling thread; the threads
+ *          take the counters in turn
+ */
+uint32_t
+GetEvaluationShard (void)
+{
+  static std::atomic<uint32_t> nextShard (0);
+  static thread_local uint32_t shard = nextShard.fetch_add (1, std::memory_order_relaxed);
+  return shard;
+}
+
+} // anonymous namespace
+
+TypeId
+EmpiricalPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EmpiricalPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddAttribute ("ValidityPolicy",
+                   "What to do with inputs outside the validity range of the model (default is extrapolate).",
+                   EnumValue (Extrapolate),
+                   MakeEnumAccessor (&EmpiricalPropagationLossModel::m_validityPolicy),
+                   MakeEnumChecker (Extrapolate, "Extrapolate", Clamp, "Clamp"))
+    .AddAttribute ("MinDistance",
+                   "Distances below this one are raised to it, whatever the policy (default is 1m).",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&EmpiricalPropagationLossModel::m_minDistance),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MathBackend",
+                   "The implementation of the logarithms: libm, or an approximation within 0.01 dB or 0.1 dB of loss (default is exact).",
+                   EnumValue (EmpiricalMath::Exact),
+                   MakeEnumAccessor (&EmpiricalPropagationLossModel::m_mathBackend),
+                   MakeEnumChecker (EmpiricalMath::Exact, "Exact",
+                                    EmpiricalMath::Accurate, "Accurate",
+                                    EmpiricalMath::Fast, "Fast"))
+    .AddAttribute ("ClutterRaster",
+                   "The clutter raster giving the environment at each receiver (default is none).",
+                   PointerValue (),
+                   MakePointerAccessor (&EmpiricalPropagationLossModel::m_clutterRaster),
+                   MakePointerChecker<ClutterRaster> ())
+    .AddAttribute ("ReportOutOfRange",
+                   "Print the out-of-range counters to std::clog when the model is disposed, if any is not zero (default is true).",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&EmpiricalPropagationLossModel::m_reportOutOfRange),
+                   MakeBooleanChecker ());
+  return tid;
+}
+
+EmpiricalPropagationLossModel::EmpiricalPropagationLossModel ()
+  : m_distanceOutOfRange (0),
+    m_frequencyOutOfRange (0),
+    m_txAntennaHeightOutOfRange (0),
+    m_rxAntennaHeightOutOfRange (0)
+{
+  for (uint32_t i = 0; i < EVALUATION_SHARDS; i++)
+    {
+      m_evaluations[i].value.store (0, std::memory_order_relaxed);
+    }
+}
+
+EmpiricalPropagationLossModel::~EmpiricalPropagationLossModel ()
+{
+}
+
+void
+EmpiricalPropagationLossModel::DoDispose (void)
+{
+  ValidityCounters counters = GetValidityCounters ();
+  if (m_reportOutOfRange
+      && counters.distance + counters.frequency + counters.txAntennaHeight + counters.rxAntennaHeight > 0)
+    {
+      std::clog << GetInstanceTypeId ().GetName () << ": ";
+      PrintValidityReport (std::clog);
+      std::clog << std::endl;
+    }
+  PropagationLossModel::DoDispose ();
+}
+
+EmpiricalPropagationLossModel::Coefficients
+EmpiricalPropagationLossModel::GetCoefficients (void) const
+{
+  return DoGetCoefficients (GuardParameters (DoGetParameters (), 0));
+}
+
+EmpiricalPropagationLossModel::Coefficients
+EmpiricalPropagationLossModel::GetCoefficients (double frequency) const
+{
+  Parameters parameters = DoGetParameters ();
+  parameters.frequency = frequency;
+  parameters.lambda = 300000000 / frequency;
+  return DoGetCoefficients (GuardParameters (parameters, 0));
+}
+
+Ptr<ClutterRaster>
+EmpiricalPropagationLossModel::GetClutterRaster (void) const
+{
+  return m_clutterRaster;
+}
+
+EmpiricalPropagationLossModel::Parameters
+EmpiricalPropagationLossModel::GetReceiverParameters (Ptr<MobilityModel> receiver) const
+{
+  Parameters parameters = DoGetParameters ();
+  if (m_clutterRaster != 0)
+    {
+      parameters.environment = DoGetClutterEnvironment (m_clutterRaster->GetClass (receiver->GetPosition ()));
+    }
+  return parameters;
+}
+
+EmpiricalPropagationLossModel::ValidityPolicy
+EmpiricalPropagationLossModel::GetValidityPolicy (void) const
+{
+  return m_validityPolicy;
+}
+
+double
+EmpiricalPropagationLossModel::GetMinDistance (void) const
+{
+  return m_minDistance;
+}
+
+EmpiricalPropagationLossModel::ValidityRange
+EmpiricalPropagationLossModel::GetValidityRange (void) const
+{
+  return DoGetValidityRange ();
+}
+
+EmpiricalPropagationLossModel::Parameters
+EmpiricalPropagationLossModel::GuardParameters (Parameters parameters, uint32_t n) const
+{
+  ValidityRange range = DoGetValidityRange ();
+  // a batch counts once; the out-of-range counters are only written for
+  // out-of-range inputs, and the evaluations on the counter of the thread
+  if (n > 0)
+    {
+      m_evaluations[GetEvaluationShard () % EVALUATION_SHARDS].value.fetch_add (n, std::memory_order_relaxed);
+      if (IsOutOfRange (parameters.frequency, range.minFrequency, range.maxFrequency))
+        {
+          m_frequencyOutOfRange.fetch_add (n, std::memory_order_relaxed);
+        }
+      if (IsOutOfRange (parameters.txAntennaHeight, range.minTxAntennaHeight, range.maxTxAntennaHeight))
+        {
+          m_txAntennaHeightOutOfRange.fetch_add (n, std::memory_order_relaxed);
+        }
+      if (IsOutOfRange (parameters.rxAntennaHeight, range.minRxAntennaHeight, range.maxRxAntennaHeight))
+        {
+          m_rxAntennaHeightOutOfRange.fetch_add (n, std::memory_order_relaxed);
+        }
+    }
+
+  if (m_validityPolicy == Clamp)
+    {
+      parameters = EmpiricalKernels::ClampParameters (parameters, range);
+    }
+  return parameters;
+}
+
+void
+EmpiricalPropagationLossModel::GetDistanceBounds (double &lower, double &upper) const
+{
+  lower = m_minDistance;
+  upper = std::numeric_limits<double>::infinity ();
+  if (m_validityPolicy == Clamp)
+    {
+      ValidityRange range = DoGetValidityRange ();
+      lower = std::max (lower, range.minDistance);
+      upper = range.maxDistance;
+    }
+}
+
+double
+EmpiricalPropagationLossModel::GuardDistance (double distance) const
+{
+  ValidityRange range = DoGetValidityRange ();
+  if (IsOutOfRange (distance, range.minDistance, range.maxDistance))
+    {
+      m_distanceOutOfRange.fetch_add (1, std::memory_order_relaxed);
+    }
+  double lower;
+  double upper;
+  GetDistanceBounds (lower, upper);
+  return ClampToRange (distance, lower, upper);
+}
+
+void
+EmpiricalPropagationLossModel::GetLossBatch (const double *distance, double *loss, uint32_t n) const
+{
+  NS_LOG_FUNCTION (this << n);
+  DoGetLossBatch (DoGetParameters (), distance, 0, loss, n);
+}
+
+void
+EmpiricalPropagationLossModel::GetLossBatch (const double *distance, const uint8_t *clutter, double *loss, uint32_t n) const
+{
+  NS_LOG_FUNCTION (this << n);
+  DoGetLossBatch (DoGetParameters (), distance, clutter, loss, n);
+}
+
+void
+EmpiricalPropagationLossModel::GetLossBatchAtHeight (double txAntennaHeight, const double *distance,
+                                                     const uint8_t *clutter, double *loss, uint32_t n) const
+{
+  NS_LOG_FUNCTION (this << txAntennaHeight << n);
+  Parameters parameters = DoGetParameters ();
+  parameters.txAntennaHeight = txAntennaHeight;
+  DoGetLossBatch (parameters, distance, clutter, loss, n);
+}
+
+void
+EmpiricalPropagationLossModel::DoGetLossBatch (const Parameters &raw, const double *distance,
+                                               const uint8_t *clutter, double *loss, uint32_t n) const
+{
+  Parameters parameters = GuardParameters (raw, n);
+  PerfCounterScope scope ("batch", this, clutter == 0 ? parameters.environment : -1, n);
+  const ValidityRange range = DoGetValidityRange ();
+  double lower;
+  double upper;
+  GetDistanceBounds (lower, upper);
+
+  uint64_t outOfRange;
+  if (clutter == 0)
+    {
+      const Coefficients c = DoGetCoefficients (parameters);
+      outOfRange = EmpiricalKernels::LossBatch (c, distance, loss, n, range, lower, upper, m_mathBackend);
+    }
+  else
+    {
+      Coefficients table[ClutterRaster::NUM_CLASSES];
+      for (uint32_t k = 0; k < ClutterRaster::NUM_CLASSES; ++k)
+        {
+          parameters.environment = DoGetClutterEnvironment (static_cast<ClutterRaster::ClutterClass> (k));
+          table[k] = DoGetCoefficients (parameters);
+        }
+      // unknown classes read the last row rather than past the table
+      outOfRange = EmpiricalKernels::LossBatch (table, ClutterRaster::NUM_CLASSES, clutter, distance, loss, n,
+                                                range, lower, upper, m_mathBackend);
+    }
+  if (outOfRange > 0)
+    {
+      m_distanceOutOfRange.fetch_add (outOfRange, std::memory_order_relaxed);
+    }
+}
+
+void
+EmpiricalPropagationLossModel::GetLossGrid (const double *distance, uint32_t nDistance,
+                                            const double *frequency, uint32_t nFrequency,
+                                            double *loss) const
+{
+  NS_LOG_FUNCTION (this << nDistance << nFrequency);
+  DoGetLossGrid (distance, 0, nDistance, frequency, nFrequency, loss);
+}
+
+void
+EmpiricalPropagationLossModel::GetLossGrid (const double *distance, const uint8_t *clutter, uint32_t nDistance,
+                                            const double *frequency, uint32_t nFrequency,
+                                            double *loss) const
+{
+  NS_LOG_FUNCTION (this << nDistance << nFrequency);
+  DoGetLossGrid (distance, clutter, nDistance, frequency, nFrequency, loss);
+}
+
+void
+EmpiricalPropagationLossModel::DoGetLossGrid (const double *distance, const uint8_t *clutter, uint32_t nDistance,
+                                              const double *frequency, uint32_t nFrequency, double *loss) const
+{
+  if (nFrequency == 0)
+    {
+      return;
+    }
+
+  // one row of distance coefficients and frequency terms per clutter class
+  uint32_t nTable = clutter == 0 ? 1 : ClutterRaster::NUM_CLASSES;
+  Coefficients table[ClutterRaster::NUM_CLASSES];
+  std::vector<double> frequencyTerm (nTable * nFrequency);
+  Parameters raw = DoGetParameters ();
+  PerfCounterScope scope ("grid", this, clutter == 0 ? raw.environment : -1,
+                          static_cast<uint64_t> (nDistance) * nFrequency);
+  for (uint32_t j = 0; j < nFrequency; ++j)
+    {
+      raw.frequency = frequency[j];
+      raw.lambda = 300000000 / frequency[j];
+      Parameters parameters = GuardParameters (raw, nDistance);
+      for (uint32_t k = 0; k < nTable; ++k)
+        {
+          if (clutter != 0)
+            {
+              parameters.environment = DoGetClutterEnvironment (static_cast<ClutterRaster::ClutterClass> (k));
+            }
+          Coefficients cf = DoGetCoefficients (parameters);
+          NS_ASSERT_MSG (j == 0 || (cf.c1 == table[k].c1 && cf.c2 == table[k].c2),
+                         "distance terms depend on the frequency");
+          frequencyTerm[k * nFrequency + j] = cf.c0;
+          table[k] = cf;
+        }
+    }
+
+  const ValidityRange range = DoGetValidityRange ();
+  double lower;
+  double upper;
+  GetDistanceBounds (lower, upper);
+
+  std::vector<double> logDistance (nDistance);
+  uint64_t outOfRange = EmpiricalKernels::LogDistances (distance, logDistance.data (), nDistance,
+                                                        range, lower, upper, m_mathBackend);
+  for (uint32_t i = 0; i < nDistance; ++i)
+    {
+      // unknown classes read the last row rather than past the table
+      uint32_t k = clutter == 0 ? 0 : std::min<uint32_t> (clutter[i], nTable - 1);
+      const Coefficients &c = table[k];
+      const double *term = &frequencyTerm[k * nFrequency];
+      double l = logDistance[i];
+      double distanceTerm = l * (c.c1 + c.c2 * l);
+      double *row = loss + static_cast<size_t> (i) * nFrequency;
+      for (uint32_t j = 0; j < nFrequency; ++j)
+        {
+          row[j] = 0 - (distanceTerm + term[j]);
+        }
+    }
+  if (outOfRange > 0)
+    {
+      m_distanceOutOfRange.fetch_add (outOfRange * nFrequency, std::memory_order_relaxed);
+    }
+}
+
+void
+EmpiricalPropagationLossModel::DoGetLossGradientBatch (const Parameters &raw, const double *distance, double *loss,
+                                                       double *dDistance, double *dTxAntennaHeight,
+                                                       double *dFrequency, uint32_t n) const
+{
+  const Parameters parameters = GuardParameters (raw, n);
+  PerfCounterScope scope ("gradient", this, parameters.environment, n);
+  const Coefficients c = DoGetCoefficients (parameters);
+  CoefficientDerivatives dc = DoGetCoefficientDerivatives (parameters);
+  // a clamped parameter doesn't move the loss
+  const Coefficients zero = { 0.0, 0.0, 0.0 };
+  if (parameters.txAntennaHeight != raw.txAntennaHeight)
+    {
+      dc.txAntennaHeight = zero;
+    }
+  if (parameters.frequency != raw.frequency)
+    {
+      dc.frequency = zero;
+    }
+  const ValidityRange range = DoGetValidityRange ();
+  double lower;
+  double upper;
+  GetDistanceBounds (lower, upper);
+
+  uint64_t outOfRange = EmpiricalKernels::LossGradientBatch (c, dc, distance, loss, dDistance, dTxAntennaHeight,
+                                                             dFrequency, n, range, lower, upper, m_mathBackend);
+  if (outOfRange > 0)
+    {
+      m_distanceOutOfRange.fetch_add (outOfRange, std::memory_order_relaxed);
+    }
+}
+
+EmpiricalPropagationLossModel::LossGradient
+EmpiricalPropagationLossModel::GetLossGradient (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  NS_LOG_FUNCTION (this << a << b);
+  double distance = a->GetDistanceFrom (b);
+  LossGradient gradient;
+  DoGetLossGradientBatch (GetReceiverParameters (b), &distance, &gradient.loss, &gradient.distance,
+                          &gradient.txAntennaHeight, &gradient.frequency, 1);
+  return gradient;
+}
+
+void
+EmpiricalPropagationLossModel::GetLossGradientBatch (const double *distance, double *loss, double *dDistance,
+                                                     double *dTxAntennaHeight, double *dFrequency, uint32_t n) const
+{
+  NS_LOG_FUNCTION (this << n);
+  DoGetLossGradientBatch (DoGetParameters (), distance, loss, dDistance, dTxAntennaHeight, dFrequency, n);
+}
+
+EmpiricalPropagationLossModel::ValidityCounters
+EmpiricalPropagationLossModel::GetValidityCounters (void) const
+{
+  ValidityCounters counters;
+  counters.evaluations = 0;
+  for (uint32_t i = 0; i < EVALUATION_SHARDS; i++)
+    {
+      counters.evaluations += m_evaluations[i].value.load (std::memory_order_relaxed);
+    }
+  counters.distance = m_distanceOutOfRange.load (std::memory_order_relaxed);
+  counters.frequency = m_frequencyOutOfRange.load (std::memory_order_relaxed);
+  counters.txAntennaHeight = m_txAntennaHeightOutOfRange.load (std::memory_order_relaxed);
+  counters.rxAntennaHeight = m_rxAntennaHeightOutOfRange.load (std::memory_order_relaxed);
+  return counters;
+}
+
+void
+EmpiricalPropagationLossModel::ResetValidityCounters (void)
+{
+  for (uint32_t i = 0; i < EVALUATION_SHARDS; i++)
+    {
+      m_evaluations[i].value.store (0);
+    }
+  m_distanceOutOfRange.store (0);
+  m_frequencyOutOfRange.store (0);
+  m_txAntennaHeightOutOfRange.store (0);
+  m_rxAntennaHeightOutOfRange.store (0);
+}
+
+void
+EmpiricalPropagationLossModel::PrintValidityReport (std::ostream &os) const
+{
+  ValidityCounters counters = GetValidityCounters ();
+  os << counters.evaluations << " evaluations, out of range: "
+     << counters.distance << " distance, "
+     << counters.frequency << " frequency, "
+     << counters.txAntennaHeight << " Tx antenna height, "
+     << counters.rxAntennaHeight << " Rx antenna height";
+}
+
+}
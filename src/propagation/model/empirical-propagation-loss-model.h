@@ -0,0 +1,437 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef EMPIRICAL_PROPAGATION_LOSS_MODEL_H
+#define EMPIRICAL_PROPAGATION_LOSS_MODEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <ostream>
+#include "ns3/propagation-loss-model.h"
+#include "ns3/clutter-raster.h"
+#include "ns3/empirical-math.h"
+#include "ns3/empirical-kernels.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Base class of the empirical ECC-33, Ericsson and SUI models
+ *
+ * For a given configuration (frequency, antenna heights, environment)
+ * the loss of each of these models only depends on the link distance d,
+ * through a polynomial in log10 (d):
+ *
+ *   L = c0 + c1 * log10 (d) + c2 * log10 (d)^2,   d in meters
+ *
+ * Subclasses provide the coefficients of their configuration, which lets
+ * the batch path evaluate many links with a single log10 per link. The
+ * formulas themselves are in EmpiricalKernels, which doesn't depend on
+ * the ns-3 object system; the models only adapt their attributes to it.
+ *
+ * Only c0 depends on the frequency, so the losses of one geometry over
+ * many carrier frequencies are the outer sum of a distance vector and a
+ * frequency vector (see GetLossGrid).
+ *
+ * Each model also has a validity range for the distance, frequency and
+ * antenna heights. Distances are always floored at MinDistance so that a
+ * zero distance does not turn into an infinite loss. With the Clamp
+ * ValidityPolicy every input is also clamped into the validity range;
+ * with Extrapolate the formulas are used as they are. In both cases the
+ * evaluations with out-of-range inputs are counted, see
+ * GetValidityCounters.
+ *
+ * The MathBackend attribute selects libm or one of the log10
+ * approximations of EmpiricalMath for the logarithms evaluated per link.
+ *
+ * When a ClutterRaster is set, the environment or terrain of each link is
+ * the one mapped to the clutter class at the receiver position, in place
+ * of the environment attribute of the model.
+ */
+class EmpiricalPropagationLossModel : public PropagationLossModel
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  EmpiricalPropagationLossModel ();
+  virtual ~EmpiricalPropagationLossModel ();
+
+  /**
+   * What to do with inputs outside the validity range of the model
+   */
+  enum ValidityPolicy
+  {
+    Extrapolate, Clamp
+  };
+
+  /// Loss as a polynomial in log10 of the distance [m]
+  typedef EmpiricalKernels::Coefficients Coefficients;
+  /// The link-independent inputs of a model
+  typedef EmpiricalKernels::Parameters Parameters;
+  /// The inputs a model was designed for
+  typedef EmpiricalKernels::ValidityRange ValidityRange;
+  /// Partial derivatives of the coefficients
+  typedef EmpiricalKernels::CoefficientDerivatives CoefficientDerivatives;
+
+  /**
+   * \brief The loss of a link and its partial derivatives
+   */
+  struct LossGradient
+  {
+    double loss; //!< the loss, with the sign convention of GetLoss
+    double distance; //!< derivative with respect to the link distance [dB/m]
+    double txAntennaHeight; //!< derivative with respect to the Tx (BS) antenna height [dB/m]
+    double frequency; //!< derivative with respect to the frequency [dB/Hz]
+  };
+
+  /**
+   * \brief Number of evaluations with inputs outside the validity range
+   */
+  struct ValidityCounters
+  {
+    uint64_t evaluations; //!< total number of evaluated links
+    uint64_t distance; //!< evaluations with an out-of-range distance
+    uint64_t frequency; //!< evaluations with an out-of-range frequency
+    uint64_t txAntennaHeight; //!< evaluations with an out-of-range Tx antenna height
+    uint64_t rxAntennaHeight; //!< evaluations with an out-of-range Rx antenna height
+  };
+
+  /**
+   * Get the coefficients of the current configuration
+   * \returns the coefficients
+   */
+  Coefficients GetCoefficients (void) const;
+  /**
+   * Get the coefficients of the current configuration at another
+   * frequency
+   * \param frequency frequency [Hz]
+   * \returns the coefficients
+   */
+  Coefficients GetCoefficients (double frequency) const;
+  /**
+   * Get the validity range of the model
+   * \returns the validity range
+   */
+  ValidityRange GetValidityRange (void) const;
+
+  /**
+   * Get the propagation loss of a batch of links
+   *
+   * The results have the sign convention of GetLoss, i.e., they are added
+   * to the Tx power to get the Rx power.
+   *
+   * \param distance the link distances [m]
+   * \param loss the propagation losses (in dBm)
+   * \param n the number of links
+   */
+  void GetLossBatch (const double *distance, double *loss, uint32_t n) const;
+  /**
+   * Get the propagation loss of a batch of links in mixed clutter
+   *
+   * The coefficients of the environment of each clutter class are
+   * computed once per call; each link then picks its row of that table.
+   *
+   * \param distance the link distances [m]
+   * \param clutter the ClutterRaster::ClutterClass of each receiver, see
+   *        ClutterRaster::GetClasses
+   * \param loss the propagation losses (in dBm)
+   * \param n the number of links
+   */
+  void GetLossBatch (const double *distance, const uint8_t *clutter, double *loss, uint32_t n) const;
+  /**
+   * Get the propagation loss of a batch of links as if the Tx antenna
+   * were at another height, without changing the model, so that several
+   * threads can evaluate several heights at once
+   * \param txAntennaHeight the Tx (BS) antenna height [m]
+   * \param distance the link distances [m]
+   * \param clutter the ClutterRaster::ClutterClass of each receiver, or 0
+   *        for the environment of the model
+   * \param loss the propagation losses (in dBm)
+   * \param n the number of links
+   */
+  void GetLossBatchAtHeight (double txAntennaHeight, const double *distance,
+                             const uint8_t *clutter, double *loss, uint32_t n) const;
+  /**
+   * Get the propagation loss of every (distance, frequency) pair
+   *
+   * The distance terms are evaluated once per distance and the frequency
+   * terms once per frequency, so the cost of an extra band is one
+   * addition per link. The results have the sign convention of GetLoss.
+   *
+   * Like GetLossBatch, the links are in the environment of the model,
+   * whether or not a ClutterRaster is set: use the overload with the
+   * clutter classes for the losses GetLoss returns in mixed clutter.
+   *
+   * \param distance the link distances [m]
+   * \param nDistance the number of distances
+   * \param frequency the carrier frequencies [Hz]
+   * \param nFrequency the number of frequencies
+   * \param loss the nDistance x nFrequency propagation losses (in dBm),
+   *        row-major: loss[i * nFrequency + j] is for distance[i] and
+   *        frequency[j]
+   */
+  void GetLossGrid (const double *distance, uint32_t nDistance,
+                    const double *frequency, uint32_t nFrequency,
+                    double *loss) const;
+  /**
+   * Get the propagation loss of every (distance, frequency) pair in mixed
+   * clutter
+   *
+   * The distance and frequency terms are evaluated once per clutter
+   * class, as the coefficients of GetLossBatch in mixed clutter.
+   *
+   * \param distance the link distances [m]
+   * \param clutter the ClutterRaster::ClutterClass of the receiver of
+   *        each distance, see ClutterRaster::GetClasses
+   * \param nDistance the number of distances
+   * \param frequency the carrier frequencies [Hz]
+   * \param nFrequency the number of frequencies
+   * \param loss the nDistance x nFrequency propagation losses (in dBm),
+   *        row-major as in the overload without clutter
+   */
+  void GetLossGrid (const double *distance, const uint8_t *clutter, uint32_t nDistance,
+                    const double *frequency, uint32_t nFrequency,
+                    double *loss) const;
+
+  /**
+   * Get the loss of a link and its partial derivatives, in one pass
+   *
+   * The loss is evaluated from the coefficients, as in GetLossBatch. The
+   * derivatives are zero for the inputs the Clamp ValidityPolicy (or
+   * MinDistance) holds at a bound.
+   *
+   * \param a the mobility model of the source
+   * \param b the mobility model of the destination
+   * \returns the loss and its derivatives
+   */
+  LossGradient GetLossGradient (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  /**
+   * Get the losses of a batch of links and their partial derivatives, in
+   * one pass
+   * \param distance the link distances [m]
+   * \param loss the propagation losses (in dBm)
+   * \param dDistance the derivatives with respect to the distance [dB/m]
+   * \param dTxAntennaHeight the derivatives with respect to the Tx (BS)
+   *        antenna height [dB/m]
+   * \param dFrequency the derivatives with respect to the frequency [dB/Hz]
+   * \param n the number of links
+   */
+  void GetLossGradientBatch (const double *distance, double *loss, double *dDistance,
+                             double *dTxAntennaHeight, double *dFrequency, uint32_t n) const;
+
+  /**
+   * \returns the out-of-range counters since the last reset
+   */
+  ValidityCounters GetValidityCounters (void) const;
+  /**
+   * Reset the out-of-range counters
+   */
+  void ResetValidityCounters (void);
+  /**
+   * Print the out-of-range counters
+   * \param os the output stream
+   */
+  void PrintValidityReport (std::ostream &os) const;
+
+  /**
+   * \returns the clutter raster, or 0 if the model uses a single
+   *          environment
+   */
+  Ptr<ClutterRaster> GetClutterRaster (void) const;
+
+  /**
+   * \returns the ValidityPolicy of the model
+   */
+  ValidityPolicy GetValidityPolicy (void) const;
+  /**
+   * \returns the MinDistance of the model [m]
+   */
+  double GetMinDistance (void) const;
+  /**
+   * \returns the MathBackend of the model
+   */
+  EmpiricalMath::Backend GetMathBackend (void) const
+  {
+    return m_mathBackend;
+  }
+
+protected:
+  virtual void DoDispose (void);
+
+  /**
+   * \param x a positive number
+   * \returns log10 (x), computed with the MathBackend of the model
+   */
+  double Log10 (double x) const
+  {
+    return EmpiricalMath::Log10 (m_mathBackend, x);
+  }
+  /**
+   * \param x a positive number
+   * \returns the natural logarithm of x, computed with the MathBackend
+   *          of the model
+   */
+  double Log (double x) const
+  {
+    return EmpiricalMath::Log (m_mathBackend, x);
+  }
+  /**
+   * Get the configuration parameters of a link, with the environment
+   * taken from the clutter raster when there is one
+   * \param receiver the mobility model of the receiver
+   * \returns the configuration parameters
+   */
+  Parameters GetReceiverParameters (Ptr<MobilityModel> receiver) const;
+  /**
+   * Apply the validity policy to the configuration parameters and count
+   * the out-of-range ones
+   * \param parameters the configuration parameters
+   * \param n the number of links evaluated with them
+   * \returns the parameters to use in the formulas
+   */
+  Parameters GuardParameters (Parameters parameters, uint32_t n) const;
+  /**
+   * Apply the validity policy to the distance of one link and count it
+   * if it is out of range
+   * \param distance the link distance [m]
+   * \returns the distance to use in the formulas [m]
+   */
+  double GuardDistance (double distance) const;
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  EmpiricalPropagationLossModel (const EmpiricalPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  EmpiricalPropagationLossModel & operator = (const EmpiricalPropagationLossModel &);
+
+  /**
+   * Subclasses must implement this to return their configuration
+   * \returns the configuration parameters
+   */
+  virtual Parameters DoGetParameters (void) const = 0;
+  /**
+   * Subclasses must implement this to return their validity range
+   * \returns the validity range
+   */
+  virtual ValidityRange DoGetValidityRange (void) const = 0;
+  /**
+   * Subclasses must implement this to return the coefficients of their
+   * current configuration, with the given parameters in place of their
+   * own
+   * \param parameters the parameters to use
+   * \returns the coefficients
+   */
+  virtual Coefficients DoGetCoefficients (const Parameters &parameters) const = 0;
+  /**
+   * Subclasses must implement this to map a clutter class to one of
+   * their environments
+   * \param clutter the clutter class
+   * \returns the environment or terrain enum value
+   */
+  virtual int32_t DoGetClutterEnvironment (ClutterRaster::ClutterClass clutter) const = 0;
+  /**
+   * Subclasses must implement this to return the derivatives of
+   * DoGetCoefficients
+   * \param parameters the parameters to use
+   * \returns the derivatives of the coefficients
+   */
+  virtual CoefficientDerivatives DoGetCoefficientDerivatives (const Parameters &parameters) const = 0;
+
+  /**
+   * Evaluate a batch of links of one configuration
+   * \param raw the configuration parameters, before the validity policy
+   * \param distance the link distances [m]
+   * \param clutter the clutter class of each receiver, or 0 for the
+   *        environment of the parameters
+   * \param loss the propagation losses (in dBm)
+   * \param n the number of links
+   */
+  void DoGetLossBatch (const Parameters &raw, const double *distance, const uint8_t *clutter,
+                       double *loss, uint32_t n) const;
+  /**
+   * Evaluate every (distance, frequency) pair
+   * \param distance the link distances [m]
+   * \param clutter the clutter class of the receiver of each distance,
+   *        or 0 for the environment of the model
+   * \param nDistance the number of distances
+   * \param frequency the carrier frequencies [Hz]
+   * \param nFrequency the number of frequencies
+   * \param loss the nDistance x nFrequency propagation losses (in dBm)
+   */
+  void DoGetLossGrid (const double *distance, const uint8_t *clutter, uint32_t nDistance,
+                      const double *frequency, uint32_t nFrequency, double *loss) const;
+  /**
+   * Evaluate a batch of links of one configuration with their derivatives
+   * \param raw the configuration parameters, before the validity policy
+   * \param distance the link distances [m]
+   * \param loss the propagation losses (in dBm)
+   * \param dDistance the derivatives with respect to the distance [dB/m]
+   * \param dTxAntennaHeight the derivatives with respect to the Tx (BS)
+   *        antenna height [dB/m]
+   * \param dFrequency the derivatives with respect to the frequency [dB/Hz]
+   * \param n the number of links
+   */
+  void DoGetLossGradientBatch (const Parameters &raw, const double *distance, double *loss, double *dDistance,
+                               double *dTxAntennaHeight, double *dFrequency, uint32_t n) const;
+
+  /**
+   * Get the distance bounds of the validity policy
+   * \param lower the lower bound [m]
+   * \param upper the upper bound [m]
+   */
+  void GetDistanceBounds (double &lower, double &upper) const;
+
+  ValidityPolicy m_validityPolicy; //!< what to do with out-of-range inputs
+  double m_minDistance; //!< distance floor [m]
+  EmpiricalMath::Backend m_mathBackend; //!< implementation of the logarithms
+  Ptr<ClutterRaster> m_clutterRaster; //!< per-receiver environment, if any
+
+  /// Number of evaluation counters, written by different threads
+  static const uint32_t EVALUATION_SHARDS = 8;
+  /// An evaluation counter, two cache lines away from the next one
+  struct EvaluationShard
+  {
+    std::atomic<uint64_t> value; //!< the evaluated links
+    char pad[128 - sizeof (std::atomic<uint64_t>)]; //!< up to the next shard
+  };
+
+  bool m_reportOutOfRange; //!< print the counters to std::clog on dispose
+  mutable EvaluationShard m_evaluations[EVALUATION_SHARDS]; //!< evaluated links, per thread
+  mutable std::atomic<uint64_t> m_distanceOutOfRange; //!< out-of-range distances
+  mutable std::atomic<uint64_t> m_frequencyOutOfRange; //!< links with an out-of-range frequency
+  mutable std::atomic<uint64_t> m_txAntennaHeightOutOfRange; //!< links with an out-of-range Tx antenna height
+  mutable std::atomic<uint64_t> m_rxAntennaHeightOutOfRange; //!< links with an out-of-range Rx antenna height
+};
+
+}
+
+#endif /* EMPIRICAL_PROPAGATION_LOSS_MODEL_H */
@@ -22,6 +22,7 @@
 #include "ns3/double.h"
 #include "ns3/enum.h"
 #include "ns3/pointer.h"
+#include "ns3/perf-counter-scope.h"
 #include <cmath>
 #include "ericsson-propagation-loss-model.h"
 
@@ -35,7 +36,7 @@ TypeId
 EricssonPropagationLossModel::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::EricssonPropagationLossModel")
-    .SetParent<PropagationLossModel> ()
+    .SetParent<EmpiricalPropagationLossModel> ()
     .SetGroupName ("Propagation")
     .AddConstructor<EricssonPropagationLossModel> ()
     .AddAttribute ("Frequency",
@@ -117,31 +118,52 @@ double
 EricssonPropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
 {
 
-  double distance = (a->GetDistanceFrom (b)) / 1e3; // distance in km
-  double frequency = m_frequency / 1e6;            //frequency in MHz
+  Parameters p = GuardParameters (GetReceiverParameters (b), 1);
+  PerfCounterScope scope ("scalar", this, p.environment, 1);
+  double distance = GuardDistance (a->GetDistanceFrom (b));
+  double loss = EmpiricalKernels::EricssonLoss (p, distance, GetMathBackend ());
 
-  double g_f = 44.49*log10(frequency) - 4.78*pow(log10(frequency), 2);
-  double a0;
-  double a1;
-  double a2 = 12;
-  double a3 = 0.1;
-  if(m_environment == Urban){
-    a0 = 36.2;
-    a1 = 30.2;
-  } else if (m_environment == Suburban){
-    a0 = 43.2;
-    a1 = 68.93;
-  } else if (m_environment == Rural){
-    a0 = 45.95;
-    a1 = 100.6;
-  }
+  NS_LOG_DEBUG ("dist =" << distance << ", Path Loss = " << -loss);
 
-  double loss_in_db = a0 + a1*log10(distance) + a2*log(m_RxAntennaHeight) + a3*log10(m_TxAntennaHeight)*log10(distance) - 3.2*pow(log10(11.75*m_RxAntennaHeight), 2) + g_f;
+  return loss;
 
-  NS_LOG_DEBUG ("dist =" << distance << ", Path Loss = " << loss_in_db << ", g_f = " << g_f << ", a0 = " << a0 << ", a1 = " << a1 << ", a2 = " << a2 << ", a3 = " << a3);
+}
 
-  return (0 - loss_in_db);
+EricssonPropagationLossModel::Parameters
+EricssonPropagationLossModel::DoGetParameters (void) const
+{
+  Parameters p;
+  p.frequency = m_frequency;
+  p.lambda = 300000000 / m_frequency;
+  p.txAntennaHeight = m_TxAntennaHeight;
+  p.rxAntennaHeight = m_RxAntennaHeight;
+  p.environment = m_environment;
+  return p;
+}
 
+EricssonPropagationLossModel::ValidityRange
+EricssonPropagationLossModel::DoGetValidityRange (void) const
+{
+  return EmpiricalKernels::EricssonValidityRange ();
+}
+
+EricssonPropagationLossModel::Coefficients
+EricssonPropagationLossModel::DoGetCoefficients (const Parameters &parameters) const
+{
+  return EmpiricalKernels::EricssonCoefficients (parameters);
+}
+
+EricssonPropagationLossModel::CoefficientDerivatives
+EricssonPropagationLossModel::DoGetCoefficientDerivatives (const Parameters &parameters) const
+{
+  return EmpiricalKernels::EricssonCoefficientDerivatives (parameters);
+}
+
+int32_t
+EricssonPropagationLossModel::DoGetClutterEnvironment (ClutterRaster::ClutterClass clutter) const
+{
+  const Environment environment[ClutterRaster::NUM_CLASSES] = { Urban, Suburban, Rural };
+  return environment[clutter];
 }
 
 double
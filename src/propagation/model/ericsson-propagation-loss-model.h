@@ -20,7 +20,7 @@
 #define ERICSSON_PROPAGATION_LOSS_MODEL_H
 
 #include "ns3/nstime.h"
-#include "ns3/propagation-loss-model.h"
+#include "ns3/empirical-propagation-loss-model.h"
 
 namespace ns3 {
 
@@ -31,7 +31,7 @@ namespace ns3 {
  *
  */
 
-class EricssonPropagationLossModel : public PropagationLossModel
+class EricssonPropagationLossModel : public EmpiricalPropagationLossModel
 {
 
 public:
@@ -43,7 +43,9 @@ public:
   EricssonPropagationLossModel ();
   enum Environment
   {
-    Rural, Suburban, Urban
+    Rural = EmpiricalKernels::ERICSSON_RURAL,
+    Suburban = EmpiricalKernels::ERICSSON_SUBURBAN,
+    Urban = EmpiricalKernels::ERICSSON_URBAN
   };
 
   /**
@@ -111,6 +113,11 @@ private:
 
   virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual Parameters DoGetParameters (void) const;
+  virtual ValidityRange DoGetValidityRange (void) const;
+  virtual Coefficients DoGetCoefficients (const Parameters &parameters) const;
+  virtual int32_t DoGetClutterEnvironment (ClutterRaster::ClutterClass clutter) const;
+  virtual CoefficientDerivatives DoGetCoefficientDerivatives (const Parameters &parameters) const;
 
   double m_TxAntennaHeight; //!< Tx Antenna Height [m]
   double m_RxAntennaHeight; //!< Rx Antenna Height [m]
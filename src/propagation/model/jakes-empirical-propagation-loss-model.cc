@@ -0,0 +1,266 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/mobility-model.h"
+#include <cmath>
+#include "clutter-raster.h"
+#include "perf-counter-scope.h"
+#include "jakes-empirical-propagation-loss-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("JakesEmpiricalPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (JakesEmpiricalPropagationLossModel);
+
+TypeId
+JakesEmpiricalPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::JakesEmpiricalPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<JakesEmpiricalPropagationLossModel> ()
+    .AddAttribute ("Median",
+                   "The empirical model of the median loss.",
+                   PointerValue (),
+                   MakePointerAccessor (&JakesEmpiricalPropagationLossModel::m_median),
+                   MakePointerChecker<EmpiricalPropagationLossModel> ())
+    .AddAttribute ("NumberOfOscillators",
+                   "The number of sinusoids of the fading process of each link (default is 20).",
+                   UintegerValue (20),
+                   MakeUintegerAccessor (&JakesEmpiricalPropagationLossModel::SetNumberOfOscillators,
+                                         &JakesEmpiricalPropagationLossModel::GetNumberOfOscillators),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("DopplerFrequencyHz",
+                   "The maximum Doppler frequency of the fading processes (default is 80 Hz).",
+                   DoubleValue (80),
+                   MakeDoubleAccessor (&JakesEmpiricalPropagationLossModel::SetDopplerFrequencyHz,
+                                       &JakesEmpiricalPropagationLossModel::GetDopplerFrequencyHz),
+                   MakeDoubleChecker<double> (0.0));
+  return tid;
+}
+
+JakesEmpiricalPropagationLossModel::JakesEmpiricalPropagationLossModel ()
+  : m_nOscillators (0),
+    m_dopplerFrequency (0)
+{
+  m_uniformVariable = CreateObject<UniformRandomVariable> ();
+}
+
+JakesEmpiricalPropagationLossModel::~JakesEmpiricalPropagationLossModel ()
+{
+}
+
+void
+JakesEmpiricalPropagationLossModel::DoDispose (void)
+{
+  m_median = 0;
+  m_uniformVariable = 0;
+  m_linkIndex.clear ();
+  m_linkA.clear ();
+  m_linkB.clear ();
+  m_phase.clear ();
+  m_omega.clear ();
+  m_amplitudeReal.clear ();
+  m_amplitudeImag.clear ();
+  PropagationLossModel::DoDispose ();
+}
+
+void
+JakesEmpiricalPropagationLossModel::SetNumberOfOscillators (uint32_t n)
+{
+  NS_ABORT_MSG_IF (!m_phase.empty () && n != m_nOscillators,
+                   "Can't change the number of oscillators once links exist");
+  m_nOscillators = n;
+}
+
+uint32_t
+JakesEmpiricalPropagationLossModel::GetNumberOfOscillators (void) const
+{
+  return m_nOscillators;
+}
+
+void
+JakesEmpiricalPropagationLossModel::SetDopplerFrequencyHz (double frequency)
+{
+  NS_ABORT_MSG_IF (!m_phase.empty () && frequency != m_dopplerFrequency,
+                   "Can't change the Doppler frequency once links exist");
+  m_dopplerFrequency = frequency;
+}
+
+double
+JakesEmpiricalPropagationLossModel::GetDopplerFrequencyHz (void) const
+{
+  return m_dopplerFrequency;
+}
+
+uint32_t
+JakesEmpiricalPropagationLossModel::CreateLink (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  uint32_t link = m_phase.size ();
+  NS_LOG_FUNCTION (this << a << b << link);
+
+  // the oscillators of JakesProcess::ConstructOscillators, in the same
+  // order of draws
+  // Initial phase is common for all oscillators:
+  double phi = m_uniformVariable->GetValue (-M_PI, M_PI);
+  // Theta is common for all oscillators:
+  double theta = m_uniformVariable->GetValue (-M_PI, M_PI);
+  for (uint32_t i = 0; i < m_nOscillators; ++i)
+    {
+      uint32_t n = i + 1;
+      double alpha = (2.0 * M_PI * n - M_PI + theta) / (4.0 * m_nOscillators);
+      double psi = m_uniformVariable->GetValue (-M_PI, M_PI);
+      m_omega.push_back (2.0 * M_PI * m_dopplerFrequency * std::cos (alpha));
+      m_amplitudeReal.push_back (std::cos (psi) * 2.0 / std::sqrt (m_nOscillators));
+      m_amplitudeImag.push_back (std::sin (psi) * 2.0 / std::sqrt (m_nOscillators));
+    }
+  m_phase.push_back (phi);
+  m_linkA.push_back (a);
+  m_linkB.push_back (b);
+  return link;
+}
+
+uint32_t
+JakesEmpiricalPropagationLossModel::FindLink (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  const MobilityModel *pa = PeekPointer (a);
+  const MobilityModel *pb = PeekPointer (b);
+  LinkKey key = pa < pb ? LinkKey (pa, pb) : LinkKey (pb, pa);
+  std::map<LinkKey, uint32_t>::const_iterator it = m_linkIndex.find (key);
+  if (it != m_linkIndex.end ())
+    {
+      return it->second;
+    }
+  uint32_t link = CreateLink (a, b);
+  m_linkIndex[key] = link;
+  return link;
+}
+
+uint32_t
+JakesEmpiricalPropagationLossModel::AddLink (Ptr<MobilityModel> a, Ptr<MobilityModel> b)
+{
+  return FindLink (a, b);
+}
+
+uint32_t
+JakesEmpiricalPropagationLossModel::GetNLinks (void) const
+{
+  return m_phase.size ();
+}
+
+double
+JakesEmpiricalPropagationLossModel::DoGetFadingGainDb (uint32_t link, double t) const
+{
+  const double *omega = m_omega.data () + static_cast<size_t> (link) * m_nOscillators;
+  const double *real = m_amplitudeReal.data () + static_cast<size_t> (link) * m_nOscillators;
+  const double *imag = m_amplitudeImag.data () + static_cast<size_t> (link) * m_nOscillators;
+  double phi = m_phase[link];
+  double sumReal = 0;
+  double sumImag = 0;
+  for (uint32_t i = 0; i < m_nOscillators; ++i)
+    {
+      double c = std::cos (omega[i] * t + phi);
+      sumReal += real[i] * c;
+      sumImag += imag[i] * c;
+    }
+  return 10 * std::log10 ((sumReal * sumReal + sumImag * sumImag) / 2);
+}
+
+double
+JakesEmpiricalPropagationLossModel::GetFadingGainDb (uint32_t link) const
+{
+  NS_ASSERT (link < m_phase.size ());
+  return DoGetFadingGainDb (link, Simulator::Now ().GetSeconds ());
+}
+
+void
+JakesEmpiricalPropagationLossModel::GetLossBatch (const uint32_t *link, const double *distance,
+                                                  double *loss, uint32_t n) const
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ABORT_MSG_IF (m_median == 0, "No Median model");
+  m_median->GetLossBatch (distance, loss, n);
+  AddFadingGains (link, loss, n);
+}
+
+void
+JakesEmpiricalPropagationLossModel::AddFadingGains (const uint32_t *link, double *loss, uint32_t n) const
+{
+  PerfCounterScope scope ("fading", this, -1, n);
+  double t = Simulator::Now ().GetSeconds ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      NS_ASSERT (link[i] < m_phase.size ());
+      loss[i] += DoGetFadingGainDb (link[i], t);
+    }
+}
+
+void
+JakesEmpiricalPropagationLossModel::GetLinkLosses (double *loss) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_median == 0, "No Median model");
+
+  uint32_t n = m_phase.size ();
+  std::vector<double> distance (n);
+  std::vector<uint32_t> link (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      distance[i] = m_linkA[i]->GetDistanceFrom (m_linkB[i]);
+      link[i] = i;
+    }
+
+  Ptr<ClutterRaster> raster = m_median->GetClutterRaster ();
+  if (raster == 0)
+    {
+      GetLossBatch (link.data (), distance.data (), loss, n);
+      return;
+    }
+  std::vector<uint8_t> clutter (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      clutter[i] = raster->GetClass (m_linkB[i]->GetPosition ());
+    }
+  m_median->GetLossBatch (distance.data (), clutter.data (), loss, n);
+  AddFadingGains (link.data (), loss, n);
+}
+
+double
+JakesEmpiricalPropagationLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  NS_ABORT_MSG_IF (m_median == 0, "No Median model");
+  uint32_t link = FindLink (a, b);
+  return m_median->CalcRxPower (txPowerDbm, a, b)
+         + DoGetFadingGainDb (link, Simulator::Now ().GetSeconds ());
+}
+
+int64_t
+JakesEmpiricalPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  m_uniformVariable->SetStream (stream);
+  return 1;
+}
+
+}
@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef JAKES_EMPIRICAL_PROPAGATION_LOSS_MODEL_H
+#define JAKES_EMPIRICAL_PROPAGATION_LOSS_MODEL_H
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "ns3/nstime.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/empirical-propagation-loss-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Median loss of an empirical model plus Jakes fast fading
+ *
+ * The loss is the loss of the Median model (ECC-33, Ericsson or SUI)
+ * plus the gain of a sum-of-sinusoids fading process, built like the
+ * oscillators of JakesProcess: each link has NumberOfOscillators
+ * oscillators with rotation speeds 2 pi fd cos (alpha_n), random
+ * complex amplitudes and a random common phase.
+ *
+ * Instead of one JakesProcess object per link, reached through a
+ * PropagationCache, the oscillators of all the links are kept in
+ * contiguous arrays, indexed by link. Links are registered on first use
+ * or with AddLink, and GetLossBatch evaluates the median loss and the
+ * fading of a batch of links in one call. The fading is reciprocal: (a,
+ * b) and (b, a) are the same link.
+ *
+ * The fading processes are drawn when the links are registered, so the
+ * oscillator count and Doppler frequency can't change once a link
+ * exists.
+ */
+class JakesEmpiricalPropagationLossModel : public PropagationLossModel
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  JakesEmpiricalPropagationLossModel ();
+  virtual ~JakesEmpiricalPropagationLossModel ();
+
+  /**
+   * Register a link, if not already known
+   * \param a the mobility model of the source
+   * \param b the mobility model of the destination
+   * \returns the index of the link
+   */
+  uint32_t AddLink (Ptr<MobilityModel> a, Ptr<MobilityModel> b);
+  /**
+   * \returns the number of registered links
+   */
+  uint32_t GetNLinks (void) const;
+  /**
+   * \param link the index of a link
+   * \returns the fading gain of the link now [dB]
+   */
+  double GetFadingGainDb (uint32_t link) const;
+
+  /**
+   * Get the propagation loss of a batch of registered links now
+   *
+   * The results have the sign convention of
+   * EmpiricalPropagationLossModel::GetLoss, i.e., they are added to the
+   * Tx power to get the Rx power.
+   *
+   * \param link the link indices, see AddLink
+   * \param distance the link distances [m]
+   * \param loss the propagation losses (in dBm)
+   * \param n the number of links
+   */
+  void GetLossBatch (const uint32_t *link, const double *distance, double *loss, uint32_t n) const;
+  /**
+   * Get the propagation loss of every registered link now, in link index
+   * order, from the current positions of the nodes. With a clutter
+   * raster on the median model, each link uses the class at its
+   * destination.
+   * \param loss the GetNLinks () propagation losses (in dBm)
+   */
+  void GetLinkLosses (double *loss) const;
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  JakesEmpiricalPropagationLossModel (const JakesEmpiricalPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  JakesEmpiricalPropagationLossModel & operator = (const JakesEmpiricalPropagationLossModel &);
+
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+  virtual void DoDispose (void);
+
+  /**
+   * \param a the mobility model of the source
+   * \param b the mobility model of the destination
+   * \returns the index of the link, registered if new
+   */
+  uint32_t FindLink (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  /**
+   * Draw the oscillators of a new link
+   * \param a the mobility model of the source
+   * \param b the mobility model of the destination
+   * \returns the index of the link
+   */
+  uint32_t CreateLink (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  /**
+   * \param link the index of a link
+   * \param t the time [s]
+   * \returns the fading gain of the link [dB]
+   */
+  double DoGetFadingGainDb (uint32_t link, double t) const;
+  /**
+   * Add the fading gains of a batch of links now
+   * \param link the link indices
+   * \param loss the propagation losses (in dBm)
+   * \param n the number of links
+   */
+  void AddFadingGains (const uint32_t *link, double *loss, uint32_t n) const;
+
+  /**
+   * \param n the number of oscillators per link
+   */
+  void SetNumberOfOscillators (uint32_t n);
+  /**
+   * \returns the number of oscillators per link
+   */
+  uint32_t GetNumberOfOscillators (void) const;
+  /**
+   * \param frequency the maximum Doppler frequency [Hz]
+   */
+  void SetDopplerFrequencyHz (double frequency);
+  /**
+   * \returns the maximum Doppler frequency [Hz]
+   */
+  double GetDopplerFrequencyHz (void) const;
+
+  /// Unordered pair of mobility models
+  typedef std::pair<const MobilityModel *, const MobilityModel *> LinkKey;
+
+  Ptr<EmpiricalPropagationLossModel> m_median; //!< the median loss model
+  uint32_t m_nOscillators; //!< number of oscillators per link
+  double m_dopplerFrequency; //!< maximum Doppler frequency [Hz]
+  Ptr<UniformRandomVariable> m_uniformVariable; //!< random phases
+
+  mutable std::map<LinkKey, uint32_t> m_linkIndex; //!< mobility models -> link index
+  mutable std::vector<Ptr<MobilityModel> > m_linkA; //!< source of each link
+  mutable std::vector<Ptr<MobilityModel> > m_linkB; //!< destination of each link
+  mutable std::vector<double> m_phase; //!< common phase of each link
+  mutable std::vector<double> m_omega; //!< rotation speeds [rad/s], m_nOscillators per link
+  mutable std::vector<double> m_amplitudeReal; //!< real parts of the amplitudes, m_nOscillators per link
+  mutable std::vector<double> m_amplitudeImag; //!< imaginary parts of the amplitudes, m_nOscillators per link
+};
+
+}
+
+#endif /* JAKES_EMPIRICAL_PROPAGATION_LOSS_MODEL_H */
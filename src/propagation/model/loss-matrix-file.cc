@@ -0,0 +1,355 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/node.h"
+#include "ns3/mobility-model.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "loss-matrix-file.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LossMatrixFile");
+
+const char LossMatrixFile::LOSS_MATRIX_MAGIC[8] = { 'N', 'S', '3', 'L', 'O', 'S', 'S', '\0' };
+const uint32_t LossMatrixFile::LOSS_MATRIX_VERSION;
+const uint32_t LossMatrixFile::NOT_FOUND;
+
+/**
+ * \param model the model
+ * \param name the attribute name
+ * \param alternate the attribute name used by SUI-style models, if any
+ * \returns the attribute value, or 0 if the model has neither attribute
+ */
+static double
+GetDoubleAttribute (Ptr<PropagationLossModel> model, std::string name, std::string alternate)
+{
+  DoubleValue value (0.0);
+  if (!model->GetAttributeFailSafe (name, value) && !alternate.empty ())
+    {
+      model->GetAttributeFailSafe (alternate, value);
+    }
+  return value.Get ();
+}
+
+/**
+ * \param model the model
+ * \param tx the mobility of the row
+ * \param rx the mobility of the columns
+ * \param row the losses of the row [dB]
+ */
+static void
+ComputeRow (Ptr<PropagationLossModel> model, Ptr<MobilityModel> tx,
+            const std::vector<Ptr<MobilityModel> > &rx, double *row)
+{
+  for (uint32_t j = 0; j < rx.size (); ++j)
+    {
+      row[j] = 0 - model->CalcRxPower (0, tx, rx[j]);
+    }
+}
+
+/// Size of the header of the version 1 files, which ends before the scale
+static const uint32_t LOSS_MATRIX_V1_HEADER_SIZE = offsetof (LossMatrixHeader, scaleOffset);
+
+LossMatrixFile::LossMatrixFile ()
+  : m_map (0),
+    m_mapSize (0),
+    m_losses (0),
+    m_encoding (LossQuantization::Double)
+{
+  std::memset (&m_header, 0, sizeof (m_header));
+  m_scale.offset = 0;
+  m_scale.step = 1;
+}
+
+LossMatrixFile::~LossMatrixFile ()
+{
+  Close ();
+}
+
+uint64_t
+LossMatrixFile::GetLossOffset (uint32_t headerSize, uint32_t nTx, uint32_t nRx)
+{
+  uint64_t offset = headerSize + (static_cast<uint64_t> (nTx) + nRx) * sizeof (uint32_t);
+  return (offset + 7) & ~static_cast<uint64_t> (7);
+}
+
+void
+LossMatrixFile::Write (std::string filename, Ptr<PropagationLossModel> model,
+                       NodeContainer tx, NodeContainer rx, LossQuantization::Encoding encoding)
+{
+  NS_LOG_FUNCTION (filename << model << tx.GetN () << rx.GetN () << encoding);
+
+  LossMatrixHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, LOSS_MATRIX_MAGIC, sizeof (header.magic));
+  header.version = LOSS_MATRIX_VERSION;
+  header.headerSize = sizeof (LossMatrixHeader);
+  std::strncpy (header.model, model->GetInstanceTypeId ().GetName ().c_str (), sizeof (header.model) - 1);
+  header.frequency = GetDoubleAttribute (model, "Frequency", "");
+  header.txAntennaHeight = GetDoubleAttribute (model, "TxAntennaHeight", "BSAntennaHeight");
+  header.rxAntennaHeight = GetDoubleAttribute (model, "RxAntennaHeight", "SSAntennaHeight");
+  EnumValue environment (0);
+  if (!model->GetAttributeFailSafe ("Environment", environment))
+    {
+      model->GetAttributeFailSafe ("Terrain", environment);
+    }
+  header.environment = environment.Get ();
+  header.nTx = tx.GetN ();
+  header.nRx = rx.GetN ();
+  header.encoding = encoding;
+
+  std::ofstream os (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os.is_open ())
+    {
+      NS_FATAL_ERROR ("Can't open loss matrix file " << filename);
+    }
+  os.write (reinterpret_cast<const char *> (&header), sizeof (header));
+
+  std::vector<Ptr<MobilityModel> > txMobility;
+  for (NodeContainer::Iterator i = tx.Begin (); i != tx.End (); ++i)
+    {
+      uint32_t id = (*i)->GetId ();
+      os.write (reinterpret_cast<const char *> (&id), sizeof (id));
+      txMobility.push_back ((*i)->GetObject<MobilityModel> ());
+      NS_ABORT_MSG_IF (txMobility.back () == 0, "Node " << id << " has no MobilityModel");
+    }
+  std::vector<Ptr<MobilityModel> > rxMobility;
+  for (NodeContainer::Iterator i = rx.Begin (); i != rx.End (); ++i)
+    {
+      uint32_t id = (*i)->GetId ();
+      os.write (reinterpret_cast<const char *> (&id), sizeof (id));
+      rxMobility.push_back ((*i)->GetObject<MobilityModel> ());
+      NS_ABORT_MSG_IF (rxMobility.back () == 0, "Node " << id << " has no MobilityModel");
+    }
+  uint64_t written = sizeof (header) + (txMobility.size () + rxMobility.size ()) * sizeof (uint32_t);
+  const char padding[8] = { 0 };
+
+  std::vector<double> row (rxMobility.size ());
+  LossQuantization::Scale scale = { 0.0, 1.0 };
+  FILE *rows = 0;
+  if (encoding != LossQuantization::Double && !rxMobility.empty ())
+    {
+      // keep the rows until the range is known, without evaluating them again
+      rows = std::tmpfile ();
+      if (rows == 0)
+        {
+          NS_FATAL_ERROR ("Can't create the temporary rows of loss matrix file " << filename);
+        }
+      double min = std::numeric_limits<double>::infinity ();
+      double max = -std::numeric_limits<double>::infinity ();
+      for (uint32_t i = 0; i < txMobility.size (); ++i)
+        {
+          ComputeRow (model, txMobility[i], rxMobility, row.data ());
+          if (std::fwrite (row.data (), sizeof (double), row.size (), rows) != row.size ())
+            {
+              std::fclose (rows);
+              NS_FATAL_ERROR ("Error while writing the temporary rows of loss matrix file " << filename);
+            }
+          double rowMin;
+          double rowMax;
+          LossQuantization::GetRange (row.data (), row.size (), rowMin, rowMax);
+          min = std::min (min, rowMin);
+          max = std::max (max, rowMax);
+        }
+      scale = LossQuantization::MakeScale (encoding, min, max);
+      std::rewind (rows);
+    }
+  // the scale is only known now: rewrite the header
+  header.scaleOffset = scale.offset;
+  header.scaleStep = scale.step;
+  os.seekp (0);
+  os.write (reinterpret_cast<const char *> (&header), sizeof (header));
+  os.seekp (written);
+  os.write (padding, GetLossOffset (header.headerSize, header.nTx, header.nRx) - written);
+
+  std::vector<char> codes (row.size () * LossQuantization::GetValueSize (encoding));
+  for (uint32_t i = 0; i < txMobility.size (); ++i)
+    {
+      if (rows == 0)
+        {
+          ComputeRow (model, txMobility[i], rxMobility, row.data ());
+        }
+      else if (std::fread (row.data (), sizeof (double), row.size (), rows) != row.size ())
+        {
+          std::fclose (rows);
+          NS_FATAL_ERROR ("Error while reading the temporary rows of loss matrix file " << filename);
+        }
+      LossQuantization::Encode (encoding, row.data (), codes.data (), row.size (), scale);
+      os.write (codes.data (), codes.size ());
+    }
+  if (rows != 0)
+    {
+      std::fclose (rows);
+    }
+  if (!os.good ())
+    {
+      NS_FATAL_ERROR ("Error while writing loss matrix file " << filename);
+    }
+}
+
+void
+LossMatrixFile::Open (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_FATAL_ERROR ("Can't open loss matrix file " << filename);
+    }
+  struct stat st;
+  if (fstat (fd, &st) != 0 || static_cast<uint64_t> (st.st_size) < LOSS_MATRIX_V1_HEADER_SIZE)
+    {
+      close (fd);
+      NS_FATAL_ERROR ("Loss matrix file " << filename << " is truncated");
+    }
+  m_mapSize = st.st_size;
+  m_map = mmap (0, m_mapSize, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (m_map == MAP_FAILED)
+    {
+      m_map = 0;
+      NS_FATAL_ERROR ("Can't map loss matrix file " << filename);
+    }
+  // lookups follow the node pairs of the simulation, not the file order
+  madvise (m_map, m_mapSize, MADV_RANDOM);
+
+  // a version 1 header is shorter: copy the fields the file has
+  const LossMatrixHeader *header = static_cast<const LossMatrixHeader *> (m_map);
+  if (std::memcmp (header->magic, LOSS_MATRIX_MAGIC, sizeof (header->magic)) != 0)
+    {
+      NS_FATAL_ERROR (filename << " is not a loss matrix file");
+    }
+  if (!(header->version == LOSS_MATRIX_VERSION && header->headerSize == sizeof (LossMatrixHeader))
+      && !(header->version == 1 && header->headerSize == LOSS_MATRIX_V1_HEADER_SIZE))
+    {
+      NS_FATAL_ERROR ("Loss matrix file " << filename << " has version " << header->version
+                      << ", expected 1 or " << LOSS_MATRIX_VERSION);
+    }
+  if (m_mapSize < header->headerSize)
+    {
+      NS_FATAL_ERROR ("Loss matrix file " << filename << " is truncated");
+    }
+  std::memset (&m_header, 0, sizeof (m_header));
+  std::memcpy (&m_header, header, header->headerSize);
+  if (m_header.version == 1)
+    {
+      m_header.encoding = LossQuantization::Double;
+      m_header.scaleStep = 1;
+    }
+  if (m_header.encoding > LossQuantization::Uint8)
+    {
+      NS_FATAL_ERROR ("Loss matrix file " << filename << " has an unknown encoding " << m_header.encoding);
+    }
+  m_encoding = static_cast<LossQuantization::Encoding> (m_header.encoding);
+  m_scale.offset = m_header.scaleOffset;
+  m_scale.step = m_header.scaleStep;
+
+  uint64_t offset = GetLossOffset (m_header.headerSize, m_header.nTx, m_header.nRx);
+  if (m_mapSize != offset + static_cast<uint64_t> (m_header.nTx) * m_header.nRx * LossQuantization::GetValueSize (m_encoding))
+    {
+      NS_FATAL_ERROR ("Loss matrix file " << filename << " has an inconsistent size");
+    }
+  m_losses = static_cast<const char *> (m_map) + offset;
+
+  const uint32_t *ids = reinterpret_cast<const uint32_t *> (static_cast<const char *> (m_map) + m_header.headerSize);
+  for (uint32_t i = 0; i < m_header.nTx; ++i, ++ids)
+    {
+      if (*ids >= m_txIndex.size ())
+        {
+          m_txIndex.resize (*ids + 1, NOT_FOUND);
+        }
+      m_txIndex[*ids] = i;
+    }
+  for (uint32_t i = 0; i < m_header.nRx; ++i, ++ids)
+    {
+      if (*ids >= m_rxIndex.size ())
+        {
+          m_rxIndex.resize (*ids + 1, NOT_FOUND);
+        }
+      m_rxIndex[*ids] = i;
+    }
+
+  NS_LOG_DEBUG ("mapped " << m_header.nTx << "x" << m_header.nRx << " losses of " << m_header.model
+                          << ", freq = " << m_header.frequency << ", Tx antenna height = " << m_header.txAntennaHeight
+                          << ", Rx antenna height = " << m_header.rxAntennaHeight << ", environment = " << m_header.environment
+                          << ", encoding = " << m_header.encoding);
+}
+
+void
+LossMatrixFile::Close (void)
+{
+  if (m_map != 0)
+    {
+      munmap (m_map, m_mapSize);
+    }
+  m_map = 0;
+  m_mapSize = 0;
+  std::memset (&m_header, 0, sizeof (m_header));
+  m_losses = 0;
+  m_encoding = LossQuantization::Double;
+  m_txIndex.clear ();
+  m_rxIndex.clear ();
+}
+
+bool
+LossMatrixFile::IsOpen (void) const
+{
+  return m_map != 0;
+}
+
+const LossMatrixHeader &
+LossMatrixFile::GetHeader (void) const
+{
+  NS_ASSERT (IsOpen ());
+  return m_header;
+}
+
+void
+LossMatrixFile::GetRow (uint32_t tx, double *loss) const
+{
+  NS_ASSERT (IsOpen () && tx < m_header.nTx);
+  uint64_t begin = static_cast<uint64_t> (tx) * m_header.nRx * LossQuantization::GetValueSize (m_encoding);
+  LossQuantization::Decode (m_encoding, static_cast<const char *> (m_losses) + begin, loss, m_header.nRx, m_scale);
+}
+
+uint32_t
+LossMatrixFile::GetTxIndex (uint32_t nodeId) const
+{
+  return nodeId < m_txIndex.size () ? m_txIndex[nodeId] : NOT_FOUND;
+}
+
+uint32_t
+LossMatrixFile::GetRxIndex (uint32_t nodeId) const
+{
+  return nodeId < m_rxIndex.size () ? m_rxIndex[nodeId] : NOT_FOUND;
+}
+
+}
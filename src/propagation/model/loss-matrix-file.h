@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef LOSS_MATRIX_FILE_H
+#define LOSS_MATRIX_FILE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ns3/ptr.h"
+#include "ns3/node-container.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/loss-quantization.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Fixed-size header at the start of a loss matrix file
+ *
+ * A loss matrix file is laid out as
+ *   - this header
+ *   - nTx uint32_t node ids, one per row
+ *   - nRx uint32_t node ids, one per column
+ *   - padding up to the next multiple of 8 bytes
+ *   - nTx * nRx losses [dB], row-major, stored as given by encoding
+ *
+ * All fields are stored in host byte order; the magic doubles as an
+ * endianness check.
+ *
+ * Version 1 files end their header at scaleOffset, with a zero encoding
+ * (double losses); they are still read.
+ */
+struct LossMatrixHeader
+{
+  char magic[8];            //!< LOSS_MATRIX_MAGIC
+  uint32_t version;         //!< LOSS_MATRIX_VERSION
+  uint32_t headerSize;      //!< sizeof (LossMatrixHeader) of the writer
+  char model[64];           //!< TypeId name of the model that produced the losses
+  double frequency;         //!< frequency [Hz]
+  double txAntennaHeight;   //!< Tx (BS) antenna height [m]
+  double rxAntennaHeight;   //!< Rx (SS) antenna height [m]
+  int32_t environment;      //!< environment or terrain enum value of the model
+  uint32_t nTx;             //!< number of rows
+  uint32_t nRx;             //!< number of columns
+  uint32_t encoding;        //!< LossQuantization::Encoding of the losses
+  double scaleOffset;       //!< loss of code 0 of the quantized encodings [dB]
+  double scaleStep;         //!< loss step between two codes of the quantized encodings [dB]
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Read-only, memory-mapped view of a precomputed loss matrix
+ *
+ * The file is mapped shared and read-only, so pages are brought in
+ * lazily on first access and are shared between all the processes
+ * mapping the same file.
+ */
+class LossMatrixFile
+{
+public:
+  /// Magic at the start of every loss matrix file
+  static const char LOSS_MATRIX_MAGIC[8];
+  /// Current version of the file format
+  static const uint32_t LOSS_MATRIX_VERSION = 2;
+
+  LossMatrixFile ();
+  ~LossMatrixFile ();
+
+  /**
+   * Evaluate a model over every (tx, rx) node pair and store the result
+   *
+   * The frequency, antenna heights and environment recorded in the
+   * header are read from the model attributes when it has them.
+   *
+   * The quantized encodings take the scale from the range of the finite
+   * losses of the whole matrix. The model is evaluated once: the rows go
+   * to a temporary file until the range is known, then are read back one
+   * at a time and stored as codes.
+   *
+   * \param filename the file to create
+   * \param model the model to evaluate
+   * \param tx the nodes of the rows, which must have a MobilityModel
+   * \param rx the nodes of the columns, which must have a MobilityModel
+   * \param encoding the storage format of the losses
+   */
+  static void Write (std::string filename, Ptr<PropagationLossModel> model,
+                     NodeContainer tx, NodeContainer rx,
+                     LossQuantization::Encoding encoding = LossQuantization::Double);
+
+  /**
+   * Map a loss matrix file, aborting on a malformed or incompatible file
+   * \param filename the file to map
+   */
+  void Open (std::string filename);
+  /**
+   * Unmap the file, if any
+   */
+  void Close (void);
+  /**
+   * \returns true if a file is currently mapped
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * \returns the header of the mapped file
+   */
+  const LossMatrixHeader & GetHeader (void) const;
+  /**
+   * \param nodeId a node id
+   * \returns the row of the node, or NOT_FOUND
+   */
+  uint32_t GetTxIndex (uint32_t nodeId) const;
+  /**
+   * \param nodeId a node id
+   * \returns the column of the node, or NOT_FOUND
+   */
+  uint32_t GetRxIndex (uint32_t nodeId) const;
+  /**
+   * \param tx row
+   * \param rx column
+   * \returns the loss [dB]
+   */
+  double GetLoss (uint32_t tx, uint32_t rx) const
+  {
+    uint64_t k = static_cast<uint64_t> (tx) * m_header.nRx + rx;
+    switch (m_encoding)
+      {
+      case LossQuantization::Uint16:
+        return LossQuantization::Decode (static_cast<const uint16_t *> (m_losses)[k], m_scale);
+      case LossQuantization::Uint8:
+        return LossQuantization::Decode (static_cast<const uint8_t *> (m_losses)[k], m_scale);
+      default:
+        return static_cast<const double *> (m_losses)[k];
+      }
+  }
+  /**
+   * \param tx row
+   * \param loss the nRx losses of the row [dB]
+   */
+  void GetRow (uint32_t tx, double *loss) const;
+
+  /// Returned by GetTxIndex and GetRxIndex for unknown nodes
+  static const uint32_t NOT_FOUND = 0xffffffff;
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  LossMatrixFile (const LossMatrixFile &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  LossMatrixFile & operator = (const LossMatrixFile &);
+
+  /**
+   * \param headerSize size of the header [bytes]
+   * \param nTx number of rows
+   * \param nRx number of columns
+   * \returns the offset of the first loss value in the file
+   */
+  static uint64_t GetLossOffset (uint32_t headerSize, uint32_t nTx, uint32_t nRx);
+
+  void *m_map; //!< start of the mapping
+  uint64_t m_mapSize; //!< size of the mapping [bytes]
+  LossMatrixHeader m_header; //!< header, completed for version 1 files
+  const void *m_losses; //!< losses, inside the mapping
+  LossQuantization::Encoding m_encoding; //!< storage format of the losses
+  LossQuantization::Scale m_scale; //!< scale of the codes
+  std::vector<uint32_t> m_txIndex; //!< node id -> row
+  std::vector<uint32_t> m_rxIndex; //!< node id -> column
+};
+
+}
+
+#endif /* LOSS_MATRIX_FILE_H */
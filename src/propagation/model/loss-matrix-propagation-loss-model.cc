@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/perf-counter-scope.h"
+#include "loss-matrix-propagation-loss-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LossMatrixPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (LossMatrixPropagationLossModel);
+
+TypeId
+LossMatrixPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LossMatrixPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<LossMatrixPropagationLossModel> ()
+    .AddAttribute ("Filename",
+                   "The loss matrix file to map.",
+                   StringValue (""),
+                   MakeStringAccessor (&LossMatrixPropagationLossModel::SetFilename,
+                                       &LossMatrixPropagationLossModel::GetFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("Fallback",
+                   "The model used for node pairs missing from the file (default is none).",
+                   PointerValue (),
+                   MakePointerAccessor (&LossMatrixPropagationLossModel::m_fallback),
+                   MakePointerChecker<PropagationLossModel> ());
+  return tid;
+}
+
+LossMatrixPropagationLossModel::LossMatrixPropagationLossModel ()
+{
+}
+
+void
+LossMatrixPropagationLossModel::SetFilename (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  m_filename = filename;
+  if (filename.empty ())
+    {
+      m_file.Close ();
+    }
+  else
+    {
+      m_file.Open (filename);
+    }
+}
+
+std::string
+LossMatrixPropagationLossModel::GetFilename (void) const
+{
+  return m_filename;
+}
+
+const LossMatrixHeader &
+LossMatrixPropagationLossModel::GetHeader (void) const
+{
+  return m_file.GetHeader ();
+}
+
+double
+LossMatrixPropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  NS_ABORT_MSG_IF (!m_file.IsOpen (), "No loss matrix file mapped");
+  PerfCounterScope scope ("matrix", this, m_file.GetHeader ().environment, 1);
+  Ptr<Node> na = a->GetObject<Node> ();
+  Ptr<Node> nb = b->GetObject<Node> ();
+  NS_ABORT_MSG_IF (na == 0 || nb == 0, "MobilityModel not aggregated to a Node");
+
+  uint32_t tx = m_file.GetTxIndex (na->GetId ());
+  uint32_t rx = m_file.GetRxIndex (nb->GetId ());
+  if (tx == LossMatrixFile::NOT_FOUND || rx == LossMatrixFile::NOT_FOUND)
+    {
+      tx = m_file.GetTxIndex (nb->GetId ());
+      rx = m_file.GetRxIndex (na->GetId ());
+    }
+  if (tx == LossMatrixFile::NOT_FOUND || rx == LossMatrixFile::NOT_FOUND)
+    {
+      if (m_fallback == 0)
+        {
+          NS_FATAL_ERROR ("Nodes " << na->GetId () << " and " << nb->GetId () << " are not in " << m_filename);
+        }
+      return m_fallback->CalcRxPower (0, a, b);
+    }
+
+  double loss_in_db = m_file.GetLoss (tx, rx);
+
+  NS_LOG_DEBUG ("nodes " << na->GetId () << "," << nb->GetId () << ", Path Loss = " << loss_in_db);
+
+  return (0 - loss_in_db);
+}
+
+double
+LossMatrixPropagationLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  return txPowerDbm + GetLoss (a, b);
+}
+
+int64_t
+LossMatrixPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+}
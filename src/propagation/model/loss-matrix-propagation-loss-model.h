@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef LOSS_MATRIX_PROPAGATION_LOSS_MODEL_H
+#define LOSS_MATRIX_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/propagation-loss-model.h"
+#include "loss-matrix-file.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Propagation loss read from a precomputed loss matrix file
+ *
+ * The matrix is written once with LossMatrixFile::Write for a fixed node
+ * placement and memory-mapped by every later run, so the losses of an
+ * empirical model are looked up by node id instead of being recomputed.
+ * The nodes are found through the MobilityModel aggregated to them.
+ *
+ * A (tx, rx) pair missing from the file is looked up as (rx, tx), then
+ * handed to the Fallback model; without a fallback model it is an error.
+ */
+class LossMatrixPropagationLossModel : public PropagationLossModel
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LossMatrixPropagationLossModel ();
+
+  /**
+   * Get the propagation loss
+   * \param a the mobility model of the source
+   * \param b the mobility model of the destination
+   * \returns the propagation loss (in dBm)
+   */
+  double GetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+
+  /**
+   * Map a loss matrix file
+   * \param filename the loss matrix file
+   */
+  void SetFilename (std::string filename);
+  /**
+   * Get the name of the mapped file
+   * \returns the file name
+   */
+  std::string GetFilename (void) const;
+  /**
+   * Get the header of the mapped file
+   * \returns the header
+   */
+  const LossMatrixHeader & GetHeader (void) const;
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  LossMatrixPropagationLossModel (const LossMatrixPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  LossMatrixPropagationLossModel & operator = (const LossMatrixPropagationLossModel &);
+
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  std::string m_filename; //!< name of the mapped file
+  LossMatrixFile m_file; //!< the mapped file
+  Ptr<PropagationLossModel> m_fallback; //!< model used for pairs missing from the file
+};
+
+}
+
+#endif /* LOSS_MATRIX_PROPAGATION_LOSS_MODEL_H */
@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef LOSS_QUANTIZATION_H
+#define LOSS_QUANTIZATION_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Fixed-point storage of tabulated losses
+ *
+ * A table of losses is stored as unsigned integer codes with a scale of
+ * its own: value = offset + code * step. The scale spans the range of
+ * the finite values of the table, so a uint16 table of losses between
+ * 40 dB and 250 dB has a step of 0.0032 dB, and a uint8 table a step of
+ * 0.83 dB; the rounding error is at most half a step. Finite values
+ * outside the range of the scale are clamped to it.
+ *
+ * The three highest codes are reserved for -inf, +inf and NaN, which
+ * decode to themselves.
+ *
+ * Encode and Decode are branch-free loops over arrays, which the
+ * compiler vectorizes.
+ */
+namespace LossQuantization {
+
+/**
+ * The storage formats
+ */
+enum Encoding
+{
+  Double, //!< 8-byte double, no quantization
+  Uint16, //!< 2-byte codes
+  Uint8   //!< 1-byte codes
+};
+
+/**
+ * Affine map from the codes to the values
+ */
+struct Scale
+{
+  double offset; //!< value of code 0
+  double step; //!< value difference between two consecutive codes
+};
+
+/// Number of codes reserved for the non-finite values
+static const uint32_t NON_FINITE_CODES = 3;
+
+/**
+ * \returns the code of -inf; the next two are those of +inf and NaN
+ */
+template <typename T>
+inline T
+GetNonFiniteCode (void)
+{
+  return std::numeric_limits<T>::max () - (NON_FINITE_CODES - 1);
+}
+
+/**
+ * \param encoding a storage format
+ * \returns the size of a stored value [bytes]
+ */
+inline uint32_t
+GetValueSize (Encoding encoding)
+{
+  return encoding == Uint16 ? sizeof (uint16_t) : encoding == Uint8 ? sizeof (uint8_t) : sizeof (double);
+}
+
+/**
+ * \param value the values
+ * \param n the number of values
+ * \param min the smallest finite value, +inf if there is none
+ * \param max the largest finite value, -inf if there is none
+ */
+inline void
+GetRange (const double *value, uint64_t n, double &min, double &max)
+{
+  const double inf = std::numeric_limits<double>::infinity ();
+  double lo = inf;
+  double hi = -inf;
+  for (uint64_t i = 0; i < n; ++i)
+    {
+      bool finite = std::isfinite (value[i]);
+      lo = std::min (lo, finite ? value[i] : inf);
+      hi = std::max (hi, finite ? value[i] : -inf);
+    }
+  min = lo;
+  max = hi;
+}
+
+/**
+ * \param encoding a storage format
+ * \param min the smallest finite value to store
+ * \param max the largest finite value to store
+ * \returns the scale whose finite codes span [min, max]; a table without
+ *          finite values, as reported by GetRange, gets the scale {0, 1}
+ */
+inline Scale
+MakeScale (Encoding encoding, double min, double max)
+{
+  double codes = encoding == Uint16 ? GetNonFiniteCode<uint16_t> () - 1
+    : encoding == Uint8 ? GetNonFiniteCode<uint8_t> () - 1 : 1;
+  Scale scale;
+  scale.offset = std::isfinite (min) ? min : 0.0;
+  // a constant table still needs a usable step
+  scale.step = std::isfinite (min) && std::isfinite (max) && max > min ? (max - min) / codes : 1.0;
+  return scale;
+}
+
+/**
+ * \param value the values
+ * \param code the codes of the values
+ * \param n the number of values
+ * \param scale the scale of the codes
+ */
+template <typename T>
+inline void
+Encode (const double *value, T *code, uint64_t n, Scale scale)
+{
+  const double inverse = 1 / scale.step;
+  const double inf = std::numeric_limits<double>::infinity ();
+  const double nonFinite = GetNonFiniteCode<T> ();
+  for (uint64_t i = 0; i < n; ++i)
+    {
+      // round half up: the clamped value is never negative; the
+      // non-finite values are replaced before the conversion
+      double q = (value[i] - scale.offset) * inverse + 0.5;
+      q = std::min (std::max (q, 0.0), nonFinite - 1);
+      q = value[i] == -inf ? nonFinite : q;
+      q = value[i] == inf ? nonFinite + 1 : q;
+      q = value[i] != value[i] ? nonFinite + 2 : q;
+      code[i] = static_cast<T> (q);
+    }
+}
+
+/**
+ * \param code a code
+ * \param scale the scale of the code
+ * \returns the value of the code
+ */
+template <typename T>
+inline double
+Decode (T code, Scale scale)
+{
+  const T nonFinite = GetNonFiniteCode<T> ();
+  double value = scale.offset + code * scale.step;
+  value = code == nonFinite ? -std::numeric_limits<double>::infinity () : value;
+  value = code == nonFinite + 1 ? std::numeric_limits<double>::infinity () : value;
+  value = code == nonFinite + 2 ? std::numeric_limits<double>::quiet_NaN () : value;
+  return value;
+}
+
+/**
+ * \param code the codes
+ * \param value the values of the codes
+ * \param n the number of codes
+ * \param scale the scale of the codes
+ */
+template <typename T>
+inline void
+Decode (const T *code, double *value, uint64_t n, Scale scale)
+{
+  for (uint64_t i = 0; i < n; ++i)
+    {
+      value[i] = Decode (code[i], scale);
+    }
+}
+
+/**
+ * Decode values of any storage format
+ * \param encoding the storage format
+ * \param data the stored values
+ * \param value the values
+ * \param n the number of values
+ * \param scale the scale of the codes, unused for Double
+ */
+inline void
+Decode (Encoding encoding, const void *data, double *value, uint64_t n, Scale scale)
+{
+  if (encoding == Uint16)
+    {
+      Decode (static_cast<const uint16_t *> (data), value, n, scale);
+    }
+  else if (encoding == Uint8)
+    {
+      Decode (static_cast<const uint8_t *> (data), value, n, scale);
+    }
+  else
+    {
+      std::copy (static_cast<const double *> (data), static_cast<const double *> (data) + n, value);
+    }
+}
+
+/**
+ * Encode values into any storage format
+ * \param encoding the storage format
+ * \param value the values
+ * \param data the stored values
+ * \param n the number of values
+ * \param scale the scale of the codes, unused for Double
+ */
+inline void
+Encode (Encoding encoding, const double *value, void *data, uint64_t n, Scale scale)
+{
+  if (encoding == Uint16)
+    {
+      Encode (value, static_cast<uint16_t *> (data), n, scale);
+    }
+  else if (encoding == Uint8)
+    {
+      Encode (value, static_cast<uint8_t *> (data), n, scale);
+    }
+  else
+    {
+      std::copy (value, value + n, static_cast<double *> (data));
+    }
+}
+
+} // namespace LossQuantization
+
+} // namespace ns3
+
+#endif /* LOSS_QUANTIZATION_H */
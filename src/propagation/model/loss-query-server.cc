@@ -0,0 +1,824 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "clutter-raster.h"
+#include "loss-query-server.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LossQueryServer");
+
+NS_OBJECT_ENSURE_REGISTERED (LossQueryServer);
+
+namespace {
+
+/**
+ * Send a buffer list completely on a blocking socket
+ * \param fd the socket
+ * \param iov the buffers; modified
+ * \param n the number of buffers
+ * \returns false on error
+ */
+bool
+SendAll (int fd, struct iovec *iov, int n)
+{
+  while (n > 0)
+    {
+      struct msghdr msg;
+      std::memset (&msg, 0, sizeof (msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = n;
+      ssize_t sent = sendmsg (fd, &msg, MSG_NOSIGNAL);
+      if (sent < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          return false;
+        }
+      // skip what was sent
+      while (n > 0 && static_cast<size_t> (sent) >= iov->iov_len)
+        {
+          sent -= iov->iov_len;
+          ++iov;
+          --n;
+        }
+      if (n > 0)
+        {
+          iov->iov_base = static_cast<uint8_t *> (iov->iov_base) + sent;
+          iov->iov_len -= sent;
+        }
+    }
+  return true;
+}
+
+/**
+ * Receive a buffer completely
+ * \param fd the socket
+ * \param buffer the buffer
+ * \param size the size of the buffer [bytes]
+ * \returns false on error or end of stream
+ */
+bool
+ReceiveAll (int fd, void *buffer, size_t size)
+{
+  uint8_t *p = static_cast<uint8_t *> (buffer);
+  while (size > 0)
+    {
+      ssize_t received = recv (fd, p, size, MSG_WAITALL);
+      if (received < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if (received <= 0)
+        {
+          return false;
+        }
+      p += received;
+      size -= received;
+    }
+  return true;
+}
+
+/**
+ * \param kind a LossQueryKind
+ * \returns the number of doubles per link, 0 for an unknown kind
+ */
+uint32_t
+GetLinkDoubles (uint32_t kind)
+{
+  switch (kind)
+    {
+    case LOSS_QUERY_DISTANCES:
+      return 1;
+    case LOSS_QUERY_POSITIONS:
+      return 6;
+    default:
+      return 0;
+    }
+}
+
+} // anonymous namespace
+
+TypeId
+LossQueryServer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LossQueryServer")
+    .SetParent<Object> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<LossQueryServer> ()
+    .AddAttribute ("SocketPath",
+                   "The path of the Unix domain socket to listen on.",
+                   StringValue ("/tmp/ns3-loss-query.sock"),
+                   MakeStringAccessor (&LossQueryServer::m_socketPath),
+                   MakeStringChecker ())
+    .AddAttribute ("MaxLinks",
+                   "The maximum number of links of a request (default is 1048576).",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&LossQueryServer::m_maxLinks),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("BatchWindow",
+                   "How long after the first queued request to wait for more frames before evaluating a batch, "
+                   "in whole milliseconds (default is 0).",
+                   TimeValue (MilliSeconds (0)),
+                   MakeTimeAccessor (&LossQueryServer::m_batchWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxOutbox",
+                   "The maximum number of response bytes queued for a client that doesn't read them, "
+                   "before its connection is closed (default is 64 MiB).",
+                   UintegerValue (64 << 20),
+                   MakeUintegerAccessor (&LossQueryServer::m_maxOutbox),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxInbox",
+                   "The maximum number of request bytes of a connection read for a batch, "
+                   "or one request if it is larger; the rest waits in the socket (default is 1 MiB).",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&LossQueryServer::m_maxInbox),
+                   MakeUintegerChecker<uint32_t> ());
+  return tid;
+}
+
+LossQueryServer::LossQueryServer ()
+  : m_listen (-1),
+    m_running (false),
+    m_nBatches (0)
+{
+  m_wake[0] = -1;
+  m_wake[1] = -1;
+}
+
+LossQueryServer::~LossQueryServer ()
+{
+}
+
+LossQueryServer::Connection::Connection ()
+  : queued (0),
+    shutdown (false)
+{
+}
+
+void
+LossQueryServer::DoDispose (void)
+{
+  while (!m_connections.empty ())
+    {
+      Close (m_connections.begin ()->first);
+    }
+  if (m_listen >= 0)
+    {
+      close (m_listen);
+      unlink (m_socketPath.c_str ());
+      m_listen = -1;
+    }
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      if (m_wake[i] >= 0)
+        {
+          close (m_wake[i]);
+          m_wake[i] = -1;
+        }
+    }
+  m_models.clear ();
+  m_batches.clear ();
+  m_pending.clear ();
+  Object::DoDispose ();
+}
+
+uint16_t
+LossQueryServer::AddModel (Ptr<EmpiricalPropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  NS_ABORT_MSG_IF (m_models.size () >= 0xffff, "Too many models");
+  m_models.push_back (model);
+  // a plain and a clutter batch per model
+  m_batches.resize (2 * m_models.size ());
+  return m_models.size () - 1;
+}
+
+void
+LossQueryServer::Start (void)
+{
+  NS_LOG_FUNCTION (this << m_socketPath);
+  NS_ABORT_MSG_IF (m_listen >= 0, "Server already started");
+
+  struct sockaddr_un address;
+  std::memset (&address, 0, sizeof (address));
+  address.sun_family = AF_UNIX;
+  NS_ABORT_MSG_IF (m_socketPath.size () >= sizeof (address.sun_path),
+                   "Socket path " << m_socketPath << " is too long");
+  std::strncpy (address.sun_path, m_socketPath.c_str (), sizeof (address.sun_path) - 1);
+
+  m_listen = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (m_listen < 0)
+    {
+      NS_FATAL_ERROR ("Can't create a Unix socket: " << std::strerror (errno));
+    }
+  unlink (m_socketPath.c_str ());
+  if (bind (m_listen, reinterpret_cast<struct sockaddr *> (&address), sizeof (address)) != 0
+      || listen (m_listen, SOMAXCONN) != 0)
+    {
+      NS_FATAL_ERROR ("Can't listen on " << m_socketPath << ": " << std::strerror (errno));
+    }
+  fcntl (m_listen, F_SETFL, fcntl (m_listen, F_GETFL) | O_NONBLOCK);
+
+  if (pipe (m_wake) != 0)
+    {
+      NS_FATAL_ERROR ("Can't create the wake-up pipe: " << std::strerror (errno));
+    }
+  fcntl (m_wake[0], F_SETFL, fcntl (m_wake[0], F_GETFL) | O_NONBLOCK);
+  fcntl (m_wake[1], F_SETFL, fcntl (m_wake[1], F_GETFL) | O_NONBLOCK);
+  m_nBatches = 0;
+  m_running = true;
+}
+
+void
+LossQueryServer::Stop (void)
+{
+  m_running = false;
+  if (m_wake[1] >= 0)
+    {
+      char c = 0;
+      ssize_t written = write (m_wake[1], &c, 1);
+      (void) written;
+    }
+}
+
+void
+LossQueryServer::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_listen < 0, "Server not started");
+  while (m_running)
+    {
+      RunOnce (-1);
+    }
+}
+
+void
+LossQueryServer::Accept (void)
+{
+  while (true)
+    {
+      int fd = accept (m_listen, 0, 0);
+      if (fd < 0)
+        {
+          return;
+        }
+      fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+      NS_LOG_LOGIC ("New connection " << fd);
+      m_connections[fd];
+      if (!Receive (fd))
+        {
+          Close (fd);
+        }
+    }
+}
+
+void
+LossQueryServer::Close (int fd)
+{
+  NS_LOG_LOGIC ("Closing connection " << fd);
+  close (fd);
+  m_connections.erase (fd);
+  // the number may be reused by the next connection
+  for (uint32_t i = 0; i < m_pending.size (); ++i)
+    {
+      if (m_pending[i].fd == fd)
+        {
+          m_pending[i].fd = -1;
+        }
+    }
+}
+
+bool
+LossQueryServer::Receive (int fd)
+{
+  Connection &connection = m_connections[fd];
+  uint8_t buffer[65536];
+  while (true)
+    {
+      // leave the rest in the socket until the next batch
+      size_t room = GetInboxRoom (connection);
+      if (room == 0)
+        {
+          break;
+        }
+      ssize_t received = recv (fd, buffer, std::min (room, sizeof (buffer)), 0);
+      if (received > 0)
+        {
+          connection.inbox.insert (connection.inbox.end (), buffer, buffer + received);
+          continue;
+        }
+      if (received < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if (received == 0)
+        {
+          NS_LOG_LOGIC ("Connection " << fd << " shut down");
+          connection.shutdown = true;
+          break;
+        }
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+          break;
+        }
+      return false;
+    }
+  // the frames received before a shutdown are still answered
+  return Parse (fd);
+}
+
+size_t
+LossQueryServer::GetInboxRoom (const Connection &connection) const
+{
+  size_t held = connection.inbox.size () + connection.queued;
+  if (held < m_maxInbox)
+    {
+      return m_maxInbox - held;
+    }
+  // a request larger than MaxInbox is read alone
+  if (connection.queued == 0 && connection.inbox.size () >= sizeof (LossQueryRequest))
+    {
+      LossQueryRequest request;
+      std::memcpy (&request, connection.inbox.data (), sizeof (request));
+      size_t size = sizeof (request) + static_cast<size_t> (request.count) * GetLinkDoubles (request.kind) * sizeof (double);
+      if (request.count <= m_maxLinks && connection.inbox.size () < size)
+        {
+          return size - connection.inbox.size ();
+        }
+    }
+  return 0;
+}
+
+bool
+LossQueryServer::Parse (int fd)
+{
+  Connection &connection = m_connections[fd];
+  std::vector<uint8_t> &inbox = connection.inbox;
+  size_t used = 0;
+  while (inbox.size () - used >= sizeof (LossQueryRequest))
+    {
+      LossQueryRequest request;
+      std::memcpy (&request, inbox.data () + used, sizeof (request));
+      uint32_t doubles = GetLinkDoubles (request.kind);
+      if (request.magic != LOSS_QUERY_REQUEST_MAGIC || request.version != LOSS_QUERY_VERSION
+          || doubles == 0 || request.count > m_maxLinks)
+        {
+          NS_LOG_WARN ("Malformed request on connection " << fd);
+          return false;
+        }
+      size_t size = static_cast<size_t> (request.count) * doubles * sizeof (double);
+      if (inbox.size () - used - sizeof (request) < size)
+        {
+          break;
+        }
+      // the first request of a batch is always taken
+      if (connection.queued > 0 && connection.queued + sizeof (request) + size > m_maxInbox)
+        {
+          break;
+        }
+      const uint8_t *payload = inbox.data () + used + sizeof (request);
+      used += sizeof (request) + size;
+      connection.queued += sizeof (request) + size;
+
+      Pending pending;
+      pending.fd = fd;
+      pending.id = request.id;
+      pending.status = LOSS_QUERY_OK;
+      pending.batch = 0;
+      pending.offset = 0;
+      pending.count = request.count;
+      if (request.model >= m_models.size ())
+        {
+          pending.status = LOSS_QUERY_UNKNOWN_MODEL;
+          pending.count = 0;
+          m_pending.push_back (pending);
+          continue;
+        }
+
+      Ptr<ClutterRaster> raster = m_models[request.model]->GetClutterRaster ();
+      bool clutter = request.kind == LOSS_QUERY_POSITIONS && raster != 0;
+      pending.batch = 2 * request.model + (clutter ? 1 : 0);
+      Batch &batch = m_batches[pending.batch];
+      pending.offset = batch.distance.size ();
+      if (request.kind == LOSS_QUERY_DISTANCES)
+        {
+          batch.distance.resize (pending.offset + request.count);
+          std::memcpy (batch.distance.data () + pending.offset, payload, size);
+        }
+      else
+        {
+          for (uint32_t i = 0; i < request.count; ++i)
+            {
+              double p[6];
+              std::memcpy (p, payload + i * sizeof (p), sizeof (p));
+              double dx = p[3] - p[0];
+              double dy = p[4] - p[1];
+              double dz = p[5] - p[2];
+              batch.distance.push_back (std::sqrt (dx * dx + dy * dy + dz * dz));
+              if (clutter)
+                {
+                  batch.clutter.push_back (raster->GetClass (Vector (p[3], p[4], p[5])));
+                }
+            }
+        }
+      m_pending.push_back (pending);
+    }
+  inbox.erase (inbox.begin (), inbox.begin () + used);
+  return true;
+}
+
+void
+LossQueryServer::Answer (void)
+{
+  for (uint32_t b = 0; b < m_batches.size (); ++b)
+    {
+      Batch &batch = m_batches[b];
+      uint32_t n = batch.distance.size ();
+      if (n == 0)
+        {
+          continue;
+        }
+      batch.loss.resize (n);
+      const Ptr<EmpiricalPropagationLossModel> &model = m_models[b / 2];
+      if (b % 2 == 0)
+        {
+          model->GetLossBatch (batch.distance.data (), batch.loss.data (), n);
+        }
+      else
+        {
+          model->GetLossBatch (batch.distance.data (), batch.clutter.data (), batch.loss.data (), n);
+        }
+      m_nBatches++;
+    }
+
+  for (uint32_t i = 0; i < m_pending.size (); ++i)
+    {
+      const Pending &pending = m_pending[i];
+      if (pending.fd < 0)
+        {
+          // connection closed
+          continue;
+        }
+      LossQueryResponse response;
+      response.magic = LOSS_QUERY_RESPONSE_MAGIC;
+      response.status = pending.status;
+      response.id = pending.id;
+      response.count = pending.count;
+      response.reserved = 0;
+      struct iovec iov[2];
+      iov[0].iov_base = &response;
+      iov[0].iov_len = sizeof (response);
+      iov[1].iov_base = m_batches[pending.batch].loss.data () + pending.offset;
+      iov[1].iov_len = pending.count * sizeof (double);
+      if (!Send (pending.fd, iov, pending.count > 0 ? 2 : 1))
+        {
+          Close (pending.fd);
+        }
+    }
+
+  m_pending.clear ();
+  for (uint32_t b = 0; b < m_batches.size (); ++b)
+    {
+      m_batches[b].distance.clear ();
+      m_batches[b].clutter.clear ();
+      m_batches[b].loss.clear ();
+    }
+  for (std::map<int, Connection>::iterator it = m_connections.begin (); it != m_connections.end (); ++it)
+    {
+      it->second.queued = 0;
+    }
+}
+
+bool
+LossQueryServer::Send (int fd, const struct iovec *iov, int n)
+{
+  Connection &connection = m_connections[fd];
+  size_t sent = 0;
+  // behind a queued response, the socket must not take this one first
+  if (connection.outbox.empty ())
+    {
+      struct msghdr msg;
+      std::memset (&msg, 0, sizeof (msg));
+      msg.msg_iov = const_cast<struct iovec *> (iov);
+      msg.msg_iovlen = n;
+      ssize_t result;
+      do
+        {
+          result = sendmsg (fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }
+      while (result < 0 && errno == EINTR);
+      if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+          NS_LOG_WARN ("Can't answer on connection " << fd << ": " << std::strerror (errno));
+          return false;
+        }
+      sent = result < 0 ? 0 : result;
+    }
+  for (int i = 0; i < n; ++i)
+    {
+      const uint8_t *base = static_cast<const uint8_t *> (iov[i].iov_base);
+      size_t skip = std::min (sent, iov[i].iov_len);
+      connection.outbox.insert (connection.outbox.end (), base + skip, base + iov[i].iov_len);
+      sent -= skip;
+    }
+  if (connection.outbox.size () > m_maxOutbox)
+    {
+      NS_LOG_WARN ("Connection " << fd << " doesn't read its responses");
+      return false;
+    }
+  return true;
+}
+
+bool
+LossQueryServer::Flush (int fd)
+{
+  std::vector<uint8_t> &outbox = m_connections[fd].outbox;
+  size_t sent = 0;
+  while (sent < outbox.size ())
+    {
+      ssize_t result = send (fd, outbox.data () + sent, outbox.size () - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (result < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+              break;
+            }
+          NS_LOG_WARN ("Can't answer on connection " << fd << ": " << std::strerror (errno));
+          return false;
+        }
+      sent += result;
+    }
+  outbox.erase (outbox.begin (), outbox.begin () + sent);
+  return true;
+}
+
+void
+LossQueryServer::RunOnce (int timeoutMs)
+{
+  NS_ABORT_MSG_IF (m_listen < 0, "Server not started");
+  // the window runs from the first queued request, however busy the
+  // clients; the requests held back from the last batch are queued already
+  const std::chrono::milliseconds window (static_cast<int64_t> (m_batchWindow.GetMilliSeconds ()));
+  bool gathering = !m_pending.empty ();
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now () + window;
+  while (true)
+    {
+      std::vector<struct pollfd> fds;
+      struct pollfd p;
+      p.events = POLLIN;
+      p.revents = 0;
+      p.fd = m_wake[0];
+      fds.push_back (p);
+      p.fd = m_listen;
+      fds.push_back (p);
+      for (std::map<int, Connection>::const_iterator it = m_connections.begin (); it != m_connections.end (); ++it)
+        {
+          bool receive = !it->second.shutdown && GetInboxRoom (it->second) > 0;
+          p.events = (receive ? POLLIN : 0) | (it->second.outbox.empty () ? 0 : POLLOUT);
+          if (p.events != 0)
+            {
+              p.fd = it->first;
+              fds.push_back (p);
+            }
+        }
+
+      int timeout = timeoutMs;
+      if (gathering)
+        {
+          int64_t left = std::chrono::duration_cast<std::chrono::microseconds> (
+              deadline - std::chrono::steady_clock::now ()).count ();
+          timeout = static_cast<int> (std::max<int64_t> (0, (left + 999) / 1000));
+        }
+      int ready = poll (fds.data (), fds.size (), timeout);
+      if (ready < 0 && errno != EINTR)
+        {
+          NS_FATAL_ERROR ("poll failed: " << std::strerror (errno));
+        }
+      if (ready <= 0)
+        {
+          break;
+        }
+      if (fds[0].revents)
+        {
+          char buffer[64];
+          while (read (m_wake[0], buffer, sizeof (buffer)) > 0)
+            {
+            }
+        }
+      if (fds[1].revents & POLLIN)
+        {
+          Accept ();
+        }
+      for (uint32_t i = 2; i < fds.size (); ++i)
+        {
+          int fd = fds[i].fd;
+          short revents = fds[i].revents;
+          if (revents == 0)
+            {
+              continue;
+            }
+          bool open = true;
+          if (fds[i].events & POLLOUT)
+            {
+              open = Flush (fd);
+            }
+          if (open && (fds[i].events & POLLIN) && (revents & (POLLIN | POLLHUP | POLLERR)))
+            {
+              open = Receive (fd);
+            }
+          if (!open)
+            {
+              Close (fd);
+            }
+        }
+      // gather the frames of the other clients for at most BatchWindow
+      if (m_pending.empty () || !m_running || m_batchWindow.GetMilliSeconds () <= 0)
+        {
+          break;
+        }
+      if (!gathering)
+        {
+          gathering = true;
+          deadline = std::chrono::steady_clock::now () + window;
+        }
+      else if (std::chrono::steady_clock::now () >= deadline)
+        {
+          break;
+        }
+    }
+  Answer ();
+
+  // the requests held back by MaxInbox go to the next batch, and the
+  // clients that stopped sending are closed once they have all their responses
+  std::vector<int> done;
+  for (std::map<int, Connection>::const_iterator it = m_connections.begin (); it != m_connections.end (); ++it)
+    {
+      if (!it->second.inbox.empty () && !Parse (it->first))
+        {
+          done.push_back (it->first);
+        }
+      else if (it->second.shutdown && it->second.outbox.empty () && it->second.queued == 0)
+        {
+          done.push_back (it->first);
+        }
+    }
+  for (uint32_t i = 0; i < done.size (); ++i)
+    {
+      Close (done[i]);
+    }
+}
+
+uint64_t
+LossQueryServer::GetNBatches (void) const
+{
+  return m_nBatches;
+}
+
+uint64_t
+LossQueryServer::GetNBufferedBytes (void) const
+{
+  uint64_t bytes = 0;
+  for (std::map<int, Connection>::const_iterator it = m_connections.begin (); it != m_connections.end (); ++it)
+    {
+      bytes += it->second.inbox.size () + it->second.queued;
+    }
+  return bytes;
+}
+
+LossQueryClient::LossQueryClient ()
+  : m_fd (-1),
+    m_nextId (0)
+{
+}
+
+LossQueryClient::~LossQueryClient ()
+{
+  Close ();
+}
+
+bool
+LossQueryClient::Connect (std::string socketPath)
+{
+  Close ();
+  struct sockaddr_un address;
+  std::memset (&address, 0, sizeof (address));
+  address.sun_family = AF_UNIX;
+  if (socketPath.size () >= sizeof (address.sun_path))
+    {
+      return false;
+    }
+  std::strncpy (address.sun_path, socketPath.c_str (), sizeof (address.sun_path) - 1);
+  m_fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (m_fd < 0)
+    {
+      return false;
+    }
+  if (connect (m_fd, reinterpret_cast<struct sockaddr *> (&address), sizeof (address)) != 0)
+    {
+      Close ();
+      return false;
+    }
+  return true;
+}
+
+void
+LossQueryClient::Close (void)
+{
+  if (m_fd >= 0)
+    {
+      close (m_fd);
+      m_fd = -1;
+    }
+}
+
+int32_t
+LossQueryClient::Exchange (uint16_t model, uint32_t kind, const double *payload, size_t size,
+                           double *loss, uint32_t n)
+{
+  if (m_fd < 0)
+    {
+      return -1;
+    }
+  LossQueryRequest request;
+  request.magic = LOSS_QUERY_REQUEST_MAGIC;
+  request.version = LOSS_QUERY_VERSION;
+  request.model = model;
+  request.kind = kind;
+  request.count = n;
+  request.id = m_nextId++;
+  struct iovec iov[2];
+  iov[0].iov_base = &request;
+  iov[0].iov_len = sizeof (request);
+  iov[1].iov_base = const_cast<double *> (payload);
+  iov[1].iov_len = size;
+
+  LossQueryResponse response;
+  if (!SendAll (m_fd, iov, 2)
+      || !ReceiveAll (m_fd, &response, sizeof (response))
+      || response.magic != LOSS_QUERY_RESPONSE_MAGIC || response.id != request.id)
+    {
+      Close ();
+      return -1;
+    }
+  if (response.status != LOSS_QUERY_OK)
+    {
+      return response.status;
+    }
+  if (response.count != n || !ReceiveAll (m_fd, loss, n * sizeof (double)))
+    {
+      Close ();
+      return -1;
+    }
+  return LOSS_QUERY_OK;
+}
+
+int32_t
+LossQueryClient::Query (uint16_t model, const double *distance, double *loss, uint32_t n)
+{
+  return Exchange (model, LOSS_QUERY_DISTANCES, distance, n * sizeof (double), loss, n);
+}
+
+int32_t
+LossQueryClient::QueryPositions (uint16_t model, const double *positions, double *loss, uint32_t n)
+{
+  return Exchange (model, LOSS_QUERY_POSITIONS, positions, n * 6 * sizeof (double), loss, n);
+}
+
+}
@@ -0,0 +1,354 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef LOSS_QUERY_SERVER_H
+#define LOSS_QUERY_SERVER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/empirical-propagation-loss-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Header of a loss query frame
+ *
+ * The header is followed by count distances [m] (LOSS_QUERY_DISTANCES) or
+ * by count (tx x, tx y, tx z, rx x, rx y, rx z) positions [m]
+ * (LOSS_QUERY_POSITIONS), as doubles. All the fields are in host byte
+ * order: the frames never leave the host.
+ */
+struct LossQueryRequest
+{
+  uint32_t magic; //!< LOSS_QUERY_REQUEST_MAGIC
+  uint16_t version; //!< LOSS_QUERY_VERSION
+  uint16_t model; //!< index of the model in the server, see LossQueryServer::AddModel
+  uint32_t kind; //!< LOSS_QUERY_DISTANCES or LOSS_QUERY_POSITIONS
+  uint32_t count; //!< number of links
+  uint64_t id; //!< echoed in the response
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Header of a loss response frame
+ *
+ * With a LOSS_QUERY_OK status, the header is followed by count losses,
+ * as doubles, with the sign convention of
+ * EmpiricalPropagationLossModel::GetLoss.
+ */
+struct LossQueryResponse
+{
+  uint32_t magic; //!< LOSS_QUERY_RESPONSE_MAGIC
+  int32_t status; //!< LOSS_QUERY_OK or an error
+  uint64_t id; //!< id of the request
+  uint32_t count; //!< number of losses
+  uint32_t reserved; //!< zero
+};
+
+/// Magic number of the request frames, "LQRQ"
+const uint32_t LOSS_QUERY_REQUEST_MAGIC = 0x5152514c;
+/// Magic number of the response frames, "LQRS"
+const uint32_t LOSS_QUERY_RESPONSE_MAGIC = 0x5352514c;
+/// Version of the frames
+const uint16_t LOSS_QUERY_VERSION = 1;
+
+/// Link descriptions of a request
+enum LossQueryKind
+{
+  LOSS_QUERY_DISTANCES = 0, //!< one distance per link
+  LOSS_QUERY_POSITIONS = 1  //!< Tx and Rx positions per link
+};
+
+/// Status of a response
+enum LossQueryStatus
+{
+  LOSS_QUERY_OK = 0, //!< the losses follow
+  LOSS_QUERY_UNKNOWN_MODEL = 1 //!< no model with that index
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Answers loss queries over a Unix domain socket
+ *
+ * Tools that only need the losses of the empirical models connect to
+ * SocketPath and send LossQueryRequest frames. The server reads every
+ * frame available on every connection, and keeps reading until
+ * BatchWindow after the first request it queued, even if clients keep
+ * sending, then evaluates all the links of each model with one batch call,
+ * and answers each request with a LossQueryResponse header followed by
+ * its slice of the batch output, sent with one scatter-gather call
+ * without an extra copy.
+ *
+ * For position queries, the models with a clutter raster use the class
+ * at the Rx position; distance queries use the environment of the model.
+ *
+ * A malformed frame (bad magic, version or kind, more than MaxLinks
+ * links) closes its connection. A client may shut down its sending side
+ * after its last request: the requests it sent are still answered
+ * before the connection is closed.
+ *
+ * The server doesn't read more than MaxInbox bytes of requests of a
+ * connection per batch, or one request if it is larger: the rest stays
+ * in the socket buffer, and a client sending faster than the server
+ * answers blocks in its send.
+ *
+ * The server never waits for a client: what a connection can't take at
+ * once is queued in its outbox and sent when the socket is writable
+ * again. A client that doesn't read its responses is disconnected once
+ * its outbox exceeds MaxOutbox bytes. The server runs on the thread calling
+ * Run, and Stop can be called from any thread. The models must not be
+ * used by other threads while the server runs.
+ */
+class LossQueryServer : public Object
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LossQueryServer ();
+  virtual ~LossQueryServer ();
+
+  /**
+   * \param model an empirical model to serve
+   * \returns the index of the model in the requests
+   */
+  uint16_t AddModel (Ptr<EmpiricalPropagationLossModel> model);
+  /**
+   * Bind and listen on SocketPath, replacing any stale socket file
+   */
+  void Start (void);
+  /**
+   * Serve the clients until Stop is called
+   */
+  void Run (void);
+  /**
+   * Wait for frames and answer them, once
+   * \param timeoutMs the maximum wait [ms], -1 for no limit
+   */
+  void RunOnce (int timeoutMs);
+  /**
+   * Make Run return; can be called from any thread or a signal handler
+   */
+  void Stop (void);
+  /**
+   * \returns the number of batch evaluations since Start
+   */
+  uint64_t GetNBatches (void) const;
+  /**
+   * \returns the number of request bytes read from the connections and
+   *          not answered yet
+   */
+  uint64_t GetNBufferedBytes (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  LossQueryServer (const LossQueryServer &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  LossQueryServer & operator = (const LossQueryServer &);
+
+  /// A request waiting for its batch
+  struct Pending
+  {
+    int fd; //!< connection of the request
+    uint64_t id; //!< id of the request
+    int32_t status; //!< status of the response
+    uint32_t batch; //!< index of the batch in m_batches
+    uint32_t offset; //!< first link of the request in the batch
+    uint32_t count; //!< number of links
+  };
+
+  /// The buffers of a client connection
+  struct Connection
+  {
+    Connection ();
+    std::vector<uint8_t> inbox; //!< received bytes, not parsed yet
+    std::vector<uint8_t> outbox; //!< response bytes the socket didn't take yet
+    size_t queued; //!< bytes of the requests in the current batches
+    bool shutdown; //!< whether the client stopped sending
+  };
+
+  /// The links of one model, evaluated together
+  struct Batch
+  {
+    std::vector<double> distance; //!< link distances [m]
+    std::vector<uint8_t> clutter; //!< clutter classes of the Rx positions
+    std::vector<double> loss; //!< losses
+  };
+
+  /**
+   * Accept the pending connections, and read the frames they already sent
+   */
+  void Accept (void);
+  /**
+   * Read what is available on a connection, then parse it
+   * \param fd the connection
+   * \returns false if the connection must be closed
+   */
+  bool Receive (int fd);
+  /**
+   * Move the complete frames of a connection to their batches, up to
+   * MaxInbox bytes of requests per batch
+   * \param fd the connection
+   * \returns false if a frame is malformed
+   */
+  bool Parse (int fd);
+  /**
+   * \param connection a connection
+   * \returns the number of bytes to read before the next batch: up to
+   *          MaxInbox, or the rest of the first request
+   */
+  size_t GetInboxRoom (const Connection &connection) const;
+  /**
+   * Evaluate the batches and answer the pending requests
+   */
+  void Answer (void);
+  /**
+   * Send a response, or queue what the socket doesn't take
+   * \param fd the connection
+   * \param iov the header and the losses of the response
+   * \param n the number of buffers
+   * \returns false if the connection must be closed
+   */
+  bool Send (int fd, const struct iovec *iov, int n);
+  /**
+   * Send as much of the outbox of a connection as the socket takes
+   * \param fd the connection
+   * \returns false if the connection must be closed
+   */
+  bool Flush (int fd);
+  /**
+   * \param fd a connection to close
+   */
+  void Close (int fd);
+
+  std::string m_socketPath; //!< path of the listening socket
+  uint32_t m_maxLinks; //!< maximum number of links of a request
+  Time m_batchWindow; //!< maximum wait for more frames before a batch
+  uint32_t m_maxOutbox; //!< maximum number of queued response bytes of a connection
+  uint32_t m_maxInbox; //!< maximum number of request bytes of a connection per batch
+
+  std::vector<Ptr<EmpiricalPropagationLossModel> > m_models; //!< served models
+  int m_listen; //!< listening socket, -1 if not started
+  int m_wake[2]; //!< pipe that wakes up the poll on Stop
+  std::atomic<bool> m_running; //!< whether Run should continue
+  std::map<int, Connection> m_connections; //!< buffers of each connection
+  std::vector<Batch> m_batches; //!< plain and clutter batches of each model
+  std::vector<Pending> m_pending; //!< requests of the current batches
+  uint64_t m_nBatches; //!< number of batch evaluations
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Blocking client of a LossQueryServer
+ *
+ * The losses are received straight into the buffer of the caller.
+ */
+class LossQueryClient
+{
+public:
+  LossQueryClient ();
+  ~LossQueryClient ();
+
+  /**
+   * \param socketPath the path of the server socket
+   * \returns false if the connection failed
+   */
+  bool Connect (std::string socketPath);
+  /**
+   * Close the connection
+   */
+  void Close (void);
+  /**
+   * \param model the index of the model in the server
+   * \param distance the link distances [m]
+   * \param loss the losses
+   * \param n the number of links
+   * \returns the status of the response, or -1 on a connection error
+   */
+  int32_t Query (uint16_t model, const double *distance, double *loss, uint32_t n);
+  /**
+   * \param model the index of the model in the server
+   * \param positions the (tx x, tx y, tx z, rx x, rx y, rx z) positions
+   *        of each link [m]
+   * \param loss the losses
+   * \param n the number of links
+   * \returns the status of the response, or -1 on a connection error
+   */
+  int32_t QueryPositions (uint16_t model, const double *positions, double *loss, uint32_t n);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  LossQueryClient (const LossQueryClient &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  LossQueryClient & operator = (const LossQueryClient &);
+
+  /**
+   * Send a request and receive its response
+   * \param model the index of the model in the server
+   * \param kind the LossQueryKind
+   * \param payload the link descriptions
+   * \param size the size of the payload [bytes]
+   * \param loss the losses
+   * \param n the number of links
+   * \returns the status of the response, or -1 on a connection error
+   */
+  int32_t Exchange (uint16_t model, uint32_t kind, const double *payload, size_t size,
+                    double *loss, uint32_t n);
+
+  int m_fd; //!< connection, -1 if not connected
+  uint64_t m_nextId; //!< id of the next request
+};
+
+}
+
+#endif /* LOSS_QUERY_SERVER_H */
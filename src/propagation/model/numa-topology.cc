@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include "numa-topology.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NumaTopology");
+
+NumaTopology::NumaTopology ()
+{
+  Read ("/sys/devices/system/node");
+}
+
+NumaTopology::NumaTopology (std::string path)
+{
+  Read (path);
+}
+
+const NumaTopology &
+NumaTopology::GetSystem (void)
+{
+  static const NumaTopology topology;
+  return topology;
+}
+
+void
+NumaTopology::Read (std::string path)
+{
+  NS_LOG_FUNCTION (this << path);
+  // the node ids can have holes: sort them rather than counting
+  std::map<uint32_t, std::vector<uint32_t> > nodes;
+  DIR *dir = opendir (path.c_str ());
+  if (dir != 0)
+    {
+      struct dirent *entry;
+      while ((entry = readdir (dir)) != 0)
+        {
+          std::string name = entry->d_name;
+          if (name.compare (0, 4, "node") != 0 || name.size () == 4
+              || name.find_first_not_of ("0123456789", 4) != std::string::npos)
+            {
+              continue;
+            }
+          std::ifstream file ((path + "/" + name + "/cpulist").c_str ());
+          std::string list;
+          std::getline (file, list);
+          std::vector<uint32_t> cpus = ParseCpuList (list);
+          if (!cpus.empty ())
+            {
+              nodes[std::atoi (name.c_str () + 4)] = cpus;
+            }
+        }
+      closedir (dir);
+    }
+
+  m_cpus.clear ();
+  for (std::map<uint32_t, std::vector<uint32_t> >::const_iterator i = nodes.begin (); i != nodes.end (); ++i)
+    {
+      NS_LOG_LOGIC ("Node " << i->first << " has " << i->second.size () << " CPUs");
+      m_cpus.push_back (i->second);
+    }
+  if (m_cpus.empty ())
+    {
+      NS_LOG_LOGIC ("No NUMA node in " << path << ", using a single node");
+      std::vector<uint32_t> cpus;
+      for (uint32_t cpu = 0; cpu < std::max (1u, std::thread::hardware_concurrency ()); ++cpu)
+        {
+          cpus.push_back (cpu);
+        }
+      m_cpus.push_back (cpus);
+    }
+}
+
+uint32_t
+NumaTopology::GetNNodes (void) const
+{
+  return m_cpus.size ();
+}
+
+const std::vector<uint32_t> &
+NumaTopology::GetCpus (uint32_t node) const
+{
+  NS_ASSERT (node < m_cpus.size ());
+  return m_cpus[node];
+}
+
+std::vector<uint32_t>
+NumaTopology::ParseCpuList (std::string list)
+{
+  std::vector<uint32_t> cpus;
+  std::istringstream ranges (list);
+  std::string range;
+  while (std::getline (ranges, range, ','))
+    {
+      if (range.find_first_of ("0123456789") == std::string::npos)
+        {
+          continue;
+        }
+      uint32_t first = std::strtoul (range.c_str (), 0, 10);
+      uint32_t last = first;
+      std::string::size_type dash = range.find ('-');
+      if (dash != std::string::npos)
+        {
+          last = std::strtoul (range.c_str () + dash + 1, 0, 10);
+        }
+      for (uint32_t cpu = first; cpu <= last; ++cpu)
+        {
+          cpus.push_back (cpu);
+        }
+    }
+  std::sort (cpus.begin (), cpus.end ());
+  cpus.erase (std::unique (cpus.begin (), cpus.end ()), cpus.end ());
+  return cpus;
+}
+
+bool
+NumaTopology::PinCurrentThread (uint32_t cpu)
+{
+#ifdef __linux__
+  if (cpu >= CPU_SETSIZE)
+    {
+      return false;
+    }
+  cpu_set_t set;
+  CPU_ZERO (&set);
+  CPU_SET (cpu, &set);
+  return pthread_setaffinity_np (pthread_self (), sizeof (set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+FirstTouchBuffer::FirstTouchBuffer ()
+  : m_data (0),
+    m_size (0)
+{
+}
+
+FirstTouchBuffer::~FirstTouchBuffer ()
+{
+  Free ();
+}
+
+void
+FirstTouchBuffer::Allocate (size_t bytes)
+{
+  Free ();
+  if (bytes == 0)
+    {
+      return;
+    }
+  void *data = mmap (0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED)
+    {
+      NS_FATAL_ERROR ("Can't allocate " << bytes << " bytes");
+    }
+  m_data = data;
+  m_size = bytes;
+}
+
+void
+FirstTouchBuffer::Free (void)
+{
+  if (m_data != 0)
+    {
+      munmap (m_data, m_size);
+      m_data = 0;
+      m_size = 0;
+    }
+}
+
+size_t
+FirstTouchBuffer::GetSize (void) const
+{
+  return m_size;
+}
+
+}
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief The NUMA nodes of the machine and the CPUs of each node
+ *
+ * The topology is read from the cpulist file of every nodeN directory
+ * under /sys/devices/system/node. Nodes without CPUs (memory-only
+ * nodes) are skipped. Without that directory, e.g. on a kernel built
+ * without NUMA support, the machine is a single node holding every CPU.
+ */
+class NumaTopology
+{
+public:
+  /**
+   * Read the topology of the machine
+   */
+  NumaTopology ();
+  /**
+   * Read the topology from another directory, laid out as
+   * /sys/devices/system/node
+   * \param path the directory
+   */
+  NumaTopology (std::string path);
+
+  /**
+   * \returns the topology of the machine, read on the first call
+   */
+  static const NumaTopology & GetSystem (void);
+
+  /**
+   * \returns the number of nodes with CPUs, at least 1
+   */
+  uint32_t GetNNodes (void) const;
+  /**
+   * \param node the index of a node, less than GetNNodes
+   * \returns the CPUs of the node, in increasing order
+   */
+  const std::vector<uint32_t> & GetCpus (uint32_t node) const;
+
+  /**
+   * \param list a kernel CPU list, such as "0-3,8,10-11"
+   * \returns the CPUs of the list, in increasing order
+   */
+  static std::vector<uint32_t> ParseCpuList (std::string list);
+  /**
+   * Bind the calling thread to one CPU
+   * \param cpu the CPU
+   * \returns false if the CPU is not available to the process, or if the
+   *          platform has no thread affinity
+   */
+  static bool PinCurrentThread (uint32_t cpu);
+
+private:
+  /**
+   * Read the nodes of a directory, or make a single node
+   * \param path the directory
+   */
+  void Read (std::string path);
+
+  std::vector<std::vector<uint32_t> > m_cpus; //!< CPUs of each node
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief An array whose pages are placed by the threads that first
+ * write them
+ *
+ * The memory comes straight from an anonymous mapping, so none of its
+ * pages is backed until it is written. With the default first-touch
+ * policy of Linux, each page then lands on the NUMA node of the thread
+ * that writes it first. Allocate therefore does not initialize the
+ * array: the threads that will compute each part of it must write it
+ * first.
+ */
+class FirstTouchBuffer
+{
+public:
+  FirstTouchBuffer ();
+  ~FirstTouchBuffer ();
+
+  /**
+   * Replace the buffer with an uninitialized one
+   * \param bytes the size of the buffer [bytes]
+   */
+  void Allocate (size_t bytes);
+  /**
+   * Release the buffer, if any
+   */
+  void Free (void);
+  /**
+   * \returns the start of the buffer, as an array of T
+   */
+  template <typename T>
+  T * Get (void) const
+  {
+    return static_cast<T *> (m_data);
+  }
+  /**
+   * \returns the size of the buffer [bytes]
+   */
+  size_t GetSize (void) const;
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  FirstTouchBuffer (const FirstTouchBuffer &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  FirstTouchBuffer & operator = (const FirstTouchBuffer &);
+
+  void *m_data; //!< start of the mapping
+  size_t m_size; //!< size of the mapping [bytes]
+};
+
+}
+
+#endif /* NUMA_TOPOLOGY_H */
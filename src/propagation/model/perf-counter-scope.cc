@@ -0,0 +1,507 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/object.h"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef HAVE_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "perf-counter-scope.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PerfCounterScope");
+
+std::atomic<bool> PerfCounters::g_enabled (false);
+
+namespace {
+
+/// Key of the recorded samples
+struct SampleKey
+{
+  std::string path; //!< evaluation path
+  std::string model; //!< TypeId name of the model
+  int32_t environment; //!< environment of the model, -1 if mixed
+
+  /**
+   * \param o another key
+   * \returns true if this key sorts before o
+   */
+  bool operator < (const SampleKey &o) const
+  {
+    if (model != o.model)
+      {
+        return model < o.model;
+      }
+    if (environment != o.environment)
+      {
+        return environment < o.environment;
+      }
+    return path < o.path;
+  }
+};
+
+/// Accumulated counters of one key
+struct Sample
+{
+  uint64_t calls; //!< number of scopes
+  uint64_t links; //!< number of links evaluated
+  uint64_t value[PerfCounters::NUM_COUNTERS]; //!< counter sums
+};
+
+/**
+ * \param to the sample to add to
+ * \param from the sample to add
+ */
+void
+AddSample (Sample &to, const Sample &from)
+{
+  to.calls += from.calls;
+  to.links += from.links;
+  for (uint32_t i = 0; i < PerfCounters::NUM_COUNTERS; ++i)
+    {
+      to.value[i] += from.value[i];
+    }
+}
+
+/**
+ * \brief The samples recorded by one thread
+ *
+ * Record only touches the table of its thread: an open-addressing table
+ * keyed by the path literal, the model and the environment, which never
+ * allocates. Its mutex is only contended while Print or Reset visits the
+ * tables. The samples of a thread that exits are merged into
+ * g_retiredSamples.
+ */
+class ThreadSamples
+{
+public:
+  ThreadSamples ();
+  ~ThreadSamples ();
+
+  /**
+   * \param path the evaluation path
+   * \param model the model
+   * \param environment the environment of the model, -1 if mixed
+   * \param sample the counters to add
+   */
+  void Add (const char *path, const Object *model, int32_t environment, const Sample &sample);
+  /**
+   * Add the samples of the thread to a map keyed by names
+   * \param samples the map
+   */
+  void MergeInto (std::map<SampleKey, Sample> &samples);
+  /**
+   * Forget the samples of the thread
+   */
+  void Clear (void);
+
+private:
+  /// Number of entries of the table, a power of 2
+  static const uint32_t CAPACITY = 256;
+
+  /// A recorded key and its counters
+  struct Entry
+  {
+    const char *path; //!< evaluation path, 0 for a free entry
+    const Object *model; //!< model
+    TypeId tid; //!< type of the model, for Print
+    int32_t environment; //!< environment of the model
+    Sample sample; //!< accumulated counters
+  };
+
+  std::mutex m_mutex; //!< taken by the thread, and by Print and Reset
+  Entry m_entries[CAPACITY]; //!< the table
+  uint64_t m_dropped; //!< scopes not recorded because the table is full
+};
+
+const uint32_t ThreadSamples::CAPACITY;
+
+std::mutex g_threadsMutex; //!< protects g_threads and g_retiredSamples
+std::vector<ThreadSamples *> g_threads; //!< the tables of the running threads
+std::map<SampleKey, Sample> g_retiredSamples; //!< samples of the exited threads
+
+ThreadSamples::ThreadSamples ()
+  : m_dropped (0)
+{
+  Clear ();
+  std::lock_guard<std::mutex> lock (g_threadsMutex);
+  g_threads.push_back (this);
+}
+
+ThreadSamples::~ThreadSamples ()
+{
+  std::lock_guard<std::mutex> lock (g_threadsMutex);
+  MergeInto (g_retiredSamples);
+  for (std::vector<ThreadSamples *>::iterator it = g_threads.begin (); it != g_threads.end (); ++it)
+    {
+      if (*it == this)
+        {
+          g_threads.erase (it);
+          break;
+        }
+    }
+}
+
+void
+ThreadSamples::Add (const char *path, const Object *model, int32_t environment, const Sample &sample)
+{
+  TypeId tid = model->GetInstanceTypeId ();
+  uintptr_t hash = reinterpret_cast<uintptr_t> (path) ^ (reinterpret_cast<uintptr_t> (model) >> 4)
+    ^ static_cast<uint32_t> (environment);
+  hash ^= hash >> 16;
+  std::lock_guard<std::mutex> lock (m_mutex);
+  for (uint32_t probe = 0; probe < CAPACITY; ++probe)
+    {
+      Entry &entry = m_entries[(hash + probe) & (CAPACITY - 1)];
+      if (entry.path == 0)
+        {
+          entry.path = path;
+          entry.model = model;
+          entry.tid = tid;
+          entry.environment = environment;
+          entry.sample = sample;
+          return;
+        }
+      // a model freed and another allocated at its address is a new key
+      if (entry.path == path && entry.model == model && entry.environment == environment && entry.tid == tid)
+        {
+          AddSample (entry.sample, sample);
+          return;
+        }
+    }
+  m_dropped++;
+}
+
+void
+ThreadSamples::MergeInto (std::map<SampleKey, Sample> &samples)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  for (uint32_t i = 0; i < CAPACITY; ++i)
+    {
+      const Entry &entry = m_entries[i];
+      if (entry.path == 0)
+        {
+          continue;
+        }
+      SampleKey key;
+      key.path = entry.path;
+      key.model = entry.tid.GetName ();
+      key.environment = entry.environment;
+      std::map<SampleKey, Sample>::iterator it = samples.find (key);
+      if (it == samples.end ())
+        {
+          samples.insert (std::make_pair (key, entry.sample));
+        }
+      else
+        {
+          AddSample (it->second, entry.sample);
+        }
+    }
+  if (m_dropped > 0)
+    {
+      NS_LOG_WARN (m_dropped << " scopes of a thread not recorded, more than " << CAPACITY << " keys");
+    }
+}
+
+void
+ThreadSamples::Clear (void)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  for (uint32_t i = 0; i < CAPACITY; ++i)
+    {
+      m_entries[i].path = 0;
+    }
+  m_dropped = 0;
+}
+
+/**
+ * \returns the samples of the calling thread, registered on first use
+ */
+ThreadSamples &
+GetThreadSamples (void)
+{
+  static thread_local ThreadSamples samples;
+  return samples;
+}
+
+/**
+ * \returns the samples of every thread, merged by names
+ */
+std::map<SampleKey, Sample>
+MergeSamples (void)
+{
+  std::lock_guard<std::mutex> lock (g_threadsMutex);
+  std::map<SampleKey, Sample> samples = g_retiredSamples;
+  for (uint32_t i = 0; i < g_threads.size (); ++i)
+    {
+      g_threads[i]->MergeInto (samples);
+    }
+  return samples;
+}
+
+#ifdef HAVE_PERF_EVENTS
+
+/// The counter group of one thread
+class ThreadCounters
+{
+public:
+  ThreadCounters ()
+    : m_open (false)
+  {
+    const uint64_t config[PerfCounters::NUM_COUNTERS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (uint32_t i = 0; i < PerfCounters::NUM_COUNTERS; ++i)
+      {
+        m_fd[i] = -1;
+      }
+    for (uint32_t i = 0; i < PerfCounters::NUM_COUNTERS; ++i)
+      {
+        struct perf_event_attr attr;
+        std::memset (&attr, 0, sizeof (attr));
+        attr.size = sizeof (attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config[i];
+        attr.disabled = (i == 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // calling thread, any CPU, one group led by the cycle counter
+        m_fd[i] = syscall (__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : m_fd[0], 0);
+        if (m_fd[i] < 0)
+          {
+            NS_LOG_WARN ("perf_event_open failed for counter " << i << ": " << std::strerror (errno));
+            Close ();
+            return;
+          }
+      }
+    ioctl (m_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl (m_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    m_open = true;
+  }
+  ~ThreadCounters ()
+  {
+    Close ();
+  }
+  /**
+   * \param reading the counts and times
+   * \returns false if the group is not open or the read failed
+   */
+  bool Read (PerfCounters::Reading &reading)
+  {
+    uint64_t buffer[3 + PerfCounters::NUM_COUNTERS];
+    if (!m_open || read (m_fd[0], buffer, sizeof (buffer)) != sizeof (buffer))
+      {
+        return false;
+      }
+    return PerfCounters::Parse (buffer, reading);
+  }
+  /**
+   * \returns true if the group is open
+   */
+  bool IsOpen (void) const
+  {
+    return m_open;
+  }
+
+private:
+  /// Close the counters opened so far
+  void Close (void)
+  {
+    for (uint32_t i = 0; i < PerfCounters::NUM_COUNTERS; ++i)
+      {
+        if (m_fd[i] >= 0)
+          {
+            close (m_fd[i]);
+            m_fd[i] = -1;
+          }
+      }
+    m_open = false;
+  }
+
+  bool m_open; //!< whether every counter is open
+  int m_fd[PerfCounters::NUM_COUNTERS]; //!< counter file descriptors, 0 leads
+};
+
+/**
+ * \returns the counter group of the calling thread, opened on first use
+ */
+ThreadCounters &
+GetThreadCounters (void)
+{
+  static thread_local ThreadCounters counters;
+  return counters;
+}
+
+#endif /* HAVE_PERF_EVENTS */
+
+} // anonymous namespace
+
+bool
+PerfCounters::IsAvailable (void)
+{
+#ifdef HAVE_PERF_EVENTS
+  return GetThreadCounters ().IsOpen ();
+#else
+  return false;
+#endif
+}
+
+void
+PerfCounters::Enable (bool enabled)
+{
+  NS_LOG_FUNCTION (enabled);
+  if (enabled && !IsAvailable ())
+    {
+      NS_LOG_WARN ("Hardware performance counters are not available, not recording");
+      enabled = false;
+    }
+  g_enabled.store (enabled, std::memory_order_relaxed);
+}
+
+void
+PerfCounters::Reset (void)
+{
+  std::lock_guard<std::mutex> lock (g_threadsMutex);
+  g_retiredSamples.clear ();
+  for (uint32_t i = 0; i < g_threads.size (); ++i)
+    {
+      g_threads[i]->Clear ();
+    }
+}
+
+bool
+PerfCounters::Read (Reading &reading)
+{
+#ifdef HAVE_PERF_EVENTS
+  return GetThreadCounters ().Read (reading);
+#else
+  return false;
+#endif
+}
+
+bool
+PerfCounters::Parse (const uint64_t buffer[3 + NUM_COUNTERS], Reading &reading)
+{
+  if (buffer[0] != NUM_COUNTERS)
+    {
+      return false;
+    }
+  reading.timeEnabled = buffer[1];
+  reading.timeRunning = buffer[2];
+  for (uint32_t i = 0; i < NUM_COUNTERS; ++i)
+    {
+      reading.value[i] = buffer[3 + i];
+    }
+  return true;
+}
+
+bool
+PerfCounters::GetDelta (const Reading &start, const Reading &end, uint64_t delta[NUM_COUNTERS])
+{
+  // the raw counts only grow; the totals must not be scaled before the
+  // difference, as the ratio of the times changes from one read to the next
+  if (end.timeRunning <= start.timeRunning || end.timeEnabled < start.timeEnabled)
+    {
+      return false;
+    }
+  uint64_t enabled = end.timeEnabled - start.timeEnabled;
+  uint64_t running = end.timeRunning - start.timeRunning;
+  // the group only counted while it had the PMU: scale to the time enabled
+  double scale = running < enabled ? static_cast<double> (enabled) / running : 1.0;
+  for (uint32_t i = 0; i < NUM_COUNTERS; ++i)
+    {
+      uint64_t raw = end.value[i] >= start.value[i] ? end.value[i] - start.value[i] : 0;
+      delta[i] = static_cast<uint64_t> (raw * scale);
+    }
+  return true;
+}
+
+void
+PerfCounters::Record (const char *path, const Object *model, int32_t environment,
+                      uint64_t links, const uint64_t delta[NUM_COUNTERS])
+{
+  Sample sample;
+  sample.calls = 1;
+  sample.links = links;
+  for (uint32_t i = 0; i < NUM_COUNTERS; ++i)
+    {
+      sample.value[i] = delta[i];
+    }
+  GetThreadSamples ().Add (path, model, environment, sample);
+}
+
+void
+PerfCounters::Print (std::ostream &os)
+{
+  std::map<SampleKey, Sample> samples = MergeSamples ();
+  os << std::left << std::setw (36) << "model" << std::setw (6) << "env" << std::setw (8) << "path"
+     << std::right << std::setw (12) << "calls" << std::setw (14) << "links"
+     << std::setw (12) << "cycles/link" << std::setw (12) << "instr/link" << std::setw (8) << "IPC"
+     << std::setw (14) << "cache-miss/k" << std::setw (14) << "branch-miss/k" << std::endl;
+  for (std::map<SampleKey, Sample>::const_iterator it = samples.begin (); it != samples.end (); ++it)
+    {
+      const Sample &s = it->second;
+      double links = s.links > 0 ? s.links : 1;
+      std::ostringstream env;
+      if (it->first.environment < 0)
+        {
+          env << "mixed";
+        }
+      else
+        {
+          env << it->first.environment;
+        }
+      os << std::left << std::setw (36) << it->first.model << std::setw (6) << env.str () << std::setw (8) << it->first.path
+         << std::right << std::setw (12) << s.calls << std::setw (14) << s.links
+         << std::fixed << std::setprecision (1)
+         << std::setw (12) << s.value[CYCLES] / links << std::setw (12) << s.value[INSTRUCTIONS] / links
+         << std::setprecision (2)
+         << std::setw (8) << (s.value[CYCLES] > 0 ? static_cast<double> (s.value[INSTRUCTIONS]) / s.value[CYCLES] : 0.0)
+         << std::setw (14) << 1e3 * s.value[CACHE_MISSES] / links
+         << std::setw (14) << 1e3 * s.value[BRANCH_MISSES] / links << std::endl;
+      os.unsetf (std::ios::floatfield);
+    }
+}
+
+void
+PerfCounterScope::Stop (void)
+{
+  PerfCounters::Reading end;
+  uint64_t delta[PerfCounters::NUM_COUNTERS];
+  if (!PerfCounters::Read (end) || !PerfCounters::GetDelta (m_start, end, delta))
+    {
+      return;
+    }
+  PerfCounters::Record (m_path, m_model, m_environment, m_links, delta);
+}
+
+}
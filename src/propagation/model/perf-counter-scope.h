@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef PERF_COUNTER_SCOPE_H
+#define PERF_COUNTER_SCOPE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <ostream>
+
+namespace ns3 {
+
+class Object;
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Hardware performance counters of the propagation loss kernels
+ *
+ * When enabled, every PerfCounterScope reads the cycles, instructions,
+ * cache misses and branch misses of the calling thread (Linux
+ * perf_event_open, one counter group per thread) on entry and exit, and
+ * accumulates the difference under its (path, model, environment) key.
+ * In case the kernel multiplexed the counters, the difference of the raw
+ * counts of a scope is scaled by the time the group was enabled over the
+ * time it was counting during the scope; a scope during which the group
+ * did not count is not recorded.
+ *
+ * Each thread accumulates its samples in a table of its own, keyed by
+ * the path literal, the model pointer and the environment, without
+ * allocating or taking a shared lock. Print merges the tables of every
+ * thread by model type name, environment and path, and reports the
+ * cycles and instructions per evaluated link, the misses per thousand
+ * links and the IPC of each key.
+ *
+ * The counters are only compiled in when the perf_event header was found
+ * at configure time, and only read once Enable (true) was called; a
+ * disabled scope costs a relaxed atomic load. Opening the counters needs
+ * perf_event_paranoid <= 2 (user space counting) or CAP_PERFMON.
+ */
+class PerfCounters
+{
+public:
+  /**
+   * The recorded counters
+   */
+  enum Counter
+  {
+    CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, NUM_COUNTERS
+  };
+
+  /**
+   * \returns true if the counters can be read on this host
+   */
+  static bool IsAvailable (void);
+  /**
+   * Start or stop recording; enabling fails, with a warning, when the
+   * counters are not available
+   * \param enabled whether to record
+   */
+  static void Enable (bool enabled);
+  /**
+   * \returns true if the scopes are recording
+   */
+  static bool IsEnabled (void)
+  {
+    return g_enabled.load (std::memory_order_relaxed);
+  }
+  /**
+   * Forget every recorded sample
+   */
+  static void Reset (void);
+  /**
+   * Print the recorded samples, one line per (path, model, environment)
+   * \param os the output stream
+   */
+  static void Print (std::ostream &os);
+
+  /**
+   * The unscaled counts of a counter group, with its times
+   */
+  struct Reading
+  {
+    uint64_t value[NUM_COUNTERS]; //!< raw counter values
+    uint64_t timeEnabled; //!< time the group was enabled [ns]
+    uint64_t timeRunning; //!< time the group was counting [ns]
+  };
+
+  /**
+   * Read the counters of the calling thread
+   * \param reading the counts and times
+   * \returns false if the counters can't be read
+   */
+  static bool Read (Reading &reading);
+  /**
+   * Parse the result of a read of a counter group opened with
+   * PERF_FORMAT_GROUP, PERF_FORMAT_TOTAL_TIME_ENABLED and
+   * PERF_FORMAT_TOTAL_TIME_RUNNING
+   * \param buffer the number of counters, the time enabled, the time
+   *        running, then NUM_COUNTERS values
+   * \param reading the counts and times
+   * \returns false if the buffer is not of NUM_COUNTERS counters
+   */
+  static bool Parse (const uint64_t buffer[3 + NUM_COUNTERS], Reading &reading);
+  /**
+   * Get the counts between two readings, scaled by the time the group
+   * was enabled over the time it was counting between them
+   * \param start the earlier reading
+   * \param end the later reading
+   * \param delta the scaled counter differences
+   * \returns false if the group did not count between the readings
+   */
+  static bool GetDelta (const Reading &start, const Reading &end, uint64_t delta[NUM_COUNTERS]);
+  /**
+   * Accumulate a sample
+   * \param path the evaluation path
+   * \param model the model
+   * \param environment the environment or terrain of the model, -1 if mixed
+   * \param links the number of links evaluated
+   * \param delta the counter differences
+   */
+  static void Record (const char *path, const Object *model, int32_t environment,
+                      uint64_t links, const uint64_t delta[NUM_COUNTERS]);
+
+private:
+  static std::atomic<bool> g_enabled; //!< whether the scopes record
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Records the hardware counters of its lifetime, see PerfCounters
+ */
+class PerfCounterScope
+{
+public:
+  /**
+   * \param path the evaluation path, e.g. "scalar" or "batch"; must be a
+   *        string literal
+   * \param model the model doing the evaluation
+   * \param environment the environment or terrain of the model, -1 if mixed
+   * \param links the number of links evaluated in the scope
+   */
+  PerfCounterScope (const char *path, const Object *model, int32_t environment, uint64_t links)
+    : m_active (PerfCounters::IsEnabled ())
+  {
+    if (m_active)
+      {
+        m_path = path;
+        m_model = model;
+        m_environment = environment;
+        m_links = links;
+        m_active = PerfCounters::Read (m_start);
+      }
+  }
+  ~PerfCounterScope ()
+  {
+    if (m_active)
+      {
+        Stop ();
+      }
+  }
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  PerfCounterScope (const PerfCounterScope &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  PerfCounterScope & operator = (const PerfCounterScope &);
+
+  /**
+   * Read the counters again and record the difference
+   */
+  void Stop (void);
+
+  bool m_active; //!< whether the counters were read on entry
+  const char *m_path; //!< evaluation path
+  const Object *m_model; //!< model doing the evaluation
+  int32_t m_environment; //!< environment of the model
+  uint64_t m_links; //!< number of links evaluated
+  PerfCounters::Reading m_start; //!< counters on entry
+};
+
+}
+
+#endif /* PERF_COUNTER_SCOPE_H */
@@ -0,0 +1,318 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "clutter-raster.h"
+#include "site-height-optimizer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SiteHeightOptimizer");
+
+NS_OBJECT_ENSURE_REGISTERED (SiteHeightOptimizer);
+
+TypeId
+SiteHeightOptimizer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SiteHeightOptimizer")
+    .SetParent<Object> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<SiteHeightOptimizer> ()
+    .AddAttribute ("MinHeight",
+                   "The lowest candidate antenna height (default is 10 m).",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&SiteHeightOptimizer::m_minHeight),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MaxHeight",
+                   "The highest candidate antenna height (default is 100 m).",
+                   DoubleValue (100.0),
+                   MakeDoubleAccessor (&SiteHeightOptimizer::m_maxHeight),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("HeightStep",
+                   "The step between the candidate antenna heights (default is 1 m).",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&SiteHeightOptimizer::m_heightStep),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TxPowerDbm",
+                   "The transmission power of the base station (default is 43 dBm).",
+                   DoubleValue (43.0),
+                   MakeDoubleAccessor (&SiteHeightOptimizer::m_txPowerDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SensitivityDbm",
+                   "The received power a location needs to be covered (default is -95 dBm).",
+                   DoubleValue (-95.0),
+                   MakeDoubleAccessor (&SiteHeightOptimizer::m_sensitivityDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("ReceiverHeight",
+                   "The height of the receivers, for the link distances (default is 1.5 m).",
+                   DoubleValue (1.5),
+                   MakeDoubleAccessor (&SiteHeightOptimizer::m_receiverHeight),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("TileSize",
+                   "The number of locations evaluated together (default is 4096).",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&SiteHeightOptimizer::m_tileSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Threads",
+                   "The number of threads, 0 for one per core (default is 0).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SiteHeightOptimizer::m_threads),
+                   MakeUintegerChecker<uint32_t> ());
+  return tid;
+}
+
+SiteHeightOptimizer::SiteHeightOptimizer ()
+  : m_peekModel (0),
+    m_bestSite (0),
+    m_bestHeight (0)
+{
+}
+
+SiteHeightOptimizer::~SiteHeightOptimizer ()
+{
+}
+
+void
+SiteHeightOptimizer::DoDispose (void)
+{
+  m_model = 0;
+  m_peekModel = 0;
+  Object::DoDispose ();
+}
+
+void
+SiteHeightOptimizer::SetModel (Ptr<EmpiricalPropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  m_model = model;
+}
+
+uint32_t
+SiteHeightOptimizer::AddCandidateSite (double x, double y)
+{
+  NS_LOG_FUNCTION (this << x << y);
+  m_siteX.push_back (x);
+  m_siteY.push_back (y);
+  m_covered.clear ();
+  return m_siteX.size () - 1;
+}
+
+uint32_t
+SiteHeightOptimizer::GetNSites (void) const
+{
+  return m_siteX.size ();
+}
+
+void
+SiteHeightOptimizer::SetTargetArea (const double *x, const double *y, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_x.assign (x, x + n);
+  m_y.assign (y, y + n);
+  m_covered.clear ();
+}
+
+uint32_t
+SiteHeightOptimizer::GetNLocations (void) const
+{
+  return m_x.size ();
+}
+
+void
+SiteHeightOptimizer::EvaluateUnit (uint32_t site, uint32_t begin, uint32_t n, double *horizontal,
+                                   double *distance, double *loss, uint64_t *covered) const
+{
+  double sx = m_siteX[site];
+  double sy = m_siteY[site];
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      double dx = m_x[begin + i] - sx;
+      double dy = m_y[begin + i] - sy;
+      horizontal[i] = dx * dx + dy * dy;
+    }
+  const uint8_t *clutter = m_clutter.empty () ? 0 : m_clutter.data () + begin;
+  double threshold = m_sensitivityDbm - m_txPowerDbm;
+
+  // the 3D distance depends on the height, so only its horizontal part
+  // is shared: log10 (distance) is not separable into tile and height terms
+  for (uint32_t k = 0; k < m_heights.size (); ++k)
+    {
+      double dz = m_heights[k] - m_receiverHeight;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          distance[i] = std::sqrt (horizontal[i] + dz * dz);
+        }
+      m_peekModel->GetLossBatchAtHeight (m_heights[k], distance, clutter, loss, n);
+      uint64_t count = 0;
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          count += loss[i] >= threshold;
+        }
+      covered[k] += count;
+    }
+}
+
+void
+SiteHeightOptimizer::Worker (std::atomic<uint32_t> *nextUnit, uint64_t *covered)
+{
+  uint32_t locations = m_x.size ();
+  uint32_t tiles = (locations + static_cast<uint64_t> (m_tileSize) - 1) / m_tileSize;
+  uint32_t units = tiles * m_siteX.size ();
+  std::vector<double> horizontal (m_tileSize);
+  std::vector<double> distance (m_tileSize);
+  std::vector<double> loss (m_tileSize);
+  while (true)
+    {
+      uint32_t unit = nextUnit->fetch_add (1);
+      if (unit >= units)
+        {
+          return;
+        }
+      uint32_t site = unit / tiles;
+      uint32_t begin = (unit % tiles) * m_tileSize;
+      uint32_t n = std::min (m_tileSize, locations - begin);
+      EvaluateUnit (site, begin, n, horizontal.data (), distance.data (), loss.data (),
+                    covered + static_cast<size_t> (site) * m_heights.size ());
+    }
+}
+
+void
+SiteHeightOptimizer::Run (void)
+{
+  uint32_t locations = m_x.size ();
+  NS_LOG_FUNCTION (this << m_siteX.size () << locations);
+  NS_ABORT_MSG_IF (m_model == 0, "No model");
+  NS_ABORT_MSG_IF (m_siteX.empty (), "No candidate site");
+  NS_ABORT_MSG_IF (locations == 0, "No target area");
+  NS_ABORT_MSG_IF (m_heightStep <= 0 || m_maxHeight < m_minHeight, "No candidate height");
+
+  m_heights.clear ();
+  uint32_t nHeights = static_cast<uint32_t> (std::floor ((m_maxHeight - m_minHeight) / m_heightStep + 1e-9)) + 1;
+  for (uint32_t k = 0; k < nHeights; ++k)
+    {
+      m_heights.push_back (m_minHeight + k * m_heightStep);
+    }
+
+  // the workers only use raw pointers: the reference counts are not atomic
+  m_peekModel = PeekPointer (m_model);
+  m_clutter.clear ();
+  Ptr<ClutterRaster> raster = m_model->GetClutterRaster ();
+  if (raster != 0)
+    {
+      m_clutter.resize (locations);
+      raster->GetClasses (m_x.data (), m_y.data (), m_clutter.data (), locations);
+    }
+
+  uint32_t tiles = (locations + static_cast<uint64_t> (m_tileSize) - 1) / m_tileSize;
+  uint32_t units = tiles * m_siteX.size ();
+  uint32_t threads = m_threads > 0 ? m_threads : std::max (1u, std::thread::hardware_concurrency ());
+  threads = std::min (threads, units);
+  size_t candidates = m_siteX.size () * m_heights.size ();
+  // one table of counts per worker, summed once they are done
+  std::vector<std::vector<uint64_t> > covered (threads, std::vector<uint64_t> (candidates, 0));
+  std::atomic<uint32_t> nextUnit (0);
+  if (threads <= 1)
+    {
+      Worker (&nextUnit, covered[0].data ());
+    }
+  else
+    {
+      std::vector<std::thread> workers;
+      for (uint32_t t = 0; t < threads; ++t)
+        {
+          workers.push_back (std::thread (&SiteHeightOptimizer::Worker, this, &nextUnit, covered[t].data ()));
+        }
+      for (uint32_t t = 0; t < threads; ++t)
+        {
+          workers[t].join ();
+        }
+    }
+
+  m_covered.assign (candidates, 0);
+  for (uint32_t t = 0; t < threads; ++t)
+    {
+      for (size_t c = 0; c < candidates; ++c)
+        {
+          m_covered[c] += covered[t][c];
+        }
+    }
+  m_bestSite = 0;
+  m_bestHeight = 0;
+  for (uint32_t s = 0; s < m_siteX.size (); ++s)
+    {
+      for (uint32_t k = 0; k < nHeights; ++k)
+        {
+          if (m_covered[s * nHeights + k] > m_covered[m_bestSite * nHeights + m_bestHeight]
+              || (m_covered[s * nHeights + k] == m_covered[m_bestSite * nHeights + m_bestHeight] && k < m_bestHeight))
+            {
+              m_bestSite = s;
+              m_bestHeight = k;
+            }
+        }
+    }
+  NS_LOG_LOGIC ("Best site " << m_bestSite << " at " << m_heights[m_bestHeight] << " m covers "
+                << m_covered[m_bestSite * nHeights + m_bestHeight] << " of " << locations << " locations");
+}
+
+uint32_t
+SiteHeightOptimizer::GetNHeights (void) const
+{
+  return m_heights.size ();
+}
+
+double
+SiteHeightOptimizer::GetHeight (uint32_t k) const
+{
+  NS_ASSERT (k < m_heights.size ());
+  return m_heights[k];
+}
+
+double
+SiteHeightOptimizer::GetCoverage (uint32_t site, uint32_t k) const
+{
+  NS_ASSERT (site < m_siteX.size () && k < m_heights.size () && !m_covered.empty ());
+  return static_cast<double> (m_covered[site * m_heights.size () + k]) / m_x.size ();
+}
+
+uint32_t
+SiteHeightOptimizer::GetBestSite (void) const
+{
+  NS_ASSERT (!m_covered.empty ());
+  return m_bestSite;
+}
+
+double
+SiteHeightOptimizer::GetBestHeight (void) const
+{
+  NS_ASSERT (!m_covered.empty ());
+  return m_heights[m_bestHeight];
+}
+
+double
+SiteHeightOptimizer::GetBestCoverage (void) const
+{
+  return GetCoverage (m_bestSite, m_bestHeight);
+}
+
+}
@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef SITE_HEIGHT_OPTIMIZER_H
+#define SITE_HEIGHT_OPTIMIZER_H
+
+#include <atomic>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/empirical-propagation-loss-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Search the base station height, and optionally the site, that
+ * covers the most of a target area
+ *
+ * Every candidate site is evaluated at every height from MinHeight to
+ * MaxHeight by HeightStep. A target location is covered when its
+ * received power, TxPowerDbm plus the loss of the model, reaches
+ * SensitivityDbm. The best candidate covers the most locations; ties go
+ * to the lowest height, then to the first site.
+ *
+ * The work is split into (site, tile of TileSize locations) units that
+ * Threads threads take in turn. A unit computes the horizontal distances
+ * and clutter classes of its tile once, and reuses them for every
+ * height: only the vertical offset and the height-dependent coefficients
+ * of the model (see EmpiricalPropagationLossModel::GetLossBatchAtHeight)
+ * change from one height to the next. The model itself is never
+ * modified, so the heights need no synchronization.
+ *
+ * The link distance is the 3D one, as in CalcRxPower, so it changes with
+ * the height: its square root and logarithm are computed again at every
+ * height. Caching the logarithm per tile would only be exact for the
+ * horizontal distance, which underestimates the loss of the locations
+ * close to a tall mast.
+ */
+class SiteHeightOptimizer : public Object
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  SiteHeightOptimizer ();
+  virtual ~SiteHeightOptimizer ();
+
+  /**
+   * \param model the empirical model of the base station; its Tx antenna
+   *        height is replaced by the candidate heights
+   */
+  void SetModel (Ptr<EmpiricalPropagationLossModel> model);
+  /**
+   * \param x the x coordinate of the candidate site [m]
+   * \param y the y coordinate of the candidate site [m]
+   * \returns the index of the site
+   */
+  uint32_t AddCandidateSite (double x, double y);
+  /**
+   * \returns the number of candidate sites
+   */
+  uint32_t GetNSites (void) const;
+  /**
+   * Set the locations of the target area; the receivers are at
+   * ReceiverHeight
+   * \param x the x coordinates [m]
+   * \param y the y coordinates [m]
+   * \param n the number of locations
+   */
+  void SetTargetArea (const double *x, const double *y, uint32_t n);
+  /**
+   * \returns the number of target locations
+   */
+  uint32_t GetNLocations (void) const;
+
+  /**
+   * Evaluate every candidate site at every height
+   */
+  void Run (void);
+
+  /**
+   * \returns the number of candidate heights
+   */
+  uint32_t GetNHeights (void) const;
+  /**
+   * \param k the index of a candidate height
+   * \returns the height [m]
+   */
+  double GetHeight (uint32_t k) const;
+  /**
+   * \param site the index of a candidate site
+   * \param k the index of a candidate height
+   * \returns the fraction of the target area the site covers at that height
+   */
+  double GetCoverage (uint32_t site, uint32_t k) const;
+  /**
+   * \returns the index of the best site
+   */
+  uint32_t GetBestSite (void) const;
+  /**
+   * \returns the best height [m]
+   */
+  double GetBestHeight (void) const;
+  /**
+   * \returns the fraction of the target area the best candidate covers
+   */
+  double GetBestCoverage (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  SiteHeightOptimizer (const SiteHeightOptimizer &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  SiteHeightOptimizer & operator = (const SiteHeightOptimizer &);
+
+  /**
+   * Take units until there are none left
+   * \param nextUnit the index of the next unit to take
+   * \param covered the covered locations of this worker, per site and
+   *        height
+   */
+  void Worker (std::atomic<uint32_t> *nextUnit, uint64_t *covered);
+  /**
+   * Evaluate one site at every height over a tile
+   * \param site the index of the site
+   * \param begin the first location of the tile
+   * \param n the number of locations of the tile
+   * \param horizontal scratch space of n squared horizontal distances
+   * \param distance scratch space of n distances
+   * \param loss scratch space of n losses
+   * \param covered the covered locations of the site, per height
+   */
+  void EvaluateUnit (uint32_t site, uint32_t begin, uint32_t n, double *horizontal,
+                     double *distance, double *loss, uint64_t *covered) const;
+
+  double m_minHeight; //!< lowest candidate height [m]
+  double m_maxHeight; //!< highest candidate height [m]
+  double m_heightStep; //!< step between the candidate heights [m]
+  double m_txPowerDbm; //!< transmission power [dBm]
+  double m_sensitivityDbm; //!< received power of a covered location [dBm]
+  double m_receiverHeight; //!< height of the receivers [m]
+  uint32_t m_tileSize; //!< number of locations per unit
+  uint32_t m_threads; //!< number of threads, 0 for one per core
+
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< model of the base station
+  const EmpiricalPropagationLossModel *m_peekModel; //!< m_model for the workers, set by Run
+  std::vector<double> m_siteX; //!< x coordinates of the candidate sites [m]
+  std::vector<double> m_siteY; //!< y coordinates of the candidate sites [m]
+  std::vector<double> m_x; //!< x coordinates of the locations [m]
+  std::vector<double> m_y; //!< y coordinates of the locations [m]
+  std::vector<uint8_t> m_clutter; //!< clutter classes of the locations, empty without a raster
+  std::vector<double> m_heights; //!< candidate heights [m]
+  std::vector<uint64_t> m_covered; //!< covered locations, site-major: m_covered[site * heights + k]
+  uint32_t m_bestSite; //!< index of the best site
+  uint32_t m_bestHeight; //!< index of the best height
+};
+
+}
+
+#endif /* SITE_HEIGHT_OPTIMIZER_H */
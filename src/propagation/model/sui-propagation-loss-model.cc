@@ -25,6 +25,7 @@
 #include "ns3/double.h"
 #include "ns3/enum.h"
 #include "ns3/pointer.h"
+#include "ns3/perf-counter-scope.h"
 #include <cmath>
 #include "sui-propagation-loss-model.h"
 
@@ -38,7 +39,7 @@ TypeId
 SUIPropagationLossModel::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::SUIPropagationLossModel")
-    .SetParent<PropagationLossModel> ()
+    .SetParent<EmpiricalPropagationLossModel> ()
     .SetGroupName ("Propagation")
     .AddConstructor<SUIPropagationLossModel> ()
     .AddAttribute ("Lambda",
@@ -145,42 +146,53 @@ double
 SUIPropagationLossModel::GetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
 {
 
-  double distance = a->GetDistanceFrom (b);
+  Parameters p = GuardParameters (GetReceiverParameters (b), 1);
+  PerfCounterScope scope ("scalar", this, p.environment, 1);
+  double distance = GuardDistance (a->GetDistanceFrom (b));
+  double loss = EmpiricalKernels::SuiLoss (p, m_shadowing, distance, GetMathBackend ());
 
-  double frequency_MHz = m_frequency * 1e-6;
+  NS_LOG_DEBUG ("dist =" << distance << ", Path Loss = " << -loss);
 
-  double d0 = 100.0;
+  return loss;
 
-  double Xf = 6.0 * std::log10(frequency_MHz / 2000.0);
-  double Xh = -10.8 * std::log10(m_SSAntennaHeight / 2000.0);
-  double modparam_a = 4.6, modparam_b = 0.0075, modparam_c = 12.6;
-  if (m_terrain == A) {
-    modparam_a = 4.6;
-    modparam_b = 0.0075;
-    modparam_c = 12.6;
-    Xh = -10.8 * std::log10(m_SSAntennaHeight / 2000.0);
-  } else if (m_terrain == B) {
-    modparam_a = 4.0;
-    modparam_b = 0.0065;
-    modparam_c = 17.1;
-    Xh = -10.8 * std::log10(m_SSAntennaHeight / 2000.0);
-  } else if (m_terrain == C) {
-    modparam_a = 3.6;
-    modparam_b = 0.005;
-    modparam_c = 20.0;
-    Xh = -20.0 * std::log10(m_SSAntennaHeight / 20000.0);
-  }
-
-  double param_A = 20 * log10(4 * M_PI * d0 / m_lambda);
+}
 
-  double gamma = modparam_a - modparam_b * m_BSAntennaHeight + (modparam_c / m_BSAntennaHeight);
+SUIPropagationLossModel::Parameters
+SUIPropagationLossModel::DoGetParameters (void) const
+{
+  Parameters p;
+  p.frequency = m_frequency;
+  p.lambda = m_lambda;
+  p.txAntennaHeight = m_BSAntennaHeight;
+  p.rxAntennaHeight = m_SSAntennaHeight;
+  p.environment = m_terrain;
+  return p;
+}
 
-  double loss_in_db = param_A + 10 * gamma * std::log10(distance / d0) + Xf + Xh + m_shadowing;
+SUIPropagationLossModel::ValidityRange
+SUIPropagationLossModel::DoGetValidityRange (void) const
+{
+  return EmpiricalKernels::SuiValidityRange ();
+}
 
-  NS_LOG_DEBUG ("dist =" << distance << ", Path Loss = " << loss_in_db);
+SUIPropagationLossModel::Coefficients
+SUIPropagationLossModel::DoGetCoefficients (const Parameters &parameters) const
+{
+  return EmpiricalKernels::SuiCoefficients (parameters, m_shadowing);
+}
 
-  return (0 - loss_in_db);
+SUIPropagationLossModel::CoefficientDerivatives
+SUIPropagationLossModel::DoGetCoefficientDerivatives (const Parameters &parameters) const
+{
+  return EmpiricalKernels::SuiCoefficientDerivatives (parameters);
+}
 
+int32_t
+SUIPropagationLossModel::DoGetClutterEnvironment (ClutterRaster::ClutterClass clutter) const
+{
+  // terrain A (hilly, dense) to C (flat, light tree density)
+  const Terrain terrain[ClutterRaster::NUM_CLASSES] = { A, B, C };
+  return terrain[clutter];
 }
 
 double
@@ -23,7 +23,7 @@
 #define SUI_PROPAGATION_LOSS_MODEL_H
 
 #include "ns3/nstime.h"
-#include "ns3/propagation-loss-model.h"
+#include "ns3/empirical-propagation-loss-model.h"
 
 namespace ns3 {
 
@@ -47,7 +47,7 @@ namespace ns3 {
  *
  */
 
-class SUIPropagationLossModel : public PropagationLossModel
+class SUIPropagationLossModel : public EmpiricalPropagationLossModel
 {
 
 public:
@@ -58,7 +58,9 @@ public:
   static TypeId GetTypeId (void);
   SUIPropagationLossModel ();
   enum Terrain {
-    A, B, C
+    A = EmpiricalKernels::SUI_A,
+    B = EmpiricalKernels::SUI_B,
+    C = EmpiricalKernels::SUI_C
   };
 
   /**
@@ -143,6 +145,11 @@ private:
 
   virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual Parameters DoGetParameters (void) const;
+  virtual ValidityRange DoGetValidityRange (void) const;
+  virtual Coefficients DoGetCoefficients (const Parameters &parameters) const;
+  virtual int32_t DoGetClutterEnvironment (ClutterRaster::ClutterClass clutter) const;
+  virtual CoefficientDerivatives DoGetCoefficientDerivatives (const Parameters &parameters) const;
   double m_BSAntennaHeight; //!< BS Antenna Height [m]
   double m_SSAntennaHeight; //!< SS Antenna Height [m]
   double m_lambda; //!< The wavelength
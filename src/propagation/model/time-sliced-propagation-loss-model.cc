@@ -0,0 +1,265 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include <cmath>
+#include "time-sliced-propagation-loss-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimeSlicedPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TimeSlicedLossPipeline);
+NS_OBJECT_ENSURE_REGISTERED (TimeSlicedPropagationLossModel);
+
+TypeId
+TimeSlicedLossPipeline::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TimeSlicedLossPipeline")
+    .SetParent<Object> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<TimeSlicedLossPipeline> ()
+    .AddAttribute ("SliceDuration",
+                   "Maximum age of the positions the losses are computed from (default is 100 ms).",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&TimeSlicedLossPipeline::m_sliceDuration),
+                   MakeTimeChecker ());
+  return tid;
+}
+
+TimeSlicedLossPipeline::TimeSlicedLossPipeline ()
+  : m_valid (false)
+{
+}
+
+TimeSlicedLossPipeline::~TimeSlicedLossPipeline ()
+{
+}
+
+void
+TimeSlicedLossPipeline::DoDispose (void)
+{
+  m_tx = NodeSet ();
+  m_rx = NodeSet ();
+  m_slots.clear ();
+  m_models.clear ();
+  m_tables.clear ();
+  m_distance.clear ();
+  m_valid = false;
+  Object::DoDispose ();
+}
+
+void
+TimeSlicedLossPipeline::Add (NodeSet &set, NodeContainer nodes, bool receivers)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<MobilityModel> mobility = (*i)->GetObject<MobilityModel> ();
+      NS_ABORT_MSG_IF (mobility == 0, "Node " << (*i)->GetId () << " has no MobilityModel");
+      Slot empty = { -1, -1 };
+      Slot &slot = m_slots.insert (std::make_pair (PeekPointer (mobility), empty)).first->second;
+      (receivers ? slot.rx : slot.tx) = set.mobility.size ();
+      set.mobility.push_back (mobility);
+    }
+  set.x.resize (set.mobility.size ());
+  set.y.resize (set.mobility.size ());
+  set.z.resize (set.mobility.size ());
+  m_valid = false;
+}
+
+void
+TimeSlicedLossPipeline::AddTransmitters (NodeContainer nodes)
+{
+  NS_LOG_FUNCTION (this << nodes.GetN ());
+  Add (m_tx, nodes, false);
+}
+
+void
+TimeSlicedLossPipeline::AddReceivers (NodeContainer nodes)
+{
+  NS_LOG_FUNCTION (this << nodes.GetN ());
+  Add (m_rx, nodes, true);
+}
+
+Ptr<PropagationLossModel>
+TimeSlicedLossPipeline::AddModel (Ptr<EmpiricalPropagationLossModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  Ptr<TimeSlicedPropagationLossModel> view = CreateObject<TimeSlicedPropagationLossModel> ();
+  view->SetPipeline (this, m_models.size (), model);
+  m_models.push_back (model);
+  m_tables.push_back (std::vector<double> ());
+  m_valid = false;
+  return view;
+}
+
+void
+TimeSlicedLossPipeline::Snapshot (NodeSet &set)
+{
+  for (uint32_t i = 0; i < set.mobility.size (); ++i)
+    {
+      Vector position = set.mobility[i]->GetPosition ();
+      set.x[i] = position.x;
+      set.y[i] = position.y;
+      set.z[i] = position.z;
+    }
+}
+
+void
+TimeSlicedLossPipeline::Update (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Snapshot (m_tx);
+  Snapshot (m_rx);
+
+  uint32_t nTx = m_tx.mobility.size ();
+  uint32_t nRx = m_rx.mobility.size ();
+  m_distance.resize (static_cast<size_t> (nTx) * nRx);
+  const double *rxX = m_rx.x.data ();
+  const double *rxY = m_rx.y.data ();
+  const double *rxZ = m_rx.z.data ();
+  for (uint32_t i = 0; i < nTx; ++i)
+    {
+      double x = m_tx.x[i];
+      double y = m_tx.y[i];
+      double z = m_tx.z[i];
+      double *distance = &m_distance[static_cast<size_t> (i) * nRx];
+      for (uint32_t j = 0; j < nRx; ++j)
+        {
+          double dx = rxX[j] - x;
+          double dy = rxY[j] - y;
+          double dz = rxZ[j] - z;
+          distance[j] = std::sqrt (dx * dx + dy * dy + dz * dz);
+        }
+    }
+
+  for (uint32_t k = 0; k < m_models.size (); ++k)
+    {
+      m_tables[k].resize (m_distance.size ());
+      Ptr<ClutterRaster> raster = m_models[k]->GetClutterRaster ();
+      if (raster == 0)
+        {
+          m_models[k]->GetLossBatch (m_distance.data (), m_tables[k].data (), m_distance.size ());
+          continue;
+        }
+      // the receivers pick the environment, so one class row serves every transmitter
+      m_clutter.resize (nRx);
+      raster->GetClasses (rxX, rxY, m_clutter.data (), nRx);
+      for (uint32_t i = 0; i < nTx; ++i)
+        {
+          size_t offset = static_cast<size_t> (i) * nRx;
+          m_models[k]->GetLossBatch (&m_distance[offset], m_clutter.data (), &m_tables[k][offset], nRx);
+        }
+    }
+
+  m_sliceStart = Simulator::Now ();
+  m_valid = true;
+  NS_LOG_DEBUG ("slice at " << m_sliceStart << ": " << nTx << "x" << nRx << " links, " << m_models.size () << " models");
+}
+
+Time
+TimeSlicedLossPipeline::GetSliceStart (void) const
+{
+  return m_sliceStart;
+}
+
+bool
+TimeSlicedLossPipeline::Lookup (uint32_t model, Ptr<MobilityModel> a, Ptr<MobilityModel> b, double &loss)
+{
+  NS_ASSERT (model < m_models.size ());
+  std::unordered_map<const MobilityModel *, Slot>::const_iterator slotA = m_slots.find (PeekPointer (a));
+  std::unordered_map<const MobilityModel *, Slot>::const_iterator slotB = m_slots.find (PeekPointer (b));
+  if (slotA == m_slots.end () || slotB == m_slots.end ())
+    {
+      return false;
+    }
+  int32_t tx = slotA->second.tx;
+  int32_t rx = slotB->second.rx;
+  if (tx < 0 || rx < 0)
+    {
+      // the reversed link has the same loss, unless the receiver picks the environment
+      tx = slotB->second.tx;
+      rx = slotA->second.rx;
+      if (tx < 0 || rx < 0 || m_models[model]->GetClutterRaster () != 0)
+        {
+          return false;
+        }
+    }
+
+  Time now = Simulator::Now ();
+  if (!m_valid || (now > m_sliceStart && now >= m_sliceStart + m_sliceDuration))
+    {
+      Update ();
+    }
+  loss = m_tables[model][static_cast<size_t> (tx) * m_rx.mobility.size () + rx];
+  return true;
+}
+
+TypeId
+TimeSlicedPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TimeSlicedPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<TimeSlicedPropagationLossModel> ();
+  return tid;
+}
+
+TimeSlicedPropagationLossModel::TimeSlicedPropagationLossModel ()
+  : m_index (0)
+{
+}
+
+void
+TimeSlicedPropagationLossModel::SetPipeline (Ptr<TimeSlicedLossPipeline> pipeline, uint32_t index,
+                                             Ptr<EmpiricalPropagationLossModel> model)
+{
+  m_pipeline = pipeline;
+  m_index = index;
+  m_model = model;
+}
+
+double
+TimeSlicedPropagationLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  double loss;
+  if (!m_pipeline->Lookup (m_index, a, b, loss))
+    {
+      return m_model->CalcRxPower (txPowerDbm, a, b);
+    }
+  // the tables only hold the empirical model: apply its chain as CalcRxPower would
+  double rxPowerDbm = txPowerDbm + loss;
+  Ptr<PropagationLossModel> next = m_model->GetNext ();
+  if (next != 0)
+    {
+      rxPowerDbm = next->CalcRxPower (rxPowerDbm, a, b);
+    }
+  return rxPowerDbm;
+}
+
+int64_t
+TimeSlicedPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+}
@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TIME_SLICED_PROPAGATION_LOSS_MODEL_H
+#define TIME_SLICED_PROPAGATION_LOSS_MODEL_H
+
+#include <unordered_map>
+#include <vector>
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/empirical-propagation-loss-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Evaluates all the links of a set of nodes once per time slice
+ *
+ * At the first loss lookup of a time slice, the positions of all the
+ * transmitters and receivers are copied into contiguous coordinate
+ * arrays, the distances of all the tx x rx links are computed in one pass
+ * and every configured empirical model evaluates them with its batch
+ * path. The losses are kept in one table per model until the slice ends.
+ *
+ * The channel reads the tables through the TimeSlicedPropagationLossModel
+ * returned by AddModel. Positions, and hence losses, are at most
+ * SliceDuration old. A lookup finds the row and column of a link with one
+ * hash lookup per mobility model. A receiver -> transmitter link reads
+ * the loss of the transmitter -> receiver one, unless the model has a
+ * clutter raster: the environment is then the one of the receiver, and
+ * the link is evaluated directly.
+ */
+class TimeSlicedLossPipeline : public Object
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  TimeSlicedLossPipeline ();
+  virtual ~TimeSlicedLossPipeline ();
+
+  /**
+   * Add transmitters, which must have a MobilityModel
+   * \param nodes the transmitters
+   */
+  void AddTransmitters (NodeContainer nodes);
+  /**
+   * Add receivers, which must have a MobilityModel
+   * \param nodes the receivers
+   */
+  void AddReceivers (NodeContainer nodes);
+  /**
+   * Add a model evaluated at every slice
+   *
+   * The returned model should be installed in the channel in place of
+   * the empirical model, and any further model chained to it. Links that
+   * the pipeline does not track are evaluated directly by the empirical
+   * model. Models chained to the empirical model (SetNext) are applied
+   * to the losses of the tables as well.
+   *
+   * \param model the empirical model
+   * \returns the model reading the losses of the slice
+   */
+  Ptr<PropagationLossModel> AddModel (Ptr<EmpiricalPropagationLossModel> model);
+
+  /**
+   * Look up the loss of a link in the current slice, starting a new slice
+   * if the current one is over
+   * \param model index of the model, in AddModel order
+   * \param a the mobility model of the source
+   * \param b the mobility model of the destination
+   * \param loss the propagation loss (in dBm)
+   * \returns false if the link is not tracked by the pipeline
+   */
+  bool Lookup (uint32_t model, Ptr<MobilityModel> a, Ptr<MobilityModel> b, double &loss);
+  /**
+   * Evaluate all the links now and start a new slice
+   */
+  void Update (void);
+  /**
+   * \returns the time the current slice started
+   */
+  Time GetSliceStart (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  TimeSlicedLossPipeline (const TimeSlicedLossPipeline &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  TimeSlicedLossPipeline & operator = (const TimeSlicedLossPipeline &);
+
+  /**
+   * Positions of a set of nodes, as separate coordinate arrays
+   */
+  struct NodeSet
+  {
+    std::vector<Ptr<MobilityModel> > mobility; //!< mobility models
+    std::vector<double> x; //!< x coordinates [m]
+    std::vector<double> y; //!< y coordinates [m]
+    std::vector<double> z; //!< z coordinates [m]
+  };
+
+  /**
+   * Row and column of a mobility model in the tables
+   */
+  struct Slot
+  {
+    int32_t tx; //!< position among the transmitters, -1 if none
+    int32_t rx; //!< position among the receivers, -1 if none
+  };
+
+  /**
+   * \param set the set to add to
+   * \param nodes the nodes to add
+   * \param receivers whether set is m_rx
+   */
+  void Add (NodeSet &set, NodeContainer nodes, bool receivers);
+  /**
+   * \param set the set to snapshot
+   */
+  static void Snapshot (NodeSet &set);
+
+  Time m_sliceDuration; //!< maximum age of the losses
+  Time m_sliceStart; //!< start of the current slice
+  bool m_valid; //!< whether the tables hold a slice
+  NodeSet m_tx; //!< transmitters (rows)
+  NodeSet m_rx; //!< receivers (columns)
+  std::unordered_map<const MobilityModel *, Slot> m_slots; //!< row and column of each mobility model
+  std::vector<double> m_distance; //!< link distances of the slice [m], row-major
+  std::vector<uint8_t> m_clutter; //!< clutter classes of the receivers
+  std::vector<Ptr<EmpiricalPropagationLossModel> > m_models; //!< evaluated models
+  std::vector<std::vector<double> > m_tables; //!< losses of the slice, one table per model
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Propagation loss read from a TimeSlicedLossPipeline table
+ */
+class TimeSlicedPropagationLossModel : public PropagationLossModel
+{
+
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  TimeSlicedPropagationLossModel ();
+
+  /**
+   * \param pipeline the pipeline holding the tables
+   * \param index index of the model in the pipeline
+   * \param model the empirical model, used for untracked links
+   */
+  void SetPipeline (Ptr<TimeSlicedLossPipeline> pipeline, uint32_t index,
+                    Ptr<EmpiricalPropagationLossModel> model);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  TimeSlicedPropagationLossModel (const TimeSlicedPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  TimeSlicedPropagationLossModel & operator = (const TimeSlicedPropagationLossModel &);
+
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  Ptr<TimeSlicedLossPipeline> m_pipeline; //!< pipeline holding the tables
+  uint32_t m_index; //!< index of the model in the pipeline
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< the empirical model
+};
+
+}
+
+#endif /* TIME_SLICED_PROPAGATION_LOSS_MODEL_H */
@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/adaptive-path-sampler.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("AdaptivePathSamplerTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Compare the adaptive samples of two models with a dense uniform
+ * sampling of the same path
+ */
+class AdaptivePathSamplerTestCase : public TestCase
+{
+public:
+  AdaptivePathSamplerTestCase ();
+  virtual ~AdaptivePathSamplerTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the straight lines between the samples with the models, every
+   * meter along the path
+   * \param sampler the sampler holding the samples
+   * \param models the models of the sampler
+   * \param transmitter the position of the transmitter
+   * \param tolerance the Tolerance of the sampler [dB]
+   * \returns the number of 1 m samples
+   */
+  uint32_t CheckInterpolation (Ptr<AdaptivePathSampler> sampler, const std::vector<Ptr<PropagationLossModel> > &models,
+                               const Vector &transmitter, double tolerance);
+};
+
+AdaptivePathSamplerTestCase::AdaptivePathSamplerTestCase ()
+  : TestCase ("Check the adaptive path samples against a dense sampling")
+{
+}
+
+AdaptivePathSamplerTestCase::~AdaptivePathSamplerTestCase ()
+{
+}
+
+uint32_t
+AdaptivePathSamplerTestCase::CheckInterpolation (Ptr<AdaptivePathSampler> sampler,
+                                                 const std::vector<Ptr<PropagationLossModel> > &models,
+                                                 const Vector &transmitter, double tolerance)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (transmitter);
+  uint32_t dense = 0;
+  for (uint32_t i = 1; i < sampler->GetNSamples (); ++i)
+    {
+      Vector p = sampler->GetPosition (i - 1);
+      Vector q = sampler->GetPosition (i);
+      double span = CalculateDistance (p, q);
+      for (double s = 0; s < span; s += 1.0)
+        {
+          double t = s / span;
+          b->SetPosition (Vector (p.x + t * (q.x - p.x), p.y + t * (q.y - p.y), p.z + t * (q.z - p.z)));
+          dense++;
+          for (uint32_t k = 0; k < models.size (); ++k)
+            {
+              double interpolated = sampler->GetLoss (k, i - 1) + t * (sampler->GetLoss (k, i) - sampler->GetLoss (k, i - 1));
+              NS_TEST_EXPECT_MSG_EQ_TOL (-models[k]->CalcRxPower (0, a, b), interpolated, tolerance,
+                                         "Interpolation off the model " << k << " between samples " << i - 1 << " and " << i);
+            }
+        }
+    }
+  return dense;
+}
+
+void
+AdaptivePathSamplerTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  const double tolerance = 0.5;
+  const Vector transmitter (0.0, 0.0, 30.0);
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetTxAntennaHeight (30.0);
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Urban);
+  Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+  sui->SetTerrain (SUIPropagationLossModel::B);
+  std::vector<Ptr<PropagationLossModel> > models;
+  models.push_back (ericsson);
+  models.push_back (sui);
+
+  Ptr<AdaptivePathSampler> sampler = CreateObject<AdaptivePathSampler> ();
+  sampler->SetAttribute ("Tolerance", DoubleValue (tolerance));
+  sampler->SetTransmitter (transmitter);
+  for (uint32_t k = 0; k < models.size (); ++k)
+    {
+      NS_TEST_ASSERT_MSG_EQ (sampler->AddModel (models[k]), k, "Wrong model index");
+    }
+
+  // moving away from the transmitter, then along a circle-like detour at 3 km
+  std::vector<Vector> waypoints;
+  waypoints.push_back (Vector (20.0, 0.0, 1.5));
+  waypoints.push_back (Vector (3000.0, 0.0, 1.5));
+  waypoints.push_back (Vector (3000.0, 0.0, 1.5));
+  waypoints.push_back (Vector (5000.0, 2000.0, 1.5));
+  sampler->Sample (waypoints);
+  uint32_t n = sampler->GetNSamples ();
+  NS_TEST_ASSERT_MSG_GT (n, waypoints.size (), "No refinement");
+
+  // the waypoints are samples, in order, and the samples are the losses of the models
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (transmitter);
+  double along = 0;
+  uint32_t waypoint = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Vector position = sampler->GetPosition (i);
+      if (i > 0)
+        {
+          along += CalculateDistance (sampler->GetPosition (i - 1), position);
+        }
+      if (waypoint < waypoints.size () && CalculateDistance (position, waypoints[waypoint]) == 0)
+        {
+          waypoint++;
+        }
+      b->SetPosition (position);
+      NS_TEST_ASSERT_MSG_EQ_TOL (sampler->GetDistance (i), CalculateDistance (transmitter, position), 1e-9,
+                                 "Wrong distance at sample " << i);
+      for (uint32_t k = 0; k < models.size (); ++k)
+        {
+          NS_TEST_ASSERT_MSG_EQ_TOL (sampler->GetLoss (k, i), -models[k]->CalcRxPower (0, a, b), 1e-9,
+                                     "Wrong loss of model " << k << " at sample " << i);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (waypoint, waypoints.size (), "Waypoints missing or out of order");
+  double length = CalculateDistance (waypoints[0], waypoints[1]) + CalculateDistance (waypoints[2], waypoints[3]);
+  NS_TEST_ASSERT_MSG_EQ_TOL (along, length, 1e-6, "Samples not along the path");
+
+  // a 1 m uniform sampling stays within the tolerance of the interpolated samples
+  uint32_t dense = CheckInterpolation (sampler, models, transmitter, tolerance);
+  NS_LOG_LOGIC (n << " adaptive samples, " << dense << " uniform samples");
+  NS_TEST_ASSERT_MSG_LT (n * 20, dense, "Adaptive sampling not much sparser than the uniform one");
+
+  // a tighter tolerance refines more
+  sampler->SetAttribute ("Tolerance", DoubleValue (tolerance / 4));
+  sampler->Sample (waypoints);
+  NS_TEST_ASSERT_MSG_GT (sampler->GetNSamples (), n, "Tighter tolerance without more samples");
+
+  // a leg passing the transmitter, with nearly the same losses at its ends:
+  // the closest point is a sample, and the losses are refined around it
+  sampler->SetAttribute ("Tolerance", DoubleValue (tolerance));
+  std::vector<Vector> pass;
+  pass.push_back (Vector (-3000.0, 10.0, 1.5));
+  pass.push_back (Vector (3050.0, 10.0, 1.5));
+  sampler->Sample (pass);
+  double closest = CalculateDistance (transmitter, pass[0]);
+  for (uint32_t i = 0; i < sampler->GetNSamples (); ++i)
+    {
+      closest = std::min (closest, sampler->GetDistance (i));
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (closest, CalculateDistance (transmitter, Vector (0.0, 10.0, 1.5)), 1e-9,
+                             "Closest point to the transmitter not sampled");
+  NS_TEST_ASSERT_MSG_GT (sampler->GetNSamples (), 10, "Leg passing the transmitter not refined");
+  CheckInterpolation (sampler, models, transmitter, tolerance);
+  sampler->Dispose ();
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Adaptive path sampler TestSuite
+ */
+class AdaptivePathSamplerTestSuite : public TestSuite
+{
+public:
+  AdaptivePathSamplerTestSuite ();
+};
+
+AdaptivePathSamplerTestSuite::AdaptivePathSamplerTestSuite ()
+  : TestSuite ("adaptive-path-sampler", UNIT)
+{
+  AddTestCase (new AdaptivePathSamplerTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static AdaptivePathSamplerTestSuite g_adaptivePathSamplerTestSuite;
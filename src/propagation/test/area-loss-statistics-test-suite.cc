@@ -0,0 +1,311 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/area-loss-statistics.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("AreaLossStatisticsTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the CDF, the quantiles and the merge of loss histograms
+ */
+class LossHistogramTestCase : public TestCase
+{
+public:
+  LossHistogramTestCase ();
+  virtual ~LossHistogramTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LossHistogramTestCase::LossHistogramTestCase ()
+  : TestCase ("Check the loss histograms")
+{
+}
+
+LossHistogramTestCase::~LossHistogramTestCase ()
+{
+}
+
+void
+LossHistogramTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // one loss in the middle of each bin, plus an underflow and an overflow
+  LossHistogram all (0.0, 100.0, 1.0);
+  LossHistogram even (0.0, 100.0, 1.0);
+  LossHistogram odd (0.0, 100.0, 1.0);
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      all.Add (i + 0.5);
+      (i % 2 ? odd : even).Add (i + 0.5);
+    }
+  const double outside[2] = { -5.0, 150.0 };
+  all.Add (outside, 2);
+  odd.Add (outside, 2);
+  NS_TEST_ASSERT_MSG_EQ (all.GetCount (), 102, "Wrong count");
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetCdf (-1.0), 0.0, 1e-12, "Wrong CDF below the bins");
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetCdf (50.0), 51.0 / 102, 1e-12, "Wrong CDF at a bin edge");
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetCdf (50.5), 51.5 / 102, 1e-12, "Wrong CDF within a bin");
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetCdf (100.0), 1.0, 1e-12, "Wrong CDF above the bins");
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetQuantile (0.0), 0.0, 1e-12, "Wrong minimum");
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetQuantile (0.5), 50.0, 1e-12, "Wrong median");
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetQuantile (51.5 / 102), 50.5, 1e-12, "Quantile not the inverse of the CDF");
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetQuantile (1.0), 100.0, 1e-12, "Wrong maximum");
+
+  // merging in any order gives the histogram of all the losses
+  LossHistogram merged = odd;
+  merged.Merge (even);
+  NS_TEST_ASSERT_MSG_EQ (merged.GetCount (), all.GetCount (), "Wrong merged count");
+  for (double loss = -1.0; loss <= 101.0; loss += 0.25)
+    {
+      NS_TEST_ASSERT_MSG_EQ (merged.GetCdf (loss), all.GetCdf (loss), "Wrong merged CDF at " << loss);
+    }
+  merged.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (merged.GetCount (), 0, "Counts left after Clear");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Compare the area statistics with the losses of every location
+ */
+class AreaLossStatisticsTestCase : public TestCase
+{
+public:
+  AreaLossStatisticsTestCase ();
+  virtual ~AreaLossStatisticsTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param statistics the statistics to run
+   * \param threads the number of threads
+   */
+  void Run (Ptr<AreaLossStatistics> statistics, uint32_t threads);
+};
+
+AreaLossStatisticsTestCase::AreaLossStatisticsTestCase ()
+  : TestCase ("Check the streaming area statistics")
+{
+}
+
+AreaLossStatisticsTestCase::~AreaLossStatisticsTestCase ()
+{
+}
+
+void
+AreaLossStatisticsTestCase::Run (Ptr<AreaLossStatistics> statistics, uint32_t threads)
+{
+  statistics->SetAttribute ("Threads", UintegerValue (threads));
+  statistics->Run ();
+}
+
+void
+AreaLossStatisticsTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  const Vector site (100.0, -50.0, 30.0);
+  const double spacing = 50.0;
+  const double side = 4000.0;
+  Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+  sui->SetTerrain (SUIPropagationLossModel::A);
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetTxAntennaHeight (30.0);
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Urban);
+  std::vector<Ptr<EmpiricalPropagationLossModel> > models;
+  models.push_back (sui);
+  models.push_back (ericsson);
+
+  // the losses of every cell of the grid, the threshold at the median SUI loss
+  uint32_t cells = static_cast<uint32_t> (side / spacing);
+  std::vector<double> distance;
+  for (uint32_t row = 0; row < cells; ++row)
+    {
+      for (uint32_t col = 0; col < cells; ++col)
+        {
+          double dx = -side / 2 + (col + 0.5) * spacing - site.x;
+          double dy = -side / 2 + (row + 0.5) * spacing - site.y;
+          distance.push_back (std::sqrt (dx * dx + dy * dy + (site.z - 1.5) * (site.z - 1.5)));
+        }
+    }
+  uint32_t n = distance.size ();
+  std::vector<std::vector<double> > exact (models.size (), std::vector<double> (n));
+  for (uint32_t k = 0; k < models.size (); ++k)
+    {
+      models[k]->GetLossBatch (distance.data (), exact[k].data (), n);
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          exact[k][i] = -exact[k][i];
+        }
+      std::sort (exact[k].begin (), exact[k].end ());
+    }
+  double threshold = exact[0][n / 2];
+
+  Ptr<AreaLossStatistics> grid = CreateObject<AreaLossStatistics> ();
+  grid->SetAttribute ("GridSpacing", DoubleValue (spacing));
+  grid->SetAttribute ("TileSize", UintegerValue (500));
+  grid->SetAttribute ("TxPowerDbm", DoubleValue (0.0));
+  grid->SetAttribute ("SensitivityDbm", DoubleValue (-threshold));
+  grid->SetSite (site);
+  grid->SetArea (-side / 2, -side / 2, side / 2, side / 2);
+  for (uint32_t k = 0; k < models.size (); ++k)
+    {
+      NS_TEST_ASSERT_MSG_EQ (grid->AddModel (models[k]), k, "Wrong model index");
+    }
+  Run (grid, 1);
+  NS_TEST_ASSERT_MSG_EQ (grid->GetNSamples (), n, "Not every cell evaluated");
+  NS_TEST_ASSERT_MSG_EQ (grid->HasConverged (), false, "A grid run stopped early");
+  for (uint32_t k = 0; k < models.size (); ++k)
+    {
+      uint32_t covered = std::upper_bound (exact[k].begin (), exact[k].end (), threshold) - exact[k].begin ();
+      NS_TEST_ASSERT_MSG_EQ_TOL (grid->GetCoverage (k), static_cast<double> (covered) / n, 1e-12,
+                                 "Wrong coverage of model " << k);
+      double low;
+      double high;
+      grid->GetCoverageBounds (k, low, high);
+      NS_TEST_ASSERT_MSG_EQ (low <= grid->GetCoverage (k) && grid->GetCoverage (k) <= high, true,
+                             "Coverage outside its bounds");
+      for (double p = 0.1; p < 1.0; p += 0.2)
+        {
+          double quantile = exact[k][static_cast<uint32_t> (p * n)];
+          NS_TEST_ASSERT_MSG_EQ_TOL (grid->GetQuantile (k, p), quantile, 0.2,
+                                     "Wrong quantile " << p << " of model " << k);
+          grid->GetQuantileBounds (k, p, low, high);
+          NS_TEST_ASSERT_MSG_EQ (low <= grid->GetQuantile (k, p) && grid->GetQuantile (k, p) <= high, true,
+                                 "Quantile outside its bounds");
+        }
+    }
+  // cells at the same distance from the site tie at the median
+  NS_TEST_ASSERT_MSG_EQ_TOL (grid->GetCoverage (0), 0.5, 0.01, "Threshold not at the median");
+
+  // the threads change nothing
+  double coverage = grid->GetCoverage (1);
+  double median = grid->GetQuantile (1, 0.5);
+  Run (grid, 4);
+  NS_TEST_ASSERT_MSG_EQ (grid->GetCoverage (1), coverage, "Coverage changed with the threads");
+  NS_TEST_ASSERT_MSG_EQ (grid->GetQuantile (1, 0.5), median, "Median changed with the threads");
+
+  // random locations stop at the precision
+  const double precision = 0.01;
+  Ptr<AreaLossStatistics> random = CreateObject<AreaLossStatistics> ();
+  random->SetAttribute ("Sampling", EnumValue (AreaLossStatistics::Random));
+  random->SetAttribute ("Precision", DoubleValue (precision));
+  random->SetAttribute ("TileSize", UintegerValue (1024));
+  random->SetAttribute ("CheckInterval", UintegerValue (4));
+  random->SetAttribute ("TxPowerDbm", DoubleValue (0.0));
+  random->SetAttribute ("SensitivityDbm", DoubleValue (-threshold));
+  random->SetSite (site);
+  random->SetArea (-side / 2, -side / 2, side / 2, side / 2);
+  for (uint32_t k = 0; k < models.size (); ++k)
+    {
+      random->AddModel (models[k]);
+    }
+  Run (random, 1);
+  NS_TEST_ASSERT_MSG_EQ (random->HasConverged (), true, "Precision not reached");
+  NS_TEST_ASSERT_MSG_LT (random->GetNSamples (), 100000, "Too many samples for the precision");
+  NS_TEST_ASSERT_MSG_EQ (random->GetNSamples () % 4096, 0, "Stopped within a round");
+  for (uint32_t k = 0; k < models.size (); ++k)
+    {
+      double low;
+      double high;
+      random->GetCoverageBounds (k, low, high);
+      NS_TEST_ASSERT_MSG_LT ((high - low) / 2, precision * (1 + 1e-9), "Interval wider than the precision");
+      NS_TEST_ASSERT_MSG_EQ_TOL (random->GetCoverage (k), grid->GetCoverage (k), 2 * precision,
+                                 "Random coverage of model " << k << " far from the grid");
+    }
+  // the checks of every round share the error level: the interval is
+  // wider than the Wilson interval of a run of that fixed size
+  double p = random->GetCoverage (0);
+  double m = static_cast<double> (random->GetNSamples ());
+  double z = 1.959964;
+  double nominal = z * std::sqrt (p * (1 - p) / m + z * z / (4 * m * m)) / (1 + z * z / m);
+  double low;
+  double high;
+  random->GetCoverageBounds (0, low, high);
+  NS_TEST_ASSERT_MSG_GT ((high - low) / 2, 1.5 * nominal, "Interval of an early stop at the nominal level");
+  uint64_t samples = random->GetNSamples ();
+  coverage = random->GetCoverage (0);
+  Run (random, 3);
+  NS_TEST_ASSERT_MSG_EQ (random->GetNSamples (), samples, "Stop changed with the threads");
+  NS_TEST_ASSERT_MSG_EQ (random->GetCoverage (0), coverage, "Random coverage changed with the threads");
+
+  // random locations stop at the precision of a quantile
+  const double quantilePrecision = 0.5;
+  random->SetAttribute ("Precision", DoubleValue (0.0));
+  random->SetAttribute ("QuantilePrecision", DoubleValue (quantilePrecision));
+  random->SetAttribute ("PrecisionQuantile", DoubleValue (0.9));
+  Run (random, 2);
+  NS_TEST_ASSERT_MSG_EQ (random->HasConverged (), true, "Quantile precision not reached");
+  NS_TEST_ASSERT_MSG_LT (random->GetNSamples (), 100000, "Too many samples for the quantile precision");
+  for (uint32_t k = 0; k < models.size (); ++k)
+    {
+      random->GetQuantileBounds (k, 0.9, low, high);
+      NS_TEST_ASSERT_MSG_LT ((high - low) / 2, quantilePrecision * (1 + 1e-9), "Quantile interval wider than the precision");
+      NS_TEST_ASSERT_MSG_EQ_TOL (random->GetQuantile (k, 0.9), grid->GetQuantile (k, 0.9), 2 * quantilePrecision,
+                                 "Random quantile of model " << k << " far from the grid");
+    }
+
+  // without a precision, every sample is evaluated
+  random->SetAttribute ("QuantilePrecision", DoubleValue (0.0));
+  random->SetAttribute ("MaxSamples", UintegerValue (5000));
+  Run (random, 2);
+  NS_TEST_ASSERT_MSG_EQ (random->GetNSamples (), 5000, "Wrong number of samples");
+  NS_TEST_ASSERT_MSG_EQ (random->GetHistogram (1).GetCount (), 5000, "Wrong histogram count");
+  NS_TEST_ASSERT_MSG_EQ (random->HasConverged (), false, "Converged without a precision");
+
+  grid->Dispose ();
+  random->Dispose ();
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Area loss statistics TestSuite
+ */
+class AreaLossStatisticsTestSuite : public TestSuite
+{
+public:
+  AreaLossStatisticsTestSuite ();
+};
+
+AreaLossStatisticsTestSuite::AreaLossStatisticsTestSuite ()
+  : TestSuite ("area-loss-statistics", UNIT)
+{
+  AddTestCase (new LossHistogramTestCase, TestCase::QUICK);
+  AddTestCase (new AreaLossStatisticsTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static AreaLossStatisticsTestSuite g_areaLossStatisticsTestSuite;
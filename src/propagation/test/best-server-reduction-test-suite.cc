@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include "ns3/best-server-reduction.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("BestServerReductionTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the best servers, RSRP and SINR of a reduction against
+ * the scalar losses of every (site, location) pair
+ */
+class BestServerReductionTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param threads the number of threads
+   * \param tileSize the number of locations per tile
+   * \param numaNodes the number of partitions
+   * \param pin whether to pin the threads
+   * \param name TestCase name
+   */
+  BestServerReductionTestCase (uint32_t threads, uint32_t tileSize, uint32_t numaNodes, bool pin, std::string name);
+  virtual ~BestServerReductionTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_threads; //!< the number of threads
+  uint32_t m_tileSize; //!< the number of locations per tile
+  uint32_t m_numaNodes; //!< the number of partitions
+  bool m_pin; //!< whether to pin the threads
+};
+
+BestServerReductionTestCase::BestServerReductionTestCase (uint32_t threads, uint32_t tileSize, uint32_t numaNodes,
+                                                          bool pin, std::string name)
+  : TestCase (name),
+    m_threads (threads),
+    m_tileSize (tileSize),
+    m_numaNodes (numaNodes),
+    m_pin (pin)
+{
+}
+
+BestServerReductionTestCase::~BestServerReductionTestCase ()
+{
+}
+
+void
+BestServerReductionTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  const double noiseDbm = -100.0;
+  const uint32_t topK = 3;
+  Ptr<BestServerReduction> reduction = CreateObject<BestServerReduction> ();
+  reduction->SetAttribute ("Threads", UintegerValue (m_threads));
+  reduction->SetAttribute ("TileSize", UintegerValue (m_tileSize));
+  reduction->SetAttribute ("NumaNodes", UintegerValue (m_numaNodes));
+  reduction->SetAttribute ("PinThreads", BooleanValue (m_pin));
+  reduction->SetAttribute ("TopK", UintegerValue (topK));
+  reduction->SetAttribute ("NoisePowerDbm", DoubleValue (noiseDbm));
+
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Suburban);
+  Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+  sui->SetTerrain (SUIPropagationLossModel::B);
+
+  std::vector<Ptr<EmpiricalPropagationLossModel> > models;
+  std::vector<Ptr<MobilityModel> > sites;
+  std::vector<double> power;
+  for (uint32_t s = 0; s < 7; ++s)
+    {
+      Ptr<MobilityModel> site = CreateObject<ConstantPositionMobilityModel> ();
+      site->SetPosition (Vector (2500.0 * (s % 3), 2000.0 * (s / 3), 40.0));
+      sites.push_back (site);
+      models.push_back (s % 2 ? StaticCast<EmpiricalPropagationLossModel> (sui)
+                              : StaticCast<EmpiricalPropagationLossModel> (ericsson));
+      power.push_back (40.0 + s);
+      NS_TEST_ASSERT_MSG_EQ (reduction->AddSite (site->GetPosition (), power[s], models[s]), s, "Unexpected site index");
+    }
+
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+  for (uint32_t i = 0; i < 1001; ++i)
+    {
+      x.push_back (-500.0 + 6000.0 * ((i * 37) % 1001) / 1001);
+      y.push_back (-500.0 + 5000.0 * ((i * 91) % 1001) / 1001);
+      z.push_back (1.5);
+    }
+  reduction->SetLocations (x.data (), y.data (), z.data (), x.size ());
+  reduction->Run ();
+
+  Ptr<MobilityModel> location = CreateObject<ConstantPositionMobilityModel> ();
+  for (uint32_t i = 0; i < x.size (); ++i)
+    {
+      location->SetPosition (Vector (x[i], y[i], z[i]));
+      std::vector<std::pair<double, uint32_t> > rsrp;
+      double total = 0;
+      for (uint32_t s = 0; s < sites.size (); ++s)
+        {
+          double r = models[s]->CalcRxPower (power[s], sites[s], location);
+          rsrp.push_back (std::make_pair (r, s));
+          total += std::pow (10.0, r / 10);
+        }
+      std::sort (rsrp.rbegin (), rsrp.rend ());
+      for (uint32_t k = 0; k < topK; ++k)
+        {
+          NS_TEST_ASSERT_MSG_EQ (reduction->GetServer (k)[i], rsrp[k].second, "Wrong server of rank " << k << " at " << i);
+          NS_TEST_ASSERT_MSG_EQ_TOL (reduction->GetRsrp (k)[i], rsrp[k].first, 1e-6, "Wrong RSRP of rank " << k << " at " << i);
+        }
+      double interference = total - std::pow (10.0, rsrp[0].first / 10);
+      double sinr = rsrp[0].first - 10 * std::log10 (interference + std::pow (10.0, noiseDbm / 10));
+      NS_TEST_ASSERT_MSG_EQ_TOL (reduction->GetSinr ()[i], sinr, 1e-6, "Wrong SINR at " << i);
+    }
+
+  // fewer sites than ranks
+  Ptr<BestServerReduction> single = CreateObject<BestServerReduction> ();
+  single->SetAttribute ("Threads", UintegerValue (m_threads));
+  single->AddSite (sites[0]->GetPosition (), power[0], models[0]);
+  single->SetLocations (x.data (), y.data (), z.data (), x.size ());
+  single->Run ();
+  NS_TEST_ASSERT_MSG_EQ (single->GetServer (0)[0], 0, "Missing best server");
+  NS_TEST_ASSERT_MSG_EQ (single->GetServer (1)[0], BestServerReduction::NO_SITE, "Rank without a site");
+  NS_TEST_ASSERT_MSG_EQ_TOL (single->GetSinr ()[0], single->GetRsrp (0)[0] - noiseDbm, 1e-9, "SINR without interference");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Best server reduction TestSuite
+ */
+class BestServerReductionTestSuite : public TestSuite
+{
+public:
+  BestServerReductionTestSuite ();
+};
+
+BestServerReductionTestSuite::BestServerReductionTestSuite ()
+  : TestSuite ("best-server-reduction", UNIT)
+{
+  AddTestCase (new BestServerReductionTestCase (1, 4096, 1, false, "Single thread, single tile"), TestCase::QUICK);
+  AddTestCase (new BestServerReductionTestCase (4, 64, 1, false, "Four threads, partial last tile"), TestCase::QUICK);
+  AddTestCase (new BestServerReductionTestCase (5, 64, 2, true, "Two pinned partitions"), TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static BestServerReductionTestSuite g_bestServerReductionTestSuite;
@@ -0,0 +1,294 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/pointer.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/clutter-raster.h"
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ClutterRasterTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Write a clutter raster and look up positions in and around it
+ */
+class ClutterRasterLookupTestCase : public TestCase
+{
+public:
+  ClutterRasterLookupTestCase ();
+  virtual ~ClutterRasterLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ClutterRasterLookupTestCase::ClutterRasterLookupTestCase ()
+  : TestCase ("Clutter raster lookup")
+{
+}
+
+ClutterRasterLookupTestCase::~ClutterRasterLookupTestCase ()
+{
+}
+
+void
+ClutterRasterLookupTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // 3 x 2 cells of 100 m from (-100, 0): urban core on the left, rural on
+  // the right, one invalid class
+  const uint8_t cells[] = {
+    ClutterRaster::Urban, ClutterRaster::Suburban, ClutterRaster::Rural,
+    ClutterRaster::Urban, 7, ClutterRaster::Rural
+  };
+  std::string filename = CreateTempDirFilename ("city.clutter");
+  ClutterRaster::Write (filename, -100.0, 0.0, 100.0, 3, 2, cells);
+
+  Ptr<ClutterRaster> raster = CreateObject<ClutterRaster> ();
+  raster->SetAttribute ("DefaultClass", EnumValue (ClutterRaster::Suburban));
+  NS_TEST_ASSERT_MSG_EQ (raster->GetClass (Vector (0.0, 0.0, 0.0)), ClutterRaster::Suburban, "Unmapped raster not using the default class");
+  raster->SetAttribute ("Filename", StringValue (filename));
+  NS_TEST_ASSERT_MSG_EQ (raster->GetHeader ().width, 3, "Wrong width");
+  NS_TEST_ASSERT_MSG_EQ (raster->GetHeader ().height, 2, "Wrong height");
+
+  const double nan = std::numeric_limits<double>::quiet_NaN ();
+  const double x[] = { -100.0, -0.01, 0.0, 199.99, -50.0, 50.0, 150.0, -100.01, 200.0, 0.0, 0.0, nan };
+  const double y[] = { 0.0, 99.0, 50.0, 0.0, 150.0, 150.0, 199.0, 0.0, 0.0, -0.01, 200.0, 0.0 };
+  const uint8_t expected[] = {
+    ClutterRaster::Urban, ClutterRaster::Urban, ClutterRaster::Suburban, ClutterRaster::Rural,
+    ClutterRaster::Urban, ClutterRaster::Suburban, ClutterRaster::Rural,
+    // outside, and NaN
+    ClutterRaster::Suburban, ClutterRaster::Suburban, ClutterRaster::Suburban, ClutterRaster::Suburban,
+    ClutterRaster::Suburban
+  };
+  const uint32_t n = sizeof (x) / sizeof (x[0]);
+  uint8_t classes[n];
+  raster->GetClasses (x, y, classes, n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) classes[i], (uint32_t) expected[i], "Wrong batch class at " << x[i] << "," << y[i]);
+      NS_TEST_ASSERT_MSG_EQ (raster->GetClass (Vector (x[i], y[i], 1.5)), expected[i], "Wrong class at " << x[i] << "," << y[i]);
+    }
+
+  // a raster without rows or columns only has the default class
+  const uint32_t size[2][2] = { { 0, 4 }, { 3, 0 } };
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      ClutterRaster::Write (filename, -100.0, 0.0, 100.0, size[k][0], size[k][1], cells);
+      raster->SetAttribute ("Filename", StringValue (filename));
+      NS_TEST_ASSERT_MSG_EQ (raster->GetHeader ().width, size[k][0], "Wrong width");
+      NS_TEST_ASSERT_MSG_EQ (raster->GetHeader ().height, size[k][1], "Wrong height");
+      raster->GetClasses (x, y, classes, n);
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((uint32_t) classes[i], (uint32_t) ClutterRaster::Suburban,
+                                 "Cell of a " << size[k][0] << "x" << size[k][1] << " raster at " << x[i] << "," << y[i]);
+          NS_TEST_ASSERT_MSG_EQ (raster->GetClass (Vector (x[i], y[i], 1.5)), ClutterRaster::Suburban,
+                                 "Cell of a " << size[k][0] << "x" << size[k][1] << " raster at " << x[i] << "," << y[i]);
+        }
+    }
+
+  raster->SetAttribute ("Filename", StringValue (""));
+  std::remove (filename.c_str ());
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check that a model with a clutter raster matches single
+ * environment models of the classes it crosses
+ */
+class ClutterRasterModelTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param model the configured model, with a clutter raster
+   * \param reference the same model without a raster, one per class
+   * \param name TestCase name
+   */
+  ClutterRasterModelTestCase (Ptr<EmpiricalPropagationLossModel> model,
+                              std::vector<Ptr<EmpiricalPropagationLossModel> > reference,
+                              std::string name);
+  virtual ~ClutterRasterModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< the model under test
+  std::vector<Ptr<EmpiricalPropagationLossModel> > m_reference; //!< single environment models
+};
+
+ClutterRasterModelTestCase::ClutterRasterModelTestCase (Ptr<EmpiricalPropagationLossModel> model,
+                                                        std::vector<Ptr<EmpiricalPropagationLossModel> > reference,
+                                                        std::string name)
+  : TestCase (name),
+    m_model (model),
+    m_reference (reference)
+{
+}
+
+ClutterRasterModelTestCase::~ClutterRasterModelTestCase ()
+{
+}
+
+void
+ClutterRasterModelTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // urban, suburban and rural rings, 1 km wide, around the BS
+  const uint32_t size = 60;
+  std::vector<uint8_t> cells (size * size);
+  for (uint32_t j = 0; j < size; ++j)
+    {
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          double r = std::max (std::abs (i + 0.5 - size / 2.0), std::abs (j + 0.5 - size / 2.0)) * 100.0;
+          cells[j * size + i] = r < 1000.0 ? ClutterRaster::Urban : r < 2000.0 ? ClutterRaster::Suburban : ClutterRaster::Rural;
+        }
+    }
+  std::string filename = CreateTempDirFilename ("rings.clutter");
+  ClutterRaster::Write (filename, -3000.0, -3000.0, 100.0, size, size, cells.data ());
+  Ptr<ClutterRaster> raster = CreateObject<ClutterRaster> ();
+  raster->SetAttribute ("Filename", StringValue (filename));
+  m_model->SetAttribute ("ClutterRaster", PointerValue (raster));
+
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  mma->SetPosition (Vector (0.0, 0.0, 40.0));
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> distance;
+  std::vector<double> expected;
+  for (double d = 150.0; d < 2900.0; d *= 1.23)
+    {
+      for (uint32_t k = 0; k < 2; ++k)
+        {
+          Vector position (k == 0 ? d : -0.6 * d, k == 0 ? 0.3 * d : -0.8 * d, 2.0);
+          mmb->SetPosition (position);
+          ClutterRaster::ClutterClass clutter = raster->GetClass (position);
+          double loss = m_model->CalcRxPower (0.0, mma, mmb);
+          NS_TEST_ASSERT_MSG_EQ_TOL (loss, m_reference[clutter]->CalcRxPower (0.0, mma, mmb), 1e-9,
+                                     "Wrong loss in clutter class " << clutter << " at " << position);
+          x.push_back (position.x);
+          y.push_back (position.y);
+          distance.push_back (mma->GetDistanceFrom (mmb));
+          expected.push_back (loss);
+        }
+    }
+
+  std::vector<uint8_t> classes (x.size ());
+  raster->GetClasses (x.data (), y.data (), classes.data (), x.size ());
+  std::vector<double> loss (x.size ());
+  m_model->GetLossBatch (distance.data (), classes.data (), loss.data (), x.size ());
+  for (uint32_t i = 0; i < x.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (loss[i], expected[i], 1e-9, "Clutter batch disagrees with GetLoss at " << distance[i] << " m");
+    }
+
+  m_model->SetAttribute ("ClutterRaster", PointerValue ());
+  raster->SetAttribute ("Filename", StringValue (""));
+  std::remove (filename.c_str ());
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Clutter raster TestSuite
+ */
+class ClutterRasterTestSuite : public TestSuite
+{
+public:
+  ClutterRasterTestSuite ();
+};
+
+ClutterRasterTestSuite::ClutterRasterTestSuite ()
+  : TestSuite ("clutter-raster", UNIT)
+{
+  AddTestCase (new ClutterRasterLookupTestCase, TestCase::QUICK);
+
+  const ECC33PropagationLossModel::Environment ecc33Environments[] = {
+    ECC33PropagationLossModel::Urban, ECC33PropagationLossModel::Suburban, ECC33PropagationLossModel::Suburban
+  };
+  const EricssonPropagationLossModel::Environment ericssonEnvironments[] = {
+    EricssonPropagationLossModel::Urban, EricssonPropagationLossModel::Suburban, EricssonPropagationLossModel::Rural
+  };
+  const SUIPropagationLossModel::Terrain suiTerrains[] = {
+    SUIPropagationLossModel::A, SUIPropagationLossModel::B, SUIPropagationLossModel::C
+  };
+  // the environment attribute of the models under test must not matter
+  std::vector<Ptr<EmpiricalPropagationLossModel> > models;
+  std::vector<Ptr<EmpiricalPropagationLossModel> > ecc33Reference;
+  std::vector<Ptr<EmpiricalPropagationLossModel> > ericssonReference;
+  std::vector<Ptr<EmpiricalPropagationLossModel> > suiReference;
+  for (uint32_t k = 0; k <= ClutterRaster::NUM_CLASSES; ++k)
+    {
+      Ptr<ECC33PropagationLossModel> ecc33 = CreateObject<ECC33PropagationLossModel> ();
+      ecc33->SetFrequency (900e6);
+      ecc33->SetTxAntennaHeight (40);
+      ecc33->SetRxAntennaHeight (2);
+      ecc33->SetEnvironment (ecc33Environments[k % ClutterRaster::NUM_CLASSES]);
+      Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+      ericsson->SetFrequency (900e6);
+      ericsson->SetTxAntennaHeight (40);
+      ericsson->SetRxAntennaHeight (2);
+      ericsson->SetEnvironment (ericssonEnvironments[k % ClutterRaster::NUM_CLASSES]);
+      Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+      sui->SetLambda (3e8 / 2.5e9);
+      sui->SetBSAntennaHeight (40);
+      sui->SetSSAntennaHeight (2);
+      sui->SetTerrain (suiTerrains[k % ClutterRaster::NUM_CLASSES]);
+      if (k < ClutterRaster::NUM_CLASSES)
+        {
+          ecc33Reference.push_back (ecc33);
+          ericssonReference.push_back (ericsson);
+          suiReference.push_back (sui);
+        }
+      else
+        {
+          ecc33->SetEnvironment (ECC33PropagationLossModel::Suburban);
+          ericsson->SetEnvironment (EricssonPropagationLossModel::Rural);
+          sui->SetTerrain (SUIPropagationLossModel::C);
+          AddTestCase (new ClutterRasterModelTestCase (ecc33, ecc33Reference, "ECC-33 with clutter raster"), TestCase::QUICK);
+          AddTestCase (new ClutterRasterModelTestCase (ericsson, ericssonReference, "Ericsson with clutter raster"), TestCase::QUICK);
+          AddTestCase (new ClutterRasterModelTestCase (sui, suiReference, "SUI with clutter raster"), TestCase::QUICK);
+        }
+    }
+}
+
+/// Static variable for test initialization
+static ClutterRasterTestSuite g_clutterRasterTestSuite;
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/coverage-tile-cache.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("CoverageTileCacheTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the losses, reuse, eviction and invalidation of the tiles
+ */
+class CoverageTileCacheTestCase : public TestCase
+{
+public:
+  CoverageTileCacheTestCase ();
+  virtual ~CoverageTileCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare a region with the scalar losses of its cells
+   * \param region the region
+   * \param model the model of the site
+   * \param site the mobility model of the site
+   * \param tolerance the largest difference of the losses [dB]
+   */
+  void CheckRegion (const CoverageTileCache::Region &region,
+                    Ptr<EricssonPropagationLossModel> model, Ptr<MobilityModel> site,
+                    double tolerance = 1e-6);
+};
+
+CoverageTileCacheTestCase::CoverageTileCacheTestCase ()
+  : TestCase ("Coverage tile cache")
+{
+}
+
+CoverageTileCacheTestCase::~CoverageTileCacheTestCase ()
+{
+}
+
+void
+CoverageTileCacheTestCase::CheckRegion (const CoverageTileCache::Region &region,
+                                        Ptr<EricssonPropagationLossModel> model, Ptr<MobilityModel> site,
+                                        double tolerance)
+{
+  Ptr<MobilityModel> cell = CreateObject<ConstantPositionMobilityModel> ();
+  for (uint32_t row = 0; row < region.height; row += 7)
+    {
+      for (uint32_t column = 0; column < region.width; column += 5)
+        {
+          cell->SetPosition (Vector (region.originX + (column + 0.5) * region.cellSize,
+                                     region.originY + (row + 0.5) * region.cellSize, 1.5));
+          NS_TEST_ASSERT_MSG_EQ_TOL (region.loss[row * region.width + column],
+                                     model->CalcRxPower (0.0, site, cell), tolerance,
+                                     "Wrong loss at (" << column << ", " << row << ")");
+        }
+    }
+}
+
+void
+CoverageTileCacheTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Urban);
+  Ptr<MobilityModel> site = CreateObject<ConstantPositionMobilityModel> ();
+  site->SetPosition (Vector (120.0, -340.0, 30.0));
+
+  const uint32_t tileSize = 32;
+  const uint64_t tileBytes = tileSize * tileSize * sizeof (double);
+  Ptr<CoverageTileCache> cache = CreateObject<CoverageTileCache> ();
+  cache->SetAttribute ("TileSize", UintegerValue (tileSize));
+  cache->SetAttribute ("BaseCellSize", DoubleValue (10.0));
+  cache->SetAttribute ("Levels", UintegerValue (4));
+  cache->SetAttribute ("MaxBytes", UintegerValue (100 * tileBytes));
+  cache->SetSite (site->GetPosition (), ericsson);
+
+  // a viewport across the origin: 3 x 3 tiles of 320 m at level 0
+  CoverageTileCache::Region region = cache->GetRegion (-500.0, -400.0, 300.0, 200.0, 0);
+  NS_TEST_ASSERT_MSG_EQ (region.width, 80, "Unexpected region width");
+  NS_TEST_ASSERT_MSG_EQ (region.height, 60, "Unexpected region height");
+  NS_TEST_ASSERT_MSG_EQ_TOL (region.originX, -500.0, 1e-9, "Unexpected region origin");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().misses, 9, "Unexpected number of computed tiles");
+  CheckRegion (region, ericsson, site);
+
+  // panning by a tile only computes the new column of tiles
+  cache->ResetStatistics ();
+  region = cache->GetRegion (-180.0, -400.0, 620.0, 200.0, 0);
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().misses, 3, "Panning recomputed cached tiles");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().hits, 6, "Panning missed cached tiles");
+  CheckRegion (region, ericsson, site);
+
+  // zooming out computes coarser tiles, coarsest first: 2 x 2 tiles at
+  // each of levels 3, 2 and 1
+  cache->ResetStatistics ();
+  cache->Prefetch (-500.0, -400.0, 300.0, 200.0, 1);
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().misses, 12, "Unexpected number of coarse tiles");
+  region = cache->GetRegion (-500.0, -400.0, 300.0, 200.0, 3);
+  NS_TEST_ASSERT_MSG_EQ (region.cellSize, 80.0, "Unexpected cell size");
+  CheckRegion (region, ericsson, site);
+
+  // a frequency change drops every tile
+  uint32_t tiles = cache->GetNTiles ();
+  NS_TEST_ASSERT_MSG_EQ (cache->GetBytes (), tiles * tileBytes, "Unexpected cache size");
+  cache->ResetStatistics ();
+  ericsson->SetAttribute ("Frequency", DoubleValue (1.8e9));
+  region = cache->GetRegion (-500.0, -400.0, 300.0, 200.0, 0);
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().invalidations, 1, "Frequency change not detected");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().misses, 9, "Stale tiles reused");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetNTiles (), 9, "Stale tiles kept");
+  CheckRegion (region, ericsson, site);
+
+  // the budget holds 4 tiles: the least recently used go first
+  cache->SetAttribute ("MaxBytes", UintegerValue (4 * tileBytes));
+  cache->ResetStatistics ();
+  cache->GetRegion (-500.0, -400.0, -420.0, -360.0, 0);
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().hits, 1, "Cached tile missed");
+  cache->GetRegion (1000.0, 1000.0, 1010.0, 1010.0, 0);
+  NS_TEST_ASSERT_MSG_EQ (cache->GetNTiles (), 4, "Budget not enforced");
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().evictions, 6, "Unexpected number of evictions");
+  cache->ResetStatistics ();
+  cache->GetRegion (-500.0, -400.0, -420.0, -360.0, 0);
+  NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().hits, 1, "Recently used tile evicted");
+
+  // so does a change of any other setting the losses depend on
+  cache->SetAttribute ("MaxBytes", UintegerValue (100 * tileBytes));
+  const char *names[3] = { "MathBackend", "ValidityPolicy", "MinDistance" };
+  for (uint32_t k = 0; k < 3; k++)
+    {
+      cache->GetRegion (-500.0, -400.0, 300.0, 200.0, 0);
+      cache->ResetStatistics ();
+      if (k == 0)
+        {
+          ericsson->SetAttribute ("MathBackend", EnumValue (EmpiricalMath::Fast));
+        }
+      else if (k == 1)
+        {
+          ericsson->SetAttribute ("ValidityPolicy", EnumValue (EmpiricalPropagationLossModel::Clamp));
+        }
+      else
+        {
+          ericsson->SetAttribute ("MinDistance", DoubleValue (200.0));
+        }
+      region = cache->GetRegion (-500.0, -400.0, 300.0, 200.0, 0);
+      NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().invalidations, 1, names[k] << " change not detected");
+      NS_TEST_ASSERT_MSG_EQ (cache->GetStatistics ().hits, 0, "Stale tiles reused after a " << names[k] << " change");
+      // the Fast logarithms of the batch and scalar paths differ within their accuracy
+      CheckRegion (region, ericsson, site, 0.1);
+    }
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Coverage tile cache TestSuite
+ */
+class CoverageTileCacheTestSuite : public TestSuite
+{
+public:
+  CoverageTileCacheTestSuite ();
+};
+
+CoverageTileCacheTestSuite::CoverageTileCacheTestSuite ()
+  : TestSuite ("coverage-tile-cache", UNIT)
+{
+  AddTestCase (new CoverageTileCacheTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static CoverageTileCacheTestSuite g_coverageTileCacheTestSuite;
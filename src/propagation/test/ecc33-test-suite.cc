@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ecc33-propagation-loss-model.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ECC33PropagationLossModelTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief ECC-33 golden value test case
+ *
+ * The reference values were computed offline from the closed-form
+ * expressions documented in ecc33-propagation-loss-model.cc, using the
+ * 3D distance between the two nodes.
+ */
+class ECC33PropagationLossModelTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param freq carrier frequency [Hz]
+   * \param dist 2D distance between BS and mobile [m]
+   * \param hb BS antenna height [m]
+   * \param hm mobile antenna height [m]
+   * \param env environment type
+   * \param refValue reference loss value [dB]
+   * \param name TestCase name
+   */
+  ECC33PropagationLossModelTestCase (double freq, double dist, double hb, double hm,
+                                     ECC33PropagationLossModel::Environment env,
+                                     double refValue, std::string name);
+  virtual ~ECC33PropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  double m_freq; //!< carrier frequency [Hz]
+  double m_dist; //!< 2D distance between BS and mobile [m]
+  double m_hb; //!< BS antenna height [m]
+  double m_hm; //!< mobile antenna height [m]
+  ECC33PropagationLossModel::Environment m_env; //!< environment type
+  double m_lossRef; //!< reference loss [dB]
+};
+
+ECC33PropagationLossModelTestCase::ECC33PropagationLossModelTestCase (double freq, double dist, double hb, double hm,
+                                                                      ECC33PropagationLossModel::Environment env,
+                                                                      double refValue, std::string name)
+  : TestCase (name),
+    m_freq (freq),
+    m_dist (dist),
+    m_hb (hb),
+    m_hm (hm),
+    m_env (env),
+    m_lossRef (refValue)
+{
+}
+
+ECC33PropagationLossModelTestCase::~ECC33PropagationLossModelTestCase ()
+{
+}
+
+void
+ECC33PropagationLossModelTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  mma->SetPosition (Vector (0.0, 0.0, m_hb));
+
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+  mmb->SetPosition (Vector (m_dist, 0.0, m_hm));
+
+  Ptr<ECC33PropagationLossModel> propagationLossModel = CreateObject<ECC33PropagationLossModel> ();
+  propagationLossModel->SetAttribute ("Frequency", DoubleValue (m_freq));
+  propagationLossModel->SetAttribute ("TxAntennaHeight", DoubleValue (m_hb));
+  propagationLossModel->SetAttribute ("RxAntennaHeight", DoubleValue (m_hm));
+  propagationLossModel->SetAttribute ("Environment", EnumValue (m_env));
+
+  // GetLoss () returns the loss as a negative gain
+  double loss = -propagationLossModel->GetLoss (mma, mmb);
+
+  NS_LOG_INFO ("Calculated loss: " << loss);
+  NS_LOG_INFO ("Theoretical loss: " << m_lossRef);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (loss, m_lossRef, 0.001, "Wrong loss !");
+
+  double txPowerDbm = 43.0;
+  double rxPowerDbm = propagationLossModel->CalcRxPower (txPowerDbm, mma, mmb);
+  NS_TEST_ASSERT_MSG_EQ_TOL (txPowerDbm - rxPowerDbm, m_lossRef, 0.001, "CalcRxPower disagrees with GetLoss");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief ECC-33 TestSuite
+ */
+class ECC33PropagationLossModelTestSuite : public TestSuite
+{
+public:
+  ECC33PropagationLossModelTestSuite ();
+};
+
+ECC33PropagationLossModelTestSuite::ECC33PropagationLossModelTestSuite ()
+  : TestSuite ("ecc33", SYSTEM)
+{
+  LogComponentEnable ("ECC33PropagationLossModelTest", LOG_LEVEL_ALL);
+
+  // setups of the empirical-propagation-loss-comparison scratch (900 MHz, 1 m mobile)
+  AddTestCase (new ECC33PropagationLossModelTestCase (900e6, 100, 33, 1, ECC33PropagationLossModel::Urban, 98.729, "ECC-33 Urban 900 MHz 100 m"), TestCase::QUICK);
+  AddTestCase (new ECC33PropagationLossModelTestCase (900e6, 500, 33, 1, ECC33PropagationLossModel::Urban, 115.035, "ECC-33 Urban 900 MHz 500 m"), TestCase::QUICK);
+  AddTestCase (new ECC33PropagationLossModelTestCase (900e6, 1000, 33, 1, ECC33PropagationLossModel::Urban, 123.586, "ECC-33 Urban 900 MHz 1 km"), TestCase::QUICK);
+  AddTestCase (new ECC33PropagationLossModelTestCase (900e6, 100, 35, 1, ECC33PropagationLossModel::Suburban, 121.719, "ECC-33 Suburban 900 MHz 100 m"), TestCase::QUICK);
+  AddTestCase (new ECC33PropagationLossModelTestCase (900e6, 500, 35, 1, ECC33PropagationLossModel::Suburban, 138.102, "ECC-33 Suburban 900 MHz 500 m"), TestCase::QUICK);
+  AddTestCase (new ECC33PropagationLossModelTestCase (900e6, 1000, 35, 1, ECC33PropagationLossModel::Suburban, 146.664, "ECC-33 Suburban 900 MHz 1 km"), TestCase::QUICK);
+
+  // attribute defaults (2 GHz, 50 m BS, 3 m mobile) and the upper end of the frequency range
+  AddTestCase (new ECC33PropagationLossModelTestCase (2e9, 1000, 50, 3, ECC33PropagationLossModel::Urban, 130.075, "ECC-33 Urban 2 GHz 1 km"), TestCase::QUICK);
+  AddTestCase (new ECC33PropagationLossModelTestCase (2e9, 1000, 50, 3, ECC33PropagationLossModel::Suburban, 135.527, "ECC-33 Suburban 2 GHz 1 km"), TestCase::QUICK);
+  AddTestCase (new ECC33PropagationLossModelTestCase (3e9, 5000, 100, 10, ECC33PropagationLossModel::Urban, 148.473, "ECC-33 Urban 3 GHz 5 km"), TestCase::QUICK);
+  AddTestCase (new ECC33PropagationLossModelTestCase (3e9, 5000, 100, 10, ECC33PropagationLossModel::Suburban, 133.821, "ECC-33 Suburban 3 GHz 5 km"), TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static ECC33PropagationLossModelTestSuite g_ecc33TestSuite;
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/empirical-kernels.h"
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("EmpiricalKernelsTest");
+
+// the guards, the polynomial and the validity ranges fold at compile time
+static_assert (EmpiricalKernels::ClampToRange (5.0, 1.0, 3.0) == 3.0, "ClampToRange is not constexpr");
+static_assert (EmpiricalKernels::IsOutOfRange (2.0, 1.0, 3.0) == 0, "IsOutOfRange is not constexpr");
+static_assert (EmpiricalKernels::Evaluate (EmpiricalKernels::Coefficients { 100.0, 20.0, 1.0 }, 2.0) == -144.0,
+               "Evaluate is not constexpr");
+static_assert (EmpiricalKernels::SuiValidityRange ().minDistance == 100.0, "SuiValidityRange is not constexpr");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check that the models and the kernels give the same losses
+ */
+class EmpiricalKernelsTestCase : public TestCase
+{
+public:
+  EmpiricalKernelsTestCase ();
+  virtual ~EmpiricalKernelsTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare a model with its kernels
+   * \param model the model
+   * \param coefficients the kernel coefficients of its configuration
+   * \param scalar the kernel loss of one link of its configuration
+   * \param range the kernel validity range
+   * \param name the name of the configuration
+   */
+  void Compare (Ptr<EmpiricalPropagationLossModel> model,
+                EmpiricalKernels::Coefficients coefficients,
+                double (*scalar)(const EmpiricalKernels::Parameters &, double, EmpiricalMath::Backend),
+                EmpiricalKernels::ValidityRange range, std::string name);
+
+  EmpiricalKernels::Parameters m_parameters; //!< configuration of the models
+};
+
+EmpiricalKernelsTestCase::EmpiricalKernelsTestCase ()
+  : TestCase ("Check the empirical kernels against the models")
+{
+}
+
+EmpiricalKernelsTestCase::~EmpiricalKernelsTestCase ()
+{
+}
+
+/// Distances of the links [m]
+static const double g_distances[] = { 0.5, 50.0, 150.0, 1e3, 2.5e3, 7.9e3, 15e3, 40e3 };
+/// Number of links
+static const uint32_t g_nDistances = sizeof (g_distances) / sizeof (g_distances[0]);
+
+/**
+ * \param p the parameters
+ * \param distance the link distance [m]
+ * \param backend the implementation of the logarithms
+ * \returns the SUI loss with the default shadowing of the model
+ */
+static double
+SuiLoss (const EmpiricalKernels::Parameters &p, double distance, EmpiricalMath::Backend backend)
+{
+  return EmpiricalKernels::SuiLoss (p, 10.0, distance, backend);
+}
+
+void
+EmpiricalKernelsTestCase::Compare (Ptr<EmpiricalPropagationLossModel> model,
+                                   EmpiricalKernels::Coefficients coefficients,
+                                   double (*scalar)(const EmpiricalKernels::Parameters &, double, EmpiricalMath::Backend),
+                                   EmpiricalKernels::ValidityRange range, std::string name)
+{
+  EmpiricalPropagationLossModel::Coefficients c = model->GetCoefficients ();
+  NS_TEST_ASSERT_MSG_EQ (c.c0, coefficients.c0, name << ": c0");
+  NS_TEST_ASSERT_MSG_EQ (c.c1, coefficients.c1, name << ": c1");
+  NS_TEST_ASSERT_MSG_EQ (c.c2, coefficients.c2, name << ": c2");
+  NS_TEST_ASSERT_MSG_EQ (model->GetValidityRange ().maxDistance, range.maxDistance, name << ": validity range");
+
+  // the default MinDistance of the models, and no clamp
+  const double lower = 1.0;
+  const double upper = 1e300;
+  std::vector<double> expected (g_nDistances);
+  std::vector<double> loss (g_nDistances);
+  uint64_t outOfRange = EmpiricalKernels::LossBatch (coefficients, g_distances, expected.data (), g_nDistances,
+                                                     range, lower, upper, EmpiricalMath::Exact);
+  model->ResetValidityCounters ();
+  model->GetLossBatch (g_distances, loss.data (), g_nDistances);
+  NS_TEST_ASSERT_MSG_EQ (model->GetValidityCounters ().distance, outOfRange, name << ": out-of-range count");
+
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  for (uint32_t i = 0; i < g_nDistances; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (loss[i], expected[i], name << ": batch loss at " << g_distances[i] << " m");
+      b->SetPosition (Vector (g_distances[i], 0.0, 0.0));
+      double distance = std::max (g_distances[i], lower);
+      NS_TEST_ASSERT_MSG_EQ (model->CalcRxPower (0.0, a, b), scalar (m_parameters, distance, EmpiricalMath::Exact),
+                             name << ": scalar loss at " << g_distances[i] << " m");
+    }
+}
+
+void
+EmpiricalKernelsTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_parameters.frequency = 1.9e9;
+  m_parameters.lambda = 300000000 / m_parameters.frequency;
+  m_parameters.txAntennaHeight = 40.0;
+  m_parameters.rxAntennaHeight = 3.0;
+
+  const ECC33PropagationLossModel::Environment ecc33[2] = { ECC33PropagationLossModel::Suburban, ECC33PropagationLossModel::Urban };
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      Ptr<ECC33PropagationLossModel> model = CreateObject<ECC33PropagationLossModel> ();
+      model->SetFrequency (m_parameters.frequency);
+      model->SetTxAntennaHeight (m_parameters.txAntennaHeight);
+      model->SetRxAntennaHeight (m_parameters.rxAntennaHeight);
+      model->SetEnvironment (ecc33[k]);
+      m_parameters.environment = ecc33[k];
+      Compare (model, EmpiricalKernels::Ecc33Coefficients (m_parameters), &EmpiricalKernels::Ecc33Loss,
+               EmpiricalKernels::Ecc33ValidityRange (), "ECC-33");
+    }
+
+  const EricssonPropagationLossModel::Environment ericsson[3] = {
+    EricssonPropagationLossModel::Urban, EricssonPropagationLossModel::Suburban, EricssonPropagationLossModel::Rural
+  };
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      Ptr<EricssonPropagationLossModel> model = CreateObject<EricssonPropagationLossModel> ();
+      model->SetFrequency (m_parameters.frequency);
+      model->SetTxAntennaHeight (m_parameters.txAntennaHeight);
+      model->SetRxAntennaHeight (m_parameters.rxAntennaHeight);
+      model->SetEnvironment (ericsson[k]);
+      m_parameters.environment = ericsson[k];
+      Compare (model, EmpiricalKernels::EricssonCoefficients (m_parameters), &EmpiricalKernels::EricssonLoss,
+               EmpiricalKernels::EricssonValidityRange (), "Ericsson");
+    }
+
+  const SUIPropagationLossModel::Terrain sui[3] = { SUIPropagationLossModel::A, SUIPropagationLossModel::B, SUIPropagationLossModel::C };
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      Ptr<SUIPropagationLossModel> model = CreateObject<SUIPropagationLossModel> ();
+      model->SetLambda (m_parameters.frequency, 300000000);
+      model->SetBSAntennaHeight (m_parameters.txAntennaHeight);
+      model->SetSSAntennaHeight (m_parameters.rxAntennaHeight);
+      model->SetTerrain (sui[k]);
+      m_parameters.environment = sui[k];
+      Compare (model, EmpiricalKernels::SuiCoefficients (m_parameters, 10.0), &SuiLoss,
+               EmpiricalKernels::SuiValidityRange (), "SUI");
+    }
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Empirical kernels TestSuite
+ */
+class EmpiricalKernelsTestSuite : public TestSuite
+{
+public:
+  EmpiricalKernelsTestSuite ();
+};
+
+EmpiricalKernelsTestSuite::EmpiricalKernelsTestSuite ()
+  : TestSuite ("empirical-kernels", UNIT)
+{
+  AddTestCase (new EmpiricalKernelsTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static EmpiricalKernelsTestSuite g_empiricalKernelsTestSuite;
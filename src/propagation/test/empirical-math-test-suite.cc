@@ -0,0 +1,292 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/empirical-math.h"
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("EmpiricalMathTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the log10 approximations against libm
+ */
+class EmpiricalMathLog10TestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param backend the approximation
+   * \param tolerance the maximum absolute error
+   * \param name TestCase name
+   */
+  EmpiricalMathLog10TestCase (EmpiricalMath::Backend backend, double tolerance, std::string name);
+  virtual ~EmpiricalMathLog10TestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  EmpiricalMath::Backend m_backend; //!< the approximation
+  double m_tolerance; //!< the maximum absolute error
+};
+
+EmpiricalMathLog10TestCase::EmpiricalMathLog10TestCase (EmpiricalMath::Backend backend, double tolerance, std::string name)
+  : TestCase (name),
+    m_backend (backend),
+    m_tolerance (tolerance)
+{
+}
+
+EmpiricalMathLog10TestCase::~EmpiricalMathLog10TestCase ()
+{
+}
+
+void
+EmpiricalMathLog10TestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<double> x;
+  for (double v = 1e-6; v < 1e12; v *= 1.0007)
+    {
+      x.push_back (v);
+    }
+  // powers of two and the mantissa split point
+  for (int e = -20; e <= 40; ++e)
+    {
+      x.push_back (std::ldexp (1.0, e));
+      x.push_back (std::ldexp (std::sqrt (2.0), e));
+      x.push_back (std::nextafter (std::ldexp (std::sqrt (2.0), e), 0.0));
+    }
+
+  std::vector<double> y (x.size ());
+  EmpiricalMath::Log10 (m_backend, x.data (), y.data (), x.size ());
+  double maxError = 0;
+  for (uint32_t i = 0; i < x.size (); ++i)
+    {
+      double scalar = EmpiricalMath::Log10 (m_backend, x[i]);
+      NS_TEST_ASSERT_MSG_EQ (y[i], scalar, "Array and scalar forms differ at " << x[i]);
+      maxError = std::max (maxError, std::abs (scalar - std::log10 (x[i])));
+    }
+  NS_LOG_INFO ("maximum log10 error " << maxError);
+  NS_TEST_ASSERT_MSG_LT (maxError, m_tolerance, "log10 approximation out of tolerance");
+
+  double lnError = std::abs (EmpiricalMath::Log (m_backend, 7.3) - std::log (7.3));
+  NS_TEST_ASSERT_MSG_LT (lnError, m_tolerance * 2.30258509299404568, "ln approximation out of tolerance");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the loss error of a model with an approximate math
+ * backend over its validity range
+ */
+class EmpiricalMathLossTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param exact the model with the exact backend
+   * \param approximate the same model with an approximate backend
+   * \param tolerance the maximum loss error [dB]
+   * \param name TestCase name
+   */
+  EmpiricalMathLossTestCase (Ptr<EmpiricalPropagationLossModel> exact,
+                             Ptr<EmpiricalPropagationLossModel> approximate,
+                             double tolerance, std::string name);
+  virtual ~EmpiricalMathLossTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Set the frequency and antenna heights of a model
+   * \param model the model
+   * \param frequency frequency [Hz]
+   * \param hb Tx (BS) antenna height [m]
+   * \param hm Rx (SS) antenna height [m]
+   */
+  void Configure (Ptr<EmpiricalPropagationLossModel> model, double frequency, double hb, double hm);
+
+  Ptr<EmpiricalPropagationLossModel> m_exact; //!< the reference model
+  Ptr<EmpiricalPropagationLossModel> m_approximate; //!< the model under test
+  double m_tolerance; //!< the maximum loss error [dB]
+};
+
+EmpiricalMathLossTestCase::EmpiricalMathLossTestCase (Ptr<EmpiricalPropagationLossModel> exact,
+                                                      Ptr<EmpiricalPropagationLossModel> approximate,
+                                                      double tolerance, std::string name)
+  : TestCase (name),
+    m_exact (exact),
+    m_approximate (approximate),
+    m_tolerance (tolerance)
+{
+}
+
+EmpiricalMathLossTestCase::~EmpiricalMathLossTestCase ()
+{
+}
+
+void
+EmpiricalMathLossTestCase::Configure (Ptr<EmpiricalPropagationLossModel> model, double frequency, double hb, double hm)
+{
+  model->SetAttribute ("Frequency", DoubleValue (frequency));
+  model->SetAttributeFailSafe ("Lambda", DoubleValue (3e8 / frequency));
+  if (!model->SetAttributeFailSafe ("TxAntennaHeight", DoubleValue (hb)))
+    {
+      model->SetAttribute ("BSAntennaHeight", DoubleValue (hb));
+      model->SetAttribute ("SSAntennaHeight", DoubleValue (hm));
+    }
+  else
+    {
+      model->SetAttribute ("RxAntennaHeight", DoubleValue (hm));
+    }
+}
+
+void
+EmpiricalMathLossTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  EmpiricalPropagationLossModel::ValidityRange range = m_exact->GetValidityRange ();
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+
+  std::vector<double> distance;
+  for (double d = range.minDistance; d <= range.maxDistance; d *= 1.05)
+    {
+      distance.push_back (d);
+    }
+  std::vector<double> exact (distance.size ());
+  std::vector<double> approximate (distance.size ());
+
+  double maxError = 0;
+  const uint32_t steps = 4;
+  for (uint32_t i = 0; i <= steps; ++i)
+    {
+      double frequency = range.minFrequency * std::pow (range.maxFrequency / range.minFrequency, double (i) / steps);
+      for (uint32_t j = 0; j <= steps; ++j)
+        {
+          double hb = range.minTxAntennaHeight + (range.maxTxAntennaHeight - range.minTxAntennaHeight) * j / steps;
+          for (uint32_t k = 0; k <= steps; ++k)
+            {
+              double hm = range.minRxAntennaHeight + (range.maxRxAntennaHeight - range.minRxAntennaHeight) * k / steps;
+              Configure (m_exact, frequency, hb, hm);
+              Configure (m_approximate, frequency, hb, hm);
+
+              // the scalar formulas, with every logarithm approximated
+              mma->SetPosition (Vector (0.0, 0.0, 0.0));
+              for (uint32_t l = 0; l < distance.size (); ++l)
+                {
+                  mmb->SetPosition (Vector (distance[l], 0.0, 0.0));
+                  double error = std::abs (m_approximate->CalcRxPower (0.0, mma, mmb) - m_exact->CalcRxPower (0.0, mma, mmb));
+                  maxError = std::max (maxError, error);
+                }
+
+              // the batch path, with the distance logarithm approximated
+              m_exact->GetLossBatch (distance.data (), exact.data (), distance.size ());
+              m_approximate->GetLossBatch (distance.data (), approximate.data (), distance.size ());
+              for (uint32_t l = 0; l < distance.size (); ++l)
+                {
+                  maxError = std::max (maxError, std::abs (approximate[l] - exact[l]));
+                }
+            }
+        }
+    }
+  NS_LOG_INFO ("maximum loss error " << maxError << " dB");
+  NS_TEST_ASSERT_MSG_LT (maxError, m_tolerance, "Loss error out of tolerance");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Empirical math backends TestSuite
+ */
+class EmpiricalMathTestSuite : public TestSuite
+{
+public:
+  EmpiricalMathTestSuite ();
+};
+
+EmpiricalMathTestSuite::EmpiricalMathTestSuite ()
+  : TestSuite ("empirical-math", UNIT)
+{
+  AddTestCase (new EmpiricalMathLog10TestCase (EmpiricalMath::Accurate, 4.5e-6, "Accurate log10"), TestCase::QUICK);
+  AddTestCase (new EmpiricalMathLog10TestCase (EmpiricalMath::Fast, 2.6e-4, "Fast log10"), TestCase::QUICK);
+
+  const EmpiricalMath::Backend backends[] = { EmpiricalMath::Accurate, EmpiricalMath::Fast };
+  const double tolerances[] = { 0.01, 0.1 };
+  const std::string names[] = { " accurate math", " fast math" };
+  for (uint32_t b = 0; b < 2; ++b)
+    {
+      const ECC33PropagationLossModel::Environment ecc33Environments[] = {
+        ECC33PropagationLossModel::Urban, ECC33PropagationLossModel::Suburban
+      };
+      for (uint32_t i = 0; i < 2; ++i)
+        {
+          Ptr<ECC33PropagationLossModel> exact = CreateObject<ECC33PropagationLossModel> ();
+          exact->SetEnvironment (ecc33Environments[i]);
+          Ptr<ECC33PropagationLossModel> approximate = CreateObject<ECC33PropagationLossModel> ();
+          approximate->SetEnvironment (ecc33Environments[i]);
+          approximate->SetAttribute ("MathBackend", EnumValue (backends[b]));
+          AddTestCase (new EmpiricalMathLossTestCase (exact, approximate, tolerances[b], "ECC-33" + names[b]), TestCase::QUICK);
+        }
+
+      const EricssonPropagationLossModel::Environment ericssonEnvironments[] = {
+        EricssonPropagationLossModel::Urban, EricssonPropagationLossModel::Suburban, EricssonPropagationLossModel::Rural
+      };
+      for (uint32_t i = 0; i < 3; ++i)
+        {
+          Ptr<EricssonPropagationLossModel> exact = CreateObject<EricssonPropagationLossModel> ();
+          exact->SetEnvironment (ericssonEnvironments[i]);
+          Ptr<EricssonPropagationLossModel> approximate = CreateObject<EricssonPropagationLossModel> ();
+          approximate->SetEnvironment (ericssonEnvironments[i]);
+          approximate->SetAttribute ("MathBackend", EnumValue (backends[b]));
+          AddTestCase (new EmpiricalMathLossTestCase (exact, approximate, tolerances[b], "Ericsson" + names[b]), TestCase::QUICK);
+        }
+
+      const SUIPropagationLossModel::Terrain suiTerrains[] = {
+        SUIPropagationLossModel::A, SUIPropagationLossModel::B, SUIPropagationLossModel::C
+      };
+      for (uint32_t i = 0; i < 3; ++i)
+        {
+          Ptr<SUIPropagationLossModel> exact = CreateObject<SUIPropagationLossModel> ();
+          exact->SetTerrain (suiTerrains[i]);
+          Ptr<SUIPropagationLossModel> approximate = CreateObject<SUIPropagationLossModel> ();
+          approximate->SetTerrain (suiTerrains[i]);
+          approximate->SetAttribute ("MathBackend", EnumValue (backends[b]));
+          AddTestCase (new EmpiricalMathLossTestCase (exact, approximate, tolerances[b], "SUI" + names[b]), TestCase::QUICK);
+        }
+    }
+}
+
+/// Static variable for test initialization
+static EmpiricalMathTestSuite g_empiricalMathTestSuite;
@@ -0,0 +1,246 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("EmpiricalPropagationLossGradientTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the analytic derivatives of a model against central
+ * differences of its losses
+ */
+class EmpiricalPropagationLossGradientTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param model the model, in the configuration to check
+   * \param txAntennaHeight the name of its Tx antenna height attribute
+   * \param name TestCase name
+   */
+  EmpiricalPropagationLossGradientTestCase (Ptr<EmpiricalPropagationLossModel> model,
+                                            std::string txAntennaHeight, std::string name);
+  virtual ~EmpiricalPropagationLossGradientTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param distance the link distances [m]
+   * \returns the losses of the model
+   */
+  std::vector<double> GetLosses (const std::vector<double> &distance) const;
+  /**
+   * Set the frequency of the model, as SUIPropagationLossModel::SetLambda
+   * for SUI
+   * \param frequency the frequency [Hz]
+   */
+  void SetFrequency (double frequency);
+  /**
+   * \returns the frequency of the model [Hz]
+   */
+  double GetFrequency (void) const;
+
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< the model
+  std::string m_txAntennaHeight; //!< name of the Tx antenna height attribute
+};
+
+EmpiricalPropagationLossGradientTestCase::EmpiricalPropagationLossGradientTestCase (Ptr<EmpiricalPropagationLossModel> model,
+                                                                                    std::string txAntennaHeight,
+                                                                                    std::string name)
+  : TestCase (name),
+    m_model (model),
+    m_txAntennaHeight (txAntennaHeight)
+{
+}
+
+EmpiricalPropagationLossGradientTestCase::~EmpiricalPropagationLossGradientTestCase ()
+{
+}
+
+std::vector<double>
+EmpiricalPropagationLossGradientTestCase::GetLosses (const std::vector<double> &distance) const
+{
+  std::vector<double> loss (distance.size ());
+  m_model->GetLossBatch (distance.data (), loss.data (), distance.size ());
+  return loss;
+}
+
+void
+EmpiricalPropagationLossGradientTestCase::SetFrequency (double frequency)
+{
+  Ptr<SUIPropagationLossModel> sui = DynamicCast<SUIPropagationLossModel> (m_model);
+  if (sui != 0)
+    {
+      sui->SetLambda (frequency, 300000000);
+      return;
+    }
+  m_model->SetAttribute ("Frequency", DoubleValue (frequency));
+}
+
+double
+EmpiricalPropagationLossGradientTestCase::GetFrequency (void) const
+{
+  DoubleValue frequency;
+  m_model->GetAttribute ("Frequency", frequency);
+  return frequency.Get ();
+}
+
+void
+EmpiricalPropagationLossGradientTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<double> distance;
+  for (double d = 150.0; d < 20e3; d *= 1.7)
+    {
+      distance.push_back (d);
+    }
+  uint32_t n = distance.size ();
+  std::vector<double> loss (n);
+  std::vector<double> dDistance (n);
+  std::vector<double> dTxAntennaHeight (n);
+  std::vector<double> dFrequency (n);
+  m_model->GetLossGradientBatch (distance.data (), loss.data (), dDistance.data (),
+                                 dTxAntennaHeight.data (), dFrequency.data (), n);
+  std::vector<double> expected = GetLosses (distance);
+
+  // central differences
+  std::vector<double> above = distance;
+  std::vector<double> below = distance;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      above[i] *= 1 + 1e-6;
+      below[i] *= 1 - 1e-6;
+    }
+  std::vector<double> lossAbove = GetLosses (above);
+  std::vector<double> lossBelow = GetLosses (below);
+
+  DoubleValue value;
+  m_model->GetAttribute (m_txAntennaHeight, value);
+  double height = value.Get ();
+  double dh = height * 1e-6;
+  m_model->SetAttribute (m_txAntennaHeight, DoubleValue (height + dh));
+  std::vector<double> heightAbove = GetLosses (distance);
+  m_model->SetAttribute (m_txAntennaHeight, DoubleValue (height - dh));
+  std::vector<double> heightBelow = GetLosses (distance);
+  m_model->SetAttribute (m_txAntennaHeight, DoubleValue (height));
+
+  double frequency = GetFrequency ();
+  double df = frequency * 1e-6;
+  SetFrequency (frequency + df);
+  std::vector<double> frequencyAbove = GetLosses (distance);
+  SetFrequency (frequency - df);
+  std::vector<double> frequencyBelow = GetLosses (distance);
+  SetFrequency (frequency);
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (loss[i], expected[i], 1e-9, "Wrong loss at " << distance[i] << " m");
+      double fd = (lossAbove[i] - lossBelow[i]) / (above[i] - below[i]);
+      NS_TEST_ASSERT_MSG_EQ_TOL (dDistance[i], fd, 1e-5 * std::fabs (fd) + 1e-12,
+                                 "Wrong distance derivative at " << distance[i] << " m");
+      fd = (heightAbove[i] - heightBelow[i]) / (2 * dh);
+      NS_TEST_ASSERT_MSG_EQ_TOL (dTxAntennaHeight[i], fd, 1e-5 * std::fabs (fd) + 1e-9,
+                                 "Wrong Tx antenna height derivative at " << distance[i] << " m");
+      fd = (frequencyAbove[i] - frequencyBelow[i]) / (2 * df);
+      NS_TEST_ASSERT_MSG_EQ_TOL (dFrequency[i], fd, 1e-5 * std::fabs (fd) + 1e-15,
+                                 "Wrong frequency derivative at " << distance[i] << " m");
+    }
+
+  // the scalar path gives the same values
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (distance[2], 0.0, 0.0));
+  EmpiricalPropagationLossModel::LossGradient gradient = m_model->GetLossGradient (a, b);
+  NS_TEST_ASSERT_MSG_EQ (gradient.loss, loss[2], "Scalar loss differs from the batch");
+  NS_TEST_ASSERT_MSG_EQ (gradient.distance, dDistance[2], "Scalar derivative differs from the batch");
+  NS_TEST_ASSERT_MSG_EQ (gradient.txAntennaHeight, dTxAntennaHeight[2], "Scalar derivative differs from the batch");
+  NS_TEST_ASSERT_MSG_EQ (gradient.frequency, dFrequency[2], "Scalar derivative differs from the batch");
+
+  // a clamped input doesn't move the loss
+  m_model->SetAttribute ("ValidityPolicy", EnumValue (EmpiricalPropagationLossModel::Clamp));
+  m_model->SetAttribute (m_txAntennaHeight, DoubleValue (500.0));
+  double d = 0.5;
+  m_model->GetLossGradientBatch (&d, loss.data (), dDistance.data (), dTxAntennaHeight.data (), dFrequency.data (), 1);
+  NS_TEST_ASSERT_MSG_EQ (dDistance[0], 0.0, "Derivative of a clamped distance");
+  NS_TEST_ASSERT_MSG_EQ (dTxAntennaHeight[0], 0.0, "Derivative of a clamped Tx antenna height");
+  m_model->SetAttribute (m_txAntennaHeight, DoubleValue (height));
+  m_model->SetAttribute ("ValidityPolicy", EnumValue (EmpiricalPropagationLossModel::Extrapolate));
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Empirical propagation loss gradient TestSuite
+ */
+class EmpiricalPropagationLossGradientTestSuite : public TestSuite
+{
+public:
+  EmpiricalPropagationLossGradientTestSuite ();
+};
+
+EmpiricalPropagationLossGradientTestSuite::EmpiricalPropagationLossGradientTestSuite ()
+  : TestSuite ("empirical-propagation-loss-gradient", UNIT)
+{
+  const ECC33PropagationLossModel::Environment ecc33[2] = { ECC33PropagationLossModel::Urban, ECC33PropagationLossModel::Suburban };
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      Ptr<ECC33PropagationLossModel> model = CreateObject<ECC33PropagationLossModel> ();
+      model->SetFrequency (1.2e9);
+      model->SetTxAntennaHeight (60.0);
+      model->SetEnvironment (ecc33[k]);
+      AddTestCase (new EmpiricalPropagationLossGradientTestCase (model, "TxAntennaHeight", "ECC-33 gradient"), TestCase::QUICK);
+    }
+  const EricssonPropagationLossModel::Environment ericsson[3] = {
+    EricssonPropagationLossModel::Urban, EricssonPropagationLossModel::Suburban, EricssonPropagationLossModel::Rural
+  };
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      Ptr<EricssonPropagationLossModel> model = CreateObject<EricssonPropagationLossModel> ();
+      model->SetFrequency (900e6);
+      model->SetTxAntennaHeight (45.0);
+      model->SetEnvironment (ericsson[k]);
+      AddTestCase (new EmpiricalPropagationLossGradientTestCase (model, "TxAntennaHeight", "Ericsson gradient"), TestCase::QUICK);
+    }
+  const SUIPropagationLossModel::Terrain sui[3] = { SUIPropagationLossModel::A, SUIPropagationLossModel::B, SUIPropagationLossModel::C };
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      Ptr<SUIPropagationLossModel> model = CreateObject<SUIPropagationLossModel> ();
+      model->SetLambda (3.5e9, 300000000);
+      model->SetBSAntennaHeight (30.0);
+      model->SetTerrain (sui[k]);
+      AddTestCase (new EmpiricalPropagationLossGradientTestCase (model, "BSAntennaHeight", "SUI gradient"), TestCase::QUICK);
+    }
+}
+
+/// Static variable for test initialization
+static EmpiricalPropagationLossGradientTestSuite g_empiricalPropagationLossGradientTestSuite;
@@ -0,0 +1,466 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include "ns3/clutter-raster.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("EmpiricalPropagationLossModelTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check that the batch path of an empirical model agrees with
+ * its scalar GetLoss
+ */
+class EmpiricalBatchTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param model the configured model
+   * \param hb BS antenna height [m]
+   * \param hm mobile antenna height [m]
+   * \param name TestCase name
+   */
+  EmpiricalBatchTestCase (Ptr<EmpiricalPropagationLossModel> model, double hb, double hm, std::string name);
+  virtual ~EmpiricalBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< the model under test
+  double m_hb; //!< BS antenna height [m]
+  double m_hm; //!< mobile antenna height [m]
+};
+
+EmpiricalBatchTestCase::EmpiricalBatchTestCase (Ptr<EmpiricalPropagationLossModel> model, double hb, double hm, std::string name)
+  : TestCase (name),
+    m_model (model),
+    m_hb (hb),
+    m_hm (hm)
+{
+}
+
+EmpiricalBatchTestCase::~EmpiricalBatchTestCase ()
+{
+}
+
+void
+EmpiricalBatchTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  mma->SetPosition (Vector (0.0, 0.0, m_hb));
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+
+  std::vector<double> distance;
+  std::vector<double> expected;
+  for (double x = 50.0; x < 20000.0; x *= 1.37)
+    {
+      mmb->SetPosition (Vector (x, 0.0, m_hm));
+      distance.push_back (mma->GetDistanceFrom (mmb));
+      expected.push_back (m_model->CalcRxPower (0.0, mma, mmb));
+    }
+
+  std::vector<double> loss (distance.size ());
+  m_model->GetLossBatch (distance.data (), loss.data (), distance.size ());
+  for (uint32_t i = 0; i < distance.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (loss[i], expected[i], 1e-9, "Batch disagrees with GetLoss at " << distance[i] << " m");
+    }
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the distance x frequency grid of an empirical model
+ * against its scalar GetLoss at each frequency
+ */
+class EmpiricalGridTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param model the configured model
+   * \param name TestCase name
+   */
+  EmpiricalGridTestCase (Ptr<EmpiricalPropagationLossModel> model, std::string name);
+  virtual ~EmpiricalGridTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< the model under test
+};
+
+EmpiricalGridTestCase::EmpiricalGridTestCase (Ptr<EmpiricalPropagationLossModel> model, std::string name)
+  : TestCase (name),
+    m_model (model)
+{
+}
+
+EmpiricalGridTestCase::~EmpiricalGridTestCase ()
+{
+}
+
+void
+EmpiricalGridTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  const double frequency[] = { 700e6, 800e6, 900e6, 1.8e9, 2.1e9, 2.6e9, 3.5e9 };
+  const uint32_t nFrequency = sizeof (frequency) / sizeof (frequency[0]);
+  std::vector<double> distance;
+  for (double d = 80.0; d < 15000.0; d *= 1.9)
+    {
+      distance.push_back (d);
+    }
+
+  std::vector<double> grid (distance.size () * nFrequency);
+  m_model->GetLossGrid (distance.data (), distance.size (), frequency, nFrequency, grid.data ());
+
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+  for (uint32_t j = 0; j < nFrequency; ++j)
+    {
+      m_model->SetAttribute ("Frequency", DoubleValue (frequency[j]));
+      m_model->SetAttributeFailSafe ("Lambda", DoubleValue (3e8 / frequency[j]));
+      for (uint32_t i = 0; i < distance.size (); ++i)
+        {
+          mmb->SetPosition (Vector (distance[i], 0.0, 0.0));
+          NS_TEST_ASSERT_MSG_EQ_TOL (grid[i * nFrequency + j], m_model->CalcRxPower (0.0, mma, mmb), 1e-9,
+                                     "Grid disagrees with GetLoss at " << distance[i] << " m, " << frequency[j] << " Hz");
+        }
+    }
+
+  // in mixed clutter, the classes of the receivers give the losses of
+  // GetLoss with the raster: 1 m cells of urban, suburban and rural in turn
+  std::vector<uint8_t> cells (16000);
+  for (uint32_t c = 0; c < cells.size (); ++c)
+    {
+      cells[c] = c % ClutterRaster::NUM_CLASSES;
+    }
+  std::string filename = CreateTempDirFilename ("grid.clutter");
+  ClutterRaster::Write (filename, 0.0, -0.5, 1.0, cells.size (), 1, cells.data ());
+  Ptr<ClutterRaster> raster = CreateObject<ClutterRaster> ();
+  raster->SetAttribute ("Filename", StringValue (filename));
+  std::vector<double> y (distance.size (), 0.0);
+  std::vector<uint8_t> clutter (distance.size ());
+  raster->GetClasses (distance.data (), y.data (), clutter.data (), distance.size ());
+  std::set<uint8_t> classes (clutter.begin (), clutter.end ());
+  NS_TEST_ASSERT_MSG_GT (classes.size (), 1, "Receivers all in one class");
+
+  m_model->GetLossGrid (distance.data (), clutter.data (), distance.size (), frequency, nFrequency, grid.data ());
+  m_model->SetAttribute ("ClutterRaster", PointerValue (raster));
+  for (uint32_t j = 0; j < nFrequency; ++j)
+    {
+      m_model->SetAttribute ("Frequency", DoubleValue (frequency[j]));
+      m_model->SetAttributeFailSafe ("Lambda", DoubleValue (3e8 / frequency[j]));
+      for (uint32_t i = 0; i < distance.size (); ++i)
+        {
+          mmb->SetPosition (Vector (distance[i], 0.0, 0.0));
+          NS_TEST_ASSERT_MSG_EQ_TOL (grid[i * nFrequency + j], m_model->CalcRxPower (0.0, mma, mmb), 1e-9,
+                                     "Clutter grid disagrees with GetLoss at " << distance[i] << " m, "
+                                     << frequency[j] << " Hz, class " << static_cast<uint32_t> (clutter[i]));
+        }
+    }
+  m_model->SetAttribute ("ClutterRaster", PointerValue ());
+  raster->SetAttribute ("Filename", StringValue (""));
+  std::remove (filename.c_str ());
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the validity policies and out-of-range counters of an
+ * empirical model
+ */
+class EmpiricalValidityTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param model the configured model, whose antenna heights must be
+   *        within its validity range
+   * \param name TestCase name
+   */
+  EmpiricalValidityTestCase (Ptr<EmpiricalPropagationLossModel> model, std::string name);
+  virtual ~EmpiricalValidityTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< the model under test
+};
+
+EmpiricalValidityTestCase::EmpiricalValidityTestCase (Ptr<EmpiricalPropagationLossModel> model, std::string name)
+  : TestCase (name),
+    m_model (model)
+{
+}
+
+EmpiricalValidityTestCase::~EmpiricalValidityTestCase ()
+{
+}
+
+void
+EmpiricalValidityTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  EmpiricalPropagationLossModel::ValidityRange range = m_model->GetValidityRange ();
+  double inRange = std::sqrt (range.minFrequency * range.maxFrequency);
+  m_model->SetAttribute ("Frequency", DoubleValue (inRange));
+  m_model->SetAttributeFailSafe ("Lambda", DoubleValue (3e8 / inRange));
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+
+  // co-located nodes: the MinDistance floor keeps the loss finite
+  m_model->ResetValidityCounters ();
+  double loss = m_model->CalcRxPower (0.0, mma, mmb);
+  NS_TEST_ASSERT_MSG_EQ (std::isfinite (loss), true, "Non-finite loss at zero distance");
+  m_model->SetAttribute ("MinDistance", DoubleValue (1.0));
+  mmb->SetPosition (Vector (1.0, 0.0, 0.0));
+  NS_TEST_ASSERT_MSG_EQ_TOL (loss, m_model->CalcRxPower (0.0, mma, mmb), 1e-9, "Zero distance not floored at MinDistance");
+  EmpiricalPropagationLossModel::ValidityCounters counters = m_model->GetValidityCounters ();
+  NS_TEST_ASSERT_MSG_EQ (counters.evaluations, 2, "Wrong number of evaluations");
+  NS_TEST_ASSERT_MSG_EQ (counters.distance, 2, "Out-of-range distances not counted");
+  NS_TEST_ASSERT_MSG_EQ (counters.frequency + counters.txAntennaHeight + counters.rxAntennaHeight, 0, "Parameters wrongly counted");
+
+  const double distance[] = { 0.0, range.minDistance / 2, range.minDistance,
+                              std::sqrt (range.minDistance * range.maxDistance), range.maxDistance, range.maxDistance * 3 };
+  const uint32_t n = sizeof (distance) / sizeof (distance[0]);
+  double extrapolated[n];
+  double clamped[n];
+  m_model->ResetValidityCounters ();
+  m_model->GetLossBatch (distance, extrapolated, n);
+  counters = m_model->GetValidityCounters ();
+  NS_TEST_ASSERT_MSG_EQ (counters.evaluations, n, "Wrong number of batch evaluations");
+  NS_TEST_ASSERT_MSG_EQ (counters.distance, 3, "Out-of-range batch distances not counted");
+
+  // clamped distances give the losses at the bounds of the range
+  m_model->SetAttribute ("ValidityPolicy", EnumValue (EmpiricalPropagationLossModel::Clamp));
+  m_model->GetLossBatch (distance, clamped, n);
+  NS_TEST_ASSERT_MSG_EQ_TOL (clamped[0], extrapolated[2], 1e-9, "Zero distance not clamped");
+  NS_TEST_ASSERT_MSG_EQ_TOL (clamped[1], extrapolated[2], 1e-9, "Short distance not clamped");
+  NS_TEST_ASSERT_MSG_EQ_TOL (clamped[3], extrapolated[3], 1e-9, "In-range distance changed by Clamp");
+  NS_TEST_ASSERT_MSG_EQ_TOL (clamped[5], extrapolated[4], 1e-9, "Long distance not clamped");
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      mmb->SetPosition (Vector (distance[i], 0.0, 0.0));
+      NS_TEST_ASSERT_MSG_EQ_TOL (clamped[i], m_model->CalcRxPower (0.0, mma, mmb), 1e-9,
+                                 "Clamped batch disagrees with GetLoss at " << distance[i] << " m");
+    }
+
+  // an out-of-range frequency is counted, and clamped to the closest bound
+  mmb->SetPosition (Vector (distance[3], 0.0, 0.0));
+  double atBound = m_model->GetCoefficients (range.maxFrequency).c0;
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_model->GetCoefficients (range.maxFrequency * 2).c0, atBound, 1e-9, "Frequency not clamped");
+  m_model->ResetValidityCounters ();
+  std::vector<double> grid (n * 2);
+  const double frequency[] = { range.minFrequency, range.maxFrequency * 2 };
+  m_model->GetLossGrid (distance, n, frequency, 2, grid.data ());
+  counters = m_model->GetValidityCounters ();
+  NS_TEST_ASSERT_MSG_EQ (counters.evaluations, 2 * n, "Wrong number of grid evaluations");
+  NS_TEST_ASSERT_MSG_EQ (counters.frequency, n, "Out-of-range grid frequencies not counted");
+  NS_TEST_ASSERT_MSG_EQ (counters.distance, 2 * 3, "Out-of-range grid distances not counted");
+
+  m_model->SetAttribute ("ValidityPolicy", EnumValue (EmpiricalPropagationLossModel::Extrapolate));
+  m_model->ResetValidityCounters ();
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the out-of-range counters of threads evaluating one model,
+ * and the report printed on dispose
+ */
+class EmpiricalValidityReportTestCase : public TestCase
+{
+public:
+  EmpiricalValidityReportTestCase ();
+  virtual ~EmpiricalValidityReportTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Evaluate the model at an out-of-range distance
+   * \param model the model
+   * \param n the number of evaluations
+   */
+  static void Evaluate (const EmpiricalPropagationLossModel *model, uint32_t n);
+  /**
+   * Dispose an Ericsson model after out-of-range evaluations
+   * \param report the ReportOutOfRange attribute of the model
+   * \returns what the model printed to std::clog
+   */
+  std::string Dispose (bool report);
+};
+
+EmpiricalValidityReportTestCase::EmpiricalValidityReportTestCase ()
+  : TestCase ("Check the out-of-range counters of several threads and the report on dispose")
+{
+}
+
+EmpiricalValidityReportTestCase::~EmpiricalValidityReportTestCase ()
+{
+}
+
+void
+EmpiricalValidityReportTestCase::Evaluate (const EmpiricalPropagationLossModel *model, uint32_t n)
+{
+  double distance = 100.0;
+  double loss;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      model->GetLossBatch (&distance, &loss, 1);
+    }
+}
+
+std::string
+EmpiricalValidityReportTestCase::Dispose (bool report)
+{
+  Ptr<EricssonPropagationLossModel> model = CreateObject<EricssonPropagationLossModel> ();
+  model->SetAttribute ("ReportOutOfRange", BooleanValue (report));
+  Evaluate (PeekPointer (model), 1);
+  std::ostringstream oss;
+  std::streambuf *clog = std::clog.rdbuf (oss.rdbuf ());
+  model->Dispose ();
+  std::clog.rdbuf (clog);
+  return oss.str ();
+}
+
+void
+EmpiricalValidityReportTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // the evaluations of every thread are counted
+  Ptr<EricssonPropagationLossModel> model = CreateObject<EricssonPropagationLossModel> ();
+  const uint32_t nThreads = 12;
+  const uint32_t n = 10000;
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < nThreads; ++t)
+    {
+      threads.push_back (std::thread (&EmpiricalValidityReportTestCase::Evaluate, PeekPointer (model), n));
+    }
+  for (uint32_t t = 0; t < nThreads; ++t)
+    {
+      threads[t].join ();
+    }
+  EmpiricalPropagationLossModel::ValidityCounters counters = model->GetValidityCounters ();
+  NS_TEST_ASSERT_MSG_EQ (counters.evaluations, nThreads * n, "Evaluations of some threads not counted");
+  NS_TEST_ASSERT_MSG_EQ (counters.distance, nThreads * n, "Out-of-range distances of some threads not counted");
+  NS_TEST_ASSERT_MSG_EQ (counters.frequency, 0, "In-range frequency counted");
+  model->ResetValidityCounters ();
+  NS_TEST_ASSERT_MSG_EQ (model->GetValidityCounters ().evaluations, 0, "Evaluations not reset");
+  model->Dispose ();
+
+  // the counters are printed on dispose, unless disabled
+  std::string report = Dispose (true);
+  NS_TEST_ASSERT_MSG_EQ ((report.find ("1 evaluations, out of range: 1 distance") != std::string::npos), true,
+                         "Wrong report: " << report);
+  NS_TEST_ASSERT_MSG_EQ (Dispose (false), "", "Disabled report printed");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Empirical propagation loss models TestSuite
+ */
+class EmpiricalPropagationLossModelTestSuite : public TestSuite
+{
+public:
+  EmpiricalPropagationLossModelTestSuite ();
+};
+
+EmpiricalPropagationLossModelTestSuite::EmpiricalPropagationLossModelTestSuite ()
+  : TestSuite ("empirical-propagation-loss-model", UNIT)
+{
+  const ECC33PropagationLossModel::Environment ecc33Environments[] = {
+    ECC33PropagationLossModel::Urban, ECC33PropagationLossModel::Suburban
+  };
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<ECC33PropagationLossModel> ecc33 = CreateObject<ECC33PropagationLossModel> ();
+      ecc33->SetFrequency (900e6);
+      ecc33->SetTxAntennaHeight (33);
+      ecc33->SetRxAntennaHeight (1.5);
+      ecc33->SetEnvironment (ecc33Environments[i]);
+      AddTestCase (new EmpiricalBatchTestCase (ecc33, 33, 1.5, "ECC-33 batch"), TestCase::QUICK);
+      AddTestCase (new EmpiricalGridTestCase (ecc33, "ECC-33 frequency grid"), TestCase::QUICK);
+      AddTestCase (new EmpiricalValidityTestCase (ecc33, "ECC-33 validity"), TestCase::QUICK);
+    }
+
+  const EricssonPropagationLossModel::Environment ericssonEnvironments[] = {
+    EricssonPropagationLossModel::Urban, EricssonPropagationLossModel::Suburban, EricssonPropagationLossModel::Rural
+  };
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+      ericsson->SetFrequency (1.8e9);
+      ericsson->SetTxAntennaHeight (42);
+      ericsson->SetRxAntennaHeight (2);
+      ericsson->SetEnvironment (ericssonEnvironments[i]);
+      AddTestCase (new EmpiricalBatchTestCase (ericsson, 42, 2, "Ericsson batch"), TestCase::QUICK);
+      AddTestCase (new EmpiricalGridTestCase (ericsson, "Ericsson frequency grid"), TestCase::QUICK);
+      AddTestCase (new EmpiricalValidityTestCase (ericsson, "Ericsson validity"), TestCase::QUICK);
+    }
+
+  const SUIPropagationLossModel::Terrain suiTerrains[] = {
+    SUIPropagationLossModel::A, SUIPropagationLossModel::B, SUIPropagationLossModel::C
+  };
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+      sui->SetLambda (3e8 / 2.5e9);
+      sui->SetBSAntennaHeight (30);
+      sui->SetSSAntennaHeight (3);
+      sui->SetTerrain (suiTerrains[i]);
+      AddTestCase (new EmpiricalBatchTestCase (sui, 30, 3, "SUI batch"), TestCase::QUICK);
+      AddTestCase (new EmpiricalGridTestCase (sui, "SUI frequency grid"), TestCase::QUICK);
+      AddTestCase (new EmpiricalValidityTestCase (sui, "SUI validity"), TestCase::QUICK);
+    }
+  AddTestCase (new EmpiricalValidityReportTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static EmpiricalPropagationLossModelTestSuite g_empiricalPropagationLossModelTestSuite;
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("EricssonPropagationLossModelTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Ericsson golden value test case
+ *
+ * The reference values were computed offline from the closed-form
+ * expressions documented in ericsson-propagation-loss-model.cc, using the
+ * 3D distance between the two nodes.
+ */
+class EricssonPropagationLossModelTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param freq carrier frequency [Hz]
+   * \param dist 2D distance between BS and mobile [m]
+   * \param hb BS antenna height [m]
+   * \param hm mobile antenna height [m]
+   * \param env environment type
+   * \param refValue reference loss value [dB]
+   * \param name TestCase name
+   */
+  EricssonPropagationLossModelTestCase (double freq, double dist, double hb, double hm,
+                                        EricssonPropagationLossModel::Environment env,
+                                        double refValue, std::string name);
+  virtual ~EricssonPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  double m_freq; //!< carrier frequency [Hz]
+  double m_dist; //!< 2D distance between BS and mobile [m]
+  double m_hb; //!< BS antenna height [m]
+  double m_hm; //!< mobile antenna height [m]
+  EricssonPropagationLossModel::Environment m_env; //!< environment type
+  double m_lossRef; //!< reference loss [dB]
+};
+
+EricssonPropagationLossModelTestCase::EricssonPropagationLossModelTestCase (double freq, double dist, double hb, double hm,
+                                                                            EricssonPropagationLossModel::Environment env,
+                                                                            double refValue, std::string name)
+  : TestCase (name),
+    m_freq (freq),
+    m_dist (dist),
+    m_hb (hb),
+    m_hm (hm),
+    m_env (env),
+    m_lossRef (refValue)
+{
+}
+
+EricssonPropagationLossModelTestCase::~EricssonPropagationLossModelTestCase ()
+{
+}
+
+void
+EricssonPropagationLossModelTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  mma->SetPosition (Vector (0.0, 0.0, m_hb));
+
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+  mmb->SetPosition (Vector (m_dist, 0.0, m_hm));
+
+  Ptr<EricssonPropagationLossModel> propagationLossModel = CreateObject<EricssonPropagationLossModel> ();
+  propagationLossModel->SetAttribute ("Frequency", DoubleValue (m_freq));
+  propagationLossModel->SetAttribute ("TxAntennaHeight", DoubleValue (m_hb));
+  propagationLossModel->SetAttribute ("RxAntennaHeight", DoubleValue (m_hm));
+  propagationLossModel->SetAttribute ("Environment", EnumValue (m_env));
+
+  // GetLoss () returns the loss as a negative gain
+  double loss = -propagationLossModel->GetLoss (mma, mmb);
+
+  NS_LOG_INFO ("Calculated loss: " << loss);
+  NS_LOG_INFO ("Theoretical loss: " << m_lossRef);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (loss, m_lossRef, 0.001, "Wrong loss !");
+
+  double txPowerDbm = 43.0;
+  double rxPowerDbm = propagationLossModel->CalcRxPower (txPowerDbm, mma, mmb);
+  NS_TEST_ASSERT_MSG_EQ_TOL (txPowerDbm - rxPowerDbm, m_lossRef, 0.001, "CalcRxPower disagrees with GetLoss");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Ericsson TestSuite
+ */
+class EricssonPropagationLossModelTestSuite : public TestSuite
+{
+public:
+  EricssonPropagationLossModelTestSuite ();
+};
+
+EricssonPropagationLossModelTestSuite::EricssonPropagationLossModelTestSuite ()
+  : TestSuite ("ericsson", SYSTEM)
+{
+  LogComponentEnable ("EricssonPropagationLossModelTest", LOG_LEVEL_ALL);
+
+  // setups of the empirical-propagation-loss-comparison scratch (900 MHz, 1 m mobile)
+  AddTestCase (new EricssonPropagationLossModelTestCase (900e6, 100, 33, 1, EricssonPropagationLossModel::Urban, 92.543, "Ericsson Urban 900 MHz 100 m"), TestCase::QUICK);
+  AddTestCase (new EricssonPropagationLossModelTestCase (900e6, 800, 33, 1, EricssonPropagationLossModel::Urban, 119.322, "Ericsson Urban 900 MHz 800 m"), TestCase::QUICK);
+  AddTestCase (new EricssonPropagationLossModelTestCase (900e6, 100, 35, 1, EricssonPropagationLossModel::Suburban, 61.809, "Ericsson Suburban 900 MHz 100 m"), TestCase::QUICK);
+  AddTestCase (new EricssonPropagationLossModelTestCase (900e6, 800, 35, 1, EricssonPropagationLossModel::Suburban, 122.585, "Ericsson Suburban 900 MHz 800 m"), TestCase::QUICK);
+  AddTestCase (new EricssonPropagationLossModelTestCase (900e6, 100, 42, 1, EricssonPropagationLossModel::Rural, 34.640, "Ericsson Rural 900 MHz 100 m"), TestCase::QUICK);
+  AddTestCase (new EricssonPropagationLossModelTestCase (900e6, 800, 42, 1, EricssonPropagationLossModel::Rural, 122.295, "Ericsson Rural 900 MHz 800 m"), TestCase::QUICK);
+
+  // attribute defaults (2 GHz, 50 m BS, 3 m mobile) and a long 1.8 GHz link
+  AddTestCase (new EricssonPropagationLossModelTestCase (2e9, 1000, 50, 3, EricssonPropagationLossModel::Urban, 136.514, "Ericsson Urban 2 GHz 1 km"), TestCase::QUICK);
+  AddTestCase (new EricssonPropagationLossModelTestCase (2e9, 1000, 50, 3, EricssonPropagationLossModel::Suburban, 143.533, "Ericsson Suburban 2 GHz 1 km"), TestCase::QUICK);
+  AddTestCase (new EricssonPropagationLossModelTestCase (2e9, 1000, 50, 3, EricssonPropagationLossModel::Rural, 146.298, "Ericsson Rural 2 GHz 1 km"), TestCase::QUICK);
+  AddTestCase (new EricssonPropagationLossModelTestCase (1.8e9, 5000, 30, 1.5, EricssonPropagationLossModel::Urban, 151.483, "Ericsson Urban 1.8 GHz 5 km"), TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static EricssonPropagationLossModelTestSuite g_ericssonTestSuite;
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/pointer.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/jakes-empirical-propagation-loss-model.h"
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("JakesEmpiricalPropagationLossModelTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check that the scalar, batch and all-links paths agree, and that
+ * the fading has unit mean power gain over time
+ */
+class JakesEmpiricalTestCase : public TestCase
+{
+public:
+  JakesEmpiricalTestCase ();
+  virtual ~JakesEmpiricalTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the evaluation paths now and accumulate the fading power
+   */
+  void Check (void);
+
+  Ptr<EricssonPropagationLossModel> m_median; //!< the median loss model
+  Ptr<JakesEmpiricalPropagationLossModel> m_model; //!< the model under test
+  Ptr<MobilityModel> m_bs; //!< the base station
+  std::vector<Ptr<MobilityModel> > m_ss; //!< the subscriber stations
+  std::vector<double> m_power; //!< summed linear fading gain of each link
+  uint32_t m_samples; //!< number of Check calls
+};
+
+JakesEmpiricalTestCase::JakesEmpiricalTestCase ()
+  : TestCase ("Fused Ericsson and Jakes fading paths"),
+    m_samples (0)
+{
+}
+
+JakesEmpiricalTestCase::~JakesEmpiricalTestCase ()
+{
+}
+
+void
+JakesEmpiricalTestCase::Check (void)
+{
+  uint32_t n = m_ss.size ();
+  std::vector<double> distance (n);
+  std::vector<uint32_t> link (n);
+  std::vector<double> batch (n);
+  std::vector<double> all (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      // reversed order, to check the batch follows the indices
+      link[i] = n - 1 - i;
+      distance[i] = m_bs->GetDistanceFrom (m_ss[link[i]]);
+    }
+  m_model->GetLossBatch (link.data (), distance.data (), batch.data (), n);
+  m_model->GetLinkLosses (all.data ());
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      double fading = m_model->GetFadingGainDb (i);
+      double scalar = m_model->CalcRxPower (0.0, m_bs, m_ss[i]);
+      NS_TEST_ASSERT_MSG_EQ_TOL (scalar, m_median->CalcRxPower (0.0, m_bs, m_ss[i]) + fading, 1e-9,
+                                 "Scalar path is not the median loss plus the fading");
+      NS_TEST_ASSERT_MSG_EQ (m_model->CalcRxPower (0.0, m_ss[i], m_bs), scalar, "Fading is not reciprocal");
+      NS_TEST_ASSERT_MSG_EQ_TOL (all[i], scalar, 1e-9, "All-links path differs from the scalar path");
+      NS_TEST_ASSERT_MSG_EQ_TOL (batch[n - 1 - i], scalar, 1e-9, "Batch path differs from the scalar path");
+      m_power[i] += std::pow (10.0, fading / 10);
+    }
+  m_samples++;
+}
+
+void
+JakesEmpiricalTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_median = CreateObject<EricssonPropagationLossModel> ();
+  m_median->SetEnvironment (EricssonPropagationLossModel::Urban);
+  m_model = CreateObject<JakesEmpiricalPropagationLossModel> ();
+  m_model->SetAttribute ("Median", PointerValue (m_median));
+  m_model->AssignStreams (1);
+
+  m_bs = CreateObject<ConstantPositionMobilityModel> ();
+  m_bs->SetPosition (Vector (0.0, 0.0, 50.0));
+  const uint32_t links = 50;
+  for (uint32_t i = 0; i < links; ++i)
+    {
+      Ptr<MobilityModel> ss = CreateObject<ConstantPositionMobilityModel> ();
+      ss->SetPosition (Vector (1000.0 + 100.0 * i, 0.0, 3.0));
+      m_ss.push_back (ss);
+      NS_TEST_ASSERT_MSG_EQ (m_model->AddLink (m_bs, ss), i, "Unexpected link index");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_model->AddLink (m_ss[7], m_bs), 7, "Reverse link registered twice");
+  NS_TEST_ASSERT_MSG_EQ (m_model->GetNLinks (), links, "Unexpected number of links");
+  m_power.assign (links, 0.0);
+
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      Simulator::Schedule (MilliSeconds (10.0 * i), &JakesEmpiricalTestCase::Check, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // each oscillator contributes |amplitude|^2 / 2 = 2 / N to the time
+  // average of |gain|^2, hence a unit mean of |gain|^2 / 2 on every link
+  for (uint32_t i = 0; i < links; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (m_power[i] / m_samples, 1.0, 0.2, "Mean fading power gain of link " << i);
+    }
+
+  // same stream, same fading
+  Ptr<JakesEmpiricalPropagationLossModel> other = CreateObject<JakesEmpiricalPropagationLossModel> ();
+  other->SetAttribute ("Median", PointerValue (m_median));
+  other->AssignStreams (1);
+  for (uint32_t i = 0; i < links; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (other->AddLink (m_bs, m_ss[i]), i, "Unexpected link index");
+      NS_TEST_ASSERT_MSG_EQ (other->GetFadingGainDb (i), m_model->GetFadingGainDb (i), "Stream does not fix the fading");
+    }
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Fused empirical and Jakes fading model TestSuite
+ */
+class JakesEmpiricalPropagationLossModelTestSuite : public TestSuite
+{
+public:
+  JakesEmpiricalPropagationLossModelTestSuite ();
+};
+
+JakesEmpiricalPropagationLossModelTestSuite::JakesEmpiricalPropagationLossModelTestSuite ()
+  : TestSuite ("jakes-empirical-propagation-loss-model", UNIT)
+{
+  AddTestCase (new JakesEmpiricalTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static JakesEmpiricalPropagationLossModelTestSuite g_jakesEmpiricalPropagationLossModelTestSuite;
@@ -0,0 +1,437 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/node-container.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/loss-matrix-file.h"
+#include "ns3/loss-matrix-propagation-loss-model.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LossMatrixPropagationLossModelTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Write a loss matrix from the Ericsson model and read it back
+ */
+class LossMatrixRoundTripTestCase : public TestCase
+{
+public:
+  LossMatrixRoundTripTestCase ();
+  virtual ~LossMatrixRoundTripTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param nodes the nodes to place
+   * \param x the x coordinate of the first node [m]
+   * \param z the height of the nodes [m]
+   */
+  void Place (NodeContainer nodes, double x, double z);
+};
+
+LossMatrixRoundTripTestCase::LossMatrixRoundTripTestCase ()
+  : TestCase ("Loss matrix file round trip")
+{
+}
+
+LossMatrixRoundTripTestCase::~LossMatrixRoundTripTestCase ()
+{
+}
+
+void
+LossMatrixRoundTripTestCase::Place (NodeContainer nodes, double x, double z)
+{
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+      mm->SetPosition (Vector (x + 150.0 * i, 20.0 * i, z));
+      nodes.Get (i)->AggregateObject (mm);
+    }
+}
+
+void
+LossMatrixRoundTripTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NodeContainer bs;
+  bs.Create (2);
+  Place (bs, 0.0, 35.0);
+  NodeContainer ss;
+  ss.Create (3);
+  Place (ss, 200.0, 1.0);
+  NodeContainer other;
+  other.Create (1);
+  Place (other, 500.0, 1.0);
+
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetFrequency (900e6);
+  ericsson->SetTxAntennaHeight (35.0);
+  ericsson->SetRxAntennaHeight (1.0);
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Suburban);
+
+  std::string filename = CreateTempDirFilename ("ericsson-suburban.loss");
+  LossMatrixFile::Write (filename, ericsson, bs, ss);
+
+  Ptr<LossMatrixPropagationLossModel> matrix = CreateObject<LossMatrixPropagationLossModel> ();
+  matrix->SetAttribute ("Filename", StringValue (filename));
+
+  const LossMatrixHeader &header = matrix->GetHeader ();
+  NS_TEST_ASSERT_MSG_EQ (std::string (header.model), "ns3::EricssonPropagationLossModel", "Wrong model name");
+  NS_TEST_ASSERT_MSG_EQ (header.nTx, 2, "Wrong number of rows");
+  NS_TEST_ASSERT_MSG_EQ (header.nRx, 3, "Wrong number of columns");
+  NS_TEST_ASSERT_MSG_EQ_TOL (header.frequency, 900e6, 1e-6, "Wrong frequency");
+  NS_TEST_ASSERT_MSG_EQ_TOL (header.txAntennaHeight, 35.0, 1e-12, "Wrong Tx antenna height");
+  NS_TEST_ASSERT_MSG_EQ_TOL (header.rxAntennaHeight, 1.0, 1e-12, "Wrong Rx antenna height");
+  NS_TEST_ASSERT_MSG_EQ (header.environment, EricssonPropagationLossModel::Suburban, "Wrong environment");
+
+  for (uint32_t i = 0; i < bs.GetN (); ++i)
+    {
+      Ptr<MobilityModel> a = bs.Get (i)->GetObject<MobilityModel> ();
+      for (uint32_t j = 0; j < ss.GetN (); ++j)
+        {
+          Ptr<MobilityModel> b = ss.Get (j)->GetObject<MobilityModel> ();
+          double expected = ericsson->CalcRxPower (20.0, a, b);
+          NS_TEST_ASSERT_MSG_EQ_TOL (matrix->CalcRxPower (20.0, a, b), expected, 1e-9, "Wrong loss for " << i << "," << j);
+          NS_TEST_ASSERT_MSG_EQ_TOL (matrix->CalcRxPower (20.0, b, a), expected, 1e-9, "Wrong reverse loss for " << i << "," << j);
+        }
+    }
+
+  // pairs outside the matrix go to the fallback model
+  matrix->SetAttribute ("Fallback", PointerValue (ericsson));
+  Ptr<MobilityModel> a = bs.Get (0)->GetObject<MobilityModel> ();
+  Ptr<MobilityModel> b = other.Get (0)->GetObject<MobilityModel> ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (matrix->CalcRxPower (20.0, a, b), ericsson->CalcRxPower (20.0, a, b), 1e-9, "Fallback not used");
+
+  matrix->SetAttribute ("Filename", StringValue (""));
+  std::remove (filename.c_str ());
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Write quantized loss matrices, and read a version 1 file
+ */
+class LossMatrixEncodingTestCase : public TestCase
+{
+public:
+  LossMatrixEncodingTestCase ();
+  virtual ~LossMatrixEncodingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LossMatrixEncodingTestCase::LossMatrixEncodingTestCase ()
+  : TestCase ("Loss matrix encodings")
+{
+}
+
+LossMatrixEncodingTestCase::~LossMatrixEncodingTestCase ()
+{
+}
+
+/**
+ * \param filename a file
+ * \returns the content of the file
+ */
+static std::vector<char>
+ReadFile (std::string filename)
+{
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  return std::vector<char> (std::istreambuf_iterator<char> (is), std::istreambuf_iterator<char> ());
+}
+
+void
+LossMatrixEncodingTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NodeContainer bs;
+  bs.Create (3);
+  NodeContainer ss;
+  ss.Create (40);
+  for (uint32_t i = 0; i < bs.GetN (); ++i)
+    {
+      Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+      mm->SetPosition (Vector (1000.0 * i, 0.0, 35.0));
+      bs.Get (i)->AggregateObject (mm);
+    }
+  for (uint32_t j = 0; j < ss.GetN (); ++j)
+    {
+      Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+      mm->SetPosition (Vector (97.0 * j, 50.0 + 61.0 * j, 1.5));
+      ss.Get (j)->AggregateObject (mm);
+    }
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Urban);
+
+  const LossQuantization::Encoding encodings[3] = {
+    LossQuantization::Double, LossQuantization::Uint16, LossQuantization::Uint8
+  };
+  std::string filenames[3];
+  LossMatrixFile files[3];
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      filenames[k] = CreateTempDirFilename ("encoding.loss");
+      filenames[k] += static_cast<char> ('0' + k);
+      LossMatrixFile::Write (filenames[k], ericsson, bs, ss, encodings[k]);
+      files[k].Open (filenames[k]);
+      NS_TEST_ASSERT_MSG_EQ (files[k].GetHeader ().version, LossMatrixFile::LOSS_MATRIX_VERSION, "Wrong version");
+      NS_TEST_ASSERT_MSG_EQ (files[k].GetHeader ().encoding, encodings[k], "Wrong encoding");
+    }
+  uint64_t losses = bs.GetN () * ss.GetN ();
+  uint64_t doubleSize = ReadFile (filenames[0]).size ();
+  NS_TEST_ASSERT_MSG_EQ (doubleSize - ReadFile (filenames[1]).size (), losses * 6, "Wrong Uint16 file size");
+  NS_TEST_ASSERT_MSG_EQ (doubleSize - ReadFile (filenames[2]).size (), losses * 7, "Wrong Uint8 file size");
+
+  std::vector<double> row (ss.GetN ());
+  for (uint32_t k = 1; k < 3; ++k)
+    {
+      const LossMatrixHeader &header = files[k].GetHeader ();
+      NS_TEST_ASSERT_MSG_GT (header.scaleStep, 0.0, "No scale");
+      for (uint32_t i = 0; i < bs.GetN (); ++i)
+        {
+          files[k].GetRow (i, row.data ());
+          for (uint32_t j = 0; j < ss.GetN (); ++j)
+            {
+              double expected = files[0].GetLoss (i, j);
+              NS_TEST_ASSERT_MSG_EQ_TOL (files[k].GetLoss (i, j), expected, header.scaleStep / 2 * (1 + 1e-9),
+                                         "Wrong quantized loss for " << i << "," << j);
+              NS_TEST_ASSERT_MSG_EQ (row[j], files[k].GetLoss (i, j), "Row differs from the single lookups");
+            }
+        }
+    }
+
+  // the same double matrix in the version 1 layout: shorter header, no scale
+  const uint32_t v1HeaderSize = 120;
+  std::vector<char> v2 = ReadFile (filenames[0]);
+  LossMatrixHeader header;
+  std::memcpy (&header, v2.data (), sizeof (header));
+  header.version = 1;
+  header.headerSize = v1HeaderSize;
+  uint64_t ids = (bs.GetN () + ss.GetN ()) * sizeof (uint32_t);
+  std::vector<char> v1 (reinterpret_cast<const char *> (&header), reinterpret_cast<const char *> (&header) + v1HeaderSize);
+  v1.insert (v1.end (), v2.begin () + sizeof (header), v2.begin () + sizeof (header) + ids);
+  v1.resize ((v1.size () + 7) & ~static_cast<uint64_t> (7), 0);
+  v1.insert (v1.end (), v2.end () - losses * sizeof (double), v2.end ());
+  std::string v1Filename = CreateTempDirFilename ("version1.loss");
+  std::ofstream (v1Filename.c_str (), std::ios::binary).write (v1.data (), v1.size ());
+  LossMatrixFile old;
+  old.Open (v1Filename);
+  NS_TEST_ASSERT_MSG_EQ (old.GetHeader ().version, 1, "Wrong version");
+  NS_TEST_ASSERT_MSG_EQ (old.GetHeader ().encoding, LossQuantization::Double, "Wrong version 1 encoding");
+  NS_TEST_ASSERT_MSG_EQ (old.GetTxIndex (bs.Get (2)->GetId ()), 2, "Wrong version 1 row index");
+  NS_TEST_ASSERT_MSG_EQ (old.GetRxIndex (ss.Get (39)->GetId ()), 39, "Wrong version 1 column index");
+  for (uint32_t i = 0; i < bs.GetN (); ++i)
+    {
+      for (uint32_t j = 0; j < ss.GetN (); ++j)
+        {
+          NS_TEST_ASSERT_MSG_EQ (old.GetLoss (i, j), files[0].GetLoss (i, j), "Wrong version 1 loss");
+        }
+    }
+
+  old.Close ();
+  std::remove (v1Filename.c_str ());
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      files[k].Close ();
+      std::remove (filenames[k].c_str ());
+    }
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Loss model with non-finite losses, counting its evaluations
+ *
+ * The receivers at x = 0, 1 and 2 get an infinite loss, an infinite gain
+ * and a NaN; the others a loss of 60 dB + x.
+ */
+class NonFiniteLossModel : public PropagationLossModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  NonFiniteLossModel ();
+
+  mutable uint32_t m_evaluations; //!< number of evaluated links
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+};
+
+TypeId
+NonFiniteLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NonFiniteLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<NonFiniteLossModel> ();
+  return tid;
+}
+
+NonFiniteLossModel::NonFiniteLossModel ()
+  : m_evaluations (0)
+{
+}
+
+double
+NonFiniteLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  m_evaluations++;
+  double x = b->GetPosition ().x;
+  if (x == 0)
+    {
+      return -std::numeric_limits<double>::infinity ();
+    }
+  if (x == 1)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  if (x == 2)
+    {
+      return std::numeric_limits<double>::quiet_NaN ();
+    }
+  return txPowerDbm - 60.0 - x;
+}
+
+int64_t
+NonFiniteLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Write quantized loss matrices of non-finite losses, with one
+ * evaluation per link
+ */
+class LossMatrixNonFiniteTestCase : public TestCase
+{
+public:
+  LossMatrixNonFiniteTestCase ();
+  virtual ~LossMatrixNonFiniteTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LossMatrixNonFiniteTestCase::LossMatrixNonFiniteTestCase ()
+  : TestCase ("Loss matrix non-finite losses")
+{
+}
+
+LossMatrixNonFiniteTestCase::~LossMatrixNonFiniteTestCase ()
+{
+}
+
+void
+LossMatrixNonFiniteTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NodeContainer bs;
+  bs.Create (2);
+  NodeContainer ss;
+  ss.Create (20);
+  for (uint32_t i = 0; i < bs.GetN (); ++i)
+    {
+      Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+      mm->SetPosition (Vector (-1.0 - i, 0.0, 35.0));
+      bs.Get (i)->AggregateObject (mm);
+    }
+  for (uint32_t j = 0; j < ss.GetN (); ++j)
+    {
+      Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+      mm->SetPosition (Vector (j, 0.0, 1.5));
+      ss.Get (j)->AggregateObject (mm);
+    }
+  Ptr<NonFiniteLossModel> model = CreateObject<NonFiniteLossModel> ();
+
+  const LossQuantization::Encoding encodings[2] = { LossQuantization::Uint16, LossQuantization::Uint8 };
+  for (uint32_t k = 0; k < 2; ++k)
+    {
+      std::string filename = CreateTempDirFilename ("non-finite.loss");
+      model->m_evaluations = 0;
+      LossMatrixFile::Write (filename, model, bs, ss, encodings[k]);
+      NS_TEST_ASSERT_MSG_EQ (model->m_evaluations, bs.GetN () * ss.GetN (), "Links evaluated more than once");
+
+      LossMatrixFile file;
+      file.Open (filename);
+      const LossMatrixHeader &header = file.GetHeader ();
+      // the scale only spans the finite losses, 63 dB to 79 dB
+      NS_TEST_ASSERT_MSG_EQ_TOL (header.scaleOffset, 63.0, 1e-9, "Non-finite losses in the scale");
+      NS_TEST_ASSERT_MSG_LT (header.scaleStep, 16.0 / 250, "Non-finite losses in the scale");
+      for (uint32_t i = 0; i < bs.GetN (); ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (file.GetLoss (i, 0), std::numeric_limits<double>::infinity (), "Infinite loss not kept");
+          NS_TEST_ASSERT_MSG_EQ (file.GetLoss (i, 1), -std::numeric_limits<double>::infinity (), "Infinite gain not kept");
+          NS_TEST_ASSERT_MSG_EQ (std::isnan (file.GetLoss (i, 2)), true, "NaN not kept");
+          for (uint32_t j = 3; j < ss.GetN (); ++j)
+            {
+              NS_TEST_ASSERT_MSG_EQ_TOL (file.GetLoss (i, j), 60.0 + j, header.scaleStep / 2 * (1 + 1e-9),
+                                         "Wrong quantized loss for " << i << "," << j);
+            }
+        }
+      file.Close ();
+      std::remove (filename.c_str ());
+    }
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Loss matrix TestSuite
+ */
+class LossMatrixPropagationLossModelTestSuite : public TestSuite
+{
+public:
+  LossMatrixPropagationLossModelTestSuite ();
+};
+
+LossMatrixPropagationLossModelTestSuite::LossMatrixPropagationLossModelTestSuite ()
+  : TestSuite ("loss-matrix", UNIT)
+{
+  AddTestCase (new LossMatrixRoundTripTestCase, TestCase::QUICK);
+  AddTestCase (new LossMatrixEncodingTestCase, TestCase::QUICK);
+  AddTestCase (new LossMatrixNonFiniteTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static LossMatrixPropagationLossModelTestSuite g_lossMatrixTestSuite;
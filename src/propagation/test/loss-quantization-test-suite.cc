@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/loss-quantization.h"
+#include "ns3/coverage-tile-cache.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LossQuantizationTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the rounding error and the clamping of the codes
+ */
+class LossQuantizationTestCase : public TestCase
+{
+public:
+  LossQuantizationTestCase ();
+  virtual ~LossQuantizationTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Encode and decode a range of losses
+   * \param encoding the storage format
+   * \param maxStep the largest acceptable step [dB]
+   */
+  void RoundTrip (LossQuantization::Encoding encoding, double maxStep);
+  /**
+   * Encode and decode infinite and NaN losses
+   * \param encoding the storage format
+   */
+  void NonFinite (LossQuantization::Encoding encoding);
+};
+
+LossQuantizationTestCase::LossQuantizationTestCase ()
+  : TestCase ("Check the loss codes")
+{
+}
+
+LossQuantizationTestCase::~LossQuantizationTestCase ()
+{
+}
+
+void
+LossQuantizationTestCase::RoundTrip (LossQuantization::Encoding encoding, double maxStep)
+{
+  std::vector<double> loss;
+  for (double l = 40.0; l <= 250.0; l += 0.0137)
+    {
+      loss.push_back (l);
+    }
+  loss.push_back (250.0);
+  uint32_t n = loss.size ();
+  double min;
+  double max;
+  LossQuantization::GetRange (loss.data (), n, min, max);
+  NS_TEST_ASSERT_MSG_EQ (min, 40.0, "Wrong minimum");
+  NS_TEST_ASSERT_MSG_EQ (max, 250.0, "Wrong maximum");
+  LossQuantization::Scale scale = LossQuantization::MakeScale (encoding, min, max);
+  NS_TEST_ASSERT_MSG_LT (scale.step, maxStep, "Step too coarse");
+
+  std::vector<char> data (n * LossQuantization::GetValueSize (encoding));
+  std::vector<double> decoded (n);
+  LossQuantization::Encode (encoding, loss.data (), data.data (), n, scale);
+  LossQuantization::Decode (encoding, data.data (), decoded.data (), n, scale);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (decoded[i], loss[i], scale.step / 2 * (1 + 1e-9), "Rounding error above half a step");
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (decoded[0], 40.0, 1e-9, "Minimum not exact");
+  NS_TEST_ASSERT_MSG_EQ_TOL (decoded[n - 1], 250.0, 1e-9, "Maximum not exact");
+
+  // out of the range of the scale
+  const double outside[2] = { 10.0, 300.0 };
+  double clamped[2];
+  LossQuantization::Encode (encoding, outside, data.data (), 2, scale);
+  LossQuantization::Decode (encoding, data.data (), clamped, 2, scale);
+  NS_TEST_ASSERT_MSG_EQ_TOL (clamped[0], 40.0, 1e-9, "Low value not clamped");
+  NS_TEST_ASSERT_MSG_EQ_TOL (clamped[1], 250.0, 1e-9, "High value not clamped");
+}
+
+void
+LossQuantizationTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_TEST_ASSERT_MSG_EQ (LossQuantization::GetValueSize (LossQuantization::Double), 8, "Wrong double size");
+  NS_TEST_ASSERT_MSG_EQ (LossQuantization::GetValueSize (LossQuantization::Uint16), 2, "Wrong uint16 size");
+  NS_TEST_ASSERT_MSG_EQ (LossQuantization::GetValueSize (LossQuantization::Uint8), 1, "Wrong uint8 size");
+  RoundTrip (LossQuantization::Uint16, 0.0033);
+  // three codes are reserved for the non-finite values
+  RoundTrip (LossQuantization::Uint8, 0.84);
+
+  // a constant table keeps its value
+  double constant[3] = { 97.5, 97.5, 97.5 };
+  uint16_t code[3];
+  LossQuantization::Scale scale = LossQuantization::MakeScale (LossQuantization::Uint16, 97.5, 97.5);
+  LossQuantization::Encode (constant, code, 3, scale);
+  LossQuantization::Decode (code, constant, 3, scale);
+  NS_TEST_ASSERT_MSG_EQ (constant[2], 97.5, "Constant table changed");
+
+  NonFinite (LossQuantization::Uint16);
+  NonFinite (LossQuantization::Uint8);
+}
+
+void
+LossQuantizationTestCase::NonFinite (LossQuantization::Encoding encoding)
+{
+  const double inf = std::numeric_limits<double>::infinity ();
+  const double nan = std::numeric_limits<double>::quiet_NaN ();
+
+  // the non-finite values are kept, and left out of the scale
+  const double loss[6] = { 150.0, inf, 40.0, -inf, nan, 250.0 };
+  double min;
+  double max;
+  LossQuantization::GetRange (loss, 6, min, max);
+  NS_TEST_ASSERT_MSG_EQ (min, 40.0, "Non-finite minimum");
+  NS_TEST_ASSERT_MSG_EQ (max, 250.0, "Non-finite maximum");
+  LossQuantization::Scale scale = LossQuantization::MakeScale (encoding, min, max);
+  std::vector<char> data (6 * LossQuantization::GetValueSize (encoding));
+  double decoded[6];
+  LossQuantization::Encode (encoding, loss, data.data (), 6, scale);
+  LossQuantization::Decode (encoding, data.data (), decoded, 6, scale);
+  NS_TEST_ASSERT_MSG_EQ_TOL (decoded[0], 150.0, scale.step / 2, "Finite value changed");
+  NS_TEST_ASSERT_MSG_EQ (decoded[1], inf, "+inf not kept");
+  NS_TEST_ASSERT_MSG_EQ_TOL (decoded[2], 40.0, 1e-9, "Minimum not exact");
+  NS_TEST_ASSERT_MSG_EQ (decoded[3], -inf, "-inf not kept");
+  NS_TEST_ASSERT_MSG_EQ (std::isnan (decoded[4]), true, "NaN not kept");
+  NS_TEST_ASSERT_MSG_EQ_TOL (decoded[5], 250.0, 1e-9, "Maximum not exact");
+
+  // a table without a finite value
+  const double none[3] = { nan, inf, -inf };
+  LossQuantization::GetRange (none, 3, min, max);
+  scale = LossQuantization::MakeScale (encoding, min, max);
+  NS_TEST_ASSERT_MSG_EQ (scale.offset, 0.0, "Scale of non-finite values");
+  NS_TEST_ASSERT_MSG_EQ (scale.step, 1.0, "Scale of non-finite values");
+  LossQuantization::Encode (encoding, none, data.data (), 3, scale);
+  LossQuantization::Decode (encoding, data.data (), decoded, 3, scale);
+  NS_TEST_ASSERT_MSG_EQ (std::isnan (decoded[0]), true, "NaN not kept");
+  NS_TEST_ASSERT_MSG_EQ (decoded[1], inf, "+inf not kept");
+  NS_TEST_ASSERT_MSG_EQ (decoded[2], -inf, "-inf not kept");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Compare the regions of a quantized tile cache with those of a
+ * double one
+ */
+class CoverageTileCacheEncodingTestCase : public TestCase
+{
+public:
+  CoverageTileCacheEncodingTestCase ();
+  virtual ~CoverageTileCacheEncodingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CoverageTileCacheEncodingTestCase::CoverageTileCacheEncodingTestCase ()
+  : TestCase ("Check the quantized coverage tiles")
+{
+}
+
+CoverageTileCacheEncodingTestCase::~CoverageTileCacheEncodingTestCase ()
+{
+}
+
+void
+CoverageTileCacheEncodingTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+  sui->SetTerrain (SUIPropagationLossModel::A);
+  const LossQuantization::Encoding encodings[3] = {
+    LossQuantization::Double, LossQuantization::Uint16, LossQuantization::Uint8
+  };
+  std::vector<Ptr<CoverageTileCache> > caches;
+  std::vector<CoverageTileCache::Region> regions;
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      Ptr<CoverageTileCache> cache = CreateObject<CoverageTileCache> ();
+      cache->SetAttribute ("TileSize", UintegerValue (32));
+      cache->SetAttribute ("Encoding", EnumValue (encodings[k]));
+      cache->SetSite (Vector (100.0, 50.0, 30.0), sui);
+      regions.push_back (cache->GetRegion (-1280.0, -1280.0, 1280.0, 1280.0, 2));
+      caches.push_back (cache);
+    }
+  NS_TEST_ASSERT_MSG_EQ (caches[1]->GetBytes () * 4, caches[0]->GetBytes (), "Uint16 tiles not four times smaller");
+  NS_TEST_ASSERT_MSG_EQ (caches[2]->GetBytes () * 8, caches[0]->GetBytes (), "Uint8 tiles not eight times smaller");
+
+  // the viewport covers whole tiles, whose steps are below those of the region
+  double min;
+  double max;
+  LossQuantization::GetRange (regions[0].loss.data (), regions[0].loss.size (), min, max);
+  for (uint32_t k = 1; k < 3; ++k)
+    {
+      double step = LossQuantization::MakeScale (encodings[k], min, max).step;
+      NS_TEST_ASSERT_MSG_EQ (regions[k].loss.size (), regions[0].loss.size (), "Wrong region size");
+      for (uint32_t i = 0; i < regions[0].loss.size (); ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ_TOL (regions[k].loss[i], regions[0].loss[i], step / 2 * (1 + 1e-9),
+                                     "Quantized loss too far at cell " << i);
+        }
+    }
+
+  // a new encoding drops the tiles
+  caches[1]->SetAttribute ("Encoding", EnumValue (LossQuantization::Uint8));
+  CoverageTileCache::Region region = caches[1]->GetRegion (-1280.0, -1280.0, 1280.0, 1280.0, 2);
+  NS_TEST_ASSERT_MSG_EQ ((region.loss == regions[2].loss), true, "Wrong losses after the new encoding");
+  NS_TEST_ASSERT_MSG_EQ (caches[1]->GetStatistics ().invalidations, 1, "Tiles kept across encodings");
+  NS_TEST_ASSERT_MSG_EQ (caches[1]->GetBytes (), caches[2]->GetBytes (), "Wrong size after the new encoding");
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      caches[k]->Dispose ();
+    }
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Loss quantization TestSuite
+ */
+class LossQuantizationTestSuite : public TestSuite
+{
+public:
+  LossQuantizationTestSuite ();
+};
+
+LossQuantizationTestSuite::LossQuantizationTestSuite ()
+  : TestSuite ("loss-quantization", UNIT)
+{
+  AddTestCase (new LossQuantizationTestCase, TestCase::QUICK);
+  AddTestCase (new CoverageTileCacheEncodingTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static LossQuantizationTestSuite g_lossQuantizationTestSuite;
@@ -0,0 +1,371 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include "ns3/loss-query-server.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LossQueryServerTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the answers of a LossQueryServer, and that concurrent
+ * requests share a batch
+ */
+class LossQueryServerTestCase : public TestCase
+{
+public:
+  LossQueryServerTestCase ();
+  virtual ~LossQueryServerTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param path the socket path
+   * \returns a connected socket
+   */
+  static int Connect (std::string path);
+  /**
+   * Send a distance request without waiting for its response
+   * \param fd the connection
+   * \param model the index of the model
+   * \param id the request id
+   * \param distance the link distances [m]
+   */
+  static void Send (int fd, uint16_t model, uint64_t id, const std::vector<double> &distance);
+};
+
+LossQueryServerTestCase::LossQueryServerTestCase ()
+  : TestCase ("Loss queries over a Unix domain socket")
+{
+}
+
+LossQueryServerTestCase::~LossQueryServerTestCase ()
+{
+}
+
+int
+LossQueryServerTestCase::Connect (std::string path)
+{
+  int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address;
+  std::memset (&address, 0, sizeof (address));
+  address.sun_family = AF_UNIX;
+  std::strncpy (address.sun_path, path.c_str (), sizeof (address.sun_path) - 1);
+  if (connect (fd, reinterpret_cast<struct sockaddr *> (&address), sizeof (address)) != 0)
+    {
+      close (fd);
+      return -1;
+    }
+  return fd;
+}
+
+void
+LossQueryServerTestCase::Send (int fd, uint16_t model, uint64_t id, const std::vector<double> &distance)
+{
+  LossQueryRequest request;
+  request.magic = LOSS_QUERY_REQUEST_MAGIC;
+  request.version = LOSS_QUERY_VERSION;
+  request.model = model;
+  request.kind = LOSS_QUERY_DISTANCES;
+  request.count = distance.size ();
+  request.id = id;
+  std::vector<uint8_t> frame (sizeof (request) + distance.size () * sizeof (double));
+  std::memcpy (frame.data (), &request, sizeof (request));
+  std::memcpy (frame.data () + sizeof (request), distance.data (), distance.size () * sizeof (double));
+  ssize_t sent = send (fd, frame.data (), frame.size (), MSG_NOSIGNAL);
+  (void) sent;
+}
+
+void
+LossQueryServerTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Rural);
+  Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+  sui->SetTerrain (SUIPropagationLossModel::C);
+
+  std::vector<double> distance;
+  for (uint32_t i = 0; i < 500; ++i)
+    {
+      distance.push_back (100.0 + 37.0 * i);
+    }
+  std::vector<double> ericssonLoss (distance.size ());
+  std::vector<double> suiLoss (distance.size ());
+  ericsson->GetLossBatch (distance.data (), ericssonLoss.data (), distance.size ());
+  sui->GetLossBatch (distance.data (), suiLoss.data (), distance.size ());
+
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  mma->SetPosition (Vector (10.0, 20.0, 30.0));
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+  mmb->SetPosition (Vector (1510.0, -380.0, 2.0));
+  double positions[6] = { 10.0, 20.0, 30.0, 1510.0, -380.0, 2.0 };
+  double positionLoss = ericsson->CalcRxPower (0.0, mma, mmb);
+
+  std::ostringstream path;
+  path << "/tmp/ns3-loss-query-test-" << getpid () << ".sock";
+  Ptr<LossQueryServer> server = CreateObject<LossQueryServer> ();
+  server->SetAttribute ("SocketPath", StringValue (path.str ()));
+  NS_TEST_ASSERT_MSG_EQ (server->AddModel (ericsson), 0, "Unexpected model index");
+  NS_TEST_ASSERT_MSG_EQ (server->AddModel (sui), 1, "Unexpected model index");
+  server->SetAttribute ("MaxOutbox", UintegerValue (1 << 20));
+  server->Start ();
+
+  // two connections with two requests each, all sent before the server
+  // reads: one batch per model
+  int fd[2] = { Connect (path.str ()), Connect (path.str ()) };
+  NS_TEST_ASSERT_MSG_EQ ((fd[0] >= 0 && fd[1] >= 0), true, "Can't connect");
+  std::vector<double> head (distance.begin (), distance.begin () + 200);
+  std::vector<double> tail (distance.begin () + 200, distance.end ());
+  Send (fd[0], 0, 10, head);
+  Send (fd[1], 0, 20, tail);
+  Send (fd[0], 1, 11, distance);
+  Send (fd[1], 7, 21, distance);
+  server->RunOnce (1000);
+  NS_TEST_ASSERT_MSG_EQ (server->GetNBatches (), 2, "Requests not batched per model");
+
+  LossQueryResponse response;
+  std::vector<double> loss (distance.size ());
+  NS_TEST_ASSERT_MSG_EQ (recv (fd[0], &response, sizeof (response), MSG_WAITALL), sizeof (response), "No response");
+  NS_TEST_ASSERT_MSG_EQ (response.id, 10, "Unexpected response order");
+  NS_TEST_ASSERT_MSG_EQ (response.count, head.size (), "Unexpected response size");
+  recv (fd[0], loss.data (), head.size () * sizeof (double), MSG_WAITALL);
+  for (uint32_t i = 0; i < head.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (loss[i], ericssonLoss[i], "Wrong Ericsson loss at " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (recv (fd[0], &response, sizeof (response), MSG_WAITALL), sizeof (response), "No response");
+  NS_TEST_ASSERT_MSG_EQ (response.id, 11, "Unexpected response order");
+  recv (fd[0], loss.data (), distance.size () * sizeof (double), MSG_WAITALL);
+  for (uint32_t i = 0; i < distance.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (loss[i], suiLoss[i], "Wrong SUI loss at " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (recv (fd[1], &response, sizeof (response), MSG_WAITALL), sizeof (response), "No response");
+  NS_TEST_ASSERT_MSG_EQ (response.id, 20, "Unexpected response order");
+  recv (fd[1], loss.data (), tail.size () * sizeof (double), MSG_WAITALL);
+  for (uint32_t i = 0; i < tail.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (loss[i], ericssonLoss[head.size () + i], "Wrong Ericsson loss at " << head.size () + i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (recv (fd[1], &response, sizeof (response), MSG_WAITALL), sizeof (response), "No response");
+  NS_TEST_ASSERT_MSG_EQ (response.status, LOSS_QUERY_UNKNOWN_MODEL, "Unknown model answered");
+  NS_TEST_ASSERT_MSG_EQ (response.count, 0, "Losses for an unknown model");
+  close (fd[0]);
+  close (fd[1]);
+
+  // a client sending a frame within every window doesn't hold the batch
+  // back past the window of the first request
+  const int64_t window = 50;
+  server->SetAttribute ("BatchWindow", TimeValue (MilliSeconds (window)));
+  int busy = Connect (path.str ());
+  Send (busy, 0, 50, head);
+  std::atomic<bool> sending (true);
+  std::thread sender ([busy, &sending, &head] () {
+                        for (uint64_t id = 51; sending && id < 550; ++id)
+                          {
+                            Send (busy, 0, id, head);
+                            std::this_thread::sleep_for (std::chrono::milliseconds (5));
+                          }
+                      });
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  server->RunOnce (1000);
+  int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - start).count ();
+  sending = false;
+  sender.join ();
+  NS_TEST_ASSERT_MSG_LT (elapsed, 10 * window, "Busy client held the batch back");
+  NS_TEST_ASSERT_MSG_EQ (recv (busy, &response, sizeof (response), MSG_WAITALL), sizeof (response), "No response");
+  NS_TEST_ASSERT_MSG_EQ (response.id, 50, "Unexpected response order");
+  close (busy);
+  server->SetAttribute ("BatchWindow", TimeValue (MilliSeconds (0)));
+
+  // a client flooding the server is read MaxInbox bytes per batch, the
+  // rest waiting in its socket, and still gets every response in order
+  const uint32_t maxInbox = 64 << 10;
+  const uint32_t nFlood = 200;
+  const uint32_t frame = sizeof (LossQueryRequest) + distance.size () * sizeof (double);
+  server->SetAttribute ("MaxInbox", UintegerValue (maxInbox));
+
+  // a burst the socket holds at once: only MaxInbox bytes are answered
+  int burst = Connect (path.str ());
+  for (uint32_t k = 0; k < 20; ++k)
+    {
+      Send (burst, 0, 2000 + k, distance);
+    }
+  server->RunOnce (0);
+  size_t answer = sizeof (LossQueryResponse) + distance.size () * sizeof (double);
+  std::vector<uint8_t> burstAnswers (20 * answer);
+  size_t burstBytes = 0;
+  ssize_t burstReceived;
+  while ((burstReceived = recv (burst, burstAnswers.data () + burstBytes, burstAnswers.size () - burstBytes,
+                                MSG_DONTWAIT)) > 0)
+    {
+      burstBytes += burstReceived;
+    }
+  NS_TEST_ASSERT_MSG_EQ (burstBytes, (maxInbox / frame) * answer, "Burst not cut at MaxInbox");
+  NS_TEST_ASSERT_MSG_LT (server->GetNBufferedBytes (), maxInbox + frame, "Requests buffered past MaxInbox");
+  close (burst);
+
+  int flood = Connect (path.str ());
+  std::thread flooder ([flood, nFlood, &distance] () {
+                         for (uint32_t k = 0; k < nFlood; ++k)
+                           {
+                             Send (flood, 0, 1000 + k, distance);
+                           }
+                       });
+  std::atomic<uint32_t> answered (0);
+  std::thread reader ([flood, nFlood, &distance, &answered] () {
+                        LossQueryResponse header;
+                        std::vector<double> losses (distance.size ());
+                        for (uint32_t k = 0; k < nFlood; ++k)
+                          {
+                            if (recv (flood, &header, sizeof (header), MSG_WAITALL) != sizeof (header)
+                                || header.id != 1000 + k
+                                || recv (flood, losses.data (), header.count * sizeof (double), MSG_WAITALL)
+                                != static_cast<ssize_t> (header.count * sizeof (double)))
+                              {
+                                return;
+                              }
+                            answered++;
+                          }
+                      });
+  uint64_t batches = server->GetNBatches ();
+  uint64_t buffered = 0;
+  for (uint32_t round = 0; round < 10000 && answered < nFlood; ++round)
+    {
+      server->RunOnce (10);
+      buffered = std::max (buffered, server->GetNBufferedBytes ());
+    }
+  flooder.join ();
+  reader.join ();
+  close (flood);
+  NS_TEST_ASSERT_MSG_EQ (answered, nFlood, "Flooding client not answered in order");
+  NS_TEST_ASSERT_MSG_LT (buffered, maxInbox + frame, "Requests buffered past MaxInbox");
+  NS_TEST_ASSERT_MSG_GT (server->GetNBatches () - batches, nFlood * frame / maxInbox, "Flood read in too few batches");
+  server->SetAttribute ("MaxInbox", UintegerValue (1 << 20));
+
+  // the blocking client, with the server on its own thread
+  std::thread thread (&LossQueryServer::Run, PeekPointer (server));
+  LossQueryClient client;
+  NS_TEST_ASSERT_MSG_EQ (client.Connect (path.str ()), true, "Client can't connect");
+  NS_TEST_ASSERT_MSG_EQ (client.Query (1, distance.data (), loss.data (), distance.size ()), LOSS_QUERY_OK, "Query failed");
+  for (uint32_t i = 0; i < distance.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (loss[i], suiLoss[i], "Wrong SUI loss at " << i);
+    }
+  double single;
+  NS_TEST_ASSERT_MSG_EQ (client.QueryPositions (0, positions, &single, 1), LOSS_QUERY_OK, "Position query failed");
+  NS_TEST_ASSERT_MSG_EQ_TOL (single, positionLoss, 1e-9, "Wrong loss of a position query");
+  NS_TEST_ASSERT_MSG_EQ (client.Query (3, distance.data (), loss.data (), 1), LOSS_QUERY_UNKNOWN_MODEL, "Unknown model answered");
+
+  // a malformed frame closes the connection
+  int bad = Connect (path.str ());
+  uint32_t garbage[6] = { 0, 0, 0, 0, 0, 0 };
+  send (bad, garbage, sizeof (garbage), 0);
+  NS_TEST_ASSERT_MSG_EQ (recv (bad, &response, sizeof (response), MSG_WAITALL), 0, "Malformed frame answered");
+  close (bad);
+
+  // a client that shuts down its sending side still gets its responses,
+  // larger than the socket buffer, then the end of the stream
+  std::vector<double> large (20000, 1234.5);
+  int half = Connect (path.str ());
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      Send (half, 0, 30 + k, large);
+    }
+  shutdown (half, SHUT_WR);
+  loss.resize (large.size ());
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      NS_TEST_ASSERT_MSG_EQ (recv (half, &response, sizeof (response), MSG_WAITALL), sizeof (response),
+                             "No response after the shutdown");
+      NS_TEST_ASSERT_MSG_EQ (response.id, 30 + k, "Unexpected response order");
+      NS_TEST_ASSERT_MSG_EQ (recv (half, loss.data (), large.size () * sizeof (double), MSG_WAITALL),
+                             static_cast<ssize_t> (large.size () * sizeof (double)), "Truncated response");
+    }
+  NS_TEST_ASSERT_MSG_EQ (recv (half, &response, sizeof (response), MSG_WAITALL), 0, "Connection left open");
+  close (half);
+
+  // a client that doesn't read its responses neither blocks the others,
+  // nor keeps more than MaxOutbox queued
+  std::vector<double> huge (100000, 1234.5);
+  int lazy = Connect (path.str ());
+  for (uint32_t k = 0; k < 8; ++k)
+    {
+      Send (lazy, 0, 40 + k, huge);
+    }
+  NS_TEST_ASSERT_MSG_EQ (client.Query (1, distance.data (), loss.data (), distance.size ()), LOSS_QUERY_OK,
+                         "Query blocked by a client that doesn't read");
+  std::vector<uint8_t> drain (1 << 16);
+  size_t drained = 0;
+  ssize_t received;
+  while ((received = recv (lazy, drain.data (), drain.size (), 0)) > 0)
+    {
+      drained += received;
+    }
+  NS_TEST_ASSERT_MSG_LT (drained, 8 * (sizeof (response) + huge.size () * sizeof (double)),
+                         "Client that doesn't read not disconnected");
+  close (lazy);
+
+  server->Stop ();
+  thread.join ();
+  client.Close ();
+  server->Dispose ();
+  NS_TEST_ASSERT_MSG_EQ (access (path.str ().c_str (), F_OK), -1, "Socket file left behind");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Loss query server TestSuite
+ */
+class LossQueryServerTestSuite : public TestSuite
+{
+public:
+  LossQueryServerTestSuite ();
+};
+
+LossQueryServerTestSuite::LossQueryServerTestSuite ()
+  : TestSuite ("loss-query-server", UNIT)
+{
+  AddTestCase (new LossQueryServerTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static LossQueryServerTestSuite g_lossQueryServerTestSuite;
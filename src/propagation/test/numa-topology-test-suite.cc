@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/numa-topology.h"
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("NumaTopologyTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the CPU lists, a topology read from a sysfs-like
+ * directory, and the first-touch buffers
+ */
+class NumaTopologyTestCase : public TestCase
+{
+public:
+  NumaTopologyTestCase ();
+  virtual ~NumaTopologyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NumaTopologyTestCase::NumaTopologyTestCase ()
+  : TestCase ("Check the NUMA topology")
+{
+}
+
+NumaTopologyTestCase::~NumaTopologyTestCase ()
+{
+}
+
+void
+NumaTopologyTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector<uint32_t> cpus = NumaTopology::ParseCpuList ("8-10,2,0-1\n");
+  NS_TEST_ASSERT_MSG_EQ (cpus.size (), 6, "Wrong number of CPUs");
+  NS_TEST_ASSERT_MSG_EQ (cpus[0], 0, "CPUs not sorted");
+  NS_TEST_ASSERT_MSG_EQ (cpus[2], 2, "Missing single CPU");
+  NS_TEST_ASSERT_MSG_EQ (cpus[5], 10, "Missing end of range");
+  NS_TEST_ASSERT_MSG_EQ (NumaTopology::ParseCpuList ("").size (), 0, "CPUs in an empty list");
+
+  // node1 has no CPU, and the ids have a hole
+  std::string root = CreateTempDirFilename ("node");
+  mkdir (root.c_str (), 0755);
+  const char *names[3] = { "node0", "node1", "node3" };
+  const char *lists[3] = { "0-3,8-11", "", "4-7,12-15" };
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      std::string dir = root + "/" + names[k];
+      mkdir (dir.c_str (), 0755);
+      std::ofstream ((dir + "/cpulist").c_str ()) << lists[k] << std::endl;
+    }
+  NumaTopology topology (root);
+  NS_TEST_ASSERT_MSG_EQ (topology.GetNNodes (), 2, "Wrong number of nodes");
+  NS_TEST_ASSERT_MSG_EQ (topology.GetCpus (0).size (), 8, "Wrong CPUs of node 0");
+  NS_TEST_ASSERT_MSG_EQ (topology.GetCpus (1)[0], 4, "Wrong CPUs of node 3");
+  NS_TEST_ASSERT_MSG_EQ (topology.GetCpus (1)[7], 15, "Wrong CPUs of node 3");
+  for (uint32_t k = 0; k < 3; ++k)
+    {
+      std::string dir = root + "/" + names[k];
+      std::remove ((dir + "/cpulist").c_str ());
+      rmdir (dir.c_str ());
+    }
+  rmdir (root.c_str ());
+
+  NumaTopology missing (root);
+  NS_TEST_ASSERT_MSG_EQ (missing.GetNNodes (), 1, "No single node without sysfs");
+  NS_TEST_ASSERT_MSG_GT (missing.GetCpus (0).size (), 0, "No CPU without sysfs");
+  NS_TEST_ASSERT_MSG_GT (NumaTopology::GetSystem ().GetNNodes (), 0, "No node on this machine");
+
+  FirstTouchBuffer buffer;
+  buffer.Allocate (1000 * sizeof (double));
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetSize (), 1000 * sizeof (double), "Wrong buffer size");
+  double *data = buffer.Get<double> ();
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      data[i] = i;
+    }
+  NS_TEST_ASSERT_MSG_EQ (data[999], 999.0, "Buffer not writable");
+  buffer.Free ();
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetSize (), 0, "Buffer not freed");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief NUMA topology TestSuite
+ */
+class NumaTopologyTestSuite : public TestSuite
+{
+public:
+  NumaTopologyTestSuite ();
+};
+
+NumaTopologyTestSuite::NumaTopologyTestSuite ()
+  : TestSuite ("numa-topology", UNIT)
+{
+  AddTestCase (new NumaTopologyTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static NumaTopologyTestSuite g_numaTopologyTestSuite;
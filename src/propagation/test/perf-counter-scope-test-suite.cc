@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/perf-counter-scope.h"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("PerfCounterScopeTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check that the scopes of the Ericsson model are recorded when
+ * the counters are enabled, and only then
+ *
+ * Hosts without hardware counters (virtual machines, restrictive
+ * perf_event_paranoid) only check that enabling is refused.
+ */
+class PerfCounterScopeTestCase : public TestCase
+{
+public:
+  PerfCounterScopeTestCase ();
+  virtual ~PerfCounterScopeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PerfCounterScopeTestCase::PerfCounterScopeTestCase ()
+  : TestCase ("Hardware counters around the Ericsson evaluation paths")
+{
+}
+
+PerfCounterScopeTestCase::~PerfCounterScopeTestCase ()
+{
+}
+
+void
+PerfCounterScopeTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Rural);
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  mma->SetPosition (Vector (0.0, 0.0, 50.0));
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+  mmb->SetPosition (Vector (1500.0, 0.0, 3.0));
+  std::vector<double> distance (1000, 1500.0);
+  std::vector<double> loss (distance.size ());
+
+  PerfCounters::Reset ();
+  ericsson->CalcRxPower (0.0, mma, mmb);
+  std::ostringstream disabled;
+  PerfCounters::Print (disabled);
+  NS_TEST_ASSERT_MSG_EQ (disabled.str ().find ("Ericsson"), std::string::npos, "Disabled scope recorded");
+
+  PerfCounters::Enable (true);
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::IsEnabled (), PerfCounters::IsAvailable (), "Enabled without counters");
+  if (!PerfCounters::IsEnabled ())
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < 10; ++i)
+    {
+      ericsson->CalcRxPower (0.0, mma, mmb);
+    }
+  ericsson->GetLossBatch (distance.data (), loss.data (), distance.size ());
+  PerfCounters::Enable (false);
+
+  std::ostringstream enabled;
+  PerfCounters::Print (enabled);
+  NS_LOG_INFO (enabled.str ());
+  NS_TEST_ASSERT_MSG_NE (enabled.str ().find (" scalar "), std::string::npos,
+                         "Scalar path not recorded");
+  NS_TEST_ASSERT_MSG_NE (enabled.str ().find (" batch "), std::string::npos,
+                         "Batch path not recorded");
+  PerfCounters::Reset ();
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the scaling of multiplexed counters on synthetic group
+ * reads whose ratio of time enabled over time running changes between
+ * the start and the end of a scope
+ */
+class PerfCountersMultiplexTestCase : public TestCase
+{
+public:
+  PerfCountersMultiplexTestCase ();
+  virtual ~PerfCountersMultiplexTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+PerfCountersMultiplexTestCase::PerfCountersMultiplexTestCase ()
+  : TestCase ("Scale the differences of multiplexed counters")
+{
+}
+
+PerfCountersMultiplexTestCase::~PerfCountersMultiplexTestCase ()
+{
+}
+
+void
+PerfCountersMultiplexTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // counters, time enabled, time running, then cycles, instructions,
+  // cache misses and branch misses
+  const uint64_t start[3 + PerfCounters::NUM_COUNTERS] = { PerfCounters::NUM_COUNTERS, 2000, 1000, 10000, 30000, 100, 50 };
+  const uint64_t end[3 + PerfCounters::NUM_COUNTERS] = { PerfCounters::NUM_COUNTERS, 3000, 2000, 12000, 33000, 110, 60 };
+  PerfCounters::Reading first;
+  PerfCounters::Reading second;
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::Parse (start, first), true, "Start not parsed");
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::Parse (end, second), true, "End not parsed");
+
+  // the ratio falls from 2 to 1.5: the scaled totals would shrink, while
+  // the group counted during the whole scope
+  uint64_t delta[PerfCounters::NUM_COUNTERS];
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::GetDelta (first, second, delta), true, "No delta");
+  NS_TEST_ASSERT_MSG_EQ (delta[PerfCounters::CYCLES], 2000, "Cycles not the raw difference");
+  NS_TEST_ASSERT_MSG_EQ (delta[PerfCounters::INSTRUCTIONS], 3000, "Instructions not the raw difference");
+  NS_TEST_ASSERT_MSG_EQ (delta[PerfCounters::CACHE_MISSES], 10, "Cache misses not the raw difference");
+  NS_TEST_ASSERT_MSG_EQ (delta[PerfCounters::BRANCH_MISSES], 10, "Branch misses not the raw difference");
+
+  // the ratio rises from 1 to 2: counting a quarter of the scope, scale by 4
+  const uint64_t later[3 + PerfCounters::NUM_COUNTERS] = { PerfCounters::NUM_COUNTERS, 5000, 2500, 12500, 34000, 111, 62 };
+  PerfCounters::Reading third;
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::Parse (later, third), true, "Later read not parsed");
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::GetDelta (second, third, delta), true, "No delta");
+  NS_TEST_ASSERT_MSG_EQ (delta[PerfCounters::CYCLES], 2000, "Cycles not scaled by the ratio of the scope");
+  NS_TEST_ASSERT_MSG_EQ (delta[PerfCounters::INSTRUCTIONS], 4000, "Instructions not scaled by the ratio of the scope");
+  NS_TEST_ASSERT_MSG_EQ (delta[PerfCounters::CACHE_MISSES], 4, "Cache misses not scaled by the ratio of the scope");
+  NS_TEST_ASSERT_MSG_EQ (delta[PerfCounters::BRANCH_MISSES], 8, "Branch misses not scaled by the ratio of the scope");
+
+  // a scope during which the group never had the PMU is not recorded
+  const uint64_t idle[3 + PerfCounters::NUM_COUNTERS] = { PerfCounters::NUM_COUNTERS, 6000, 2500, 12500, 34000, 111, 62 };
+  PerfCounters::Reading fourth;
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::Parse (idle, fourth), true, "Idle read not parsed");
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::GetDelta (third, fourth, delta), false, "Delta without running time");
+
+  // a buffer of another group is refused
+  const uint64_t other[3 + PerfCounters::NUM_COUNTERS] = { 2, 6000, 2500, 12500, 34000, 111, 62 };
+  NS_TEST_ASSERT_MSG_EQ (PerfCounters::Parse (other, fourth), false, "Buffer of another group parsed");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check that the samples recorded by several threads, for several
+ * models of one type, are merged by Print
+ *
+ * The samples are recorded directly, so this runs without hardware
+ * counters.
+ */
+class PerfCountersMergeTestCase : public TestCase
+{
+public:
+  PerfCountersMergeTestCase ();
+  virtual ~PerfCountersMergeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Record samples
+   * \param model the model
+   * \param n the number of samples
+   */
+  static void RecordSamples (const Object *model, uint32_t n);
+};
+
+PerfCountersMergeTestCase::PerfCountersMergeTestCase ()
+  : TestCase ("Merge the samples of several threads")
+{
+}
+
+PerfCountersMergeTestCase::~PerfCountersMergeTestCase ()
+{
+}
+
+void
+PerfCountersMergeTestCase::RecordSamples (const Object *model, uint32_t n)
+{
+  const uint64_t delta[PerfCounters::NUM_COUNTERS] = { 100, 200, 3, 4 };
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      PerfCounters::Record ("merged", model, 2, 10, delta);
+    }
+}
+
+void
+PerfCountersMergeTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<EricssonPropagationLossModel> first = CreateObject<EricssonPropagationLossModel> ();
+  Ptr<EricssonPropagationLossModel> second = CreateObject<EricssonPropagationLossModel> ();
+  PerfCounters::Reset ();
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 4; ++t)
+    {
+      threads.push_back (std::thread (&PerfCountersMergeTestCase::RecordSamples,
+                                      t % 2 ? PeekPointer (first) : PeekPointer (second), 1000));
+    }
+  // two threads exit before the others start printing
+  threads[0].join ();
+  threads[1].join ();
+  RecordSamples (PeekPointer (first), 500);
+  threads[2].join ();
+  threads[3].join ();
+
+  std::ostringstream os;
+  PerfCounters::Print (os);
+  NS_LOG_INFO (os.str ());
+  std::istringstream is (os.str ());
+  std::string line;
+  uint32_t lines = 0;
+  while (std::getline (is, line))
+    {
+      if (line.find (" merged ") == std::string::npos)
+        {
+          continue;
+        }
+      lines++;
+      std::istringstream fields (line);
+      std::string model;
+      std::string environment;
+      std::string path;
+      uint64_t calls;
+      uint64_t links;
+      double cycles;
+      double instructions;
+      fields >> model >> environment >> path >> calls >> links >> cycles >> instructions;
+      NS_TEST_ASSERT_MSG_EQ (environment, "2", "Wrong environment");
+      NS_TEST_ASSERT_MSG_EQ (calls, 4500, "Samples of some threads missing");
+      NS_TEST_ASSERT_MSG_EQ (links, 45000, "Links of some threads missing");
+      NS_TEST_ASSERT_MSG_EQ_TOL (cycles, 10.0, 1e-9, "Wrong cycles per link");
+      NS_TEST_ASSERT_MSG_EQ_TOL (instructions, 20.0, 1e-9, "Wrong instructions per link");
+    }
+  NS_TEST_ASSERT_MSG_EQ (lines, 1, "Models of one type not merged");
+
+  PerfCounters::Reset ();
+  std::ostringstream reset;
+  PerfCounters::Print (reset);
+  NS_TEST_ASSERT_MSG_EQ (reset.str ().find (" merged "), std::string::npos, "Samples not reset");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Hardware performance counters TestSuite
+ */
+class PerfCounterScopeTestSuite : public TestSuite
+{
+public:
+  PerfCounterScopeTestSuite ();
+};
+
+PerfCounterScopeTestSuite::PerfCounterScopeTestSuite ()
+  : TestSuite ("perf-counter-scope", UNIT)
+{
+  AddTestCase (new PerfCounterScopeTestCase, TestCase::QUICK);
+  AddTestCase (new PerfCountersMultiplexTestCase, TestCase::QUICK);
+  AddTestCase (new PerfCountersMergeTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static PerfCounterScopeTestSuite g_perfCounterScopeTestSuite;
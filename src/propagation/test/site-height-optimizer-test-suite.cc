@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/ericsson-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include "ns3/site-height-optimizer.h"
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("SiteHeightOptimizerTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the optimizer against an exhaustive search that changes
+ * the antenna height attribute of the model
+ */
+class SiteHeightOptimizerTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param model the model
+   * \param txAntennaHeight the name of its Tx antenna height attribute
+   * \param name TestCase name
+   */
+  SiteHeightOptimizerTestCase (Ptr<EmpiricalPropagationLossModel> model, std::string txAntennaHeight,
+                               std::string name);
+  virtual ~SiteHeightOptimizerTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  Ptr<EmpiricalPropagationLossModel> m_model; //!< the model
+  std::string m_txAntennaHeight; //!< name of the Tx antenna height attribute
+};
+
+SiteHeightOptimizerTestCase::SiteHeightOptimizerTestCase (Ptr<EmpiricalPropagationLossModel> model,
+                                                          std::string txAntennaHeight, std::string name)
+  : TestCase (name),
+    m_model (model),
+    m_txAntennaHeight (txAntennaHeight)
+{
+}
+
+SiteHeightOptimizerTestCase::~SiteHeightOptimizerTestCase ()
+{
+}
+
+void
+SiteHeightOptimizerTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // a 60 x 50 grid of 100 m cells, which doesn't fill the last tile
+  std::vector<double> x;
+  std::vector<double> y;
+  for (uint32_t i = 0; i < 60; ++i)
+    {
+      for (uint32_t j = 0; j < 50; ++j)
+        {
+          x.push_back (i * 100.0);
+          y.push_back (j * 100.0);
+        }
+    }
+  const double siteX[3] = { 0.0, 3000.0, 5900.0 };
+  const double siteY[3] = { 0.0, 2500.0, 4900.0 };
+
+  Ptr<SiteHeightOptimizer> optimizer = CreateObject<SiteHeightOptimizer> ();
+  optimizer->SetAttribute ("MinHeight", DoubleValue (20.0));
+  optimizer->SetAttribute ("MaxHeight", DoubleValue (80.0));
+  optimizer->SetAttribute ("HeightStep", DoubleValue (7.5));
+  optimizer->SetAttribute ("SensitivityDbm", DoubleValue (-85.0));
+  optimizer->SetAttribute ("TileSize", UintegerValue (512));
+  optimizer->SetAttribute ("Threads", UintegerValue (1));
+  optimizer->SetModel (m_model);
+  for (uint32_t s = 0; s < 3; ++s)
+    {
+      NS_TEST_ASSERT_MSG_EQ (optimizer->AddCandidateSite (siteX[s], siteY[s]), s, "Wrong site index");
+    }
+  optimizer->SetTargetArea (x.data (), y.data (), x.size ());
+  optimizer->Run ();
+  NS_TEST_ASSERT_MSG_EQ (optimizer->GetNHeights (), 9, "Wrong number of heights");
+  NS_TEST_ASSERT_MSG_EQ (optimizer->GetHeight (8), 80.0, "Wrong last height");
+
+  DoubleValue value;
+  m_model->GetAttribute (m_txAntennaHeight, value);
+  double height = value.Get ();
+  uint32_t n = x.size ();
+  std::vector<double> distance (n);
+  std::vector<double> loss (n);
+  double best = -1;
+  for (uint32_t s = 0; s < 3; ++s)
+    {
+      for (uint32_t k = 0; k < optimizer->GetNHeights (); ++k)
+        {
+          double h = optimizer->GetHeight (k);
+          m_model->SetAttribute (m_txAntennaHeight, DoubleValue (h));
+          double dz = h - 1.5;
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              double dx = x[i] - siteX[s];
+              double dy = y[i] - siteY[s];
+              distance[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+            }
+          m_model->GetLossBatch (distance.data (), loss.data (), n);
+          uint32_t covered = 0;
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              covered += 43.0 + loss[i] >= -85.0;
+            }
+          double coverage = static_cast<double> (covered) / n;
+          NS_TEST_ASSERT_MSG_EQ (optimizer->GetCoverage (s, k), coverage,
+                                 "Wrong coverage of site " << s << " at " << h << " m");
+          best = std::max (best, coverage);
+        }
+    }
+  m_model->SetAttribute (m_txAntennaHeight, DoubleValue (height));
+  NS_TEST_ASSERT_MSG_EQ (optimizer->GetBestCoverage (), best, "Wrong best coverage");
+  NS_TEST_ASSERT_MSG_GT (best, 0.0, "Nothing covered");
+  NS_TEST_ASSERT_MSG_LT (best, 1.0, "Everything covered");
+  // the central site reaches the most of the grid
+  NS_TEST_ASSERT_MSG_EQ (optimizer->GetBestSite (), 1, "Wrong best site");
+  for (uint32_t k = 0; k < optimizer->GetNHeights (); ++k)
+    {
+      if (optimizer->GetCoverage (1, k) == best)
+        {
+          NS_TEST_ASSERT_MSG_EQ (optimizer->GetBestHeight (), optimizer->GetHeight (k), "Not the lowest best height");
+          break;
+        }
+    }
+
+  // the threads share the units but find the same counts
+  std::vector<double> coverage;
+  for (uint32_t s = 0; s < 3; ++s)
+    {
+      for (uint32_t k = 0; k < optimizer->GetNHeights (); ++k)
+        {
+          coverage.push_back (optimizer->GetCoverage (s, k));
+        }
+    }
+  optimizer->SetAttribute ("Threads", UintegerValue (4));
+  optimizer->SetAttribute ("TileSize", UintegerValue (97));
+  optimizer->Run ();
+  for (uint32_t s = 0; s < 3; ++s)
+    {
+      for (uint32_t k = 0; k < optimizer->GetNHeights (); ++k)
+        {
+          NS_TEST_ASSERT_MSG_EQ (optimizer->GetCoverage (s, k), coverage[s * optimizer->GetNHeights () + k],
+                                 "Threaded coverage differs for site " << s << " at " << optimizer->GetHeight (k) << " m");
+        }
+    }
+  optimizer->Dispose ();
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Site height optimizer TestSuite
+ */
+class SiteHeightOptimizerTestSuite : public TestSuite
+{
+public:
+  SiteHeightOptimizerTestSuite ();
+};
+
+SiteHeightOptimizerTestSuite::SiteHeightOptimizerTestSuite ()
+  : TestSuite ("site-height-optimizer", UNIT)
+{
+  Ptr<EricssonPropagationLossModel> ericsson = CreateObject<EricssonPropagationLossModel> ();
+  ericsson->SetFrequency (900e6);
+  ericsson->SetEnvironment (EricssonPropagationLossModel::Urban);
+  AddTestCase (new SiteHeightOptimizerTestCase (ericsson, "TxAntennaHeight", "Ericsson site height"), TestCase::QUICK);
+
+  Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+  sui->SetLambda (2.5e9, 300000000);
+  sui->SetTerrain (SUIPropagationLossModel::B);
+  AddTestCase (new SiteHeightOptimizerTestCase (sui, "BSAntennaHeight", "SUI site height"), TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static SiteHeightOptimizerTestSuite g_siteHeightOptimizerTestSuite;
@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("SUIPropagationLossModelTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief SUI golden value test case
+ *
+ * The reference values were computed offline from the SUI expressions,
+ * using the 3D distance between the two nodes, a wavelength matching the
+ * carrier frequency and the default 10 dB shadowing.
+ */
+class SUIPropagationLossModelTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param freq carrier frequency [Hz]
+   * \param dist 2D distance between BS and SS [m]
+   * \param hb BS antenna height [m]
+   * \param hm SS antenna height [m]
+   * \param terrain terrain type
+   * \param refValue reference loss value [dB]
+   * \param name TestCase name
+   */
+  SUIPropagationLossModelTestCase (double freq, double dist, double hb, double hm,
+                                   SUIPropagationLossModel::Terrain terrain,
+                                   double refValue, std::string name);
+  virtual ~SUIPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  double m_freq; //!< carrier frequency [Hz]
+  double m_dist; //!< 2D distance between BS and SS [m]
+  double m_hb; //!< BS antenna height [m]
+  double m_hm; //!< SS antenna height [m]
+  SUIPropagationLossModel::Terrain m_terrain; //!< terrain type
+  double m_lossRef; //!< reference loss [dB]
+};
+
+SUIPropagationLossModelTestCase::SUIPropagationLossModelTestCase (double freq, double dist, double hb, double hm,
+                                                                  SUIPropagationLossModel::Terrain terrain,
+                                                                  double refValue, std::string name)
+  : TestCase (name),
+    m_freq (freq),
+    m_dist (dist),
+    m_hb (hb),
+    m_hm (hm),
+    m_terrain (terrain),
+    m_lossRef (refValue)
+{
+}
+
+SUIPropagationLossModelTestCase::~SUIPropagationLossModelTestCase ()
+{
+}
+
+void
+SUIPropagationLossModelTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  mma->SetPosition (Vector (0.0, 0.0, m_hb));
+
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+  mmb->SetPosition (Vector (m_dist, 0.0, m_hm));
+
+  Ptr<SUIPropagationLossModel> propagationLossModel = CreateObject<SUIPropagationLossModel> ();
+  propagationLossModel->SetLambda (m_freq, 3e8);
+  propagationLossModel->SetBSAntennaHeight (m_hb);
+  propagationLossModel->SetSSAntennaHeight (m_hm);
+  propagationLossModel->SetAttribute ("Terrain", EnumValue (m_terrain));
+
+  // GetLoss () returns the loss as a negative gain
+  double loss = -propagationLossModel->GetLoss (mma, mmb);
+
+  NS_LOG_INFO ("Calculated loss: " << loss);
+  NS_LOG_INFO ("Theoretical loss: " << m_lossRef);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (loss, m_lossRef, 0.001, "Wrong loss !");
+
+  double txPowerDbm = 43.0;
+  double rxPowerDbm = propagationLossModel->CalcRxPower (txPowerDbm, mma, mmb);
+  NS_TEST_ASSERT_MSG_EQ_TOL (txPowerDbm - rxPowerDbm, m_lossRef, 0.001, "CalcRxPower disagrees with GetLoss");
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief SUI reference curve test case
+ *
+ * Walks the urban path of the empirical-propagation-loss-comparison
+ * scratch (BS at 33 m, SS at 1 m, 900 MHz, terrain A) and checks the
+ * losses against the SUI curve shipped in propagation-loss-urban.plt.
+ */
+class SUIReferenceCurveTestCase : public TestCase
+{
+public:
+  SUIReferenceCurveTestCase ();
+  virtual ~SUIReferenceCurveTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SUIReferenceCurveTestCase::SUIReferenceCurveTestCase ()
+  : TestCase ("SUI urban reference curve")
+{
+}
+
+SUIReferenceCurveTestCase::~SUIReferenceCurveTestCase ()
+{
+}
+
+void
+SUIReferenceCurveTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // x, y, loss [dB] as written by the comparison scratch
+  const double curve[][3] = {
+    { 80, 0, 112.035 }, { 100, 0, 116.099 }, { 150, 0, 123.891 }, { 200, 0, 129.609 },
+    { 250, 0, 134.104 }, { 300, 0, 137.802 }, { 350, 0, 140.941 }, { 400, 0, 143.666 },
+    { 450, 0, 146.074 }, { 500, 0, 148.231 }, { 550, 0, 150.183 }, { 600, 0, 151.966 },
+    { 650, 0, 153.608 }, { 700, 0, 155.128 }, { 750, 0, 156.544 }, { 790, 0, 157.61 },
+    { 790, 50, 157.651 }, { 790, 100, 157.774 }
+  };
+
+  Ptr<MobilityModel> mma = CreateObject<ConstantPositionMobilityModel> ();
+  mma->SetPosition (Vector (0.0, 0.0, 33.0));
+  Ptr<MobilityModel> mmb = CreateObject<ConstantPositionMobilityModel> ();
+
+  Ptr<SUIPropagationLossModel> propagationLossModel = CreateObject<SUIPropagationLossModel> ();
+  propagationLossModel->SetLambda (3e8 / 900e6);
+  propagationLossModel->SetBSAntennaHeight (33.0);
+  propagationLossModel->SetSSAntennaHeight (1.0);
+  propagationLossModel->SetTerrain (SUIPropagationLossModel::A);
+
+  for (uint32_t i = 0; i < sizeof (curve) / sizeof (curve[0]); ++i)
+    {
+      mmb->SetPosition (Vector (curve[i][0], curve[i][1], 1.0));
+      double loss = -propagationLossModel->GetLoss (mma, mmb);
+      // the curve was written with 6 significant digits
+      NS_TEST_ASSERT_MSG_EQ_TOL (loss, curve[i][2], 0.005, "Wrong loss at " << curve[i][0] << "," << curve[i][1]);
+    }
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief SUI TestSuite
+ */
+class SUIPropagationLossModelTestSuite : public TestSuite
+{
+public:
+  SUIPropagationLossModelTestSuite ();
+};
+
+SUIPropagationLossModelTestSuite::SUIPropagationLossModelTestSuite ()
+  : TestSuite ("sui", SYSTEM)
+{
+  LogComponentEnable ("SUIPropagationLossModelTest", LOG_LEVEL_ALL);
+
+  // setups of the empirical-propagation-loss-comparison scratch (900 MHz, 1 m SS)
+  AddTestCase (new SUIPropagationLossModelTestCase (900e6, 100, 33, 1, SUIPropagationLossModel::A, 116.099, "SUI A 900 MHz 100 m"), TestCase::QUICK);
+  AddTestCase (new SUIPropagationLossModelTestCase (900e6, 800, 33, 1, SUIPropagationLossModel::A, 157.869, "SUI A 900 MHz 800 m"), TestCase::QUICK);
+  AddTestCase (new SUIPropagationLossModelTestCase (900e6, 100, 35, 1, SUIPropagationLossModel::B, 116.109, "SUI B 900 MHz 100 m"), TestCase::QUICK);
+  AddTestCase (new SUIPropagationLossModelTestCase (900e6, 800, 35, 1, SUIPropagationLossModel::B, 153.595, "SUI B 900 MHz 800 m"), TestCase::QUICK);
+  AddTestCase (new SUIPropagationLossModelTestCase (900e6, 100, 42, 1, SUIPropagationLossModel::C, 166.771, "SUI C 900 MHz 100 m"), TestCase::QUICK);
+  AddTestCase (new SUIPropagationLossModelTestCase (900e6, 800, 42, 1, SUIPropagationLossModel::C, 200.404, "SUI C 900 MHz 800 m"), TestCase::QUICK);
+
+  // 2.5 GHz, 50 m BS, 3 m SS
+  AddTestCase (new SUIPropagationLossModelTestCase (2.5e9, 1000, 50, 3, SUIPropagationLossModel::A, 166.272, "SUI A 2.5 GHz 1 km"), TestCase::QUICK);
+  AddTestCase (new SUIPropagationLossModelTestCase (2.5e9, 1000, 50, 3, SUIPropagationLossModel::B, 161.669, "SUI B 2.5 GHz 1 km"), TestCase::QUICK);
+  AddTestCase (new SUIPropagationLossModelTestCase (2.5e9, 1000, 50, 3, SUIPropagationLossModel::C, 204.978, "SUI C 2.5 GHz 1 km"), TestCase::QUICK);
+
+  AddTestCase (new SUIReferenceCurveTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static SUIPropagationLossModelTestSuite g_suiTestSuite;
@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/enum.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/clutter-raster.h"
+#include "ns3/node-container.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/ecc33-propagation-loss-model.h"
+#include "ns3/sui-propagation-loss-model.h"
+#include "ns3/time-sliced-propagation-loss-model.h"
+#include <cstdio>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TimeSlicedPropagationLossModelTest");
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Check the losses of a TimeSlicedLossPipeline and their staleness
+ */
+class TimeSlicedPipelineTestCase : public TestCase
+{
+public:
+  TimeSlicedPipelineTestCase ();
+  virtual ~TimeSlicedPipelineTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the sliced models against the direct models
+   * \param fresh whether the losses must match the current positions
+   */
+  void Check (bool fresh);
+  /**
+   * Move the receivers away from the transmitters
+   */
+  void Move (void);
+
+  NodeContainer m_bs; //!< transmitters
+  NodeContainer m_ss; //!< receivers
+  Ptr<EmpiricalPropagationLossModel> m_models[2]; //!< direct models
+  Ptr<PropagationLossModel> m_sliced[2]; //!< sliced models
+  std::vector<double> m_previous; //!< losses before the move
+};
+
+TimeSlicedPipelineTestCase::TimeSlicedPipelineTestCase ()
+  : TestCase ("Time-sliced pipeline losses and staleness")
+{
+}
+
+TimeSlicedPipelineTestCase::~TimeSlicedPipelineTestCase ()
+{
+}
+
+void
+TimeSlicedPipelineTestCase::Check (bool fresh)
+{
+  uint32_t k = 0;
+  for (uint32_t m = 0; m < 2; ++m)
+    {
+      for (uint32_t i = 0; i < m_bs.GetN (); ++i)
+        {
+          Ptr<MobilityModel> a = m_bs.Get (i)->GetObject<MobilityModel> ();
+          for (uint32_t j = 0; j < m_ss.GetN (); ++j, ++k)
+            {
+              Ptr<MobilityModel> b = m_ss.Get (j)->GetObject<MobilityModel> ();
+              double sliced = m_sliced[m]->CalcRxPower (10.0, a, b);
+              if (fresh)
+                {
+                  NS_TEST_EXPECT_MSG_EQ_TOL (sliced, m_models[m]->CalcRxPower (10.0, a, b), 1e-9, "Wrong loss");
+                  NS_TEST_EXPECT_MSG_EQ_TOL (m_sliced[m]->CalcRxPower (10.0, b, a), sliced, 1e-9, "Wrong reverse loss");
+                  m_previous.push_back (sliced);
+                }
+              else
+                {
+                  NS_TEST_EXPECT_MSG_EQ_TOL (sliced, m_previous[k], 1e-9, "Slice refreshed too early");
+                }
+            }
+        }
+    }
+}
+
+void
+TimeSlicedPipelineTestCase::Move (void)
+{
+  for (uint32_t j = 0; j < m_ss.GetN (); ++j)
+    {
+      Ptr<MobilityModel> b = m_ss.Get (j)->GetObject<MobilityModel> ();
+      Vector position = b->GetPosition ();
+      position.x += 250.0;
+      b->SetPosition (position);
+    }
+}
+
+void
+TimeSlicedPipelineTestCase::DoRun (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_bs.Create (2);
+  m_ss.Create (5);
+  for (uint32_t i = 0; i < m_bs.GetN (); ++i)
+    {
+      Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+      mm->SetPosition (Vector (1000.0 * i, 0.0, 35.0));
+      m_bs.Get (i)->AggregateObject (mm);
+    }
+  for (uint32_t j = 0; j < m_ss.GetN (); ++j)
+    {
+      Ptr<MobilityModel> mm = CreateObject<ConstantPositionMobilityModel> ();
+      mm->SetPosition (Vector (100.0 + 120.0 * j, 40.0 * j, 1.5));
+      m_ss.Get (j)->AggregateObject (mm);
+    }
+
+  Ptr<ECC33PropagationLossModel> ecc33 = CreateObject<ECC33PropagationLossModel> ();
+  ecc33->SetTxAntennaHeight (35.0);
+  ecc33->SetRxAntennaHeight (1.5);
+  m_models[0] = ecc33;
+  Ptr<SUIPropagationLossModel> sui = CreateObject<SUIPropagationLossModel> ();
+  sui->SetBSAntennaHeight (35.0);
+  sui->SetSSAntennaHeight (1.5);
+  m_models[1] = sui;
+
+  Ptr<TimeSlicedLossPipeline> pipeline = CreateObject<TimeSlicedLossPipeline> ();
+  pipeline->SetAttribute ("SliceDuration", TimeValue (Seconds (1.0)));
+  pipeline->AddTransmitters (m_bs);
+  pipeline->AddReceivers (m_ss);
+  m_sliced[0] = pipeline->AddModel (m_models[0]);
+  m_sliced[1] = pipeline->AddModel (m_models[1]);
+
+  // the receivers move at 0.2 s, the slice started at 0.1 s lasts until 1.1 s
+  Simulator::Schedule (Seconds (0.1), &TimeSlicedPipelineTestCase::Check, this, true);
+  Simulator::Schedule (Seconds (0.2), &TimeSlicedPipelineTestCase::Move, this);
+  Simulator::Schedule (Seconds (0.9), &TimeSlicedPipelineTestCase::Check, this, false);
+  Simulator::Schedule (Seconds (1.2), &TimeSlicedPipelineTestCase::Check, this, true);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // links the pipeline does not track are evaluated directly
+  Ptr<MobilityModel> a = m_ss.Get (0)->GetObject<MobilityModel> ();
+  Ptr<MobilityModel> b = m_ss.Get (1)->GetObject<MobilityModel> ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_sliced[0]->CalcRxPower (10.0, a, b), m_models[0]->CalcRxPower (10.0, a, b), 1e-9, "Untracked link");
+
+  // with a clutter raster the receiver picks the environment: urban at the
+  // first transmitter, rural elsewhere, so the reversed link differs
+  const uint8_t cells[] = { ClutterRaster::Urban };
+  std::string filename = CreateTempDirFilename ("site.clutter");
+  ClutterRaster::Write (filename, -25.0, -25.0, 50.0, 1, 1, cells);
+  Ptr<ClutterRaster> raster = CreateObject<ClutterRaster> ();
+  raster->SetAttribute ("DefaultClass", EnumValue (ClutterRaster::Rural));
+  raster->SetAttribute ("Filename", StringValue (filename));
+  m_models[1]->SetAttribute ("ClutterRaster", PointerValue (raster));
+  pipeline->Update ();
+  a = m_bs.Get (0)->GetObject<MobilityModel> ();
+  b = m_ss.Get (0)->GetObject<MobilityModel> ();
+  double forward = m_sliced[1]->CalcRxPower (10.0, a, b);
+  double reverse = m_sliced[1]->CalcRxPower (10.0, b, a);
+  NS_TEST_ASSERT_MSG_EQ_TOL (forward, m_models[1]->CalcRxPower (10.0, a, b), 1e-9, "Wrong loss with clutter");
+  NS_TEST_ASSERT_MSG_EQ_TOL (reverse, m_models[1]->CalcRxPower (10.0, b, a), 1e-9, "Reversed link read from the table");
+  NS_TEST_ASSERT_MSG_NE (forward, reverse, "Same environment at both ends");
+
+  // the models chained to the empirical model apply to the table losses
+  m_models[0]->SetNext (CreateObject<SUIPropagationLossModel> ());
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_sliced[0]->CalcRxPower (10.0, a, b), m_models[0]->CalcRxPower (10.0, a, b), 1e-9,
+                             "Chained model dropped");
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_sliced[0]->CalcRxPower (10.0, b, a), m_models[0]->CalcRxPower (10.0, b, a), 1e-9,
+                             "Chained model dropped on the reversed link");
+
+  raster->SetAttribute ("Filename", StringValue (""));
+  std::remove (filename.c_str ());
+
+  pipeline->Dispose ();
+}
+
+/**
+ * \ingroup propagation-tests
+ *
+ * \brief Time-sliced propagation loss TestSuite
+ */
+class TimeSlicedPropagationLossModelTestSuite : public TestSuite
+{
+public:
+  TimeSlicedPropagationLossModelTestSuite ();
+};
+
+TimeSlicedPropagationLossModelTestSuite::TimeSlicedPropagationLossModelTestSuite ()
+  : TestSuite ("time-sliced-propagation-loss-model", UNIT)
+{
+  AddTestCase (new TimeSlicedPipelineTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static TimeSlicedPropagationLossModelTestSuite g_timeSlicedPropagationLossModelTestSuite;